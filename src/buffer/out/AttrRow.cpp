@@ -9,13 +9,55 @@
 // Arguments:
 // - cchRowWidth - the length of the default text attribute
 // - attr - the default text attribute
+// - table - where to intern the attributes of the row
+// - resource - where to allocate the runs from
 // Return Value:
 // - constructed object
 // Note: will throw exception if unable to allocate memory for text attribute storage
-ATTR_ROW::ATTR_ROW(const UINT cchRowWidth, const TextAttribute attr)
+ATTR_ROW::ATTR_ROW(const UINT cchRowWidth,
+                   const TextAttribute attr,
+                   TextAttributeTable& table,
+                   std::pmr::memory_resource* const resource) :
+    _list{ resource },
+    _cchRowWidth{ cchRowWidth },
+    _table{ &table }
 {
-    _list.push_back(TextAttributeRun(cchRowWidth, attr));
-    _cchRowWidth = cchRowWidth;
+    _list.push_back({ gsl::narrow<uint16_t>(cchRowWidth), table.Intern(attr) });
+}
+
+// Routine Description:
+// - Copies the runs of another row. If the other row interns its attributes
+//   in another table, they're interned in this row's table instead.
+// Arguments:
+// - other - The row to copy.
+// Return Value:
+// - This row. Throws if the runs can't be copied, in which case this row is unchanged.
+ATTR_ROW& ATTR_ROW::operator=(const ATTR_ROW& other)
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    if (_table == other._table)
+    {
+        _list = other._list;
+    }
+    else
+    {
+        decltype(_list) list{ _list.get_allocator() };
+        list.reserve(other._list.size());
+
+        _table->Reserve(other._list.size());
+        for (const auto& run : other._list)
+        {
+            list.push_back({ run.length, _table->Intern(other._table->Get(run.id)) });
+        }
+        _list.swap(list);
+    }
+
+    _cchRowWidth = other._cchRowWidth;
+    return *this;
 }
 
 // Routine Description:
@@ -24,8 +66,9 @@ ATTR_ROW::ATTR_ROW(const UINT cchRowWidth, const TextAttribute attr)
 // - attr - The default text attributes to use on text in this row.
 void ATTR_ROW::Reset(const TextAttribute attr)
 {
+    const auto id = _table->Intern(attr);
     _list.clear();
-    _list.push_back(TextAttributeRun(_cchRowWidth, attr));
+    _list.push_back({ gsl::narrow_cast<uint16_t>(_cchRowWidth), id });
 }
 
 // Routine Description:
@@ -49,7 +92,7 @@ void ATTR_ROW::Resize(const size_t newWidth)
         auto& run = _list.at(runPos);
 
         // Extend its length by the additional columns we're adding.
-        run.SetLength(run.GetLength() + newWidth - _cchRowWidth);
+        run.length = gsl::narrow<uint16_t>(run.length + newWidth - _cchRowWidth);
 
         // Store that the new total width we represent is the new width.
         _cchRowWidth = newWidth;
@@ -67,7 +110,7 @@ void ATTR_ROW::Resize(const size_t newWidth)
         // then when we called FindAttrIndex, it returned the B5 as the pIndexedRun and a 2 for how many more segments it covers
         // after and including the 3rd column.
         // B5-2 = B3, which is what we desire to cover the new 3 size buffer.
-        run.SetLength(run.GetLength() - CountOfAttr + 1);
+        run.length = gsl::narrow_cast<uint16_t>(run.length - CountOfAttr + 1);
 
         // Store that the new total width we represent is the new width.
         _cchRowWidth = newWidth;
@@ -108,7 +151,7 @@ TextAttribute ATTR_ROW::GetAttrByColumn(const size_t column,
 {
     THROW_HR_IF(E_INVALIDARG, column >= _cchRowWidth);
     const auto runPos = FindAttrIndex(column, pApplies);
-    return _list.at(runPos).GetAttributes();
+    return _table->Get(_list.at(runPos).id);
 }
 
 // Routine Description:
@@ -141,7 +184,7 @@ size_t ATTR_ROW::FindAttrIndex(const size_t index, size_t* const pApplies) const
     auto runPos = _list.cbegin();
     do
     {
-        cTotalLength += runPos->GetLength();
+        cTotalLength += runPos->length;
 
         if (cTotalLength > index)
         {
@@ -179,14 +222,15 @@ size_t ATTR_ROW::FindAttrIndex(const size_t index, size_t* const pApplies) const
 // - Finds the hyperlink IDs present in this row and returns them
 // Return value:
 // - An unordered set containing the hyperlink IDs present in this row
-std::unordered_set<uint16_t> ATTR_ROW::GetHyperlinks()
+std::unordered_set<uint16_t> ATTR_ROW::GetHyperlinks() const
 {
     std::unordered_set<uint16_t> ids;
     for (const auto& run : _list)
     {
-        if (run.GetAttributes().IsHyperlink())
+        const auto& attr = _table->Get(run.id);
+        if (attr.IsHyperlink())
         {
-            ids.emplace(run.GetAttributes().GetHyperlinkId());
+            ids.emplace(attr.GetHyperlinkId());
         }
     }
     return ids;
@@ -207,6 +251,51 @@ bool ATTR_ROW::SetAttrToEnd(const UINT iStart, const TextAttribute attr)
     return SUCCEEDED(InsertAttrRuns({ &run, 1 }, iStart, _cchRowWidth - 1, _cchRowWidth));
 }
 
+// Routine Description:
+// - Copies the attributes of a range of columns of another row, which may
+//   have a different width and table. The attribute of the last copied
+//   column is also applied through the end of this row, the same way as
+//   setting each column's attribute with SetAttrToEnd in turn would.
+// Arguments:
+// - source - The row to copy from
+// - sourceColumn - The first column of source to copy
+// - count - The number of columns to copy
+// - column - The column of this row that receives the first attribute
+// Return Value:
+// - E_INVALIDARG if either range is out of bounds,
+//   E_OUTOFMEMORY if there wasn't enough memory to insert the runs, otherwise S_OK.
+[[nodiscard]] HRESULT ATTR_ROW::CopyAttrsToEnd(const ATTR_ROW& source,
+                                               const size_t sourceColumn,
+                                               const size_t count,
+                                               const size_t column)
+try
+{
+    RETURN_HR_IF(E_INVALIDARG, count == 0 || sourceColumn + count > source._cchRowWidth || column + count > _cchRowWidth);
+
+    const auto sourceEnd = sourceColumn + count;
+    std::vector<TextAttributeRun> runs;
+    size_t runStart = 0;
+    for (const auto& run : source._list)
+    {
+        const auto runEnd = runStart + run.length;
+        if (runEnd > sourceColumn)
+        {
+            const auto length = std::min(runEnd, sourceEnd) - std::max(runStart, sourceColumn);
+            runs.emplace_back(length, source._table->Get(run.id));
+            if (runEnd >= sourceEnd)
+            {
+                break;
+            }
+        }
+        runStart = runEnd;
+    }
+
+    auto& last = runs.back();
+    last.SetLength(last.GetLength() + _cchRowWidth - column - count);
+    return InsertAttrRuns(runs, column, _cchRowWidth - 1, _cchRowWidth);
+}
+CATCH_RETURN();
+
 // Method Description:
 // - Replaces all runs in the row with the given toBeReplacedAttr with the new
 //      attribute replaceWith.
@@ -215,13 +304,21 @@ bool ATTR_ROW::SetAttrToEnd(const UINT iStart, const TextAttribute attr)
 // - replaceWith - the new value for the matching runs' attributes.
 // Return Value:
 // - <none>
-void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAttribute& replaceWith) noexcept
+void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAttribute& replaceWith)
 {
+    // If the attribute was never interned, no run can have it.
+    const auto toBeReplaced = _table->Find(toBeReplacedAttr);
+    if (!toBeReplaced)
+    {
+        return;
+    }
+
+    const auto replacement = _table->Intern(replaceWith);
     for (auto& run : _list)
     {
-        if (run.GetAttributes() == toBeReplacedAttr)
+        if (run.id == *toBeReplaced)
         {
-            run.SetAttributes(replaceWith);
+            run.id = replacement;
         }
     }
 }
@@ -244,6 +341,34 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
                                                const size_t iStart,
                                                const size_t iEnd,
                                                const size_t cBufferWidth)
+{
+    // Intern the attributes first, so that the merge below only has to compare IDs.
+    // A single run is by far the most common case and doesn't need to allocate.
+    if (newAttrs.size() == 1)
+    {
+        const auto& attr = til::at(newAttrs, 0);
+        const TextAttributeTable::Run run{ gsl::narrow<uint16_t>(attr.GetLength()), _table->Intern(attr.GetAttributes()) };
+        return _InsertRuns({ &run, 1 }, iStart, iEnd, cBufferWidth);
+    }
+
+    std::vector<TextAttributeTable::Run> newRuns;
+    newRuns.reserve(newAttrs.size());
+
+    _table->Reserve(newAttrs.size());
+    for (const auto& attr : newAttrs)
+    {
+        newRuns.push_back({ gsl::narrow<uint16_t>(attr.GetLength()), _table->Intern(attr.GetAttributes()) });
+    }
+
+    return _InsertRuns(newRuns, iStart, iEnd, cBufferWidth);
+}
+
+// Routine Description:
+// - Inserts runs whose attributes were interned already, see InsertAttrRuns.
+[[nodiscard]] HRESULT ATTR_ROW::_InsertRuns(const gsl::span<const TextAttributeTable::Run> newAttrs,
+                                            const size_t iStart,
+                                            const size_t iEnd,
+                                            const size_t cBufferWidth)
 {
     // Definitions:
     // Existing Run = The run length encoded color array we're already storing in memory before this was called.
@@ -267,11 +392,11 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
     if (newAttrs.size() == 1)
     {
         // Get the new color attribute we're trying to apply
-        const TextAttribute NewAttr = til::at(newAttrs, 0).GetAttributes();
+        const auto NewAttr = til::at(newAttrs, 0).id;
 
         // If the existing run was only 1 element...
         // ...and the new color is the same as the old, we don't have to do anything and can exit quick.
-        if (_list.size() == 1 && _list.at(0).GetAttributes() == NewAttr)
+        if (_list.size() == 1 && _list.at(0).id == NewAttr)
         {
             return S_OK;
         }
@@ -287,7 +412,7 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
             for (size_t i = 0; i < _list.size(); i++)
             {
                 const auto curr = begin + i;
-                upperBound += curr->GetLength();
+                upperBound += curr->length;
 
                 if (iStart >= lowerBound && iStart < upperBound)
                 {
@@ -299,7 +424,7 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
                     //
                     // 'B' is the new color and '^' represents where iStart is. We don't have to
                     // do anything.
-                    if (curr->GetAttributes() == NewAttr)
+                    if (curr->id == NewAttr)
                     {
                         return S_OK;
                     }
@@ -312,9 +437,9 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
                     // AAAAADCCCCCCCCC
                     //
                     // Here 'D' is the new color.
-                    if (curr->GetLength() == 1)
+                    if (curr->length == 1)
                     {
-                        curr->SetAttributes(NewAttr);
+                        curr->id = NewAttr;
                         return S_OK;
                     }
 
@@ -330,13 +455,13 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
                         // AAAAAABBBBBBCCC
                         //
                         // Here 'A' is the new color.
-                        if (NewAttr == prev->GetAttributes())
+                        if (NewAttr == prev->id)
                         {
-                            prev->IncrementLength();
-                            curr->DecrementLength();
+                            prev->length++;
+                            curr->length--;
 
                             // If we just reduced the right half to zero, just erase it out of the list.
-                            if (curr->GetLength() == 0)
+                            if (curr->length == 0)
                             {
                                 _list.erase(curr);
                             }
@@ -357,12 +482,12 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
                         //
                         // Here 'B' is the new color.
                         const auto next = std::next(curr, 1);
-                        if (NewAttr == next->GetAttributes())
+                        if (NewAttr == next->id)
                         {
-                            curr->DecrementLength();
-                            next->IncrementLength();
+                            curr->length--;
+                            next->length++;
 
-                            if (curr->GetLength() == 0)
+                            if (curr->length == 0)
                             {
                                 _list.erase(curr);
                             }
@@ -402,7 +527,7 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
     // The original run was 3 long. The insertion run was 1 long. We need 1 more for the
     // fact that an existing piece of the run was split in half (to hold the latter half).
     const size_t cNewRun = _list.size() + newAttrs.size() + 1;
-    std::vector<TextAttributeRun> newRun;
+    decltype(_list) newRun{ _list.get_allocator() };
     newRun.reserve(cNewRun);
 
     // We will start analyzing from the beginning of our existing run.
@@ -424,7 +549,7 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
         while (iExistingRunCoverage < iStart)
         {
             // Add up how much length we can cover by copying an item from the existing run.
-            iExistingRunCoverage += pExistingRunPos->GetLength();
+            iExistingRunCoverage += pExistingRunPos->length;
 
             // Copy it to the new run buffer and advance both pointers.
             newRun.push_back(*pExistingRunPos++);
@@ -447,7 +572,7 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
         //      the new/final run.
 
         // Fetch out the length so we can fix it up based on the below conditions.
-        size_t length = newRun.back().GetLength();
+        size_t length = newRun.back().length;
 
         // If we've covered more cells already than the start of the attributes to be inserted...
         if (iExistingRunCoverage > iStart)
@@ -462,9 +587,9 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
         // Now we're still on that "last cell copied" into the new run.
         // If the color of that existing copied cell matches the color of the first segment
         // of the run we're about to insert, we can just increment the length to extend the coverage.
-        if (newRun.back().GetAttributes() == pInsertRunPos->GetAttributes())
+        if (newRun.back().id == pInsertRunPos->id)
         {
-            length += pInsertRunPos->GetLength();
+            length += pInsertRunPos->length;
 
             // Since the color matched, we have already "used up" part of the insert run
             // and can skip it in our big "memcopy" step below that will copy the bulk of the insert run.
@@ -473,7 +598,7 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
         }
 
         // We're done manipulating the length. Store it back.
-        newRun.back().SetLength(length);
+        newRun.back().length = gsl::narrow_cast<uint16_t>(length);
     }
 
     // Bulk copy the majority (or all, depending on circumstance) of the insert run into the final run buffer.
@@ -487,7 +612,7 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
     while (iExistingRunCoverage <= iEnd)
     {
         FAIL_FAST_IF(!(pExistingRunPos != pExistingRunEnd));
-        iExistingRunCoverage += pExistingRunPos->GetLength();
+        iExistingRunCoverage += pExistingRunPos->length;
         pExistingRunPos++;
     }
 
@@ -517,11 +642,11 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
             // This case is slightly off from the example above. This case is for if the B2 above was actually Y2.
             // That Y2 from the existing run is the same color as the Y2 we just filled a few columns left in the final run
             // so we can just adjust the final run's column count instead of adding another segment here.
-            if (newRun.back().GetAttributes() == pExistingRunPos->GetAttributes())
+            if (newRun.back().id == pExistingRunPos->id)
             {
-                size_t length = newRun.back().GetLength();
+                size_t length = newRun.back().length;
                 length += (iExistingRunCoverage - (iEnd + 1));
-                newRun.back().SetLength(length);
+                newRun.back().length = gsl::narrow_cast<uint16_t>(length);
             }
             else
             {
@@ -532,11 +657,11 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
                 newRun.emplace_back();
 
                 // Copy the existing run's color information to the new run
-                newRun.back().SetAttributes(pExistingRunPos->GetAttributes());
+                newRun.back().id = pExistingRunPos->id;
 
                 // Adjust the length of that copied color to cover only the reduced number of columns needed
                 // now that some have been replaced by the insert run.
-                newRun.back().SetLength(iExistingRunCoverage - (iEnd + 1));
+                newRun.back().length = gsl::narrow_cast<uint16_t>(iExistingRunCoverage - (iEnd + 1));
             }
 
             // Now that we're done recovering a piece of the existing run we skipped, move the pointer forward again.
@@ -554,12 +679,12 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
         // New Run desired when done = R3 -> B7
         // Existing run pointer is on B2.
         // We want to merge the 2 from the B2 into the B5 so we get B7.
-        else if (newRun.back().GetAttributes() == pExistingRunPos->GetAttributes())
+        else if (newRun.back().id == pExistingRunPos->id)
         {
             // Add the value from the existing run into the current new run position.
-            size_t length = newRun.back().GetLength();
-            length += pExistingRunPos->GetLength();
-            newRun.back().SetLength(length);
+            size_t length = newRun.back().length;
+            length += pExistingRunPos->length;
+            newRun.back().length = gsl::narrow_cast<uint16_t>(length);
 
             // Advance the existing run position since we consumed its value and merged it in.
             pExistingRunPos++;
@@ -606,6 +731,32 @@ std::vector<TextAttributeRun> ATTR_ROW::PackAttrs(const std::vector<TextAttribut
     return runs;
 }
 
+// Routine Description:
+// - Gets the table that the attributes of this row are interned in.
+const TextAttributeTable& ATTR_ROW::GetTable() const noexcept
+{
+    return *_table;
+}
+
+// Routine Description:
+// - Marks the IDs that this row stores as still in use, see TextAttributeTable::Marker.
+// Arguments:
+// - table - The table that's being collected. Rows of other tables don't mark anything.
+// Return Value:
+// - <none>
+void ATTR_ROW::MarkAttributes(TextAttributeTable& table) const noexcept
+{
+    if (&table != _table)
+    {
+        return;
+    }
+
+    for (const auto& run : _list)
+    {
+        table.Mark(run.id);
+    }
+}
+
 ATTR_ROW::const_iterator ATTR_ROW::begin() const noexcept
 {
     return AttrRowIterator(this);
@@ -21,6 +21,7 @@ Revision History:
 #pragma once
 
 #include "TextAttributeRun.hpp"
+#include "TextAttributeTable.hpp"
 #include "AttrRowIterator.hpp"
 
 class ATTR_ROW final
@@ -28,7 +29,15 @@ class ATTR_ROW final
 public:
     using const_iterator = typename AttrRowIterator;
 
-    ATTR_ROW(const UINT cchRowWidth, const TextAttribute attr);
+    ATTR_ROW(const UINT cchRowWidth,
+             const TextAttribute attr,
+             TextAttributeTable& table,
+             std::pmr::memory_resource* const resource = std::pmr::get_default_resource());
+
+    ATTR_ROW(const ATTR_ROW&) = default;
+    ATTR_ROW(ATTR_ROW&&) noexcept = default;
+    ATTR_ROW& operator=(const ATTR_ROW& other);
+    ATTR_ROW& operator=(ATTR_ROW&&) = default;
 
     void Reset(const TextAttribute attr);
 
@@ -41,10 +50,14 @@ public:
     size_t FindAttrIndex(const size_t index,
                          size_t* const pApplies) const;
 
-    std::unordered_set<uint16_t> GetHyperlinks();
+    std::unordered_set<uint16_t> GetHyperlinks() const;
 
     bool SetAttrToEnd(const UINT iStart, const TextAttribute attr);
-    void ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAttribute& replaceWith) noexcept;
+    [[nodiscard]] HRESULT CopyAttrsToEnd(const ATTR_ROW& source,
+                                         const size_t sourceColumn,
+                                         const size_t count,
+                                         const size_t column);
+    void ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAttribute& replaceWith);
 
     void Resize(const size_t newWidth);
 
@@ -55,6 +68,9 @@ public:
 
     static std::vector<TextAttributeRun> PackAttrs(const std::vector<TextAttribute>& attrs);
 
+    const TextAttributeTable& GetTable() const noexcept;
+    void MarkAttributes(TextAttributeTable& table) const noexcept;
+
     const_iterator begin() const noexcept;
     const_iterator end() const noexcept;
 
@@ -65,8 +81,15 @@ public:
     friend class AttrRowIterator;
 
 private:
-    std::vector<TextAttributeRun> _list;
+    [[nodiscard]] HRESULT _InsertRuns(const gsl::span<const TextAttributeTable::Run> newRuns,
+                                      const size_t iStart,
+                                      const size_t iEnd,
+                                      const size_t cBufferWidth);
+
+    std::pmr::vector<TextAttributeTable::Run> _list;
     size_t _cchRowWidth;
+    // Where the attributes of the runs are interned. Rows of the same buffer share it.
+    TextAttributeTable* _table;
 
 #ifdef UNIT_TESTING
     friend class AttrRowTests;
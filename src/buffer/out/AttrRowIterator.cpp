@@ -90,13 +90,22 @@ AttrRowIterator AttrRowIterator::operator--(int)
 const TextAttribute* AttrRowIterator::operator->() const
 {
     THROW_HR_IF(E_BOUNDS, _exceeded);
-    return &_run->GetAttributes();
+    return &_pAttrRow->_table->Get(_run->id);
 }
 
 const TextAttribute& AttrRowIterator::operator*() const
 {
     THROW_HR_IF(E_BOUNDS, _exceeded);
-    return _run->GetAttributes();
+    return _pAttrRow->_table->Get(_run->id);
+}
+
+// Routine Description:
+// - Gets the ID that the attribute is interned as. Attributes of the same row
+//   are equal if and only if their IDs are.
+TextAttributeTable::Id AttrRowIterator::GetId() const
+{
+    THROW_HR_IF(E_BOUNDS, _exceeded);
+    return _run->id;
 }
 
 // Routine Description:
@@ -107,7 +116,7 @@ void AttrRowIterator::_increment(size_t count)
 {
     while (count > 0)
     {
-        const size_t runLength = _run->GetLength();
+        const size_t runLength = _run->length;
         if (count + _currentAttributeIndex < runLength)
         {
             _currentAttributeIndex += count;
@@ -148,7 +157,7 @@ void AttrRowIterator::_decrement(size_t count)
             }
             count -= _currentAttributeIndex + 1;
             --_run;
-            _currentAttributeIndex = _run->GetLength() - 1;
+            _currentAttributeIndex = _run->length - 1;
         }
     }
 }
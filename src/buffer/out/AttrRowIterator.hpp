@@ -17,6 +17,7 @@ Author(s):
 
 #include "TextAttribute.hpp"
 #include "TextAttributeRun.hpp"
+#include "TextAttributeTable.hpp"
 
 class ATTR_ROW;
 
@@ -50,8 +51,10 @@ public:
     const TextAttribute* operator->() const;
     const TextAttribute& operator*() const;
 
+    TextAttributeTable::Id GetId() const;
+
 private:
-    std::vector<TextAttributeRun>::const_iterator _run;
+    std::pmr::vector<TextAttributeTable::Run>::const_iterator _run;
     const ATTR_ROW* _pAttrRow;
     size_t _currentAttributeIndex; // index of TextAttribute within the current TextAttributeRun
     bool _exceeded;
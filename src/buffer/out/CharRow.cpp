@@ -6,23 +6,38 @@
 #include "CharRow.hpp"
 #include "unicode.hpp"
 #include "Row.hpp"
+#include "textBuffer.hpp"
 
 // Routine Description:
 // - constructor
 // Arguments:
-// - rowWidth - the size (in wchar_t) of the char and attribute rows
-// - pParent - the parent ROW
+// - cells - the cells of the row, within the text buffer's cell buffer.
+//           They're expected to be initialized already.
+// - pParent - the text buffer that the row belongs to, if any
+// - rowIndex - the index of the row in the text buffer's storage
 // Return Value:
 // - instantiated object
-// Note: will through if unable to allocate char/attribute buffers
-CharRow::CharRow(size_t rowWidth, ROW* const pParent) :
+CharRow::CharRow(const gsl::span<value_type> cells, TextBuffer* const pParent, const size_t rowIndex) :
     _wrapForced{ false },
     _doubleBytePadded{ false },
-    _data(rowWidth, value_type()),
-    _pParent{ FAIL_FAST_IF_NULL(pParent) }
+    _data{ cells },
+    _pParent{ pParent },
+    _rowIndex{ rowIndex }
 {
 }
 
+// Routine Description:
+// - Sets the index of the row in the text buffer's storage, after the text
+//   buffer moved the row there.
+// Arguments:
+// - rowIndex - the new index
+// Return Value:
+// - <none>
+void CharRow::SetRowIndex(const size_t rowIndex) noexcept
+{
+    _rowIndex = rowIndex;
+}
+
 // Routine Description:
 // - Sets the wrap status for the current row
 // Arguments:
@@ -31,7 +46,14 @@ CharRow::CharRow(size_t rowWidth, ROW* const pParent) :
 // - <none>
 void CharRow::SetWrapForced(const bool wrapForced) noexcept
 {
-    _wrapForced = wrapForced;
+    if (_wrapForced != wrapForced)
+    {
+        _wrapForced = wrapForced;
+        if (_pParent)
+        {
+            _pParent->_NotifyWrapForced(_rowIndex, wrapForced);
+        }
+    }
 }
 
 // Routine Description:
@@ -90,27 +112,145 @@ void CharRow::Reset() noexcept
     {
         cell.Reset();
     }
+    _storedGlyphs.clear();
 
-    _wrapForced = false;
+    SetWrapForced(false);
     _doubleBytePadded = false;
 }
 
 // Routine Description:
-// - resizes the width of the CharRowBase
+// - copies the cells, stored glyphs and flags of another row of the same width.
+//   If this throws, the row is left unchanged.
 // Arguments:
-// - newSize - the new width of the character and attributes rows
+// - source - the row to copy
 // Return Value:
-// - S_OK on success, otherwise relevant error code
-[[nodiscard]] HRESULT CharRow::Resize(const size_t newSize) noexcept
+// - <none>
+void CharRow::CopyFrom(const CharRow& source)
 {
-    try
+    THROW_HR_IF(E_INVALIDARG, source.size() != size());
+
+    _storedGlyphs = source._storedGlyphs;
+    std::copy(source._data.begin(), source._data.end(), _data.begin());
+    SetWrapForced(source._wrapForced);
+    _doubleBytePadded = source._doubleBytePadded;
+}
+
+// Routine Description:
+// - copies a range of cells of another row, which may have a different width,
+//   along with the glyphs that they store.
+// Arguments:
+// - source - the row to copy from
+// - sourceColumn - the first column of source to copy
+// - count - the number of cells to copy
+// - column - the column of this row that receives the first cell
+// Return Value:
+// - <none>
+void CharRow::CopyCellsFrom(const CharRow& source, const size_t sourceColumn, const size_t count, const size_t column)
+{
+    THROW_HR_IF(E_INVALIDARG, sourceColumn + count > source.size() || column + count > size());
+
+    const auto from = source._data.subspan(sourceColumn, count);
+    const auto to = _data.subspan(column, count);
+    if (source._storedGlyphs.empty())
     {
-        const value_type insertVals;
-        _data.resize(newSize, insertVals);
+        std::copy(from.begin(), from.end(), to.begin());
+        return;
     }
-    CATCH_RETURN();
 
-    return S_OK;
+    // Cells are copied one at a time, so that the cells that weren't copied yet
+    // can't be mistaken for stored glyphs of this row if storing one compacts them.
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto& cell = til::at(from, i);
+        auto& copy = til::at(to, i);
+        copy = cell;
+        if (cell.DbcsAttr().IsGlyphStored())
+        {
+            _StoreGlyph(copy, source._GetStoredGlyph(cell));
+        }
+    }
+}
+
+// Routine Description:
+// - Writes characters that each take up one cell without a stored glyph,
+//   like printable ASCII, straight into the cells.
+// Arguments:
+// - chars - the characters, one per cell
+// - column - the first column to write to
+// Return Value:
+// - <none>
+void CharRow::WriteAscii(const std::wstring_view chars, const size_t column)
+{
+    THROW_HR_IF(E_INVALIDARG, column > size() || chars.size() > size() - column);
+
+    // Any glyphs stored for the overwritten cells are left behind until the table is compacted.
+    std::transform(chars.begin(), chars.end(), _data.begin() + column, [](const wchar_t wch) noexcept {
+        return value_type{ wch, DbcsAttribute{} };
+    });
+}
+
+// Routine Description:
+// - Fills a range of cells with a character that takes up one cell.
+// Arguments:
+// - wch - the character
+// - column - the first column to fill
+// - count - the number of columns to fill
+// Return Value:
+// - <none>
+void CharRow::FillCells(const wchar_t wch, const size_t column, const size_t count)
+{
+    THROW_HR_IF(E_INVALIDARG, column > size() || count > size() - column);
+    if (count == 0)
+    {
+        return;
+    }
+
+    // The cells are packed into 3 bytes each, which makes filling them one
+    // at a time slow. Instead the first cell is written and the filled cells
+    // are copied after themselves, doubling each time, which memcpy does with
+    // vector stores.
+    static_assert(std::is_trivially_copyable_v<value_type>);
+    const auto cells = _data.subspan(column, count);
+    til::at(cells, 0) = value_type{ wch, DbcsAttribute{} };
+    for (size_t filled = 1; filled < count;)
+    {
+        const auto chunk = std::min(filled, count - filled);
+        memcpy(cells.subspan(filled).data(), cells.data(), chunk * sizeof(value_type));
+        filled += chunk;
+    }
+
+    // Any glyphs stored for the overwritten cells are left behind until the
+    // table is compacted, unless none of the cells are left.
+    if (count == size())
+    {
+        _storedGlyphs.clear();
+    }
+}
+
+// Routine Description:
+// - Moves the row to new cells, which determine its new width. As many cells
+//   as fit are copied over and any beyond the old width are reset.
+//   The stored glyphs of cells that were cut off are dropped.
+// Arguments:
+// - cells - the row's cells in the new cell buffer
+// Return Value:
+// - <none>
+void CharRow::Resize(const gsl::span<value_type> cells) noexcept
+{
+    const auto copied = std::min(_data.size(), cells.size());
+    std::copy_n(_data.begin(), copied, cells.begin());
+    std::fill(cells.begin() + copied, cells.end(), value_type{});
+    _data = cells;
+
+    if (!_storedGlyphs.empty())
+    {
+        // If this fails, the glyphs of the cells that were cut off are just kept a little longer.
+        try
+        {
+            _CompactStoredGlyphs();
+        }
+        CATCH_LOG();
+    }
 }
 
 typename CharRow::iterator CharRow::begin() noexcept
@@ -120,7 +260,7 @@ typename CharRow::iterator CharRow::begin() noexcept
 
 typename CharRow::const_iterator CharRow::cbegin() const noexcept
 {
-    return _data.cbegin();
+    return gsl::span<const value_type>{ _data }.begin();
 }
 
 typename CharRow::iterator CharRow::end() noexcept
@@ -130,7 +270,7 @@ typename CharRow::iterator CharRow::end() noexcept
 
 typename CharRow::const_iterator CharRow::cend() const noexcept
 {
-    return _data.cend();
+    return gsl::span<const value_type>{ _data }.end();
 }
 
 // Routine Description:
@@ -141,12 +281,8 @@ typename CharRow::const_iterator CharRow::cend() const noexcept
 // - The calculated left boundary of the internal string.
 size_t CharRow::MeasureLeft() const
 {
-    std::vector<value_type>::const_iterator it = _data.cbegin();
-    while (it != _data.cend() && it->IsSpace())
-    {
-        ++it;
-    }
-    return it - _data.cbegin();
+    const auto it = std::find_if_not(_data.begin(), _data.end(), [](const value_type& cell) noexcept { return cell.IsSpace(); });
+    return it - _data.begin();
 }
 
 // Routine Description:
@@ -157,17 +293,13 @@ size_t CharRow::MeasureLeft() const
 // - The calculated right boundary of the internal string.
 size_t CharRow::MeasureRight() const noexcept
 {
-    std::vector<value_type>::const_reverse_iterator it = _data.crbegin();
-    while (it != _data.crend() && it->IsSpace())
-    {
-        ++it;
-    }
-    return _data.crend() - it;
+    const auto it = std::find_if_not(_data.rbegin(), _data.rend(), [](const value_type& cell) noexcept { return cell.IsSpace(); });
+    return _data.rend() - it;
 }
 
 void CharRow::ClearCell(const size_t column)
 {
-    _data.at(column).Reset();
+    _CellAt(column).Reset();
 }
 
 // Routine Description:
@@ -197,7 +329,7 @@ bool CharRow::ContainsText() const noexcept
 // Note: will throw exception if column is out of bounds
 const DbcsAttribute& CharRow::DbcsAttrAt(const size_t column) const
 {
-    return _data.at(column).DbcsAttr();
+    return _CellAt(column).DbcsAttr();
 }
 
 // Routine Description:
@@ -209,7 +341,7 @@ const DbcsAttribute& CharRow::DbcsAttrAt(const size_t column) const
 // Note: will throw exception if column is out of bounds
 DbcsAttribute& CharRow::DbcsAttrAt(const size_t column)
 {
-    return _data.at(column).DbcsAttr();
+    return _CellAt(column).DbcsAttr();
 }
 
 // Routine Description:
@@ -221,7 +353,7 @@ DbcsAttribute& CharRow::DbcsAttrAt(const size_t column)
 // Note: will throw exception if column is out of bounds
 void CharRow::ClearGlyph(const size_t column)
 {
-    _data.at(column).EraseChars();
+    _CellAt(column).EraseChars();
 }
 
 // Routine Description:
@@ -254,19 +386,39 @@ std::wstring CharRow::GetText() const
 {
     std::wstring wstr;
     wstr.reserve(_data.size());
+    AppendText(0, _data.size(), wstr);
+    return wstr;
+}
 
-    for (size_t i = 0; i < _data.size(); ++i)
+// Routine Description:
+// - Appends the glyphs of a range of cells to a string, reading the cells
+//   directly. The trailing halves of wide glyphs are left out.
+// Arguments:
+// - left - the first column
+// - right - the column after the last one
+// - text - the string to append to
+// Return Value:
+// - <none>
+void CharRow::AppendText(const size_t left, const size_t right, std::wstring& text) const
+{
+    THROW_HR_IF(E_INVALIDARG, left > right || right > _data.size());
+
+    for (const auto& cell : _data.subspan(left, right - left))
     {
-        const auto glyph = GlyphAt(i);
-        if (!DbcsAttrAt(i).IsTrailing())
+        if (cell.DbcsAttr().IsTrailing())
         {
-            for (const auto wch : glyph)
-            {
-                wstr.push_back(wch);
-            }
+            continue;
+        }
+
+        if (cell.DbcsAttr().IsGlyphStored())
+        {
+            text.append(_GetStoredGlyph(cell));
+        }
+        else
+        {
+            text.push_back(cell.Char());
         }
     }
-    return wstr;
 }
 
 // Method Description:
@@ -296,32 +448,90 @@ const DelimiterClass CharRow::DelimiterClassAt(const size_t column, const std::w
     }
 }
 
-UnicodeStorage& CharRow::GetUnicodeStorage() noexcept
+// Routine Description:
+// - gets the glyph that a cell holds in the row's stored glyphs
+// Arguments:
+// - cell - a cell of this row whose glyph is stored
+// Return Value:
+// - the glyph
+std::wstring_view CharRow::_GetStoredGlyph(const value_type& cell) const
 {
-    return _pParent->GetUnicodeStorage();
+    return _storedGlyphs.at(cell.Char());
 }
 
-const UnicodeStorage& CharRow::GetUnicodeStorage() const noexcept
+// Routine Description:
+// - stores a glyph that doesn't fit into a cell and makes the cell hold it.
+//   A new entry is used even if the cell held a stored glyph already, as a
+//   cell's attributes may have been copied from another cell and so point
+//   at a glyph it doesn't own.
+// Arguments:
+// - cell - the cell of this row to hold the glyph
+// - chars - the glyph
+// Return Value:
+// - <none>
+void CharRow::_StoreGlyph(value_type& cell, const std::wstring_view chars)
 {
-    return _pParent->GetUnicodeStorage();
+    // Every cell can hold at most one glyph, so once there are more than twice
+    // as many entries as cells, at least half of them must have been overwritten.
+    // This also keeps the indices far below what a cell can hold.
+    if (_storedGlyphs.size() >= 2 * _data.size())
+    {
+        cell.DbcsAttr().SetGlyphStored(false);
+        _CompactStoredGlyphs();
+    }
+
+    _storedGlyphs.emplace_back(chars);
+    cell.Char() = gsl::narrow_cast<wchar_t>(_storedGlyphs.size() - 1);
+    cell.DbcsAttr().SetGlyphStored(true);
 }
 
 // Routine Description:
-// - calculates the key used by the given column of the char row to store glyph data in UnicodeStorage
+// - drops the stored glyphs that no cell holds anymore. If this throws,
+//   the row is left unchanged.
 // Arguments:
-// - column - the column to generate the key for
+// - <none>
 // Return Value:
-// - the COORD key for data access from UnicodeStorage for the column
-COORD CharRow::GetStorageKey(const size_t column) const noexcept
+// - <none>
+void CharRow::_CompactStoredGlyphs()
 {
-    return { gsl::narrow<SHORT>(column), _pParent->GetId() };
+    const auto isStored = [&](const value_type& cell) noexcept {
+        return cell.DbcsAttr().IsGlyphStored() && cell.Char() < _storedGlyphs.size();
+    };
+
+    std::vector<std::wstring> glyphs;
+    glyphs.reserve(std::count_if(_data.begin(), _data.end(), isStored));
+
+    // Nothing below can throw, so the cells and entries are never left half renumbered.
+    for (auto& cell : _data)
+    {
+        if (isStored(cell))
+        {
+            glyphs.emplace_back(std::move(til::at(_storedGlyphs, cell.Char())));
+            cell.Char() = gsl::narrow_cast<wchar_t>(glyphs.size() - 1);
+        }
+        else if (cell.DbcsAttr().IsGlyphStored())
+        {
+            cell.EraseChars();
+        }
+    }
+    _storedGlyphs = std::move(glyphs);
 }
 
 // Routine Description:
-// - Updates the pointer to the parent row (which might change if we shuffle the rows around)
+// - returns the cell at column
 // Arguments:
-// - pParent - Pointer to the parent row
-void CharRow::UpdateParent(ROW* const pParent)
+// - column - column to get the cell for
+// Return Value:
+// - the cell
+// - Note: will throw exception if column is out of bounds
+CharRow::value_type& CharRow::_CellAt(const size_t column)
+{
+    THROW_HR_IF(E_INVALIDARG, column >= _data.size());
+    return til::at(_data, column);
+}
+
+const CharRow::value_type& CharRow::_CellAt(const size_t column) const
 {
-    _pParent = FAIL_FAST_IF_NULL(pParent);
+    THROW_HR_IF(E_INVALIDARG, column >= _data.size());
+    return til::at(_data, column);
 }
@@ -23,9 +23,6 @@ Revision History:
 #include "DbcsAttribute.hpp"
 #include "CharRowCellReference.hpp"
 #include "CharRowCell.hpp"
-#include "UnicodeStorage.hpp"
-
-class ROW;
 
 enum class DelimiterClass
 {
@@ -44,24 +41,44 @@ enum class DelimiterClass
 //       ^    ^                  ^                     ^
 //       |    |                  |                     |
 //     Chars Left               Right                end of Chars buffer
+//
+// The cells aren't owned by the CharRow. They're a view into the cell buffer
+// that the TextBuffer allocates for all of its rows at once.
+//
+// Glyphs that don't fit into a single wchar_t, like surrogate pairs and
+// combining sequences, are kept in a side table of the row instead. A cell
+// whose glyph is stored there holds the glyph's index into the table in place
+// of a character, so the glyphs move along with their row.
+class TextBuffer;
+
 class CharRow final
 {
 public:
     using glyph_type = typename wchar_t;
     using value_type = typename CharRowCell;
-    using iterator = typename std::vector<value_type>::iterator;
-    using const_iterator = typename std::vector<value_type>::const_iterator;
+    using iterator = typename gsl::span<value_type>::iterator;
+    using const_iterator = typename gsl::span<const value_type>::iterator;
     using reference = typename CharRowCellReference;
 
-    CharRow(size_t rowWidth, ROW* const pParent);
+    CharRow(const gsl::span<value_type> cells, TextBuffer* const pParent, const size_t rowIndex);
+
+    CharRow(const CharRow&) = delete;
+    CharRow& operator=(const CharRow&) = delete;
+    CharRow(CharRow&&) noexcept = default;
+    CharRow& operator=(CharRow&&) noexcept = default;
 
+    void SetRowIndex(const size_t rowIndex) noexcept;
     void SetWrapForced(const bool wrap) noexcept;
     bool WasWrapForced() const noexcept;
     void SetDoubleBytePadded(const bool doubleBytePadded) noexcept;
     bool WasDoubleBytePadded() const noexcept;
     size_t size() const noexcept;
     void Reset() noexcept;
-    [[nodiscard]] HRESULT Resize(const size_t newSize) noexcept;
+    void CopyFrom(const CharRow& source);
+    void CopyCellsFrom(const CharRow& source, const size_t sourceColumn, const size_t count, const size_t column);
+    void WriteAscii(const std::wstring_view chars, const size_t column);
+    void FillCells(const wchar_t wch, const size_t column, const size_t count);
+    void Resize(const gsl::span<value_type> cells) noexcept;
     size_t MeasureLeft() const;
     size_t MeasureRight() const noexcept;
     void ClearCell(const size_t column);
@@ -70,6 +87,7 @@ public:
     DbcsAttribute& DbcsAttrAt(const size_t column);
     void ClearGlyph(const size_t column);
     std::wstring GetText() const;
+    void AppendText(const size_t left, const size_t right, std::wstring& text) const;
 
     const DelimiterClass DelimiterClassAt(const size_t column, const std::wstring_view wordDelimiters) const;
 
@@ -84,34 +102,48 @@ public:
     iterator end() noexcept;
     const_iterator cend() const noexcept;
 
-    UnicodeStorage& GetUnicodeStorage() noexcept;
-    const UnicodeStorage& GetUnicodeStorage() const noexcept;
-    COORD GetStorageKey(const size_t column) const noexcept;
-
-    void UpdateParent(ROW* const pParent);
-
     friend CharRowCellReference;
-    friend constexpr bool operator==(const CharRow& a, const CharRow& b) noexcept;
+    friend bool operator==(const CharRow& a, const CharRow& b) noexcept;
 
 protected:
+    value_type& _CellAt(const size_t column);
+    const value_type& _CellAt(const size_t column) const;
+
+    std::wstring_view _GetStoredGlyph(const value_type& cell) const;
+    void _StoreGlyph(value_type& cell, const std::wstring_view chars);
+    void _CompactStoredGlyphs();
+
     // Occurs when the user runs out of text in a given row and we're forced to wrap the cursor to the next line
     bool _wrapForced;
 
     // Occurs when the user runs out of text to support a double byte character and we're forced to the next line
     bool _doubleBytePadded;
 
-    // storage for glyph data and dbcs attributes
-    std::vector<value_type> _data;
+    // glyph data and dbcs attributes, stored in the TextBuffer's cell buffer
+    gsl::span<value_type> _data;
+
+    // The text buffer that this row belongs to, which is told when the row's wrap status changes.
+    // Rows that aren't part of a text buffer don't have one.
+    TextBuffer* _pParent;
+
+    // The index of the row in the text buffer's storage, which it passes along with the notification.
+    // It belongs to the place in the storage, so the text buffer updates it when it moves rows around.
+    size_t _rowIndex;
+
+    // glyphs that don't fit into a cell, indexed by the cells that hold them.
+    // Overwritten glyphs are left behind until the table is compacted.
+    std::vector<std::wstring> _storedGlyphs;
 
-    // ROW that this CharRow belongs to
-    ROW* _pParent;
+#ifdef UNIT_TESTING
+    friend class TextBufferTests;
+#endif
 };
 
-constexpr bool operator==(const CharRow& a, const CharRow& b) noexcept
+inline bool operator==(const CharRow& a, const CharRow& b) noexcept
 {
     return (a._wrapForced == b._wrapForced &&
             a._doubleBytePadded == b._doubleBytePadded &&
-            a._data == b._data);
+            std::equal(a._data.begin(), a._data.end(), b._data.begin(), b._data.end()));
 }
 
 template<typename InputIt1, typename InputIt2>
@@ -67,7 +67,7 @@ const DbcsAttribute& CharRowCell::DbcsAttr() const noexcept
 }
 
 // Routine Description:
-// - Access the cell's wchar field. this does not access any char data through UnicodeStorage.
+// - Access the cell's wchar field. this does not access any glyph data stored in the row.
 // Return Value:
 // - the cell's wchar field
 wchar_t& CharRowCell::Char() noexcept
@@ -76,7 +76,7 @@ wchar_t& CharRowCell::Char() noexcept
 }
 
 // Routine Description:
-// - Access the cell's wchar field. this does not access any char data through UnicodeStorage.
+// - Access the cell's wchar field. this does not access any glyph data stored in the row.
 // Return Value:
 // - the cell's wchar field
 const wchar_t& CharRowCell::Char() const noexcept
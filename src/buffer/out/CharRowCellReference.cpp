@@ -2,11 +2,10 @@
 // Licensed under the MIT license.
 
 #include "precomp.h"
-#include "UnicodeStorage.hpp"
 #include "CharRow.hpp"
 
 // Routine Description:
-// - assignment operator. will store extended glyph data in a separate storage location
+// - assignment operator. will store extended glyph data in the row's side table
 // Arguments:
 // - chars - the glyph data to store
 void CharRowCellReference::operator=(const std::wstring_view chars)
@@ -19,10 +18,7 @@ void CharRowCellReference::operator=(const std::wstring_view chars)
     }
     else
     {
-        auto& storage = _parent.GetUnicodeStorage();
-        const auto key = _parent.GetStorageKey(_index);
-        storage.StoreGlyph(key, { chars.cbegin(), chars.cend() });
-        _cellData().DbcsAttr().SetGlyphStored(true);
+        _parent._StoreGlyph(_cellData(), chars);
     }
 }
 
@@ -41,7 +37,8 @@ CharRowCellReference::operator std::wstring_view() const
 // - ref to the CharRowCell
 CharRowCell& CharRowCellReference::_cellData()
 {
-    return _parent._data.at(_index);
+    // The index was checked when the reference was created by CharRow::GlyphAt.
+    return til::at(_parent._data, _index);
 }
 
 // Routine Description:
@@ -50,7 +47,7 @@ CharRowCell& CharRowCellReference::_cellData()
 // - ref to the CharRowCell
 const CharRowCell& CharRowCellReference::_cellData() const
 {
-    return _parent._data.at(_index);
+    return til::at(_parent._data, _index);
 }
 
 // Routine Description:
@@ -61,9 +58,7 @@ std::wstring_view CharRowCellReference::_glyphData() const
 {
     if (_cellData().DbcsAttr().IsGlyphStored())
     {
-        const auto& text = _parent.GetUnicodeStorage().GetText(_parent.GetStorageKey(_index));
-
-        return { text.data(), text.size() };
+        return _parent._GetStoredGlyph(_cellData());
     }
     else
     {
@@ -79,7 +74,7 @@ CharRowCellReference::const_iterator CharRowCellReference::begin() const
 {
     if (_cellData().DbcsAttr().IsGlyphStored())
     {
-        return _parent.GetUnicodeStorage().GetText(_parent.GetStorageKey(_index)).data();
+        return _parent._GetStoredGlyph(_cellData()).data();
     }
     else
     {
@@ -98,7 +93,7 @@ CharRowCellReference::const_iterator CharRowCellReference::end() const
 {
     if (_cellData().DbcsAttr().IsGlyphStored())
     {
-        const auto& chars = _parent.GetUnicodeStorage().GetText(_parent.GetStorageKey(_index));
+        const auto chars = _parent._GetStoredGlyph(_cellData());
         return chars.data() + chars.size();
     }
     else
@@ -125,8 +120,8 @@ bool operator==(const CharRowCellReference& ref, const std::vector<wchar_t>& gly
     }
     else
     {
-        const auto& chars = ref._parent.GetUnicodeStorage().GetText(ref._parent.GetStorageKey(ref._index));
-        return chars == glyph;
+        const auto chars = ref._glyphData();
+        return std::equal(chars.begin(), chars.end(), glyph.begin(), glyph.end());
     }
 }
 
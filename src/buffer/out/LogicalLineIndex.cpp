@@ -0,0 +1,149 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "LogicalLineIndex.hpp"
+
+#pragma hdrstop
+
+LogicalLineIndex::LogicalLineIndex() noexcept :
+    _words{},
+    _rows{ 0 }
+{
+}
+
+// Routine Description:
+// - Sets the number of rows and marks all of them as not wrapping.
+// Arguments:
+// - rows - The number of rows of the storage.
+// Return Value:
+// - <none>
+void LogicalLineIndex::Reset(const size_t rows)
+{
+    _words.assign((rows + WordBits - 1) / WordBits, 0);
+    _rows = rows;
+}
+
+// Routine Description:
+// - Sets whether a row wraps into the row below it.
+// Arguments:
+// - index - The storage index of the row. Rows beyond the storage are ignored.
+// - wrapped - Whether its text wrapped off its end.
+// Return Value:
+// - <none>
+void LogicalLineIndex::SetWrapped(const size_t index, const bool wrapped) noexcept
+{
+    if (index >= _rows)
+    {
+        return;
+    }
+
+    auto& word = til::at(_words, index / WordBits);
+    const auto bit = word_type{ 1 } << (index % WordBits);
+    word = wrapped ? word | bit : word & ~bit;
+}
+
+bool LogicalLineIndex::IsWrapped(const size_t index) const noexcept
+{
+    if (index >= _rows)
+    {
+        return false;
+    }
+
+    return (til::at(_words, index / WordBits) >> (index % WordBits)) & 1;
+}
+
+// Routine Description:
+// - Swaps the flags of two rows, when the rows trade places in the storage.
+// Arguments:
+// - a, b - The storage indices of the rows.
+// Return Value:
+// - <none>
+void LogicalLineIndex::Swap(const size_t a, const size_t b) noexcept
+{
+    const auto wrappedA = IsWrapped(a);
+    SetWrapped(a, IsWrapped(b));
+    SetWrapped(b, wrappedA);
+}
+
+// Routine Description:
+// - Counts the rows right above a row that wrap, going up and around the
+//   start of the storage until a row doesn't wrap. That row ends the
+//   logical line before the given row's.
+// Arguments:
+// - index - The storage index of the row.
+// - limit - The most rows to count, usually the number of rows above the row.
+// Return Value:
+// - The number of rows.
+size_t LogicalLineIndex::CountWrappedBefore(const size_t index, const size_t limit) const noexcept
+{
+    size_t count = 0;
+    auto end = std::min(index, _rows);
+    while (count < limit && _rows != 0)
+    {
+        if (end == 0)
+        {
+            end = _rows;
+        }
+
+        // The rows up to the start of the word, the start of the storage or the limit, whichever comes first.
+        const auto bit = (end - 1) % WordBits;
+        const auto available = std::min(bit + 1, limit - count);
+        // The bits of the rows not above end are shifted out, and the flags are flipped, so the nearest unwrapped row is the highest one.
+        const auto unwrapped = static_cast<word_type>(~(til::at(_words, (end - 1) / WordBits) << (WordBits - 1 - bit)));
+
+        unsigned long highest;
+        const auto run = _BitScanReverse(&highest, unwrapped) ? WordBits - 1 - highest : WordBits;
+        if (run < available)
+        {
+            return count + run;
+        }
+
+        count += available;
+        end -= available;
+    }
+    return count;
+}
+
+// Routine Description:
+// - Counts the rows from a row on that wrap, going down and around the end
+//   of the storage until a row doesn't wrap. That row ends the row's
+//   logical line.
+// Arguments:
+// - index - The storage index of the row.
+// - limit - The most rows to count, usually the number of rows from the row on.
+// Return Value:
+// - The number of rows.
+size_t LogicalLineIndex::CountWrappedFrom(const size_t index, const size_t limit) const noexcept
+{
+    size_t count = 0;
+    auto begin = index < _rows ? index : 0;
+    while (count < limit && _rows != 0)
+    {
+        // The rows up to the end of the word, the end of the storage or the limit, whichever comes first.
+        const auto bit = begin % WordBits;
+        const auto available = std::min({ WordBits - bit, _rows - begin, limit - count });
+        // The bits of the rows before begin are shifted out, and the flags are flipped, so the nearest unwrapped row is the lowest one.
+        const auto unwrapped = static_cast<word_type>(~(til::at(_words, begin / WordBits) >> bit));
+
+        unsigned long lowest;
+        const auto run = _BitScanForward(&lowest, unwrapped) ? lowest : WordBits;
+        if (run < available)
+        {
+            return count + run;
+        }
+
+        count += available;
+        begin += available;
+        if (begin == _rows)
+        {
+            begin = 0;
+        }
+    }
+    return count;
+}
+
+size_t LogicalLineIndex::size() const noexcept
+{
+    return _rows;
+}
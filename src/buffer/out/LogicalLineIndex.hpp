@@ -0,0 +1,40 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- LogicalLineIndex.hpp
+
+Abstract:
+- Keeps track of which rows of a TextBuffer wrap into the row below them, so
+  that logical lines (the rows that are joined because text wrapped off
+  their end) can be found without visiting each of their rows.
+- Rows are identified by their index into the buffer's storage, which is
+  circular, so the index doesn't change as the buffer scrolls. The flags
+  are packed into words, so a line is scanned a word of rows at a time.
+--*/
+
+#pragma once
+
+class LogicalLineIndex final
+{
+public:
+    LogicalLineIndex() noexcept;
+
+    void Reset(const size_t rows);
+    void SetWrapped(const size_t index, const bool wrapped) noexcept;
+    bool IsWrapped(const size_t index) const noexcept;
+    void Swap(const size_t a, const size_t b) noexcept;
+
+    size_t CountWrappedBefore(const size_t index, const size_t limit) const noexcept;
+    size_t CountWrappedFrom(const size_t index, const size_t limit) const noexcept;
+
+    size_t size() const noexcept;
+
+private:
+    using word_type = uint32_t;
+    static constexpr size_t WordBits = sizeof(word_type) * CHAR_BIT;
+
+    std::vector<word_type> _words;
+    size_t _rows;
+};
@@ -0,0 +1,892 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "PatternMatcher.hpp"
+
+#pragma hdrstop
+
+namespace
+{
+    // Repeats are compiled by copying what's repeated, so large counts would
+    // make large programs. Patterns with more are left to std::wregex.
+    constexpr size_t MaxRepeat = 256;
+    constexpr size_t MaxProgramSize = 16384;
+    constexpr size_t Unbounded = SIZE_MAX;
+}
+
+// The parser builds a tree out of the pattern, which PatternMatcher then compiles.
+// It gives up on anything it doesn't understand, so that std::wregex can take over.
+class PatternMatcher::Parser final
+{
+public:
+    enum class Kind
+    {
+        Char,
+        Class,
+        Any,
+        Concat,
+        Alternate,
+        Repeat,
+        LineStart,
+        LineEnd,
+        WordBoundary,
+        NotWordBoundary
+    };
+
+    struct Node
+    {
+        Kind kind;
+        wchar_t ch = 0;
+        size_t cls = 0;
+        size_t min = 0;
+        size_t max = 0;
+        bool greedy = true;
+        std::vector<Node> children;
+    };
+
+    Parser(const std::wstring_view pattern, const std::regex_traits<wchar_t>& traits, std::vector<CharClass>& classes) noexcept :
+        _pattern{ pattern },
+        _pos{ 0 },
+        _traits{ traits },
+        _classes{ classes }
+    {
+    }
+
+    std::optional<Node> Parse()
+    {
+        auto node = _ParseAlternation();
+        if (!node || _pos != _pattern.size())
+        {
+            return std::nullopt;
+        }
+        return node;
+    }
+
+private:
+    bool _AtEnd() const noexcept
+    {
+        return _pos >= _pattern.size();
+    }
+
+    wchar_t _Peek() const noexcept
+    {
+        return _AtEnd() ? L'\0' : til::at(_pattern, _pos);
+    }
+
+    bool _Consume(const wchar_t wch) noexcept
+    {
+        if (!_AtEnd() && _Peek() == wch)
+        {
+            ++_pos;
+            return true;
+        }
+        return false;
+    }
+
+    std::optional<Node> _ParseAlternation()
+    {
+        Node alternate{ Kind::Alternate };
+        do
+        {
+            auto alternative = _ParseAlternative();
+            if (!alternative)
+            {
+                return std::nullopt;
+            }
+            alternate.children.emplace_back(std::move(*alternative));
+        } while (_Consume(L'|'));
+
+        if (alternate.children.size() == 1)
+        {
+            return std::move(alternate.children.front());
+        }
+        return alternate;
+    }
+
+    std::optional<Node> _ParseAlternative()
+    {
+        Node concat{ Kind::Concat };
+        while (!_AtEnd() && _Peek() != L'|' && _Peek() != L')')
+        {
+            auto term = _ParseTerm();
+            if (!term)
+            {
+                return std::nullopt;
+            }
+            concat.children.emplace_back(std::move(*term));
+        }
+        return concat;
+    }
+
+    std::optional<Node> _ParseTerm()
+    {
+        std::optional<Node> atom;
+        switch (_Peek())
+        {
+        case L'^':
+            ++_pos;
+            return Node{ Kind::LineStart };
+        case L'$':
+            ++_pos;
+            return Node{ Kind::LineEnd };
+        case L'\\':
+            if (_pos + 1 < _pattern.size() && (til::at(_pattern, _pos + 1) == L'b' || til::at(_pattern, _pos + 1) == L'B'))
+            {
+                const auto kind = til::at(_pattern, _pos + 1) == L'b' ? Kind::WordBoundary : Kind::NotWordBoundary;
+                _pos += 2;
+                return Node{ kind };
+            }
+            ++_pos;
+            atom = _ParseEscape();
+            break;
+        case L'(':
+            ++_pos;
+            // Non-capturing groups are fine, as only the whole match is reported.
+            // Lookaheads aren't.
+            if (_Consume(L'?') && !_Consume(L':'))
+            {
+                return std::nullopt;
+            }
+            atom = _ParseAlternation();
+            if (!atom || !_Consume(L')'))
+            {
+                return std::nullopt;
+            }
+            break;
+        case L'[':
+            ++_pos;
+            atom = _ParseClass();
+            break;
+        case L'.':
+            ++_pos;
+            atom = Node{ Kind::Any };
+            break;
+        case L'*':
+        case L'+':
+        case L'?':
+        case L'{':
+        case L'}':
+        case L']':
+            // Quantifiers with nothing to repeat are errors, and the rest are
+            // read differently by different implementations.
+            return std::nullopt;
+        default:
+            atom = Node{ Kind::Char, _Peek() };
+            ++_pos;
+            break;
+        }
+
+        if (!atom)
+        {
+            return std::nullopt;
+        }
+        return _ParseQuantifier(std::move(*atom));
+    }
+
+    std::optional<Node> _ParseQuantifier(Node atom)
+    {
+        size_t min = 0;
+        size_t max = 0;
+        switch (_Peek())
+        {
+        case L'*':
+            ++_pos;
+            min = 0;
+            max = Unbounded;
+            break;
+        case L'+':
+            ++_pos;
+            min = 1;
+            max = Unbounded;
+            break;
+        case L'?':
+            ++_pos;
+            min = 0;
+            max = 1;
+            break;
+        case L'{':
+        {
+            ++_pos;
+            const auto lower = _ParseNumber();
+            if (!lower)
+            {
+                return std::nullopt;
+            }
+            min = *lower;
+            max = *lower;
+            if (_Consume(L','))
+            {
+                max = Unbounded;
+                if (_Peek() != L'}')
+                {
+                    const auto upper = _ParseNumber();
+                    if (!upper || *upper < min)
+                    {
+                        return std::nullopt;
+                    }
+                    max = *upper;
+                }
+            }
+            if (!_Consume(L'}') || min > MaxRepeat || (max != Unbounded && max > MaxRepeat))
+            {
+                return std::nullopt;
+            }
+            break;
+        }
+        default:
+            return atom;
+        }
+
+        Node repeat{ Kind::Repeat };
+        repeat.min = min;
+        repeat.max = max;
+        repeat.greedy = !_Consume(L'?');
+        repeat.children.emplace_back(std::move(atom));
+        return repeat;
+    }
+
+    std::optional<size_t> _ParseNumber() noexcept
+    {
+        size_t value = 0;
+        const auto start = _pos;
+        while (!_AtEnd() && _Peek() >= L'0' && _Peek() <= L'9')
+        {
+            value = value * 10 + (_Peek() - L'0');
+            if (value > MaxRepeat)
+            {
+                return std::nullopt;
+            }
+            ++_pos;
+        }
+        if (_pos == start)
+        {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    // Reads the escape after a backslash, outside of a class.
+    std::optional<Node> _ParseEscape()
+    {
+        if (const auto cls = _ParseClassEscape())
+        {
+            Node node{ Kind::Class };
+            node.cls = _classes.size();
+            _classes.push_back({ {}, { *cls }, false });
+            return node;
+        }
+        if (const auto wch = _ParseCharEscape())
+        {
+            return Node{ Kind::Char, *wch };
+        }
+        return std::nullopt;
+    }
+
+    // Reads \d, \w or \s, or their negations, after a backslash.
+    std::optional<std::pair<char_class_type, bool>> _ParseClassEscape()
+    {
+        const auto wch = _Peek();
+        const auto lower = wch == L'D' ? L'd' : wch == L'W' ? L'w' : wch == L'S' ? L's' : wch;
+        if (lower != L'd' && lower != L'w' && lower != L's')
+        {
+            return std::nullopt;
+        }
+        ++_pos;
+        return std::make_pair(_traits.lookup_classname(&lower, &lower + 1), lower != wch);
+    }
+
+    // Reads an escaped character after a backslash.
+    std::optional<wchar_t> _ParseCharEscape()
+    {
+        if (_AtEnd())
+        {
+            return std::nullopt;
+        }
+
+        const auto wch = _Peek();
+        ++_pos;
+        switch (wch)
+        {
+        case L't':
+            return L'\t';
+        case L'n':
+            return L'\n';
+        case L'v':
+            return L'\v';
+        case L'f':
+            return L'\f';
+        case L'r':
+            return L'\r';
+        case L'0':
+            // \0 followed by more digits would be an octal or back-reference.
+            if (_Peek() >= L'0' && _Peek() <= L'9')
+            {
+                return std::nullopt;
+            }
+            return L'\0';
+        case L'c':
+            if ((_Peek() >= L'a' && _Peek() <= L'z') || (_Peek() >= L'A' && _Peek() <= L'Z'))
+            {
+                return gsl::narrow_cast<wchar_t>(til::at(_pattern, _pos++) % 32);
+            }
+            return std::nullopt;
+        case L'x':
+            return _ParseHex(2);
+        case L'u':
+            return _ParseHex(4);
+        default:
+            // Only punctuation can be escaped to stand for itself. Escaped
+            // letters and digits have meanings that aren't supported here.
+            if (wch < 0x80 && !std::iswalnum(wch) && wch != L'_')
+            {
+                return wch;
+            }
+            return std::nullopt;
+        }
+    }
+
+    std::optional<wchar_t> _ParseHex(const size_t digits) noexcept
+    {
+        if (_pos + digits > _pattern.size())
+        {
+            return std::nullopt;
+        }
+
+        unsigned int value = 0;
+        for (size_t i = 0; i < digits; ++i)
+        {
+            const auto wch = til::at(_pattern, _pos + i);
+            unsigned int digit = 0;
+            if (wch >= L'0' && wch <= L'9')
+            {
+                digit = wch - L'0';
+            }
+            else if (wch >= L'a' && wch <= L'f')
+            {
+                digit = wch - L'a' + 10;
+            }
+            else if (wch >= L'A' && wch <= L'F')
+            {
+                digit = wch - L'A' + 10;
+            }
+            else
+            {
+                return std::nullopt;
+            }
+            value = value * 16 + digit;
+        }
+        _pos += digits;
+        return gsl::narrow_cast<wchar_t>(value);
+    }
+
+    // Reads a class after its opening bracket.
+    std::optional<Node> _ParseClass()
+    {
+        CharClass cls{};
+        cls.negated = _Consume(L'^');
+
+        while (!_AtEnd() && _Peek() != L']')
+        {
+            // [:alpha:] and friends aren't supported.
+            if (_Peek() == L'[' && _pos + 1 < _pattern.size())
+            {
+                const auto next = til::at(_pattern, _pos + 1);
+                if (next == L':' || next == L'.' || next == L'=')
+                {
+                    return std::nullopt;
+                }
+            }
+
+            bool isClass = false;
+            const auto first = _ParseClassAtom(cls, isClass);
+            if (!first)
+            {
+                return std::nullopt;
+            }
+            if (isClass)
+            {
+                continue;
+            }
+
+            // A dash before the closing bracket stands for itself.
+            if (_Peek() == L'-' && _pos + 1 < _pattern.size() && til::at(_pattern, _pos + 1) != L']')
+            {
+                ++_pos;
+                const auto last = _ParseClassAtom(cls, isClass);
+                if (!last || isClass || *last < *first)
+                {
+                    return std::nullopt;
+                }
+                cls.ranges.emplace_back(*first, *last);
+            }
+            else
+            {
+                cls.ranges.emplace_back(*first, *first);
+            }
+        }
+
+        if (!_Consume(L']'))
+        {
+            return std::nullopt;
+        }
+
+        Node node{ Kind::Class };
+        node.cls = _classes.size();
+        _classes.emplace_back(std::move(cls));
+        return node;
+    }
+
+    // Reads a character of a class, or adds an escaped class like \d to it.
+    std::optional<wchar_t> _ParseClassAtom(CharClass& cls, bool& isClass)
+    {
+        isClass = false;
+        const auto wch = _Peek();
+        ++_pos;
+        if (wch != L'\\')
+        {
+            return wch;
+        }
+
+        if (const auto escaped = _ParseClassEscape())
+        {
+            cls.classes.emplace_back(*escaped);
+            isClass = true;
+            return L'\0';
+        }
+        if (_Consume(L'b'))
+        {
+            return L'\b';
+        }
+        if (_Consume(L'-'))
+        {
+            return L'-';
+        }
+        return _ParseCharEscape();
+    }
+
+    std::wstring_view _pattern;
+    size_t _pos;
+    const std::regex_traits<wchar_t>& _traits;
+    std::vector<CharClass>& _classes;
+};
+
+// Routine Description:
+// - Compiles a pattern.
+// Arguments:
+// - pattern - The pattern, in the ECMAScript syntax of std::wregex.
+// Return Value:
+// - <none>, but throws std::regex_error if the pattern isn't valid.
+PatternMatcher::PatternMatcher(const std::wstring_view pattern) :
+    _traits{},
+    _wordClass{},
+    _program{},
+    _classes{},
+    _firstInstructions{},
+    _current{},
+    _next{},
+    _marks{},
+    _stack{},
+    _generation{ 0 },
+    _fallback{}
+{
+    const wchar_t word = L'w';
+    _wordClass = _traits.lookup_classname(&word, &word + 1);
+
+    if (!_Compile(pattern))
+    {
+        _program.clear();
+        _classes.clear();
+        _firstInstructions.clear();
+        _fallback.emplace(pattern.data(), pattern.size());
+    }
+}
+
+// Routine Description:
+// - Parses the pattern and compiles it into a program.
+// Arguments:
+// - pattern - The pattern.
+// Return Value:
+// - False if the pattern uses something that can't be compiled.
+bool PatternMatcher::_Compile(const std::wstring_view pattern)
+{
+    using Node = Parser::Node;
+
+    const auto root = Parser{ pattern, _traits, _classes }.Parse();
+    if (!root)
+    {
+        return false;
+    }
+
+    const auto emit = [this](const Opcode op, const wchar_t ch = 0, const size_t x = 0, const size_t y = 0) {
+        _program.push_back({ op, ch, x, y });
+        return _program.size() - 1;
+    };
+
+    // Splits prefer their first target, which is what makes the program find
+    // the same match that a backtracking matcher would have tried first.
+    const std::function<bool(const Node&)> compile = [&](const Node& node) {
+        if (_program.size() > MaxProgramSize)
+        {
+            return false;
+        }
+
+        switch (node.kind)
+        {
+        case Parser::Kind::Char:
+            emit(Opcode::Char, node.ch);
+            return true;
+        case Parser::Kind::Class:
+            emit(Opcode::Class, 0, node.cls);
+            return true;
+        case Parser::Kind::Any:
+            emit(Opcode::Any);
+            return true;
+        case Parser::Kind::LineStart:
+            emit(Opcode::LineStart);
+            return true;
+        case Parser::Kind::LineEnd:
+            emit(Opcode::LineEnd);
+            return true;
+        case Parser::Kind::WordBoundary:
+            emit(Opcode::WordBoundary);
+            return true;
+        case Parser::Kind::NotWordBoundary:
+            emit(Opcode::NotWordBoundary);
+            return true;
+        case Parser::Kind::Concat:
+            return std::all_of(node.children.begin(), node.children.end(), compile);
+        case Parser::Kind::Alternate:
+        {
+            std::vector<size_t> jumps;
+            for (size_t i = 0; i < node.children.size(); ++i)
+            {
+                const auto isLast = i + 1 == node.children.size();
+                const auto split = isLast ? 0 : emit(Opcode::Split);
+                if (!compile(til::at(node.children, i)))
+                {
+                    return false;
+                }
+                if (!isLast)
+                {
+                    jumps.push_back(emit(Opcode::Jump));
+                    til::at(_program, split).x = split + 1;
+                    til::at(_program, split).y = _program.size();
+                }
+            }
+            for (const auto jump : jumps)
+            {
+                til::at(_program, jump).x = _program.size();
+            }
+            return true;
+        }
+        case Parser::Kind::Repeat:
+        {
+            const auto& child = node.children.front();
+            for (size_t i = 0; i < node.min; ++i)
+            {
+                if (!compile(child))
+                {
+                    return false;
+                }
+            }
+
+            const auto branch = [&](const size_t split, const size_t body, const size_t skip) {
+                til::at(_program, split).x = node.greedy ? body : skip;
+                til::at(_program, split).y = node.greedy ? skip : body;
+            };
+
+            if (node.max == Unbounded)
+            {
+                const auto split = emit(Opcode::Split);
+                if (!compile(child))
+                {
+                    return false;
+                }
+                emit(Opcode::Jump, 0, split);
+                branch(split, split + 1, _program.size());
+                return true;
+            }
+
+            // Each optional copy can only be tried after the one before it.
+            std::vector<size_t> splits;
+            for (auto i = node.min; i < node.max; ++i)
+            {
+                splits.push_back(emit(Opcode::Split));
+                if (!compile(child))
+                {
+                    return false;
+                }
+            }
+            for (const auto split : splits)
+            {
+                branch(split, split + 1, _program.size());
+            }
+            return true;
+        }
+        }
+        return false;
+    };
+
+    if (!compile(*root) || _program.size() > MaxProgramSize)
+    {
+        return false;
+    }
+    emit(Opcode::Match);
+
+    // Find the instructions that a match can start with, so that the search
+    // can skip over text that none of them accept. Assertions are assumed to
+    // pass, which only means that fewer characters get skipped. Empty matches
+    // are never found, so every match starts with one of them.
+    std::vector<bool> seen(_program.size());
+    std::vector<size_t> pending{ 0 };
+    while (!pending.empty())
+    {
+        const auto pc = pending.back();
+        pending.pop_back();
+        if (seen.at(pc))
+        {
+            continue;
+        }
+        seen.at(pc) = true;
+
+        const auto& instruction = til::at(_program, pc);
+        switch (instruction.op)
+        {
+        case Opcode::Split:
+            pending.push_back(instruction.y);
+            pending.push_back(instruction.x);
+            break;
+        case Opcode::Jump:
+            pending.push_back(instruction.x);
+            break;
+        case Opcode::LineStart:
+        case Opcode::LineEnd:
+        case Opcode::WordBoundary:
+        case Opcode::NotWordBoundary:
+            pending.push_back(pc + 1);
+            break;
+        case Opcode::Match:
+            break;
+        default:
+            _firstInstructions.push_back(pc);
+            break;
+        }
+    }
+    return true;
+}
+
+// Routine Description:
+// - Whether the pattern was compiled, rather than left to std::wregex.
+bool PatternMatcher::IsCompiled() const noexcept
+{
+    return !_fallback.has_value();
+}
+
+bool PatternMatcher::_IsWordChar(const wchar_t wch) const
+{
+    return wch == L'_' || _traits.isctype(wch, _wordClass);
+}
+
+bool PatternMatcher::_Accepts(const Instruction& instruction, const wchar_t wch) const
+{
+    switch (instruction.op)
+    {
+    case Opcode::Char:
+        return wch == instruction.ch;
+    case Opcode::Any:
+        return wch != L'\n' && wch != L'\r';
+    case Opcode::Class:
+    {
+        const auto& cls = til::at(_classes, instruction.x);
+        auto found = std::any_of(cls.ranges.begin(), cls.ranges.end(), [=](const auto& range) {
+            return wch >= range.first && wch <= range.second;
+        });
+        found = found || std::any_of(cls.classes.begin(), cls.classes.end(), [&](const auto& escaped) {
+                    return _traits.isctype(wch, escaped.first) != escaped.second;
+                });
+        return found != cls.negated;
+    }
+    default:
+        return false;
+    }
+}
+
+bool PatternMatcher::_CanStartWith(const wchar_t wch) const
+{
+    return std::any_of(_firstInstructions.begin(), _firstInstructions.end(), [&](const auto pc) {
+        return _Accepts(til::at(_program, pc), wch);
+    });
+}
+
+// Routine Description:
+// - Adds a thread to a list, following the instructions that don't consume
+//   a character until it gets to ones that do. The threads are added in the
+//   order that a backtracking matcher would try them in.
+// Arguments:
+// - threads - The list of threads, as pairs of instruction and where their match started.
+// - pc - The instruction the thread is at.
+// - start - Where the thread's match started.
+// - text - The text being searched.
+// - pos - The position in the text that the list is for.
+// Return Value:
+// - <none>
+void PatternMatcher::_AddThread(std::vector<std::pair<size_t, size_t>>& threads, const size_t pc, const size_t start, const std::wstring_view text, const size_t pos) const
+{
+    const auto wordBefore = pos > 0 && _IsWordChar(til::at(text, pos - 1));
+    const auto wordAfter = pos < text.size() && _IsWordChar(til::at(text, pos));
+
+    _stack.clear();
+    _stack.push_back(pc);
+    while (!_stack.empty())
+    {
+        const auto current = _stack.back();
+        _stack.pop_back();
+        if (til::at(_marks, current) == _generation)
+        {
+            continue;
+        }
+        til::at(_marks, current) = _generation;
+
+        const auto& instruction = til::at(_program, current);
+        switch (instruction.op)
+        {
+        case Opcode::Split:
+            _stack.push_back(instruction.y);
+            _stack.push_back(instruction.x);
+            break;
+        case Opcode::Jump:
+            _stack.push_back(instruction.x);
+            break;
+        case Opcode::LineStart:
+            if (pos == 0)
+            {
+                _stack.push_back(current + 1);
+            }
+            break;
+        case Opcode::LineEnd:
+            if (pos == text.size())
+            {
+                _stack.push_back(current + 1);
+            }
+            break;
+        case Opcode::WordBoundary:
+            if (wordBefore != wordAfter)
+            {
+                _stack.push_back(current + 1);
+            }
+            break;
+        case Opcode::NotWordBoundary:
+            if (wordBefore == wordAfter)
+            {
+                _stack.push_back(current + 1);
+            }
+            break;
+        default:
+            threads.emplace_back(current, start);
+            break;
+        }
+    }
+}
+
+// Routine Description:
+// - Finds the first match in the text at or after an offset. Of the matches
+//   that start there, it's the one std::wregex would find. Empty matches
+//   aren't found, as there's nothing in them to show.
+// Arguments:
+// - text - The text to search. The text before the offset is looked at by
+//   the assertions, as if std::regex_constants::match_prev_avail was passed.
+// - offset - Where to start searching.
+// Return Value:
+// - The start and end of the match, or nullopt if there isn't one.
+std::optional<std::pair<size_t, size_t>> PatternMatcher::Find(const std::wstring_view text, const size_t offset) const
+{
+    if (offset > text.size())
+    {
+        return std::nullopt;
+    }
+
+    if (_fallback)
+    {
+        auto flags = std::regex_constants::match_not_null;
+        if (offset > 0)
+        {
+            flags |= std::regex_constants::match_prev_avail;
+        }
+        std::wcmatch match;
+        if (!std::regex_search(text.data() + offset, text.data() + text.size(), match, *_fallback, flags))
+        {
+            return std::nullopt;
+        }
+        const auto start = offset + gsl::narrow_cast<size_t>(match.position(0));
+        return std::make_pair(start, start + gsl::narrow_cast<size_t>(match.length(0)));
+    }
+
+    _marks.resize(_program.size(), 0);
+    _current.clear();
+
+    std::optional<std::pair<size_t, size_t>> match;
+    for (auto pos = offset;; ++pos)
+    {
+        if (!match)
+        {
+            // With nothing in flight, skip ahead to where a match could start.
+            if (_current.empty())
+            {
+                while (pos < text.size() && !_CanStartWith(til::at(text, pos)))
+                {
+                    ++pos;
+                }
+            }
+
+            // A new thread starting here comes after the ones that started
+            // earlier, since those matches would be found first.
+            if (_current.empty())
+            {
+                ++_generation;
+            }
+            _AddThread(_current, 0, pos, text, pos);
+        }
+
+        if (_current.empty())
+        {
+            if (match || pos >= text.size())
+            {
+                break;
+            }
+            continue;
+        }
+
+        ++_generation;
+        _next.clear();
+        for (const auto& [pc, start] : _current)
+        {
+            const auto& instruction = til::at(_program, pc);
+            if (instruction.op == Opcode::Match)
+            {
+                // Empty matches are passed over, as if by match_not_null.
+                if (start == pos)
+                {
+                    continue;
+                }
+
+                // The threads after this one would only find matches that
+                // a backtracking matcher wouldn't get to.
+                match = std::make_pair(start, pos);
+                break;
+            }
+            if (pos < text.size() && _Accepts(instruction, til::at(text, pos)))
+            {
+                _AddThread(_next, pc + 1, start, text, pos + 1);
+            }
+        }
+        std::swap(_current, _next);
+
+        if (pos >= text.size())
+        {
+            break;
+        }
+    }
+    return match;
+}
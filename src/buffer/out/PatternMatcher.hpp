@@ -0,0 +1,89 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- PatternMatcher.hpp
+
+Abstract:
+- A compiled regular expression that the text buffer looks for patterns with.
+- Patterns are compiled once into a program that's run over the text in a
+  single pass, following every way the pattern can match at once (a Pike
+  VM), so the time taken only grows linearly with the length of the text.
+  The match found is the same one std::wregex would find.
+- Only the parts of the ECMAScript syntax that don't need backtracking are
+  compiled this way: characters, classes, groups, alternatives, quantifiers
+  and the ^, $, \b and \B assertions. Patterns with back-references or
+  lookaheads are matched with std::wregex instead.
+--*/
+
+#pragma once
+
+class PatternMatcher final
+{
+public:
+    explicit PatternMatcher(const std::wstring_view pattern);
+
+    std::optional<std::pair<size_t, size_t>> Find(const std::wstring_view text, const size_t offset) const;
+
+    bool IsCompiled() const noexcept;
+
+private:
+    using char_class_type = std::regex_traits<wchar_t>::char_class_type;
+
+    enum class Opcode : uint8_t
+    {
+        Char,
+        Class,
+        Any,
+        Split,
+        Jump,
+        LineStart,
+        LineEnd,
+        WordBoundary,
+        NotWordBoundary,
+        Match
+    };
+
+    struct Instruction
+    {
+        Opcode op;
+        wchar_t ch;
+        // The class for Class, the target for Jump, and the preferred target for Split.
+        size_t x;
+        // The other target for Split.
+        size_t y;
+    };
+
+    struct CharClass
+    {
+        std::vector<std::pair<wchar_t, wchar_t>> ranges;
+        // Classes like \d, and whether they were negated like \D.
+        std::vector<std::pair<char_class_type, bool>> classes;
+        bool negated;
+    };
+
+    class Parser;
+
+    bool _Compile(const std::wstring_view pattern);
+    bool _Accepts(const Instruction& instruction, const wchar_t wch) const;
+    bool _IsWordChar(const wchar_t wch) const;
+    bool _CanStartWith(const wchar_t wch) const;
+    void _AddThread(std::vector<std::pair<size_t, size_t>>& threads, const size_t pc, const size_t start, const std::wstring_view text, const size_t pos) const;
+
+    std::regex_traits<wchar_t> _traits;
+    char_class_type _wordClass;
+    std::vector<Instruction> _program;
+    std::vector<CharClass> _classes;
+    // The instructions that can consume the first character of a match.
+    std::vector<size_t> _firstInstructions;
+
+    // Thread lists and marks, reused from search to search.
+    mutable std::vector<std::pair<size_t, size_t>> _current;
+    mutable std::vector<std::pair<size_t, size_t>> _next;
+    mutable std::vector<size_t> _marks;
+    mutable std::vector<size_t> _stack;
+    mutable size_t _generation;
+
+    std::optional<std::wregex> _fallback;
+};
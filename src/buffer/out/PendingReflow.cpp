@@ -0,0 +1,252 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "PendingReflow.hpp"
+
+#include "textBuffer.hpp"
+
+#pragma hdrstop
+
+// Routine Description:
+// - Creates the segments of a buffer that was reflowed from another one, and
+//   links that one to it. See TextBuffer::Reflow.
+// Arguments:
+// - buffer - The buffer that the segments are written into.
+// - source - The buffer that was reflowed into it.
+PendingReflow::PendingReflow(TextBuffer& buffer, TextBuffer& source) noexcept :
+    _buffer{ buffer },
+    _source{ &source },
+    _segments{}
+{
+    _source->_reflowTarget = &_buffer;
+}
+
+PendingReflow::~PendingReflow()
+{
+    _Unlink();
+}
+
+// Routine Description:
+// - Adds a segment below the ones that were added before.
+// Arguments:
+// - segment - The segment. Its source is either the buffer that was reflowed
+//   into this one, or a buffer that another segment shares.
+void PendingReflow::Add(Segment segment)
+{
+    _segments.emplace_back(std::move(segment));
+}
+
+// Routine Description:
+// - Checks whether all segments were written.
+bool PendingReflow::empty() const noexcept
+{
+    return _segments.empty();
+}
+
+// Routine Description:
+// - Counts the buffers that the segments are copied from.
+size_t PendingReflow::GetSourceCount() const noexcept
+{
+    std::array<const TextBuffer*, MaxSources + 1> sources{};
+    size_t count = 0;
+    for (const auto& segment : _segments)
+    {
+        if (std::find(sources.begin(), sources.begin() + count, segment.source) == sources.begin() + count)
+        {
+            if (count == sources.size())
+            {
+                break;
+            }
+            til::at(sources, count++) = segment.source;
+        }
+    }
+    return count;
+}
+
+// Routine Description:
+// - Writes the segments that have rows in the given range.
+// Arguments:
+// - firstRow - The offset of the first row of the range from the first row of the buffer.
+// - lastRow - The offset of the last row of the range, inclusive.
+void PendingReflow::Write(const size_t firstRow, const size_t lastRow)
+{
+    // The segments are at the top of the buffer, so most rows are below them.
+    if (_segments.empty())
+    {
+        return;
+    }
+    const auto bufferFirstRow = _buffer.GetFirstAbsoluteRow();
+    const auto first = bufferFirstRow + gsl::narrow_cast<int64_t>(firstRow);
+    const auto last = bufferFirstRow + gsl::narrow_cast<int64_t>(lastRow);
+    if (first >= _segments.back().firstRow + gsl::narrow_cast<int64_t>(_segments.back().rowCount))
+    {
+        return;
+    }
+
+    auto segment = std::upper_bound(_segments.begin(), _segments.end(), first, [](const int64_t row, const Segment& segment) {
+        return row < segment.firstRow;
+    });
+    if (segment != _segments.begin())
+    {
+        --segment;
+    }
+    while (segment != _segments.end() && segment->firstRow <= last)
+    {
+        if (segment->firstRow + gsl::narrow_cast<int64_t>(segment->rowCount) <= first ||
+            segment->firstRow + gsl::narrow_cast<int64_t>(segment->writtenRows) > last)
+        {
+            ++segment;
+            continue;
+        }
+        const auto index = segment - _segments.begin();
+        segment = _segments.begin() + index + (_Write(segment) ? 0 : 1);
+    }
+}
+
+// Routine Description:
+// - Writes all segments.
+void PendingReflow::WriteAll()
+{
+    for (auto segment = _segments.begin(); segment != _segments.end();)
+    {
+        const auto index = segment - _segments.begin();
+        segment = _segments.begin() + index + (_Write(segment) ? 0 : 1);
+    }
+}
+
+// Routine Description:
+// - Writes the segments that Reflow can't lay out from the rows that they're
+//   copied from: the ones whose source wasn't handed over, that partly
+//   scrolled off, or that have rows from the given row on. If they're copied
+//   from too many buffers, they're all written.
+// Arguments:
+// - endRow - The offset of the first row that Reflow reprints.
+void PendingReflow::WriteUnshared(const size_t endRow)
+{
+    if (GetSourceCount() >= MaxSources)
+    {
+        WriteAll();
+        return;
+    }
+
+    const auto bufferFirstRow = _buffer.GetFirstAbsoluteRow();
+    const auto end = bufferFirstRow + gsl::narrow_cast<int64_t>(endRow);
+    for (auto segment = _segments.begin(); segment != _segments.end();)
+    {
+        if (!segment->sharedSource ||
+            segment->firstRow < bufferFirstRow ||
+            segment->firstRow + gsl::narrow_cast<int64_t>(segment->rowCount) > end)
+        {
+            const auto index = segment - _segments.begin();
+            segment = _segments.begin() + index + (_Write(segment) ? 0 : 1);
+        }
+        else
+        {
+            ++segment;
+        }
+    }
+}
+
+// Routine Description:
+// - Forgets the segments whose rows all scrolled off the top of the buffer.
+//   They're only written as they scroll off if the scrollback keeps them.
+void PendingReflow::ForgetScrolledOff() noexcept
+{
+    const auto bufferFirstRow = _buffer.GetFirstAbsoluteRow();
+    while (!_segments.empty() && _segments.front().firstRow + gsl::narrow_cast<int64_t>(_segments.front().rowCount) <= bufferFirstRow)
+    {
+        _segments.pop_front();
+    }
+    if (_segments.empty())
+    {
+        _Unlink();
+    }
+}
+
+// Routine Description:
+// - Takes over the buffer that was reflowed into this one, so that it
+//   lives as long as the segments that are copied from it.
+// Arguments:
+// - source - The buffer. Reflow linked it to this one.
+void PendingReflow::Adopt(std::shared_ptr<const TextBuffer> source) noexcept
+{
+    for (auto& segment : _segments)
+    {
+        if (segment.source == source.get())
+        {
+            segment.sharedSource = source;
+        }
+    }
+    _Unlink();
+}
+
+// Routine Description:
+// - Writes the segments that are copied from a buffer that's about to be
+//   destroyed, before it was handed over.
+// Arguments:
+// - source - The buffer.
+void PendingReflow::Detach(const TextBuffer& source) noexcept
+{
+    for (auto segment = _segments.begin(); segment != _segments.end();)
+    {
+        if (segment->source == &source && !segment->sharedSource)
+        {
+            const auto index = segment - _segments.begin();
+            auto written = true;
+            try
+            {
+                written = _Write(segment);
+            }
+            CATCH_LOG();
+            segment = _segments.begin() + index + (written ? 0 : 1);
+        }
+        else
+        {
+            ++segment;
+        }
+    }
+    _source = nullptr;
+}
+
+// Routine Description:
+// - Writes a segment into the buffer and forgets it. If its bottom isn't in
+//   the buffer yet, only the rows that are get written, and it's kept.
+// Arguments:
+// - segment - The segment.
+// Return Value:
+// - true if the segment was written and forgotten.
+bool PendingReflow::_Write(std::deque<Segment>::iterator segment)
+{
+    const auto bufferEndRow = _buffer.GetFirstAbsoluteRow() + gsl::narrow_cast<int64_t>(_buffer.TotalRowCount());
+    if (segment->firstRow + gsl::narrow_cast<int64_t>(segment->rowCount) > bufferEndRow)
+    {
+        const auto writtenRows = gsl::narrow_cast<size_t>(bufferEndRow - segment->firstRow);
+        _buffer._ReflowRows(*segment->source, segment->sourceFirstRow, segment->sourceRowCount, segment->firstRow, segment->writtenRows);
+        segment->writtenRows = writtenRows;
+        return false;
+    }
+
+    // It's forgotten first, so that it's not written twice if writing fails.
+    // Its source is kept alive until it's written, though.
+    const auto written = std::move(*segment);
+    _segments.erase(segment);
+    if (_segments.empty())
+    {
+        _Unlink();
+    }
+    _buffer._ReflowRows(*written.source, written.sourceFirstRow, written.sourceRowCount, written.firstRow, written.writtenRows);
+    return true;
+}
+
+// Routine Description:
+// - Tells the buffer that was reflowed into this one that it doesn't need to
+//   write anything into this one anymore.
+void PendingReflow::_Unlink() noexcept
+{
+    if (_source)
+    {
+        _source->_reflowTarget = nullptr;
+        _source = nullptr;
+    }
+}
@@ -0,0 +1,88 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- PendingReflow.hpp
+
+Abstract:
+- Keeps track of the rows of a TextBuffer that TextBuffer::Reflow laid out
+  but hasn't written yet.
+- Reflow only reprints the rows from the logical line above the cursor and
+  the viewports on right away. The logical lines above them are only laid
+  out: Reflow counts the rows they take at the new width, but leaves those
+  rows blank. They're grouped into segments: the rows of another buffer that
+  a run of logical lines is copied from, and the rows of this buffer that it
+  goes to. A segment is written once any of its rows is asked for, so that
+  resizing doesn't take longer the more history there is.
+- The buffer that the rows are copied from has to stay around until they're
+  written. Reflow links it to the new buffer. Once it's handed over with
+  TextBuffer::AdoptReflowSource, the segments share it, and it's freed along
+  with the last of them. If it's destroyed first, it writes its segments.
+- When a buffer with segments is reflowed again, its segments are laid out
+  from the rows that they're copied from, rather than from their own blank
+  rows, so a series of resizes keeps copying from the same buffer.
+--*/
+
+#pragma once
+
+class TextBuffer;
+
+class PendingReflow final
+{
+public:
+    // The most buffers that the segments of a buffer are copied from. Reflow
+    // writes the segments of the old buffer rather than copying from more.
+    static constexpr size_t MaxSources = 4;
+
+    // The most rows of the old buffer that Reflow groups into a segment. A
+    // logical line that's longer than that is a segment on its own.
+    static constexpr size_t SegmentRows = 64;
+
+    struct Segment
+    {
+        // The absolute row of the first row of the segment, see TextBuffer::GetFirstAbsoluteRow.
+        int64_t firstRow;
+        size_t rowCount;
+        // The buffer that the rows are copied from, and the offsets of its rows.
+        // It's only shared once it was handed over with TextBuffer::AdoptReflowSource.
+        const TextBuffer* source;
+        std::shared_ptr<const TextBuffer> sharedSource;
+        size_t sourceFirstRow;
+        size_t sourceRowCount;
+        // The rows at the top of the segment that were written already. Only
+        // Reflow writes part of a segment, when its bottom isn't in the buffer yet.
+        size_t writtenRows;
+    };
+
+    PendingReflow(TextBuffer& buffer, TextBuffer& source) noexcept;
+    ~PendingReflow();
+
+    PendingReflow(const PendingReflow&) = delete;
+    PendingReflow& operator=(const PendingReflow&) = delete;
+
+    void Add(Segment segment);
+    bool empty() const noexcept;
+    size_t GetSourceCount() const noexcept;
+
+    void Write(const size_t firstRow, const size_t lastRow);
+    void WriteAll();
+    void WriteUnshared(const size_t endRow);
+    void ForgetScrolledOff() noexcept;
+
+    void Adopt(std::shared_ptr<const TextBuffer> source) noexcept;
+    void Detach(const TextBuffer& source) noexcept;
+
+private:
+    // The buffer that the segments are written into.
+    TextBuffer& _buffer;
+    // The buffer that was reflowed into this one, until it's handed over.
+    TextBuffer* _source;
+    // The segments that weren't written yet, in order.
+    std::deque<Segment> _segments;
+
+    bool _Write(std::deque<Segment>::iterator segment);
+    void _Unlink() noexcept;
+
+    friend class TextBuffer;
+};
@@ -10,24 +10,30 @@
 // Routine Description:
 // - constructor
 // Arguments:
-// - rowId - the row index in the text buffer
-// - rowWidth - the width of the row, cell elements
+// - cells - the cells of the row in the text buffer's cell buffer, which also determine its width
 // - fillAttribute - the default text attribute
+// - attributeTable - where to intern the attributes of the row
+// - attrRunResource - where to allocate the attribute runs of the row from
 // - pParent - the text buffer that this row belongs to
+// - rowIndex - the index of this row in the text buffer's storage
 // Return Value:
 // - constructed object
-ROW::ROW(const SHORT rowId, const short rowWidth, const TextAttribute fillAttribute, TextBuffer* const pParent) :
-    _id{ rowId },
-    _rowWidth{ gsl::narrow<size_t>(rowWidth) },
-    _charRow{ gsl::narrow<size_t>(rowWidth), this },
-    _attrRow{ gsl::narrow<UINT>(rowWidth), fillAttribute },
-    _pParent{ pParent }
+ROW::ROW(const gsl::span<CharRowCell> cells,
+         const TextAttribute fillAttribute,
+         TextAttributeTable& attributeTable,
+         std::pmr::memory_resource* const attrRunResource,
+         TextBuffer* const pParent,
+         const size_t rowIndex) :
+    _charRow{ cells, pParent, rowIndex },
+    _attrRow{ gsl::narrow<UINT>(cells.size()), fillAttribute, attributeTable, attrRunResource },
+    _pParent{ pParent },
+    _revision{ 0 }
 {
 }
 
 size_t ROW::size() const noexcept
 {
-    return _rowWidth;
+    return _charRow.size();
 }
 
 const CharRow& ROW::GetCharRow() const noexcept
@@ -50,16 +56,6 @@ ATTR_ROW& ROW::GetAttrRow() noexcept
     return _attrRow;
 }
 
-SHORT ROW::GetId() const noexcept
-{
-    return _id;
-}
-
-void ROW::SetId(const SHORT id) noexcept
-{
-    _id = id;
-}
-
 // Routine Description:
 // - Sets all properties of the ROW to default values
 // Arguments:
@@ -68,6 +64,7 @@ void ROW::SetId(const SHORT id) noexcept
 // - <none>
 bool ROW::Reset(const TextAttribute Attr)
 {
+    MarkChanged();
     _charRow.Reset();
     try
     {
@@ -82,35 +79,36 @@ bool ROW::Reset(const TextAttribute Attr)
 }
 
 // Routine Description:
-// - resizes ROW to new width
+// - clears char data in column in row
 // Arguments:
-// - width - the new width, in cells
+// - column - 0-indexed column index
 // Return Value:
-// - S_OK if successful, otherwise relevant error
-[[nodiscard]] HRESULT ROW::Resize(const size_t width)
+// - <none>
+void ROW::ClearColumn(const size_t column)
 {
-    RETURN_IF_FAILED(_charRow.Resize(width));
-    try
-    {
-        _attrRow.Resize(width);
-    }
-    CATCH_RETURN();
-
-    _rowWidth = width;
+    THROW_HR_IF(E_INVALIDARG, column >= _charRow.size());
+    MarkChanged();
+    _charRow.ClearCell(column);
+}
 
-    return S_OK;
+// Routine Description:
+// - gets the revision of the text buffer in which the row last changed.
+//   Rows that aren't part of a text buffer count their own changes instead.
+// Return Value:
+// - the revision. Rows that never changed are at revision 0.
+uint64_t ROW::GetRevision() const noexcept
+{
+    return _revision;
 }
 
 // Routine Description:
-// - clears char data in column in row
-// Arguments:
-// - column - 0-indexed column index
+// - records that the row changed. The row's own methods do this, but callers
+//   that change its CharRow or ATTR_ROW directly must call it themselves.
 // Return Value:
 // - <none>
-void ROW::ClearColumn(const size_t column)
+void ROW::MarkChanged() noexcept
 {
-    THROW_HR_IF(E_INVALIDARG, column >= _charRow.size());
-    _charRow.ClearCell(column);
+    _revision = _pParent ? _pParent->_NextRevision() : _revision + 1;
 }
 
 // Routine Description:
@@ -132,16 +130,6 @@ RowCellIterator ROW::AsCellIter(const size_t startIndex, const size_t count) con
     return RowCellIterator(*this, startIndex, count);
 }
 
-UnicodeStorage& ROW::GetUnicodeStorage() noexcept
-{
-    return _pParent->GetUnicodeStorage();
-}
-
-const UnicodeStorage& ROW::GetUnicodeStorage() const noexcept
-{
-    return _pParent->GetUnicodeStorage();
-}
-
 // Routine Description:
 // - writes cell data to the row
 // Arguments:
@@ -156,6 +144,7 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const size_t index, co
     THROW_HR_IF(E_INVALIDARG, index >= _charRow.size());
     THROW_HR_IF(E_INVALIDARG, limitRight.value_or(0) >= _charRow.size());
     size_t currentIndex = index;
+    MarkChanged();
 
     // If we're given a right-side column limit, use it. Otherwise, the write limit is the final column index available in the char row.
     const auto finalColumnInRow = limitRight.value_or(_charRow.size() - 1);
@@ -256,3 +245,94 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const size_t index, co
 
     return it;
 }
+
+// Routine Description:
+// - writes a run of printable ASCII in a single color to the row. This is
+//   what WriteCells does for such text, without going through an iterator
+//   one cell at a time: the characters are copied into the cells and the
+//   color is set as one run.
+// Arguments:
+// - text - printable ASCII characters, which each take up one cell
+// - index - column in row to start writing at
+// - attr - the color of the text
+// - wrap - change the wrap flag if we filled the last column of the row.
+// Return Value:
+// - the number of columns written, which is less than the length of text if it didn't fit into the row.
+size_t ROW::WriteAscii(const std::wstring_view text, const size_t index, const TextAttribute& attr, const std::optional<bool> wrap)
+{
+    THROW_HR_IF(E_INVALIDARG, index >= _charRow.size());
+
+    const auto count = std::min(text.size(), _charRow.size() - index);
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    MarkChanged();
+    _charRow.WriteAscii(text.substr(0, count), index);
+
+    const auto end = index + count;
+    if (end == _charRow.size())
+    {
+        LOG_HR_IF(E_OUTOFMEMORY, !_attrRow.SetAttrToEnd(gsl::narrow<UINT>(index), attr));
+
+        // NOTE: same as WriteCells, wrap = true/false (un)sets the wrap status, std::nullopt leaves it alone.
+        if (wrap.has_value())
+        {
+            _charRow.SetWrapForced(wrap.value());
+        }
+    }
+    else
+    {
+        const TextAttributeRun run{ count, attr };
+        LOG_IF_FAILED(_attrRow.InsertAttrRuns({ &run, 1 }, index, end - 1, _charRow.size()));
+    }
+
+    return count;
+}
+
+// Routine Description:
+// - fills a range of the row with one character that takes up one cell, in
+//   one color. This is what WriteCells does with a fill iterator, without
+//   going through it one cell at a time. A fill of the whole row resets its
+//   color to a single run.
+// Arguments:
+// - wch - the character to fill with, which must not be full width
+// - attr - the color to fill with
+// - index - column in row to start filling at
+// - count - the number of columns to fill. Columns beyond the end of the row are ignored.
+// - wrap - change the wrap flag if we filled the last column of the row.
+// Return Value:
+// - the number of columns filled.
+size_t ROW::FillCells(const wchar_t wch, const TextAttribute& attr, const size_t index, const size_t count, const std::optional<bool> wrap)
+{
+    THROW_HR_IF(E_INVALIDARG, index >= _charRow.size());
+
+    const auto filled = std::min(count, _charRow.size() - index);
+    if (filled == 0)
+    {
+        return 0;
+    }
+
+    MarkChanged();
+    const auto end = index + filled;
+    if (index == 0 && end == _charRow.size())
+    {
+        _attrRow.Reset(attr);
+    }
+    else
+    {
+        const TextAttributeRun run{ filled, attr };
+        LOG_IF_FAILED(_attrRow.InsertAttrRuns({ &run, 1 }, index, end - 1, _charRow.size()));
+    }
+
+    _charRow.FillCells(wch, index, filled);
+
+    // NOTE: same as WriteCells, wrap = true/false (un)sets the wrap status, std::nullopt leaves it alone.
+    if (wrap.has_value() && end == _charRow.size())
+    {
+        _charRow.SetWrapForced(wrap.value());
+    }
+
+    return filled;
+}
@@ -25,14 +25,27 @@ Revision History:
 #include "OutputCellIterator.hpp"
 #include "CharRow.hpp"
 #include "RowCellIterator.hpp"
-#include "UnicodeStorage.hpp"
 
 class TextBuffer;
 
+// A ROW is a view of one row of the TextBuffer or its Scrollback. Its cells
+// live in their cell buffer, its attribute runs are allocated from their
+// pool and its attributes are interned in their table, so a ROW can't be
+// copied, only moved around within its owner.
 class ROW final
 {
 public:
-    ROW(const SHORT rowId, const short rowWidth, const TextAttribute fillAttribute, TextBuffer* const pParent);
+    ROW(const gsl::span<CharRowCell> cells,
+        const TextAttribute fillAttribute,
+        TextAttributeTable& attributeTable,
+        std::pmr::memory_resource* const attrRunResource,
+        TextBuffer* const pParent,
+        const size_t rowIndex);
+
+    ROW(const ROW&) = delete;
+    ROW& operator=(const ROW&) = delete;
+    ROW(ROW&&) noexcept = default;
+    ROW& operator=(ROW&&) = default;
 
     size_t size() const noexcept;
 
@@ -42,11 +55,7 @@ public:
     const ATTR_ROW& GetAttrRow() const noexcept;
     ATTR_ROW& GetAttrRow() noexcept;
 
-    SHORT GetId() const noexcept;
-    void SetId(const SHORT id) noexcept;
-
     bool Reset(const TextAttribute Attr);
-    [[nodiscard]] HRESULT Resize(const size_t width);
 
     void ClearColumn(const size_t column);
     std::wstring GetText() const;
@@ -54,10 +63,12 @@ public:
     RowCellIterator AsCellIter(const size_t startIndex) const;
     RowCellIterator AsCellIter(const size_t startIndex, const size_t count) const;
 
-    UnicodeStorage& GetUnicodeStorage() noexcept;
-    const UnicodeStorage& GetUnicodeStorage() const noexcept;
-
     OutputCellIterator WriteCells(OutputCellIterator it, const size_t index, const std::optional<bool> wrap = std::nullopt, std::optional<size_t> limitRight = std::nullopt);
+    size_t WriteAscii(const std::wstring_view text, const size_t index, const TextAttribute& attr, const std::optional<bool> wrap = std::nullopt);
+    size_t FillCells(const wchar_t wch, const TextAttribute& attr, const size_t index, const size_t count, const std::optional<bool> wrap = std::nullopt);
+
+    uint64_t GetRevision() const noexcept;
+    void MarkChanged() noexcept;
 
     friend bool operator==(const ROW& a, const ROW& b) noexcept;
 
@@ -68,16 +79,15 @@ public:
 private:
     CharRow _charRow;
     ATTR_ROW _attrRow;
-    SHORT _id;
-    size_t _rowWidth;
     TextBuffer* _pParent; // non ownership pointer
+
+    // When the row last changed, counted by its text buffer. See TextBuffer::GetRevision.
+    uint64_t _revision;
 };
 
 inline bool operator==(const ROW& a, const ROW& b) noexcept
 {
     return (a._charRow == b._charRow &&
             a._attrRow == b._attrRow &&
-            a._rowWidth == b._rowWidth &&
-            a._pParent == b._pParent &&
-            a._id == b._id);
+            a._pParent == b._pParent);
 }
@@ -0,0 +1,1064 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "Scrollback.hpp"
+
+#pragma hdrstop
+
+namespace
+{
+    // The flags of a packed row.
+    constexpr BYTE WrapForcedFlag = 0x01;
+    constexpr BYTE DoubleBytePaddedFlag = 0x02;
+
+    // Packed cells are grouped into runs of cells of the same kind: the
+    // DBCS attribute of the cells, and whether the glyph isn't one wchar_t.
+    // Runs of the latter only ever hold a single cell.
+    constexpr BYTE LeadingKind = 0x01;
+    constexpr BYTE TrailingKind = 0x02;
+    constexpr BYTE LongGlyphKind = 0x04;
+
+    BYTE GetCellKind(const DbcsAttribute attr, const std::wstring_view glyph) noexcept
+    {
+        BYTE kind = 0;
+        WI_SetFlagIf(kind, LeadingKind, attr.IsLeading());
+        WI_SetFlagIf(kind, TrailingKind, attr.IsTrailing());
+        WI_SetFlagIf(kind, LongGlyphKind, glyph.size() != 1);
+        return kind;
+    }
+
+    // Sizes are written 7 bits at a time, so that the small ones take up a single byte.
+    void WriteSize(std::vector<BYTE>& packed, size_t value)
+    {
+        for (; value >= 0x80; value >>= 7)
+        {
+            packed.push_back(gsl::narrow_cast<BYTE>(value | 0x80));
+        }
+        packed.push_back(gsl::narrow_cast<BYTE>(value));
+    }
+
+    template<typename T>
+    void WriteValues(std::vector<BYTE>& packed, const gsl::span<const T> values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto offset = packed.size();
+        packed.resize(offset + values.size_bytes());
+        std::memcpy(packed.data() + offset, values.data(), values.size_bytes());
+    }
+
+    // Reads back what the functions above wrote. The packed bytes are never
+    // expected to end early, but if they do, reading throws instead of
+    // reading past them.
+    class PackedReader final
+    {
+    public:
+        PackedReader(const gsl::span<const BYTE> packed) noexcept :
+            _packed{ packed },
+            _position{ 0 }
+        {
+        }
+
+        BYTE ReadByte()
+        {
+            THROW_HR_IF(E_UNEXPECTED, _position >= _packed.size());
+            return til::at(_packed, _position++);
+        }
+
+        size_t ReadSize()
+        {
+            size_t value = 0;
+            for (size_t shift = 0;; shift += 7)
+            {
+                THROW_HR_IF(E_UNEXPECTED, shift >= sizeof(size_t) * CHAR_BIT);
+                const auto byte = ReadByte();
+                value |= static_cast<size_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return value;
+                }
+            }
+        }
+
+        template<typename T>
+        void ReadValues(const gsl::span<T> values)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            THROW_HR_IF(E_UNEXPECTED, values.size_bytes() > _packed.size() - _position);
+            std::memcpy(values.data(), _packed.data() + _position, values.size_bytes());
+            _position += values.size_bytes();
+        }
+
+    private:
+        gsl::span<const BYTE> _packed;
+        size_t _position;
+    };
+}
+
+// Routine Description:
+// - Constructs an empty scrollback. It doesn't keep any rows until it's given a budget.
+Scrollback::Scrollback() noexcept :
+    _attributeTable{},
+    _attrRunPool{},
+    _blocks{},
+    _packedBlocks{ 0 },
+    _unpacked{},
+    _unpacking{ nullptr },
+    _rewrapping{ nullptr },
+    _rewrapRow{ nullptr },
+    _spillFile{},
+    _spill{ false },
+    _spilledBytes{ 0 },
+    _endRow{ 0 },
+    _budget{ 0 },
+    _usage{ 0 },
+    _rowLimit{ SIZE_MAX },
+    _coldThreshold{ DefaultColdThreshold },
+    _rewrapEnd{ 0 },
+    _rewrapWidth{ 0 }
+{
+    _attributeTable.SetMarker([this](TextAttributeTable& table) noexcept {
+        _MarkAttributes(table);
+    });
+}
+
+// Routine Description:
+// - Sets how much memory the rows may take up. If they take up more than
+//   that already, the oldest ones are dropped right away.
+// Arguments:
+// - bytes - The budget in bytes. 0 doesn't keep any rows.
+// Return Value:
+// - <none>
+void Scrollback::SetBudget(const size_t bytes) noexcept
+{
+    _budget = bytes;
+    _Trim();
+}
+
+size_t Scrollback::GetBudget() const noexcept
+{
+    return _budget;
+}
+
+// Routine Description:
+// - Gets roughly how much memory the rows take up, including the cells that
+//   were allocated for rows that haven't been appended yet. The packed blocks
+//   that were spilled to disk don't take up any, so only this is held
+//   against the budget.
+// Return Value:
+// - The memory in bytes.
+size_t Scrollback::GetUsage() const noexcept
+{
+    return _usage;
+}
+
+// Routine Description:
+// - Sets how many rows may be kept, no matter where they're kept. This is
+//   what limits the rows once they're spilled to disk, where they don't
+//   count against the budget. The oldest blocks that are entirely beyond the
+//   limit are dropped right away.
+// Arguments:
+// - rows - The number of rows. SIZE_MAX, the default, doesn't limit them.
+// Return Value:
+// - <none>
+void Scrollback::SetRowLimit(const size_t rows) noexcept
+{
+    _rowLimit = rows;
+    _Trim();
+}
+
+size_t Scrollback::GetRowLimit() const noexcept
+{
+    return _rowLimit;
+}
+
+// Routine Description:
+// - Sets how many of the newest rows are kept unpacked. The blocks that are
+//   further from the end than that are packed right away. Raising the
+//   threshold doesn't unpack any blocks.
+// Arguments:
+// - rows - The number of rows. 0 packs every block except the newest.
+// Return Value:
+// - <none>
+void Scrollback::SetColdThreshold(const size_t rows) noexcept
+{
+    _coldThreshold = rows;
+    _Pack();
+}
+
+size_t Scrollback::GetColdThreshold() const noexcept
+{
+    return _coldThreshold;
+}
+
+// Routine Description:
+// - Sets whether packed blocks are spilled to a temporary file. Turning it on
+//   spills the blocks that are packed already. Turning it off reads them
+//   back into memory, or clears the scrollback if there's no memory for them.
+// - Spilled blocks don't count against the budget, so turning it off may
+//   drop the oldest rows that were read back.
+// Arguments:
+// - spill - Whether to spill packed blocks.
+// Return Value:
+// - <none>
+void Scrollback::SetSpillToDisk(const bool spill) noexcept
+{
+    _spill = spill;
+
+    for (size_t i = 0; i < _packedBlocks; ++i)
+    {
+        auto& block = til::at(_blocks, i);
+        if (spill && !block.spillOffset)
+        {
+            _Spill(block);
+        }
+        else if (!spill && block.spillOffset)
+        {
+            try
+            {
+                const auto view = _spillFile->Map(*block.spillOffset, block.bytes);
+                block.packed.assign(view.Bytes().begin(), view.Bytes().end());
+            }
+            catch (...)
+            {
+                LOG_CAUGHT_EXCEPTION();
+                Clear();
+                return;
+            }
+
+            _spillFile->Free(*block.spillOffset, block.bytes);
+            _spilledBytes -= block.bytes;
+            _usage += block.bytes;
+            block.spillOffset.reset();
+        }
+    }
+
+    if (!spill)
+    {
+        _spillFile.reset();
+        _Trim();
+    }
+}
+
+bool Scrollback::GetSpillToDisk() const noexcept
+{
+    return _spill;
+}
+
+// Routine Description:
+// - Gets where the rows are kept: how many bytes are in memory and how many
+//   were spilled to disk.
+// Return Value:
+// - The stats.
+Scrollback::Stats Scrollback::GetStats() const noexcept
+{
+    size_t unpackedBytes = 0;
+    for (const auto& block : _unpacked)
+    {
+        unpackedBytes += block.bytes;
+    }
+
+    return { _usage, unpackedBytes, _spilledBytes, _spillFile ? _spillFile->GetSize() : 0 };
+}
+
+// Routine Description:
+// - Gets the absolute row of the oldest row that's still kept.
+// Return Value:
+// - The absolute row. Equal to GetEndRow() if no rows are kept.
+int64_t Scrollback::GetFirstRow() const noexcept
+{
+    return _blocks.empty() ? _endRow : _blocks.front().firstRow;
+}
+
+// Routine Description:
+// - Gets the absolute row that the next appended row will have. This is the
+//   absolute row of the top row of the TextBuffer.
+// Return Value:
+// - The absolute row.
+int64_t Scrollback::GetEndRow() const noexcept
+{
+    return _endRow;
+}
+
+size_t Scrollback::size() const noexcept
+{
+    return gsl::narrow_cast<size_t>(_endRow - GetFirstRow());
+}
+
+// Routine Description:
+// - Copies a row that's about to scroll off the top of the buffer.
+// - If there's no memory for it, the scrollback is cleared instead, as the
+//   rows it keeps have to stay contiguous.
+// Arguments:
+// - row - The row to copy.
+// Return Value:
+// - <none>
+void Scrollback::Append(const ROW& row) noexcept
+{
+    if (_budget != 0)
+    {
+        try
+        {
+            _AppendRow(row);
+        }
+        catch (...)
+        {
+            LOG_CAUGHT_EXCEPTION();
+            Clear();
+        }
+    }
+
+    ++_endRow;
+    _Pack();
+    _Trim();
+}
+
+// Routine Description:
+// - Drops the newest rows, up to the given absolute row.
+// - Packed blocks that are dropped entirely aren't unpacked. If there's no
+//   memory to unpack the one that's dropped in part, the scrollback is
+//   cleared instead.
+// Arguments:
+// - endRow - The absolute row that becomes the end of the scrollback.
+// Return Value:
+// - <none>
+void Scrollback::Truncate(const int64_t endRow) noexcept
+{
+    if (endRow >= _endRow)
+    {
+        return;
+    }
+
+    while (!_blocks.empty() && _blocks.back().firstRow >= endRow)
+    {
+        _usage -= _GetResidentBytes(_blocks.back());
+        if (_blocks.back().IsPacked())
+        {
+            _ForgetPacked(_blocks.back());
+        }
+        _blocks.pop_back();
+    }
+
+    if (!_blocks.empty() && _blocks.back().IsPacked())
+    {
+        try
+        {
+            _UnpackBack();
+        }
+        catch (...)
+        {
+            LOG_CAUGHT_EXCEPTION();
+            Clear();
+        }
+    }
+
+    // The newest block ends at _endRow, and the ones that start after the new end are gone.
+    if (!_blocks.empty())
+    {
+        auto& block = _blocks.back();
+        while (block.firstRow + gsl::narrow_cast<int64_t>(block.rowCount) > endRow)
+        {
+            const auto rowBytes = _GetRowBytes(block.rows.back());
+            block.cellsUsed -= block.rows.back().size();
+            block.bytes -= rowBytes;
+            _usage -= rowBytes;
+            block.rows.pop_back();
+            --block.rowCount;
+        }
+    }
+
+    _endRow = endRow;
+    _rewrapEnd = std::min(_rewrapEnd, endRow);
+}
+
+// Routine Description:
+// - Drops all rows. The rows appended after this continue the absolute rows
+//   of the ones before.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Scrollback::Clear() noexcept
+{
+    _blocks.clear();
+    _packedBlocks = 0;
+    _unpacked.clear();
+    _spillFile.reset();
+    _spilledBytes = 0;
+    _usage = 0;
+    _rewrapWidth = 0;
+}
+
+// Routine Description:
+// - Rewraps the rows before the given absolute row to a new width, once
+//   FinishRewrap is called. Rows that are appended in the meantime are
+//   expected to have the new width already and aren't rewrapped.
+// Arguments:
+// - endRow - The absolute row after the last one to rewrap. This is usually
+//   the end row from before the buffer was resized.
+// - width - The new width.
+// Return Value:
+// - <none>
+void Scrollback::Rewrap(const int64_t endRow, const size_t width) noexcept
+{
+    _rewrapEnd = std::min(endRow, _endRow);
+    _rewrapWidth = width;
+}
+
+// Routine Description:
+// - Rewraps the rows if Rewrap was called since the last time. Each logical
+//   line is rewrapped to the new width, which changes the number of rows
+//   before the end row. The rows that were asked for before are invalidated.
+// - If there's no memory for the rewrapped rows, the scrollback is cleared
+//   instead.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Scrollback::FinishRewrap() noexcept
+{
+    const auto width = std::exchange(_rewrapWidth, 0);
+    if (width == 0)
+    {
+        return;
+    }
+
+    try
+    {
+        _Rewrap(width);
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        Clear();
+    }
+}
+
+bool Scrollback::IsRewrapPending() const noexcept
+{
+    return _rewrapWidth != 0;
+}
+
+// Routine Description:
+// - Gets a row by its absolute row. If it's in a packed block, the block is
+//   unpacked into the cache first.
+// - The row stays valid until rows are dropped, or until rows of
+//   UnpackedBlocks other packed blocks were asked for.
+// Arguments:
+// - row - The absolute row, between GetFirstRow() and GetEndRow().
+// Return Value:
+// - The row. Throws if it isn't kept.
+const ROW& Scrollback::GetRow(const int64_t row) const
+{
+    THROW_HR_IF(E_INVALIDARG, row < GetFirstRow() || row >= _endRow);
+
+    // The blocks are sorted by their first row, so the row is in the last block that starts at or before it.
+    auto block = std::prev(std::upper_bound(_blocks.begin(), _blocks.end(), row, [](const int64_t value, const Block& candidate) noexcept {
+        return value < candidate.firstRow;
+    }));
+
+    if (block->IsPacked())
+    {
+        const auto firstRow = block->firstRow;
+        auto unpacked = std::find_if(_unpacked.begin(), _unpacked.end(), [=](const Block& candidate) noexcept {
+            return candidate.firstRow == firstRow;
+        });
+
+        if (unpacked == _unpacked.end())
+        {
+            // The copies allocate from the default resource, as the pool is only for the rows that are kept.
+            auto copy = _UnpackBlock(*block, std::pmr::get_default_resource());
+            if (_unpacked.size() >= UnpackedBlocks)
+            {
+                _unpacked.pop_front();
+            }
+            _unpacked.emplace_back(std::move(copy));
+        }
+        else if (unpacked != std::prev(_unpacked.end()))
+        {
+            // Moving a block leaves its rows where they are, so the rows that were handed out stay valid.
+            auto copy = std::move(*unpacked);
+            _unpacked.erase(unpacked);
+            _unpacked.emplace_back(std::move(copy));
+        }
+
+        return til::at(_unpacked.back().rows, gsl::narrow_cast<size_t>(row - firstRow));
+    }
+
+    return til::at(block->rows, gsl::narrow_cast<size_t>(row - block->firstRow));
+}
+
+// Routine Description:
+// - Estimates how much memory a row of the given width takes up, so that a
+//   budget can be given in rows instead.
+// Arguments:
+// - width - The width of the row in columns.
+// Return Value:
+// - The memory in bytes.
+size_t Scrollback::EstimateRowBytes(const size_t width) noexcept
+{
+    return sizeof(ROW) + width * sizeof(CharRowCell) + sizeof(TextAttributeTable::Run);
+}
+
+// Routine Description:
+// - Copies a row into the newest block, or a new one if it doesn't fit.
+// Arguments:
+// - row - The row to copy.
+// Return Value:
+// - <none>
+void Scrollback::_AppendRow(const ROW& row)
+{
+    const auto width = row.size();
+    if (_blocks.empty() ||
+        _blocks.back().rowCount == BlockRows ||
+        _blocks.back().IsPacked() ||
+        _blocks.back().cellCapacity - _blocks.back().cellsUsed < width)
+    {
+        Block block{ _endRow, 0, std::make_unique<CharRowCell[]>(BlockRows * width), BlockRows * width, 0, {}, {}, std::nullopt, 0 };
+        block.rows.reserve(BlockRows);
+        block.bytes = block.cellCapacity * sizeof(CharRowCell) + BlockRows * sizeof(ROW);
+        _blocks.emplace_back(std::move(block));
+        _usage += _blocks.back().bytes;
+    }
+
+    auto& block = _blocks.back();
+    const gsl::span<CharRowCell> cells{ block.cells.get() + block.cellsUsed, width };
+    auto& copy = block.rows.emplace_back(cells, TextAttribute{}, _attributeTable, &_attrRunPool, nullptr, 0);
+    try
+    {
+        copy.GetCharRow().CopyFrom(row.GetCharRow());
+        copy.GetAttrRow() = row.GetAttrRow();
+    }
+    catch (...)
+    {
+        block.rows.pop_back();
+        throw;
+    }
+
+    const auto rowBytes = _GetRowBytes(copy);
+    ++block.rowCount;
+    block.cellsUsed += width;
+    block.bytes += rowBytes;
+    _usage += rowBytes;
+}
+
+// Routine Description:
+// - Drops the oldest blocks until the rows fit into the budget, and the ones
+//   that are entirely beyond the row limit. The newest block is kept unless
+//   the budget is 0, so that the rows that were just appended are available
+//   even with a small budget.
+// - Spilled blocks are dropped to make room in memory as well, as the rows
+//   that are kept have to stay contiguous. With a budget that leaves room for
+//   the cold threshold, that only happens when the rows couldn't be spilled.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Scrollback::_Trim() noexcept
+{
+    while (!_blocks.empty() && (_budget == 0 || _blocks.size() > 1))
+    {
+        const auto& block = _blocks.front();
+        if (_usage <= _budget && size() - block.rowCount < _rowLimit)
+        {
+            return;
+        }
+
+        _usage -= _GetResidentBytes(block);
+        if (block.IsPacked())
+        {
+            _ForgetPacked(block);
+        }
+        _blocks.pop_front();
+    }
+}
+
+// Routine Description:
+// - Packs the oldest unpacked blocks, as long as all of their rows are
+//   further from the end than the cold threshold. The newest block is never
+//   packed, as rows are still appended to it.
+// - A block that can't be packed for lack of memory is left as it is.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Scrollback::_Pack() noexcept
+{
+    while (_packedBlocks + 1 < _blocks.size())
+    {
+        auto& block = til::at(_blocks, _packedBlocks);
+        const auto blockEnd = block.firstRow + gsl::narrow_cast<int64_t>(block.rowCount);
+        if (gsl::narrow_cast<size_t>(_endRow - blockEnd) < _coldThreshold)
+        {
+            return;
+        }
+
+        try
+        {
+            std::vector<BYTE> packed;
+            for (const auto& row : block.rows)
+            {
+                _PackRow(row, packed);
+            }
+            packed.shrink_to_fit();
+
+            _usage -= block.bytes;
+            block.rows.clear();
+            block.rows.shrink_to_fit();
+            block.cells.reset();
+            block.packed = std::move(packed);
+            block.bytes = block.packed.size();
+            _usage += block.bytes;
+        }
+        CATCH_LOG_RETURN();
+
+        ++_packedBlocks;
+
+        if (_spill)
+        {
+            _Spill(block);
+        }
+    }
+}
+
+// Routine Description:
+// - Moves the bytes of a packed block into the spill file. If they can't be
+//   written, they stay in memory.
+// Arguments:
+// - block - The packed block.
+// Return Value:
+// - <none>
+void Scrollback::_Spill(Block& block) noexcept
+{
+    try
+    {
+        if (!_spillFile)
+        {
+            _spillFile = std::make_unique<ScrollbackFile>();
+        }
+
+        block.spillOffset = _spillFile->Write(block.packed);
+    }
+    CATCH_LOG_RETURN();
+
+    block.packed = {};
+    _spilledBytes += block.bytes;
+    _usage -= block.bytes;
+}
+
+// Routine Description:
+// - Unpacks the rows of a packed block into a new block, mapping them from
+//   the spill file first if they were spilled.
+// Arguments:
+// - block - The packed block.
+// - resource - The resource to allocate the attribute runs of the rows from.
+// Return Value:
+// - The unpacked block.
+Scrollback::Block Scrollback::_UnpackBlock(const Block& block, std::pmr::memory_resource* const resource) const
+{
+    if (block.spillOffset)
+    {
+        const auto view = _spillFile->Map(*block.spillOffset, block.bytes);
+        return _Unpack(block, view.Bytes(), resource);
+    }
+    return _Unpack(block, block.packed, resource);
+}
+
+// Routine Description:
+// - Unpacks the newest block in place, so that rows can be dropped from it.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Scrollback::_UnpackBack()
+{
+    auto& block = _blocks.back();
+    auto unpacked = _UnpackBlock(block, &_attrRunPool);
+    _usage -= _GetResidentBytes(block);
+    _ForgetPacked(block);
+    block = std::move(unpacked);
+    _usage += block.bytes;
+}
+
+// Routine Description:
+// - Lets go of what a packed block holds outside of itself, before it's
+//   dropped or unpacked in place: its extent of the spill file and the
+//   unpacked copies. All copies are dropped, as the first row of the block
+//   may be reused by a later one.
+// Arguments:
+// - block - The packed block, which must be the oldest or the newest one.
+// Return Value:
+// - <none>
+void Scrollback::_ForgetPacked(const Block& block) noexcept
+{
+    --_packedBlocks;
+    _unpacked.clear();
+
+    if (block.spillOffset)
+    {
+        _spillFile->Free(*block.spillOffset, block.bytes);
+        _spilledBytes -= block.bytes;
+    }
+}
+
+// Routine Description:
+// - Rewraps the rows before _rewrapEnd into new blocks, a block at a time,
+//   so that the rows only take up about twice the memory of a block while
+//   they're rewrapped. The rows after _rewrapEnd are copied as they are.
+// - Each old row contributes its cells up to its last printable one, or all
+//   of them if it wrapped. A double-width character that doesn't fit at the
+//   end of a new row is moved to the next one, padding the row the same way
+//   the buffer does.
+// Arguments:
+// - width - The new width.
+// Return Value:
+// - <none>
+void Scrollback::_Rewrap(const size_t width)
+{
+    auto blocks = std::move(_blocks);
+    _blocks.clear();
+    _packedBlocks = 0;
+    _unpacked.clear();
+    _usage = 0;
+
+    // The new rows are numbered from 0 until it's known how many there are.
+    // If that fails, FinishRewrap clears the rows, and the end row has to be
+    // where it was, so that the absolute rows of the buffer don't go back.
+    const auto endRow = _endRow;
+    const auto rewrapEnd = _rewrapEnd;
+    _endRow = 0;
+    auto restoreEndRow = wil::scope_exit([&]() noexcept { _endRow = endRow; });
+
+    const auto cells = std::make_unique<CharRowCell[]>(width);
+    ROW line{ { cells.get(), width }, TextAttribute{}, _attributeTable, std::pmr::get_default_resource(), nullptr, 0 };
+    size_t column = 0;
+
+    _rewrapping = &blocks;
+    _rewrapRow = &line;
+    auto clearRewrapping = wil::scope_exit([&]() noexcept {
+        _rewrapping = nullptr;
+        _rewrapRow = nullptr;
+    });
+
+    const auto appendRow = [&](const ROW& row) {
+        _AppendRow(row);
+        ++_endRow;
+        _Pack();
+    };
+    const auto appendLine = [&](const bool wrapForced) {
+        line.GetCharRow().SetWrapForced(wrapForced);
+        appendRow(line);
+        THROW_HR_IF(E_OUTOFMEMORY, !line.Reset(TextAttribute{}));
+        column = 0;
+    };
+
+    for (; !blocks.empty(); blocks.pop_front())
+    {
+        auto& block = blocks.front();
+        if (block.IsPacked())
+        {
+            auto unpacked = _UnpackBlock(block, std::pmr::get_default_resource());
+            if (block.spillOffset)
+            {
+                _spillFile->Free(*block.spillOffset, block.bytes);
+                _spilledBytes -= block.bytes;
+            }
+            block = std::move(unpacked);
+        }
+
+        for (size_t i = 0; i < block.rows.size(); ++i)
+        {
+            const auto& row = til::at(block.rows, i);
+            if (block.firstRow + gsl::narrow_cast<int64_t>(i) >= rewrapEnd)
+            {
+                // The logical line that reaches into the rows that have the new width already stays broken up.
+                if (column != 0)
+                {
+                    appendLine(true);
+                }
+                appendRow(row);
+                continue;
+            }
+
+            const auto& charRow = row.GetCharRow();
+            auto right = charRow.MeasureRight();
+            if (charRow.WasWrapForced())
+            {
+                right = row.size() - (charRow.WasDoubleBytePadded() ? 1 : 0);
+            }
+
+            for (size_t sourceColumn = 0; sourceColumn < right;)
+            {
+                // A full row is only appended once there's more to come, so that it
+                // doesn't end up wrapped onto an empty row if the logical line ends.
+                if (column == width)
+                {
+                    appendLine(true);
+                }
+
+                auto count = std::min(right - sourceColumn, width - column);
+                if (sourceColumn + count < right && charRow.DbcsAttrAt(sourceColumn + count - 1).IsLeading())
+                {
+                    if (count == 1 && column != 0)
+                    {
+                        line.GetCharRow().SetDoubleBytePadded(true);
+                        appendLine(true);
+                        continue;
+                    }
+                    count -= count > 1 ? 1 : 0;
+                }
+
+                line.GetCharRow().CopyCellsFrom(charRow, sourceColumn, count, column);
+                THROW_IF_FAILED(line.GetAttrRow().CopyAttrsToEnd(row.GetAttrRow(), sourceColumn, count, column));
+                sourceColumn += count;
+                column += count;
+            }
+
+            if (!charRow.WasWrapForced())
+            {
+                appendLine(false);
+            }
+        }
+    }
+
+    if (column != 0)
+    {
+        appendLine(true);
+    }
+
+    // Now that the rows are all there, they're numbered to end where they did before.
+    const auto offset = endRow - _endRow;
+    for (auto& block : _blocks)
+    {
+        block.firstRow += offset;
+    }
+    restoreEndRow.reset();
+    _Trim();
+}
+
+// Routine Description:
+// - Marks the attributes of the rows that aren't packed, see TextAttributeTable::Marker.
+// Arguments:
+// - table - The table that's being collected.
+// Return Value:
+// - <none>
+void Scrollback::_MarkAttributes(TextAttributeTable& table) const noexcept
+{
+    const auto mark = [&](const Block& block) noexcept {
+        for (const auto& row : block.rows)
+        {
+            row.GetAttrRow().MarkAttributes(table);
+        }
+    };
+
+    std::for_each(_blocks.begin() + _packedBlocks, _blocks.end(), mark);
+    std::for_each(_unpacked.begin(), _unpacked.end(), mark);
+    if (_unpacking)
+    {
+        mark(*_unpacking);
+    }
+    if (_rewrapping)
+    {
+        std::for_each(_rewrapping->begin(), _rewrapping->end(), mark);
+    }
+    if (_rewrapRow)
+    {
+        _rewrapRow->GetAttrRow().MarkAttributes(table);
+    }
+}
+
+// Routine Description:
+// - Gets the memory that a block takes up, which is none once it's spilled.
+// Arguments:
+// - block - The block.
+// Return Value:
+// - The memory in bytes.
+size_t Scrollback::_GetResidentBytes(const Block& block) noexcept
+{
+    return block.spillOffset ? 0 : block.bytes;
+}
+
+// Routine Description:
+// - Gets the memory that a row takes up beyond its cells, which are accounted for with their block.
+// Arguments:
+// - row - The row.
+// Return Value:
+// - The memory in bytes.
+size_t Scrollback::_GetRowBytes(const ROW& row) noexcept
+{
+    return row.GetAttrRow().GetNumberOfRuns() * sizeof(TextAttributeTable::Run);
+}
+
+// Routine Description:
+// - Appends a row to the bytes of a packed block. A packed row is:
+//   - its width, its flags, and the number of cells that are packed. The
+//     spaces at the end of the row aren't, unless they're part of a DBCS
+//     character.
+//   - runs of cells of the same kind: the kind, the number of cells unless
+//     it's LongGlyphKind, and the glyphs of the cells. The glyph of a cell of
+//     LongGlyphKind is preceded by its length.
+//   - the number of attribute runs, and each run's length and attribute.
+// Arguments:
+// - row - The row to pack.
+// - packed - The bytes to append to.
+// Return Value:
+// - <none>
+void Scrollback::_PackRow(const ROW& row, std::vector<BYTE>& packed)
+{
+    const auto& charRow = row.GetCharRow();
+    const auto width = row.size();
+
+    auto length = charRow.MeasureRight();
+    for (auto column = length; column < width; ++column)
+    {
+        if (!charRow.DbcsAttrAt(column).IsSingle())
+        {
+            length = column + 1;
+        }
+    }
+
+    BYTE flags = 0;
+    WI_SetFlagIf(flags, WrapForcedFlag, charRow.WasWrapForced());
+    WI_SetFlagIf(flags, DoubleBytePaddedFlag, charRow.WasDoubleBytePadded());
+    WriteSize(packed, width);
+    packed.push_back(flags);
+    WriteSize(packed, length);
+
+    for (size_t column = 0; column < length;)
+    {
+        const std::wstring_view glyph = charRow.GlyphAt(column);
+        const auto kind = GetCellKind(charRow.DbcsAttrAt(column), glyph);
+        packed.push_back(kind);
+
+        if (WI_IsFlagSet(kind, LongGlyphKind))
+        {
+            WriteSize(packed, glyph.size());
+            WriteValues<wchar_t>(packed, glyph);
+            ++column;
+            continue;
+        }
+
+        auto end = column + 1;
+        while (end < length && GetCellKind(charRow.DbcsAttrAt(end), charRow.GlyphAt(end)) == kind)
+        {
+            ++end;
+        }
+
+        WriteSize(packed, end - column);
+        for (; column < end; ++column)
+        {
+            WriteValues<wchar_t>(packed, std::wstring_view{ charRow.GlyphAt(column) });
+        }
+    }
+
+    // The attribute row only hands out attributes by column, so the runs are found again here.
+    std::vector<TextAttributeRun> runs;
+    for (const auto& attr : row.GetAttrRow())
+    {
+        if (!runs.empty() && runs.back().GetAttributes() == attr)
+        {
+            runs.back().IncrementLength();
+        }
+        else
+        {
+            runs.emplace_back(1, attr);
+        }
+    }
+
+    WriteSize(packed, runs.size());
+    for (const auto& run : runs)
+    {
+        WriteSize(packed, run.GetLength());
+        WriteValues<TextAttribute>(packed, { &run.GetAttributes(), 1 });
+    }
+}
+
+// Routine Description:
+// - Unpacks the rows of a packed block into a new block.
+// Arguments:
+// - block - The packed block.
+// - packed - The bytes of the block, wherever they're kept.
+// - resource - The resource to allocate the attribute runs of the rows from.
+// Return Value:
+// - The unpacked block.
+Scrollback::Block Scrollback::_Unpack(const Block& block, const gsl::span<const BYTE> packed, std::pmr::memory_resource* const resource) const
+{
+    Block unpacked{ block.firstRow, block.rowCount, std::make_unique<CharRowCell[]>(block.cellsUsed), block.cellsUsed, 0, {}, {}, std::nullopt, 0 };
+    unpacked.rows.reserve(block.rowCount);
+
+    // Interning the attributes of a row may reclaim IDs, which mustn't include the ones of the rows before it.
+    _unpacking = &unpacked;
+    auto clearUnpacking = wil::scope_exit([&]() noexcept { _unpacking = nullptr; });
+    unpacked.bytes = unpacked.cellCapacity * sizeof(CharRowCell) + block.rowCount * sizeof(ROW);
+
+    PackedReader reader{ packed };
+    std::wstring glyph;
+    std::vector<TextAttributeRun> runs;
+    for (size_t i = 0; i < block.rowCount; ++i)
+    {
+        const auto width = reader.ReadSize();
+        THROW_HR_IF(E_UNEXPECTED, width > unpacked.cellCapacity - unpacked.cellsUsed);
+
+        const gsl::span<CharRowCell> cells{ unpacked.cells.get() + unpacked.cellsUsed, width };
+        auto& row = unpacked.rows.emplace_back(cells, TextAttribute{}, _attributeTable, resource, nullptr, 0);
+        unpacked.cellsUsed += width;
+
+        auto& charRow = row.GetCharRow();
+        const auto flags = reader.ReadByte();
+        charRow.SetWrapForced(WI_IsFlagSet(flags, WrapForcedFlag));
+        charRow.SetDoubleBytePadded(WI_IsFlagSet(flags, DoubleBytePaddedFlag));
+
+        const auto length = reader.ReadSize();
+        THROW_HR_IF(E_UNEXPECTED, length > width);
+        for (size_t column = 0; column < length;)
+        {
+            const auto kind = reader.ReadByte();
+            size_t count = 1;
+            if (WI_IsFlagSet(kind, LongGlyphKind))
+            {
+                glyph.resize(reader.ReadSize());
+                reader.ReadValues<wchar_t>(glyph);
+                charRow.GlyphAt(column) = glyph;
+            }
+            else
+            {
+                // A run of glyphs that each fit into a cell is copied into the cells all at once.
+                count = reader.ReadSize();
+                THROW_HR_IF(E_UNEXPECTED, count > length - column);
+                glyph.resize(count);
+                reader.ReadValues<wchar_t>(glyph);
+                charRow.WriteAscii(glyph, column);
+            }
+
+            for (const auto end = column + count; column < end; ++column)
+            {
+                auto& attr = charRow.DbcsAttrAt(column);
+                if (WI_IsFlagSet(kind, LeadingKind))
+                {
+                    attr.SetLeading();
+                }
+                else if (WI_IsFlagSet(kind, TrailingKind))
+                {
+                    attr.SetTrailing();
+                }
+            }
+        }
+
+        runs.resize(reader.ReadSize());
+        for (auto& run : runs)
+        {
+            run.SetLength(reader.ReadSize());
+            TextAttribute attr;
+            reader.ReadValues<TextAttribute>({ &attr, 1 });
+            run.SetAttributes(attr);
+        }
+
+        if (!runs.empty())
+        {
+            THROW_IF_FAILED(row.GetAttrRow().InsertAttrRuns(runs, 0, width - 1, width));
+        }
+        unpacked.bytes += _GetRowBytes(row);
+    }
+
+    return unpacked;
+}
@@ -0,0 +1,175 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- Scrollback.hpp
+
+Abstract:
+- Keeps the rows that scrolled off the top of a TextBuffer: search-only
+  history beyond the height that the buffer can address with a COORD.
+- The viewport, selection and renderer still address rows with a COORD, so
+  these rows can't be scrolled to or selected. Only the APIs that read rows
+  by their absolute row reach them: search, export and the search index.
+- Rows are numbered by their absolute row: the number of rows that scrolled
+  off before them. Unlike buffer coordinates, absolute rows don't change as
+  more rows scroll off.
+- The rows are copied into blocks of cells that are allocated as they're
+  needed. Once the rows take up more memory than the budget allows, or
+  there are more of them than the row limit allows, the oldest block is
+  dropped, so trimming never moves any rows around.
+- Blocks whose rows are all further than the cold threshold from the end
+  are packed: the blanks at the end of each row are dropped and the cells
+  and attribute runs are written into a single array of bytes. A packed
+  block is only unpacked again when one of its rows is asked for, into a
+  small cache that isn't counted against the budget.
+- Packed blocks can be spilled to a temporary file instead of being kept in
+  memory, so that only the newest rows and the cache take up memory. Spilled
+  blocks don't count against the budget, only against the row limit.
+- When the buffer is resized, the rows are rewrapped to the new width by
+  their logical lines: the rows that were joined because text wrapped off
+  their end. Rewrapping waits until rows are asked for again, so that a
+  series of resizes only rewraps once. The end row stays the same, so the
+  absolute rows of the rows in the buffer don't change. The first row moves
+  instead, and may even become negative.
+- Hyperlink IDs of the rows aren't kept alive. The TextBuffer forgets the
+  hyperlinks that are no longer referenced by any of its own rows.
+--*/
+
+#pragma once
+
+#include "Row.hpp"
+#include "ScrollbackFile.hpp"
+
+class Scrollback final
+{
+public:
+    // The number of rows that are allocated at once. A row that's wider than
+    // the rows before it starts a new block.
+    static constexpr size_t BlockRows = 256;
+
+    // The number of rows from the end that are kept unpacked unless set otherwise.
+    static constexpr size_t DefaultColdThreshold = 4 * BlockRows;
+
+    // The number of packed blocks that are kept unpacked after their rows were asked for.
+    static constexpr size_t UnpackedBlocks = 2;
+
+    struct Stats
+    {
+        // The rows that are kept in memory, whether they're packed or not. This is what GetUsage returns.
+        size_t residentBytes;
+        // The copies of packed blocks that were unpacked because their rows were asked for.
+        size_t unpackedBytes;
+        // The packed blocks that were spilled to the file.
+        uint64_t spilledBytes;
+        // The size of the file, including the extents that were freed.
+        uint64_t fileBytes;
+    };
+
+    Scrollback() noexcept;
+
+    Scrollback(const Scrollback&) = delete;
+    Scrollback& operator=(const Scrollback&) = delete;
+
+    void SetBudget(const size_t bytes) noexcept;
+    size_t GetBudget() const noexcept;
+    size_t GetUsage() const noexcept;
+
+    void SetRowLimit(const size_t rows) noexcept;
+    size_t GetRowLimit() const noexcept;
+
+    void SetColdThreshold(const size_t rows) noexcept;
+    size_t GetColdThreshold() const noexcept;
+
+    void SetSpillToDisk(const bool spill) noexcept;
+    bool GetSpillToDisk() const noexcept;
+    Stats GetStats() const noexcept;
+
+    int64_t GetFirstRow() const noexcept;
+    int64_t GetEndRow() const noexcept;
+    size_t size() const noexcept;
+
+    void Append(const ROW& row) noexcept;
+    void Truncate(const int64_t endRow) noexcept;
+    void Clear() noexcept;
+
+    void Rewrap(const int64_t endRow, const size_t width) noexcept;
+    void FinishRewrap() noexcept;
+    bool IsRewrapPending() const noexcept;
+
+    const ROW& GetRow(const int64_t row) const;
+
+    static size_t EstimateRowBytes(const size_t width) noexcept;
+
+private:
+    struct Block
+    {
+        int64_t firstRow;
+        size_t rowCount;
+        // The cells of all rows. Packed blocks still count them, but don't keep them.
+        std::unique_ptr<CharRowCell[]> cells;
+        size_t cellCapacity;
+        size_t cellsUsed;
+        std::vector<ROW> rows;
+        // The rows of a packed block, see _PackRow. Empty once they're spilled to the file at spillOffset.
+        std::vector<BYTE> packed;
+        std::optional<uint64_t> spillOffset;
+        size_t bytes;
+
+        bool IsPacked() const noexcept
+        {
+            return rowCount != 0 && rows.empty();
+        }
+    };
+
+    void _AppendRow(const ROW& row);
+    void _Trim() noexcept;
+    void _Pack() noexcept;
+    void _Spill(Block& block) noexcept;
+    Block _UnpackBlock(const Block& block, std::pmr::memory_resource* const resource) const;
+    void _UnpackBack();
+    void _ForgetPacked(const Block& block) noexcept;
+    void _Rewrap(const size_t width);
+
+    Block _Unpack(const Block& block, const gsl::span<const BYTE> packed, std::pmr::memory_resource* const resource) const;
+    void _MarkAttributes(TextAttributeTable& table) const noexcept;
+
+    static size_t _GetResidentBytes(const Block& block) noexcept;
+    static size_t _GetRowBytes(const ROW& row) noexcept;
+    static void _PackRow(const ROW& row, std::vector<BYTE>& packed);
+
+    // The attributes of the rows are interned in this table, and their runs are
+    // allocated from this pool. Both must outlive the blocks. Packed blocks keep
+    // whole attributes, so the table only has to mark the rows that aren't packed.
+    mutable TextAttributeTable _attributeTable;
+    std::pmr::unsynchronized_pool_resource _attrRunPool;
+    std::deque<Block> _blocks;
+    // The packed blocks are always the oldest ones.
+    size_t _packedBlocks;
+    // Copies of packed blocks whose rows were asked for, the most recently used last.
+    mutable std::deque<Block> _unpacked;
+    // The block that _Unpack is filling in, whose rows aren't anywhere else yet.
+    mutable const Block* _unpacking;
+    // The blocks that are being rewrapped and the row that's being filled, which aren't in _blocks.
+    const std::deque<Block>* _rewrapping;
+    const ROW* _rewrapRow;
+    // Created when the first block is spilled, and closed when the scrollback is cleared.
+    std::unique_ptr<ScrollbackFile> _spillFile;
+    bool _spill;
+    uint64_t _spilledBytes;
+
+    int64_t _endRow;
+    size_t _budget;
+    // The memory that the blocks take up, not counting the spilled ones.
+    size_t _usage;
+    size_t _rowLimit;
+    size_t _coldThreshold;
+    // The rows before _rewrapEnd are rewrapped to _rewrapWidth once rows are
+    // asked for. 0 if there's nothing to rewrap.
+    int64_t _rewrapEnd;
+    size_t _rewrapWidth;
+
+#ifdef UNIT_TESTING
+    friend class TextBufferTests;
+#endif
+};
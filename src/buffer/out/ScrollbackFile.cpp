@@ -0,0 +1,214 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "ScrollbackFile.hpp"
+
+#pragma hdrstop
+
+// The size of the file when it's first mapped. It at least doubles whenever it runs out of space.
+static constexpr uint64_t InitialFileSize = 4 * 1024 * 1024;
+
+ScrollbackFile::View::View(wil::unique_mapview_ptr<BYTE> view, const size_t offset, const size_t size) noexcept :
+    _view{ std::move(view) },
+    _bytes{ _view.get() + offset, size }
+{
+}
+
+gsl::span<BYTE> ScrollbackFile::View::Bytes() const noexcept
+{
+    return _bytes;
+}
+
+// Routine Description:
+// - Creates a new temporary file. Nothing is mapped until the first write.
+// Arguments:
+// - <none>
+// Return Value:
+// - Throws if the file can't be created.
+ScrollbackFile::ScrollbackFile() :
+    _file{},
+    _mapping{},
+    _granularity{ 0 },
+    _size{ 0 },
+    _end{ 0 },
+    _free{}
+{
+    wchar_t directory[MAX_PATH + 1];
+    const auto length = GetTempPathW(ARRAYSIZE(directory), directory);
+    THROW_LAST_ERROR_IF(length == 0 || length > ARRAYSIZE(directory));
+
+    wchar_t path[MAX_PATH];
+    THROW_LAST_ERROR_IF(GetTempFileNameW(directory, L"sbk", 0, path) == 0);
+
+    // The file is only ever reached through this handle, so it's deleted as soon as the handle is closed.
+    _file.reset(CreateFileW(path,
+                            GENERIC_READ | GENERIC_WRITE,
+                            0,
+                            nullptr,
+                            CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                            nullptr));
+    THROW_LAST_ERROR_IF(!_file);
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    _granularity = info.dwAllocationGranularity;
+}
+
+// Routine Description:
+// - Writes bytes into a free extent of the file, growing it if there isn't one.
+// Arguments:
+// - bytes - The bytes to write. Must not be empty.
+// Return Value:
+// - The offset that the bytes were written at, to Map and Free them with.
+uint64_t ScrollbackFile::Write(const gsl::span<const BYTE> bytes)
+{
+    THROW_HR_IF(E_INVALIDARG, bytes.empty());
+
+    const auto offset = _Allocate(bytes.size());
+    try
+    {
+        const auto view = Map(offset, bytes.size());
+        std::copy(bytes.begin(), bytes.end(), view.Bytes().begin());
+    }
+    catch (...)
+    {
+        Free(offset, bytes.size());
+        throw;
+    }
+    return offset;
+}
+
+// Routine Description:
+// - Maps bytes that were written into memory.
+// Arguments:
+// - offset - The offset that Write returned.
+// - size - The number of bytes that were written.
+// Return Value:
+// - The view of the bytes.
+ScrollbackFile::View ScrollbackFile::Map(const uint64_t offset, const size_t size) const
+{
+    THROW_HR_IF(E_INVALIDARG, size == 0 || offset > _end || size > _end - offset);
+
+    // Views have to start at a multiple of the allocation granularity.
+    const auto viewOffset = offset - offset % _granularity;
+    const auto viewSize = gsl::narrow<size_t>(offset - viewOffset) + size;
+    wil::unique_mapview_ptr<BYTE> view{ static_cast<BYTE*>(MapViewOfFile(_mapping.get(),
+                                                                         FILE_MAP_READ | FILE_MAP_WRITE,
+                                                                         static_cast<DWORD>(viewOffset >> 32),
+                                                                         static_cast<DWORD>(viewOffset),
+                                                                         viewSize)) };
+    THROW_LAST_ERROR_IF(!view);
+    return { std::move(view), gsl::narrow_cast<size_t>(offset - viewOffset), size };
+}
+
+// Routine Description:
+// - Frees an extent that was written, so that later writes can reuse it.
+// Arguments:
+// - offset - The offset that Write returned.
+// - size - The number of bytes that were written.
+// Return Value:
+// - <none>
+void ScrollbackFile::Free(const uint64_t offset, const size_t size) noexcept
+{
+    auto start = offset;
+    auto end = offset + size;
+
+    // Merge the extent with the free ones right before and after it.
+    const auto next = _free.lower_bound(start);
+    if (next != _free.end() && next->first == end)
+    {
+        end += next->second;
+        _free.erase(next);
+    }
+
+    const auto after = _free.lower_bound(start);
+    if (after != _free.begin())
+    {
+        const auto previous = std::prev(after);
+        if (previous->first + previous->second == start)
+        {
+            start = previous->first;
+            _free.erase(previous);
+        }
+    }
+
+    if (end == _end)
+    {
+        _end = start;
+        return;
+    }
+
+    try
+    {
+        _free.emplace(start, end - start);
+    }
+    CATCH_LOG(); // The extent is only lost until the file is closed.
+}
+
+// Routine Description:
+// - Gets the size of the file on disk, including the extents that are free.
+uint64_t ScrollbackFile::GetSize() const noexcept
+{
+    return _size;
+}
+
+// Routine Description:
+// - Finds room for an extent: the first free extent that's large enough, or
+//   the end of the file.
+// Arguments:
+// - size - The size of the extent.
+// Return Value:
+// - The offset of the extent.
+uint64_t ScrollbackFile::_Allocate(const size_t size)
+{
+    const auto fit = std::find_if(_free.begin(), _free.end(), [=](const auto& extent) noexcept {
+        return extent.second >= size;
+    });
+
+    if (fit != _free.end())
+    {
+        const auto [offset, freeSize] = *fit;
+        _free.erase(fit);
+        if (freeSize > size)
+        {
+            _free.emplace(offset + size, freeSize - size);
+        }
+        return offset;
+    }
+
+    if (size > _size - _end)
+    {
+        _Grow(_end + size);
+    }
+
+    const auto offset = _end;
+    _end += size;
+    return offset;
+}
+
+// Routine Description:
+// - Grows the file by mapping it again with a larger size. Views of the old
+//   mapping stay valid until they're unmapped.
+// Arguments:
+// - minimumSize - The size that the file needs to have at least.
+// Return Value:
+// - <none>
+void ScrollbackFile::_Grow(const uint64_t minimumSize)
+{
+    auto size = std::max({ InitialFileSize, _size * 2, minimumSize });
+    size += _granularity - 1;
+    size -= size % _granularity;
+
+    wil::unique_handle mapping{ CreateFileMappingW(_file.get(),
+                                                   nullptr,
+                                                   PAGE_READWRITE,
+                                                   static_cast<DWORD>(size >> 32),
+                                                   static_cast<DWORD>(size),
+                                                   nullptr) };
+    THROW_LAST_ERROR_IF(!mapping);
+
+    _mapping = std::move(mapping);
+    _size = size;
+}
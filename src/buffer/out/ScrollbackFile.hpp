@@ -0,0 +1,60 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ScrollbackFile.hpp
+
+Abstract:
+- A temporary file that the Scrollback spills packed blocks of rows into,
+  so that they don't have to stay in memory.
+- The file is deleted by the system once it's closed. It's read and written
+  through views of a file mapping, so that the system pages the bytes in
+  and out instead of copying them through another buffer.
+- Extents that are freed are reused by later writes. The file doesn't
+  shrink until it's closed.
+--*/
+
+#pragma once
+
+class ScrollbackFile final
+{
+public:
+    // A mapped view of a range of bytes of the file. Unmapped when it goes away.
+    class View final
+    {
+    public:
+        View(wil::unique_mapview_ptr<BYTE> view, const size_t offset, const size_t size) noexcept;
+
+        gsl::span<BYTE> Bytes() const noexcept;
+
+    private:
+        wil::unique_mapview_ptr<BYTE> _view;
+        gsl::span<BYTE> _bytes;
+    };
+
+    ScrollbackFile();
+
+    ScrollbackFile(const ScrollbackFile&) = delete;
+    ScrollbackFile& operator=(const ScrollbackFile&) = delete;
+
+    uint64_t Write(const gsl::span<const BYTE> bytes);
+    View Map(const uint64_t offset, const size_t size) const;
+    void Free(const uint64_t offset, const size_t size) noexcept;
+
+    uint64_t GetSize() const noexcept;
+
+private:
+    uint64_t _Allocate(const size_t size);
+    void _Grow(const uint64_t minimumSize);
+
+    wil::unique_hfile _file;
+    wil::unique_handle _mapping;
+    DWORD _granularity;
+
+    // The size of the file, and the end of the extents that were written to it.
+    uint64_t _size;
+    uint64_t _end;
+    // The extents before _end that were freed, by their offset. Adjacent ones are merged.
+    std::map<uint64_t, uint64_t> _free;
+};
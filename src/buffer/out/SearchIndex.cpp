@@ -0,0 +1,411 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "SearchIndex.hpp"
+
+#pragma hdrstop
+
+SearchIndex::SearchIndex() noexcept :
+    _needle{},
+    _caseSensitive{ true },
+    _shift{},
+    _width{ 0 },
+    _bufferRow{ 0 },
+    _matches{},
+    _sealedCount{ 0 },
+    _sealedEnd{ std::numeric_limits<int64_t>::min() },
+    _lines{},
+    _trigrams{},
+    _trigramWidth{ 0 },
+    _trigramRevision{ 0 },
+    _text{},
+    _starts{},
+    _ends{}
+{
+}
+
+// Routine Description:
+// - Sets the search term. The matches are found again on the next Update,
+//   unless the term stayed the same.
+// Arguments:
+// - needle - The search term.
+// - caseSensitive - Whether the case of the letters has to match.
+// Return Value:
+// - <none>
+void SearchIndex::SetNeedle(const std::wstring_view needle, const bool caseSensitive)
+{
+    std::wstring folded{ needle };
+    if (!caseSensitive)
+    {
+        std::transform(folded.begin(), folded.end(), folded.begin(), ::towlower);
+    }
+
+    if (folded == _needle && caseSensitive == _caseSensitive)
+    {
+        return;
+    }
+
+    _needle = std::move(folded);
+    _caseSensitive = caseSensitive;
+
+    // A character that isn't in the needle moves it along by its whole length.
+    // Characters share an entry with the ones that have the same low byte,
+    // which can only make the needle move along less than it could.
+    _shift.fill(_needle.size());
+    for (size_t i = 0; i + 1 < _needle.size(); ++i)
+    {
+        til::at(_shift, til::at(_needle, i) & 0xFF) = _needle.size() - 1 - i;
+    }
+
+    _ClearMatches();
+}
+
+// Routine Description:
+// - Forgets every match and the trigram index, so that they're all found
+//   again on the next Update. Call this when searching a different buffer.
+void SearchIndex::Invalidate() noexcept
+{
+    _ClearMatches();
+    _trigrams.Clear();
+}
+
+// Routine Description:
+// - Forgets every match, so that they're all found again on the next Update.
+void SearchIndex::_ClearMatches() noexcept
+{
+    _width = 0;
+    _bufferRow = 0;
+    _matches.clear();
+    _sealedCount = 0;
+    _sealedEnd = std::numeric_limits<int64_t>::min();
+    _lines.clear();
+}
+
+// Routine Description:
+// - Brings the matches up to date with the buffer. The lines that scrolled
+//   off since the last time and the lines in the buffer that changed are
+//   searched. The matches in the rows that were dropped from the scrollback
+//   are forgotten.
+// Arguments:
+// - buffer - The buffer to search. It has to be the same one every time, unless
+//   Invalidate is called in between.
+// Return Value:
+// - <none>
+void SearchIndex::Update(const TextBuffer& buffer)
+{
+    const auto& scrollback = buffer.GetScrollback();
+    const auto width = gsl::narrow_cast<size_t>(buffer.GetSize().Width());
+    const auto firstRow = scrollback.GetFirstRow();
+    const auto bufferRow = buffer.GetFirstAbsoluteRow();
+    const auto endRow = bufferRow + buffer.GetSize().Height();
+
+    // The rows only ever move up, unless the buffer was resized, which rewraps them.
+    if (width != _width || bufferRow < _bufferRow)
+    {
+        _ClearMatches();
+        _width = width;
+    }
+    _bufferRow = bufferRow;
+    _CheckTrigrams(buffer);
+
+    _sealedEnd = std::max(_sealedEnd, firstRow);
+    _matches.resize(_sealedCount);
+    const auto kept = std::partition_point(_matches.begin(), _matches.end(), [=](const auto& match) {
+        return match.start.y() < firstRow;
+    });
+    _matches.erase(_matches.begin(), kept);
+    _sealedCount = _matches.size();
+
+    if (_needle.empty())
+    {
+        return;
+    }
+
+    std::unordered_map<int64_t, _Line> lines;
+    for (auto row = _sealedEnd; row < endRow;)
+    {
+        // Only the lines in the trigram index that might contain the needle
+        // have to be searched. The walk has to reach the start of one of its
+        // lines first, in case the index started in the middle of a line.
+        // The matches of the lines that are all in the scrollback are kept.
+        // The candidates in the buffer are searched again every time.
+        if (const auto line = _trigrams.FindLine(row))
+        {
+            if (const auto candidates = _trigrams.FindCandidates(_needle, *line))
+            {
+                for (const auto candidate : *candidates)
+                {
+                    const auto [candidateFirstRow, candidateLastRow] = _trigrams.GetLine(candidate);
+                    _SearchLine(buffer, candidateFirstRow, candidateLastRow, _matches);
+                    if (candidateLastRow < bufferRow)
+                    {
+                        _sealedCount = _matches.size();
+                    }
+                }
+                _sealedEnd = bufferRow < row ? row : _trigrams.GetLineFirstRow(bufferRow);
+                row = _trigrams.GetEndRow();
+                continue;
+            }
+        }
+
+        const auto lineFirstRow = row;
+        while (row + 1 < endRow && buffer.GetRowByAbsoluteIndex(row).GetCharRow().WasWrapForced())
+        {
+            ++row;
+        }
+        const auto lineLastRow = row++;
+
+        auto found = _lines.find(lineFirstRow);
+        if (found == _lines.end() || !_IsUnchanged(buffer, found->second, lineFirstRow, lineLastRow))
+        {
+            found = _lines.insert_or_assign(lineFirstRow, _Line{ lineLastRow, buffer.GetRevision(), bufferRow, {} }).first;
+            _SearchLine(buffer, lineFirstRow, lineLastRow, found->second.matches);
+        }
+
+        _matches.insert(_matches.end(), found->second.matches.begin(), found->second.matches.end());
+        if (lineLastRow < bufferRow)
+        {
+            // The line is all in the scrollback now, so its matches stay as they are.
+            _sealedCount = _matches.size();
+            _sealedEnd = row;
+        }
+        else
+        {
+            lines.insert(_lines.extract(found));
+        }
+    }
+    _lines = std::move(lines);
+}
+
+// Routine Description:
+// - Gets every match, in the order of their first cells.
+const std::vector<SearchIndex::Match>& SearchIndex::GetMatches() const noexcept
+{
+    return _matches;
+}
+
+// Routine Description:
+// - Sets how much memory the trigram index of the scrollback may take up.
+// Arguments:
+// - bytes - The budget in bytes. With 0, the index isn't built at all.
+// Return Value:
+// - <none>
+void SearchIndex::SetTrigramBudget(const size_t bytes) noexcept
+{
+    _trigrams.SetBudget(bytes);
+    if (bytes == 0)
+    {
+        _trigrams.Clear();
+    }
+}
+
+// Routine Description:
+// - Adds the lines of the history to the trigram index, a few rows at a
+//   time, so that it can be done in the background between writes. The
+//   lines in the scrollback come first, then the ones in the buffer above
+//   the given row. The index is built again from the start when the rows
+//   of its lines change, or when they're rewrapped.
+// Arguments:
+// - buffer - The buffer to index.
+// - endRow - The absolute row that the history ends at: the top of the
+//   viewport, which the rows above it aren't written to from.
+// - maxRows - The most rows to index this time. A line is never split up,
+//   so a long one may go over.
+// Return Value:
+// - True if there are more rows to index. False if they're all indexed, or
+//   the index is over its budget.
+bool SearchIndex::IndexScrollback(const TextBuffer& buffer, const int64_t endRow, const size_t maxRows)
+{
+    _CheckTrigrams(buffer);
+    if (_trigrams.GetBudget() == 0)
+    {
+        return false;
+    }
+
+    const auto bufferEndRow = buffer.GetFirstAbsoluteRow() + buffer.GetSize().Height();
+    const auto historyEndRow = std::min(endRow, bufferEndRow);
+    auto row = _trigrams.size() == 0 ? buffer.GetScrollback().GetFirstRow() : _trigrams.GetEndRow();
+    auto more = true;
+    for (size_t rows = 0; row < historyEndRow && rows < maxRows;)
+    {
+        const auto lineFirstRow = row;
+        while (row + 1 < bufferEndRow && buffer.GetRowByAbsoluteIndex(row).GetCharRow().WasWrapForced())
+        {
+            ++row;
+        }
+        const auto lineLastRow = row++;
+
+        // A line that wraps into the viewport can still change.
+        if (lineLastRow >= historyEndRow)
+        {
+            more = false;
+            break;
+        }
+
+        _ReadLine(buffer, lineFirstRow, lineLastRow, false);
+        if (!_trigrams.AddLine(lineFirstRow, lineLastRow, _text))
+        {
+            more = false;
+            break;
+        }
+        rows += gsl::narrow_cast<size_t>(row - lineFirstRow);
+    }
+
+    // Reading the rows may have written them, if they were still pending
+    // after a resize (see PendingReflow), so the revision is taken after.
+    _trigramRevision = buffer.GetRevision();
+    return more && row < historyEndRow;
+}
+
+// Routine Description:
+// - Brings the trigram index up to date with the history. The lines whose
+//   first rows were dropped are dropped from it. It's cleared if the rows
+//   of any of its lines that are in the buffer changed since they were
+//   read, or if they were rewrapped.
+// Arguments:
+// - buffer - The buffer.
+// Return Value:
+// - <none>
+void SearchIndex::_CheckTrigrams(const TextBuffer& buffer)
+{
+    const auto width = gsl::narrow_cast<size_t>(buffer.GetSize().Width());
+    const auto bufferRow = buffer.GetFirstAbsoluteRow();
+    _trigrams.DropLinesBefore(buffer.GetScrollback().GetFirstRow());
+    if (_trigrams.size() != 0)
+    {
+        const auto firstRow = std::max(_trigrams.GetFirstRow(), bufferRow);
+        const auto endRow = _trigrams.GetEndRow();
+        if (width != _trigramWidth ||
+            endRow > bufferRow + buffer.GetSize().Height() ||
+            (endRow > firstRow &&
+             !buffer.GetRowsChangedSince(_trigramRevision,
+                                         gsl::narrow_cast<size_t>(firstRow - bufferRow),
+                                         gsl::narrow_cast<size_t>(endRow - 1 - bufferRow))
+                  .empty()))
+        {
+            _trigrams.Clear();
+        }
+    }
+    _trigramWidth = width;
+    _trigramRevision = buffer.GetRevision();
+}
+
+// Routine Description:
+// - Checks whether the matches that were found in a line are still there.
+// Arguments:
+// - buffer - The buffer.
+// - line - The line as it was searched.
+// - firstRow - The first absolute row of the line now.
+// - lastRow - The last absolute row of the line now.
+// Return Value:
+// - True if none of the line's rows changed since it was searched.
+bool SearchIndex::_IsUnchanged(const TextBuffer& buffer, const _Line& line, const int64_t firstRow, const int64_t lastRow) const
+{
+    if (line.lastRow != lastRow)
+    {
+        return false;
+    }
+
+    // The rows that scrolled off since the line was searched might have
+    // changed before they did. Their revisions don't come along.
+    const auto bufferRow = buffer.GetFirstAbsoluteRow();
+    if (std::max(line.bufferRow, firstRow) < std::min(bufferRow, lastRow + 1))
+    {
+        return false;
+    }
+
+    if (lastRow < bufferRow)
+    {
+        return true;
+    }
+
+    const auto first = gsl::narrow_cast<size_t>(std::max(firstRow, bufferRow) - bufferRow);
+    const auto last = gsl::narrow_cast<size_t>(lastRow - bufferRow);
+    return buffer.GetRowsChangedSince(line.revision, first, last).empty();
+}
+
+// Routine Description:
+// - Reads the text of a line into _text, folded to lower case unless the
+//   case has to match.
+// Arguments:
+// - buffer - The buffer.
+// - firstRow - The first absolute row of the line.
+// - lastRow - The last absolute row of the line.
+// - withCells - Whether to fill _starts and _ends with the cells of each character too.
+// Return Value:
+// - <none>
+void SearchIndex::_ReadLine(const TextBuffer& buffer, const int64_t firstRow, const int64_t lastRow, const bool withCells)
+{
+    _text.clear();
+    _starts.clear();
+    _ends.clear();
+    for (auto row = firstRow; row <= lastRow; ++row)
+    {
+        const auto& charRow = buffer.GetRowByAbsoluteIndex(row).GetCharRow();
+        for (size_t column = 0; column < charRow.size(); ++column)
+        {
+            const auto& dbcsAttr = charRow.DbcsAttrAt(column);
+            if (dbcsAttr.IsTrailing())
+            {
+                continue;
+            }
+
+            const auto y = gsl::narrow_cast<ptrdiff_t>(row);
+            const auto x = gsl::narrow_cast<ptrdiff_t>(column);
+            const til::point start{ x, y };
+            const til::point end{ dbcsAttr.IsLeading() && column + 1 < charRow.size() ? x + 1 : x, y };
+            for (const auto wch : charRow.GlyphAt(column))
+            {
+                _text.push_back(_caseSensitive ? wch : ::towlower(wch));
+                if (withCells)
+                {
+                    _starts.push_back(start);
+                    _ends.push_back(end);
+                }
+            }
+        }
+    }
+}
+
+// Routine Description:
+// - Finds the needle in the text of a line, with the Boyer-Moore-Horspool
+//   algorithm: the needle is compared from its end, and moved along by how
+//   far back in it the character under its last one is.
+// Arguments:
+// - buffer - The buffer.
+// - firstRow - The first absolute row of the line.
+// - lastRow - The last absolute row of the line.
+// - matches - Receives the matches.
+// Return Value:
+// - <none>
+void SearchIndex::_SearchLine(const TextBuffer& buffer, const int64_t firstRow, const int64_t lastRow, std::vector<Match>& matches)
+{
+    _ReadLine(buffer, firstRow, lastRow, true);
+
+    const auto needleSize = _needle.size();
+    if (_text.size() < needleSize)
+    {
+        return;
+    }
+
+    const auto needleLast = _needle.back();
+    const auto lastPos = _text.size() - needleSize;
+    for (size_t pos = 0; pos <= lastPos; pos += til::at(_shift, til::at(_text, pos + needleSize - 1) & 0xFF))
+    {
+        if (til::at(_text, pos + needleSize - 1) != needleLast ||
+            _text.compare(pos, needleSize - 1, _needle, 0, needleSize - 1) != 0)
+        {
+            continue;
+        }
+
+        // The needle has to cover whole glyphs.
+        const auto end = pos + needleSize;
+        if ((pos == 0 || til::at(_starts, pos - 1) != til::at(_starts, pos)) &&
+            (end == _text.size() || til::at(_starts, end - 1) != til::at(_starts, end)))
+        {
+            matches.push_back({ til::at(_starts, pos), til::at(_ends, end - 1) });
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- SearchIndex.hpp
+
+Abstract:
+- Finds every match of a search term in a TextBuffer and its scrollback, and
+  keeps them, so that they can be counted and highlighted without searching
+  the whole buffer again.
+- The text of each logical line is searched at once, so a match can span
+  the rows of a wrapped line, but not a line break. Matches start and end on
+  glyph boundaries, and may overlap, like the ones Search finds one by one.
+- Matches are kept by absolute row (see TextBuffer::GetFirstAbsoluteRow), so
+  they stay put as the buffer scrolls. Lines that have scrolled off into
+  the scrollback can't change anymore, so they're only searched once. Lines
+  in the buffer are searched again when one of their rows changes.
+- When the search term changes, the whole history has to be searched
+  again. A TrigramIndex of the lines in the history can be built a slice
+  at a time with IndexScrollback, so that only the lines that might
+  contain the term are searched then. The history is the scrollback and
+  the rows of the buffer above the viewport. Those rows aren't written to
+  in place, but they can be erased or moved, so the index is checked
+  against their revisions (see TextBuffer::GetRevision) before it's used.
+--*/
+
+#pragma once
+
+#include "textBuffer.hpp"
+#include "TrigramIndex.hpp"
+
+class SearchIndex final
+{
+public:
+    // A match, from its first cell to its last. The rows are absolute rows.
+    struct Match
+    {
+        til::point start;
+        til::point end;
+    };
+
+    SearchIndex() noexcept;
+
+    void SetNeedle(const std::wstring_view needle, const bool caseSensitive);
+    void Update(const TextBuffer& buffer);
+    void Invalidate() noexcept;
+
+    const std::vector<Match>& GetMatches() const noexcept;
+
+    void SetTrigramBudget(const size_t bytes) noexcept;
+    bool IndexScrollback(const TextBuffer& buffer, const int64_t endRow, const size_t maxRows);
+
+private:
+    // The matches of a logical line that's still in the buffer.
+    struct _Line
+    {
+        int64_t lastRow;
+        // The revision of the buffer and its first absolute row when the line
+        // was searched. See TextBuffer::GetRevision.
+        uint64_t revision;
+        int64_t bufferRow;
+        std::vector<Match> matches;
+    };
+
+    void _ClearMatches() noexcept;
+    void _CheckTrigrams(const TextBuffer& buffer);
+    bool _IsUnchanged(const TextBuffer& buffer, const _Line& line, const int64_t firstRow, const int64_t lastRow) const;
+    void _ReadLine(const TextBuffer& buffer, const int64_t firstRow, const int64_t lastRow, const bool withCells);
+    void _SearchLine(const TextBuffer& buffer, const int64_t firstRow, const int64_t lastRow, std::vector<Match>& matches);
+
+    std::wstring _needle;
+    bool _caseSensitive;
+    // How far to move the needle along, by the low byte of the character
+    // under its last one. See _SearchLine.
+    std::array<size_t, 256> _shift;
+
+    // The buffer's width and its first absolute row when it was last searched.
+    size_t _width;
+    int64_t _bufferRow;
+
+    // The matches of every line, in order. The first _sealedCount are in the
+    // lines that end before _sealedEnd, which are all in the scrollback.
+    std::vector<Match> _matches;
+    size_t _sealedCount;
+    int64_t _sealedEnd;
+    // The lines after _sealedEnd, by their first absolute row.
+    std::unordered_map<int64_t, _Line> _lines;
+
+    // The lines in the history, the buffer's width when they were indexed,
+    // and its revision when the rows of the lines that are in it were read.
+    TrigramIndex _trigrams;
+    size_t _trigramWidth;
+    uint64_t _trigramRevision;
+
+    // Reused by _ReadLine: the text of a line, and the first and last cell
+    // of the glyph that each of its characters belongs to.
+    std::wstring _text;
+    std::vector<til::point> _starts;
+    std::vector<til::point> _ends;
+
+#ifdef UNIT_TESTING
+    friend class TextBufferTests;
+#endif
+};
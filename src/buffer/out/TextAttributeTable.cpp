@@ -0,0 +1,192 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "TextAttributeTable.hpp"
+
+#pragma hdrstop
+
+// Routine Description:
+// - Packs a color into 32 bits. Its type goes into the byte that a COLORREF leaves unused.
+static uint32_t s_PackColor(const TextColor color) noexcept
+{
+    const uint32_t type = color.IsDefault() ? 0 : color.IsIndex16() ? 1 : color.IsIndex256() ? 2 : 3;
+    return type << 24 | color.GetRGB();
+}
+
+size_t TextAttributeTable::Hash::operator()(const TextAttribute& attr) const noexcept
+{
+    const auto colors = uint64_t{ s_PackColor(attr.GetForeground()) } << 32 | s_PackColor(attr.GetBackground());
+    const auto others = uint64_t{ attr.GetLegacyAttributes() } << 32 |
+                        uint64_t{ static_cast<BYTE>(attr.GetExtendedAttributes()) } << 16 |
+                        attr.GetHyperlinkId();
+
+    auto hash = std::hash<uint64_t>{}(colors);
+    hash ^= std::hash<uint64_t>{}(others) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+TextAttributeTable::TextAttributeTable() noexcept :
+    _entries{},
+    _ids{},
+    _free{},
+    _marked{},
+    _marker{}
+{
+}
+
+// Routine Description:
+// - Sets the callback that marks the IDs that are still in use, once the
+//   table runs out of IDs. Without one, IDs are never reused.
+// Arguments:
+// - marker - The callback. It must call Mark for every ID that any row still stores.
+// Return Value:
+// - <none>
+void TextAttributeTable::SetMarker(Marker marker) noexcept
+{
+    _marker = std::move(marker);
+}
+
+// Routine Description:
+// - Gets the ID of an attribute, adding it to the table if it isn't in there yet.
+// - If the table is full, the IDs that aren't in use anymore are reclaimed first,
+//   so the caller must not hold on to IDs that it didn't store in a row yet.
+//   Use Reserve to intern several attributes at once.
+// Arguments:
+// - attr - The attribute.
+// Return Value:
+// - The ID of the attribute. Throws E_OUTOFMEMORY if all IDs are in use.
+TextAttributeTable::Id TextAttributeTable::Intern(const TextAttribute& attr)
+{
+    if (const auto it = _ids.find(attr); it != _ids.end())
+    {
+        return it->second;
+    }
+
+    Reserve(1);
+
+    if (!_free.empty())
+    {
+        const auto id = _free.back();
+        _ids.emplace(attr, id);
+        _free.pop_back();
+        til::at(_entries, id) = attr;
+        return id;
+    }
+
+    const auto id = gsl::narrow_cast<Id>(_entries.size());
+    _ids.emplace(attr, id);
+    try
+    {
+        _entries.push_back(attr);
+    }
+    catch (...)
+    {
+        _ids.erase(attr);
+        throw;
+    }
+    return id;
+}
+
+// Routine Description:
+// - Makes sure that the next count attributes can be interned without
+//   reclaiming any IDs, reclaiming the unused ones now if need be.
+// Arguments:
+// - count - The number of attributes that are about to be interned.
+// Return Value:
+// - <none>. Throws E_OUTOFMEMORY if there aren't as many IDs left even after reclaiming.
+void TextAttributeTable::Reserve(const size_t count)
+{
+    if (_GetAvailable() < count)
+    {
+        _Collect();
+        THROW_HR_IF(E_OUTOFMEMORY, _GetAvailable() < count);
+    }
+}
+
+// Routine Description:
+// - Gets the ID of an attribute, if it's in the table.
+// Arguments:
+// - attr - The attribute.
+// Return Value:
+// - The ID of the attribute, or nothing if no row has used it.
+std::optional<TextAttributeTable::Id> TextAttributeTable::Find(const TextAttribute& attr) const noexcept
+{
+    const auto it = _ids.find(attr);
+    if (it == _ids.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+// Routine Description:
+// - Gets the attribute that an ID stands for.
+// Arguments:
+// - id - An ID that was returned by Intern and is still in use.
+// Return Value:
+// - The attribute. The reference stays valid until the ID is reclaimed.
+const TextAttribute& TextAttributeTable::Get(const Id id) const noexcept
+{
+    return til::at(_entries, id);
+}
+
+// Routine Description:
+// - Marks an ID as still in use. Only meaningful while the marker is called.
+// Arguments:
+// - id - The ID.
+// Return Value:
+// - <none>
+void TextAttributeTable::Mark(const Id id) noexcept
+{
+    if (id < _marked.size())
+    {
+        _marked[id] = true;
+    }
+}
+
+// Routine Description:
+// - Gets the number of distinct attributes in the table, including the ones
+//   that aren't in use anymore but weren't reclaimed yet.
+size_t TextAttributeTable::size() const noexcept
+{
+    return _ids.size();
+}
+
+size_t TextAttributeTable::_GetAvailable() const noexcept
+{
+    return _free.size() + (MaxEntries - _entries.size());
+}
+
+// Routine Description:
+// - Reclaims the IDs that the marker doesn't mark.
+void TextAttributeTable::_Collect()
+{
+    if (!_marker)
+    {
+        return;
+    }
+
+    _free.reserve(_entries.size());
+    _marked.assign(_entries.size(), false);
+    auto clearMarks = wil::scope_exit([&]() noexcept { _marked.clear(); });
+
+    _marker(*this);
+
+    _free.clear();
+    for (size_t i = 0; i < _entries.size(); ++i)
+    {
+        if (_marked[i])
+        {
+            continue;
+        }
+
+        const auto id = gsl::narrow_cast<Id>(i);
+        const auto it = _ids.find(til::at(_entries, i));
+        if (it != _ids.end() && it->second == id)
+        {
+            _ids.erase(it);
+        }
+        _free.push_back(id);
+    }
+}
@@ -0,0 +1,77 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TextAttributeTable.hpp
+
+Abstract:
+- Interns the distinct attributes of the rows of a buffer, so that the rows
+  only have to store a 16-bit ID per run. Two runs of the same table have
+  the same attributes if and only if they have the same ID.
+- IDs aren't reference counted. Once the table runs out of IDs, the owner's
+  marker is asked to mark every ID that's still stored in a row, and the
+  ones that weren't marked are reused.
+--*/
+
+#pragma once
+
+#include "TextAttribute.hpp"
+
+class TextAttributeTable final
+{
+public:
+    using Id = uint16_t;
+
+    // A run of columns of a row that share an attribute.
+    struct Run
+    {
+        uint16_t length;
+        Id id;
+    };
+
+    // The number of distinct attributes that can be interned at once.
+    static constexpr size_t MaxEntries = static_cast<size_t>(std::numeric_limits<Id>::max()) + 1;
+
+    // Called when the table runs out of IDs. It has to Mark every ID that's still in use.
+    using Marker = std::function<void(TextAttributeTable& table)>;
+
+    // Hashes attributes the way the table does, for other maps keyed by them.
+    struct Hash
+    {
+        size_t operator()(const TextAttribute& attr) const noexcept;
+    };
+
+    TextAttributeTable() noexcept;
+
+    TextAttributeTable(const TextAttributeTable&) = delete;
+    TextAttributeTable& operator=(const TextAttributeTable&) = delete;
+
+    void SetMarker(Marker marker) noexcept;
+
+    Id Intern(const TextAttribute& attr);
+    void Reserve(const size_t count);
+    std::optional<Id> Find(const TextAttribute& attr) const noexcept;
+    const TextAttribute& Get(const Id id) const noexcept;
+
+    void Mark(const Id id) noexcept;
+
+    size_t size() const noexcept;
+
+private:
+    size_t _GetAvailable() const noexcept;
+    void _Collect();
+
+    // Entries are never moved, so that Get can hand out references to them.
+    std::deque<TextAttribute> _entries;
+    std::unordered_map<TextAttribute, Id, Hash> _ids;
+    // The IDs below _entries.size() that aren't in use.
+    std::vector<Id> _free;
+    // The IDs that were marked, while the table is being collected.
+    std::vector<bool> _marked;
+    Marker _marker;
+
+#ifdef UNIT_TESTING
+    friend class TextAttributeTableTests;
+#endif
+};
@@ -0,0 +1,146 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "TextBufferExport.hpp"
+
+#pragma hdrstop
+
+// Routine Description:
+// - Creates the file to export a buffer to, and writes the start of it.
+// Arguments:
+// - path - the path of the file. It's replaced if it's already there.
+// - format - the format to write the file in. The text is in UTF-8 in all of them.
+// - fontHeightPoints - the unscaled font height, for HTML
+// - fontFaceName - the name of the font used, for HTML
+// - backgroundColor - default background color for characters, for HTML
+TextBufferExport::TextBufferExport(const std::wstring_view path,
+                                   const TextExportFormat format,
+                                   const int fontHeightPoints,
+                                   const std::wstring_view fontFaceName,
+                                   const COLORREF backgroundColor) :
+    _format{ format },
+    _file{ path },
+    _writer{ _CreateWriter(fontHeightPoints, fontFaceName, backgroundColor) },
+    _serializer{ true,
+                 format == TextExportFormat::Html ? [this](const TextAttribute& attr) { return _GetAttributeColors(attr); } : TextSerializer::AttributeColors{},
+                 { _writer.get() } },
+    _nextRow{},
+    _endRow{ 0 },
+    _renderTarget{},
+    _rows{},
+    _rowCount{ 0 },
+    _attributeColors{}
+{
+    _serializer.Begin();
+}
+
+// Routine Description:
+// - Copies the next chunk of rows to export out of the buffer, along with the
+//   colors of their attributes. Call it with the buffer locked.
+// Arguments:
+// - buffer - the buffer to export
+// - getAttributeColors - function used to map TextAttribute to RGB COLORREFs, for HTML
+// Return Value:
+// - true if rows were copied, false if there are none left to export.
+bool TextBufferExport::CopyRows(const TextBuffer& buffer, const TextSerializer::AttributeColors& getAttributeColors)
+{
+    const auto& scrollback = buffer.GetScrollback();
+    if (!_nextRow)
+    {
+        _nextRow = scrollback.GetFirstRow();
+        _endRow = buffer.GetFirstAbsoluteRow() + buffer.GetLastNonSpaceCharacter().Y + 1;
+    }
+
+    // Rows that were dropped since the last chunk are skipped.
+    auto row = std::max(*_nextRow, scrollback.GetFirstRow());
+    const auto endRow = std::min(_endRow, buffer.GetFirstAbsoluteRow() + gsl::narrow_cast<int64_t>(buffer.TotalRowCount()));
+
+    const auto width = buffer.GetSize().Width();
+    if (!_rows || _rows->GetSize().Width() != width)
+    {
+        _rows = std::make_unique<TextBuffer>(COORD{ gsl::narrow_cast<SHORT>(width), gsl::narrow_cast<SHORT>(ChunkRows) }, TextAttribute{}, 0, _renderTarget);
+    }
+
+    _rowCount = 0;
+    for (; row < endRow && _rowCount < ChunkRows; ++row, ++_rowCount)
+    {
+        const auto& source = buffer.GetRowByAbsoluteIndex(row);
+        auto& copy = _rows->GetRowByOffset(_rowCount);
+        copy.GetCharRow().CopyFrom(source.GetCharRow());
+        copy.GetAttrRow() = source.GetAttrRow();
+
+        if (_format != TextExportFormat::Html)
+        {
+            continue;
+        }
+
+        // The attribute only changes between runs, so it's enough to look at the first cell of each.
+        std::optional<TextAttributeTable::Id> runId;
+        for (auto it = copy.GetAttrRow().begin(); it; ++it)
+        {
+            if (runId == it.GetId())
+            {
+                continue;
+            }
+            runId = it.GetId();
+
+            const auto& attr = *it;
+            if (_attributeColors.find(attr) == _attributeColors.end())
+            {
+                _attributeColors.emplace(attr, getAttributeColors(attr));
+            }
+        }
+    }
+    _nextRow = row;
+    return _rowCount != 0;
+}
+
+// Routine Description:
+// - Writes the rows that CopyRows copied last out to the file. It doesn't
+//   read the buffer, so it doesn't need the buffer to be locked.
+void TextBufferExport::WriteRows()
+{
+    for (size_t offset = 0; offset < _rowCount; ++offset)
+    {
+        const auto& row = _rows->GetRowByOffset(offset);
+        _serializer.WriteRow(row, 0, row.GetCharRow().size());
+    }
+    _rowCount = 0;
+}
+
+// Routine Description:
+// - Writes the end of the file, once all rows were written.
+void TextBufferExport::Finish()
+{
+    _serializer.End();
+}
+
+// Routine Description:
+// - Creates the writer for the format, which writes into the file.
+std::unique_ptr<TextSerializer::Writer> TextBufferExport::_CreateWriter(const int fontHeightPoints,
+                                                                        const std::wstring_view fontFaceName,
+                                                                        const COLORREF backgroundColor)
+{
+    const auto writeBytes = [this](const std::string_view bytes) { _file.Write(bytes); };
+
+    switch (_format)
+    {
+    case TextExportFormat::PlainText:
+        return std::make_unique<PlainTextWriter>([this](const std::wstring_view text) { _file.Write(text); }, true);
+    case TextExportFormat::Vt:
+        return std::make_unique<VtWriter>(writeBytes);
+    case TextExportFormat::Html:
+        return std::make_unique<HtmlWriter>(writeBytes, fontHeightPoints, fontFaceName, backgroundColor, false);
+    default:
+        THROW_HR(E_INVALIDARG);
+    }
+}
+
+// Routine Description:
+// - Gets the colors that CopyRows looked up for an attribute of the copied rows.
+std::pair<COLORREF, COLORREF> TextBufferExport::_GetAttributeColors(const TextAttribute& attr) const
+{
+    const auto it = _attributeColors.find(attr);
+    return it != _attributeColors.end() ? it->second : std::pair<COLORREF, COLORREF>{};
+}
@@ -0,0 +1,69 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TextBufferExport.hpp
+
+Abstract:
+- Exports every row that a TextBuffer keeps to a file, a chunk of rows at a
+  time, so that the buffer doesn't have to stay locked while the file is
+  written. See TextBuffer::ExportToFile.
+- CopyRows copies the next chunk of rows and looks up the colors of their
+  attributes. It's the only part that reads the buffer, so that's the part
+  to call with the buffer locked. WriteRows then writes the copied rows out,
+  and can run without the lock, on any thread.
+- The rows to export are the ones from the oldest row of the scrollback to
+  the last row with text in it, at the time of the first copy. Rows keep
+  their absolute row numbers as the buffer scrolls or is resized, so the
+  export carries on from the same row. Rows that were dropped in between
+  are skipped, and rows that changed are exported the way they are when
+  their chunk is copied.
+--*/
+
+#pragma once
+
+#include "textBuffer.hpp"
+#include "../renderer/inc/DummyRenderTarget.hpp"
+
+class TextBufferExport final
+{
+public:
+    // The most rows that CopyRows copies at a time.
+    static constexpr size_t ChunkRows = 256;
+
+    TextBufferExport(const std::wstring_view path,
+                     const TextExportFormat format,
+                     const int fontHeightPoints,
+                     const std::wstring_view fontFaceName,
+                     const COLORREF backgroundColor);
+
+    TextBufferExport(const TextBufferExport&) = delete;
+    TextBufferExport& operator=(const TextBufferExport&) = delete;
+
+    bool CopyRows(const TextBuffer& buffer, const TextSerializer::AttributeColors& getAttributeColors);
+    void WriteRows();
+    void Finish();
+
+private:
+    TextExportFormat _format;
+    TextFile _file;
+    std::unique_ptr<TextSerializer::Writer> _writer;
+    TextSerializer _serializer;
+
+    // The absolute row to copy next, and the one after the last row to export.
+    // They're set by the first copy.
+    std::optional<int64_t> _nextRow;
+    int64_t _endRow;
+
+    // The rows that were copied last, and the colors of their attributes.
+    DummyRenderTarget _renderTarget;
+    std::unique_ptr<TextBuffer> _rows;
+    size_t _rowCount;
+    std::unordered_map<TextAttribute, std::pair<COLORREF, COLORREF>, TextAttributeTable::Hash> _attributeColors;
+
+    std::unique_ptr<TextSerializer::Writer> _CreateWriter(const int fontHeightPoints,
+                                                          const std::wstring_view fontFaceName,
+                                                          const COLORREF backgroundColor);
+    std::pair<COLORREF, COLORREF> _GetAttributeColors(const TextAttribute& attr) const;
+};
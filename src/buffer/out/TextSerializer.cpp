@@ -0,0 +1,571 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "TextSerializer.hpp"
+#include "../types/inc/utils.hpp"
+
+#pragma hdrstop
+
+using namespace Microsoft::Console::Utils;
+
+// The boilerplate around the fragment in the HTML document.
+static constexpr std::string_view HtmlHeader = "<!DOCTYPE><HTML><HEAD></HEAD><BODY>";
+static constexpr std::string_view HtmlFooter = "</BODY></HTML>";
+
+// Routine Description:
+// - Creates a serializer.
+// Arguments:
+// - trimTrailingWhitespace - Whether to leave out the spaces at the end of
+//   each row that wasn't wrapped.
+// - getAttributeColors - Gets the colors of the attributes for the writers.
+//   If null, the colors are all 0.
+// - writers - The writers to hand the text to. The ones that are null are left out.
+TextSerializer::TextSerializer(const bool trimTrailingWhitespace,
+                               AttributeColors getAttributeColors,
+                               const std::initializer_list<Writer*> writers) :
+    _trimTrailingWhitespace{ trimTrailingWhitespace },
+    _getAttributeColors{ std::move(getAttributeColors) },
+    _writers{},
+    _rowCount{ 0 },
+    _lastRowWrapped{ false },
+    _text{}
+{
+    std::copy_if(writers.begin(), writers.end(), std::back_inserter(_writers), [](const auto writer) { return writer != nullptr; });
+}
+
+void TextSerializer::Begin()
+{
+    _rowCount = 0;
+    for (const auto writer : _writers)
+    {
+        writer->Begin();
+    }
+}
+
+// Routine Description:
+// - Hands the text of the cells of a row to the writers, a run of attributes
+//   at a time. The trailing halves of wide glyphs are left out.
+// Arguments:
+// - row - The row.
+// - left - The first column to write.
+// - right - The column after the last one to write.
+// Return Value:
+// - <none>
+void TextSerializer::WriteRow(const ROW& row, const size_t left, const size_t right)
+{
+    const auto& charRow = row.GetCharRow();
+    const auto wrapped = charRow.WasWrapForced();
+
+    if (_rowCount != 0)
+    {
+        for (const auto writer : _writers)
+        {
+            writer->NewRow(_lastRowWrapped);
+        }
+    }
+    ++_rowCount;
+    _lastRowWrapped = wrapped;
+
+    auto end = std::min(right, charRow.size());
+    if (_trimTrailingWhitespace && !wrapped)
+    {
+        // The trailing half of a wide glyph is never a space, so this stops at it.
+        while (end > left && (charRow.cbegin() + (end - 1))->IsSpace())
+        {
+            --end;
+        }
+    }
+
+    const auto& attrRow = row.GetAttrRow();
+    auto col = left;
+    while (col < end)
+    {
+        size_t applies = 0;
+        const auto attributes = attrRow.GetAttrByColumn(col, &applies);
+        const auto runEnd = std::min(end, col + std::max<size_t>(applies, 1));
+
+        _text.clear();
+        charRow.AppendText(col, runEnd, _text);
+        col = runEnd;
+
+        if (_text.empty())
+        {
+            continue;
+        }
+
+        const auto [foreground, background] = _getAttributeColors ? _getAttributeColors(attributes) : std::pair<COLORREF, COLORREF>{};
+        for (const auto writer : _writers)
+        {
+            writer->Text(_text, attributes, foreground, background);
+        }
+    }
+}
+
+void TextSerializer::End()
+{
+    for (const auto writer : _writers)
+    {
+        writer->End();
+    }
+}
+
+PlainTextWriter::PlainTextWriter(TextSink<wchar_t>::Function sink, const bool includeCRLF) :
+    _sink{ std::move(sink) },
+    _includeCRLF{ includeCRLF }
+{
+}
+
+void PlainTextWriter::Begin()
+{
+}
+
+void PlainTextWriter::NewRow(const bool wrapped)
+{
+    if (_includeCRLF && !wrapped)
+    {
+        _sink.Write(L"\r\n");
+    }
+}
+
+void PlainTextWriter::Text(const std::wstring_view text, const TextAttribute& /*attributes*/, const COLORREF /*foreground*/, const COLORREF /*background*/)
+{
+    _sink.Write(text);
+}
+
+void PlainTextWriter::End()
+{
+    _sink.Flush();
+}
+
+VtWriter::VtWriter(TextSink<char>::Function sink) :
+    _sink{ std::move(sink) },
+    _attributes{},
+    _sequence{},
+    _utf8{}
+{
+}
+
+void VtWriter::Begin()
+{
+    _attributes.reset();
+}
+
+void VtWriter::NewRow(const bool wrapped)
+{
+    // A row that was wrapped goes on in the next one, as the terminal wraps it again.
+    if (!wrapped)
+    {
+        _sink.Write("\r\n");
+    }
+}
+
+void VtWriter::Text(const std::wstring_view text, const TextAttribute& attributes, const COLORREF /*foreground*/, const COLORREF /*background*/)
+{
+    if (!_attributes.has_value() || *_attributes != attributes)
+    {
+        _attributes = attributes;
+
+        // Start from the defaults every time, so that the attributes of
+        // one run don't have to be undone one by one for the next.
+        _sequence = "\x1b[0";
+        const std::pair<bool, std::string_view> renditions[] = {
+            { attributes.IsBold(), ";1" },
+            { attributes.IsFaint(), ";2" },
+            { attributes.IsItalic(), ";3" },
+            { attributes.IsUnderlined(), ";4" },
+            { attributes.IsBlinking(), ";5" },
+            { attributes.IsReverseVideo(), ";7" },
+            { attributes.IsInvisible(), ";8" },
+            { attributes.IsCrossedOut(), ";9" },
+            { attributes.IsDoublyUnderlined(), ";21" },
+            { attributes.IsOverlined(), ";53" },
+        };
+        for (const auto& [isSet, rendition] : renditions)
+        {
+            if (isSet)
+            {
+                _sequence.append(rendition);
+            }
+        }
+        _WriteColor(attributes.GetForeground(), true);
+        _WriteColor(attributes.GetBackground(), false);
+        _sequence.push_back('m');
+        _sink.Write(_sequence);
+    }
+
+    THROW_IF_FAILED(til::u16u8(text, _utf8));
+    _sink.Write(_utf8);
+}
+
+void VtWriter::End()
+{
+    if (_attributes.has_value())
+    {
+        _sink.Write("\x1b[0m");
+    }
+    _sink.Flush();
+}
+
+// Routine Description:
+// - Adds the parameters for a color to the SGR sequence. The default colors
+//   don't need any, as the sequence starts from them.
+void VtWriter::_WriteColor(const TextColor color, const bool isForeground)
+{
+    // The 16 colors are kept in the order of the Windows color table, where
+    // blue and red are the other way around.
+    const auto toXterm = [](const BYTE index) noexcept {
+        return index < 16 ? gsl::narrow_cast<BYTE>((index & 0b1010) | ((index & 0b0001) << 2) | ((index & 0b0100) >> 2)) : index;
+    };
+
+    if (color.IsIndex16())
+    {
+        const auto index = toXterm(color.GetIndex());
+        // The bright colors are in [90,97] and [100,107], the others in [30,37] and [40,47].
+        const auto parameter = (isForeground ? 30 : 40) + (index & 0b0111) + (WI_IsFlagSet(index, 0b1000) ? 60 : 0);
+        _sequence.push_back(';');
+        _sequence.append(std::to_string(parameter));
+    }
+    else if (color.IsIndex256())
+    {
+        _sequence.append(isForeground ? ";38;5;" : ";48;5;");
+        _sequence.append(std::to_string(toXterm(color.GetIndex())));
+    }
+    else if (color.IsRgb())
+    {
+        const auto rgb = color.GetRGB();
+        _sequence.append(isForeground ? ";38;2;" : ";48;2;");
+        _sequence.append(std::to_string(GetRValue(rgb)));
+        _sequence.push_back(';');
+        _sequence.append(std::to_string(GetGValue(rgb)));
+        _sequence.push_back(';');
+        _sequence.append(std::to_string(GetBValue(rgb)));
+    }
+}
+
+// Routine Description:
+// - Creates a HTML writer.
+// Arguments:
+// - sink - Where the document is written to.
+// - fontHeightPoints - The unscaled font height.
+// - fontFaceName - The name of the font used.
+// - backgroundColor - The default background color, also used in the padding.
+// - clipboardHeader - Whether to write the header of the CF_HTML format.
+HtmlWriter::HtmlWriter(TextSink<char>::Function sink,
+                       const int fontHeightPoints,
+                       const std::wstring_view fontFaceName,
+                       const COLORREF backgroundColor,
+                       const bool clipboardHeader) :
+    _sink{ std::move(sink) },
+    _fontHeightPoints{ fontHeightPoints },
+    _fontFaceName{},
+    _backgroundColor{ backgroundColor },
+    _clipboardHeader{ clipboardHeader },
+    _foreground{},
+    _background{},
+    _utf8{},
+    _htmlEnd{ 0 }
+{
+    THROW_IF_FAILED(til::u16u8(fontFaceName, _fontFaceName));
+}
+
+void HtmlWriter::Begin()
+{
+    _foreground.reset();
+    _background.reset();
+    _htmlEnd = 0;
+
+    if (_clipboardHeader)
+    {
+        // The offsets aren't known until the end, so they're filled in
+        // afterwards. They take up the same space either way.
+        std::string header;
+        FillClipboardHeader(header);
+        _sink.Write(header);
+    }
+
+    _sink.Write(HtmlHeader);
+    _sink.Write("<!--StartFragment -->");
+
+    // apply global style in div element
+    _sink.Write("<DIV STYLE=\"display:inline-block;white-space:pre;background-color:");
+    _sink.Write(ColorToHexString(_backgroundColor));
+    _sink.Write(";font-family:'");
+    _sink.Write(_fontFaceName);
+    // even with different font, add monospace as fallback
+    _sink.Write("',monospace;font-size:");
+    _sink.Write(std::to_string(_fontHeightPoints));
+    // note: MS Word doesn't support padding (in this way at least)
+    _sink.Write("pt;padding:4px;\">");
+}
+
+void HtmlWriter::NewRow(const bool /*wrapped*/)
+{
+    _sink.Write("<BR>");
+}
+
+void HtmlWriter::Text(const std::wstring_view text, const TextAttribute& /*attributes*/, const COLORREF foreground, const COLORREF background)
+{
+    if (foreground != _foreground || background != _background)
+    {
+        if (_foreground.has_value())
+        {
+            _sink.Write("</SPAN>");
+        }
+
+        _foreground = foreground;
+        _background = background;
+
+        _sink.Write("<SPAN STYLE=\"color:");
+        _sink.Write(ColorToHexString(foreground));
+        _sink.Write(";background-color:");
+        _sink.Write(ColorToHexString(background));
+        _sink.Write(";\">");
+    }
+
+    _WriteEscaped(text);
+}
+
+void HtmlWriter::End()
+{
+    if (_foreground.has_value())
+    {
+        // the last span that was opened is still open
+        _sink.Write("</SPAN>");
+    }
+
+    _sink.Write("</DIV><!--EndFragment -->");
+    _sink.Write(HtmlFooter);
+    _htmlEnd = _sink.GetPosition();
+    _sink.Flush();
+}
+
+// Routine Description:
+// - Fills in the header of the CF_HTML format, now that the offsets in it
+//   are known.
+// Arguments:
+// - html - The document the writer wrote. If it's empty, the header is
+//   written into it.
+// Return Value:
+// - <none>
+void HtmlWriter::FillClipboardHeader(std::string& html) const
+{
+    // these values are byte offsets from start of clipboard
+    std::ostringstream headerBuilder;
+    headerBuilder << std::setfill('0');
+    const auto writeOffset = [&](const std::string_view name, const size_t offset) {
+        headerBuilder << name << ":" << std::setw(10) << offset << "\r\n";
+    };
+
+    // once filled with values, there will be exactly 157 bytes in the header
+    constexpr size_t ClipboardHeaderSize = 157;
+    const auto htmlStart = ClipboardHeaderSize;
+    const auto htmlEnd = _htmlEnd;
+    const auto fragmentStart = ClipboardHeaderSize + HtmlHeader.size();
+    const auto fragmentEnd = _htmlEnd != 0 ? _htmlEnd - HtmlFooter.size() : 0;
+
+    // header required by HTML 0.9 format
+    headerBuilder << "Version:0.9\r\n";
+    writeOffset("StartHTML", htmlStart);
+    writeOffset("EndHTML", htmlEnd);
+    writeOffset("StartFragment", fragmentStart);
+    writeOffset("EndFragment", fragmentEnd);
+    writeOffset("StartSelection", fragmentStart);
+    writeOffset("EndSelection", fragmentEnd);
+
+    const auto header = headerBuilder.str();
+    html.replace(0, std::min(html.size(), header.size()), header);
+}
+
+void HtmlWriter::_WriteEscaped(const std::wstring_view text)
+{
+    THROW_IF_FAILED(til::u16u8(text, _utf8));
+
+    const std::string_view utf8{ _utf8 };
+    size_t start = 0;
+    for (size_t i = 0; i < utf8.size(); ++i)
+    {
+        std::string_view escaped;
+        switch (til::at(utf8, i))
+        {
+        case '<':
+            escaped = "&lt;";
+            break;
+        case '>':
+            escaped = "&gt;";
+            break;
+        case '&':
+            escaped = "&amp;";
+            break;
+        default:
+            continue;
+        }
+
+        _sink.Write(utf8.substr(start, i - start));
+        _sink.Write(escaped);
+        start = i + 1;
+    }
+    _sink.Write(utf8.substr(start));
+}
+
+// Routine Description:
+// - Creates a RTF writer.
+//   RTF 1.5 Spec: https://www.biblioscape.com/rtf15_spec.htm
+// Arguments:
+// - sink - Where the document is written to.
+// - fontHeightPoints - The unscaled font height.
+// - fontFaceName - The name of the font used.
+// - backgroundColor - The default background color.
+RtfWriter::RtfWriter(TextSink<char>::Function sink,
+                     const int fontHeightPoints,
+                     const std::wstring_view fontFaceName,
+                     const COLORREF backgroundColor) :
+    _sink{ std::move(sink) },
+    _fontHeightPoints{ fontHeightPoints },
+    _fontFaceName{},
+    _backgroundColor{ backgroundColor },
+    _foreground{},
+    _background{},
+    _utf8{},
+    _colorIndexes{},
+    _colorTable{},
+    _content{}
+{
+    THROW_IF_FAILED(til::u16u8(fontFaceName, _fontFaceName));
+}
+
+void RtfWriter::Begin()
+{
+    _foreground.reset();
+    _background.reset();
+    _colorIndexes.clear();
+    _colorTable = "{\\colortbl ;";
+    _content.clear();
+
+    // Standard RTF header.
+    // This is similar to the header generated by WordPad.
+    // \ansi - specifies that the ANSI char set is used in the current doc
+    // \ansicpg1252 - represents the ANSI code page which is used to perform the Unicode to ANSI conversion when writing RTF text
+    // \deff0 - specifies that the default font for the document is the one at index 0 in the font table
+    // \nouicompat - ?
+    _sink.Write("{\\rtf1\\ansi\\ansicpg1252\\deff0\\nouicompat");
+
+    // font table
+    _sink.Write("{\\fonttbl{\\f0\\fmodern\\fcharset0 ");
+    _sink.Write(_fontFaceName);
+    _sink.Write(";}}");
+
+    // leave 0 for the default color, so the background color is 1.
+    _GetColorIndex(_backgroundColor);
+
+    // paragraph styles
+    // \fs specifies font size in half-points i.e. \fs20 results in a font size
+    // of 10 pts. That's why, font size is multiplied by 2 here.
+    _content.append("\\viewkind4\\uc4\\pard\\slmult1\\f0\\fs");
+    _content.append(std::to_string(2 * _fontHeightPoints));
+    _content.append("\\highlight1 ");
+}
+
+void RtfWriter::NewRow(const bool /*wrapped*/)
+{
+    _content.append("\\line ");
+}
+
+void RtfWriter::Text(const std::wstring_view text, const TextAttribute& /*attributes*/, const COLORREF foreground, const COLORREF background)
+{
+    if (foreground != _foreground || background != _background)
+    {
+        _foreground = foreground;
+        _background = background;
+
+        const auto backgroundIndex = _GetColorIndex(background);
+        const auto foregroundIndex = _GetColorIndex(foreground);
+        _content.append("\\highlight");
+        _content.append(std::to_string(backgroundIndex));
+        _content.append("\\cf");
+        _content.append(std::to_string(foregroundIndex));
+        _content.push_back(' ');
+    }
+
+    THROW_IF_FAILED(til::u16u8(text, _utf8));
+    for (const auto ch : _utf8)
+    {
+        switch (ch)
+        {
+        case '\\':
+        case '{':
+        case '}':
+            _content.push_back('\\');
+            break;
+        }
+        _content.push_back(ch);
+    }
+}
+
+void RtfWriter::End()
+{
+    _colorTable.push_back('}');
+    _sink.Write(_colorTable);
+    _sink.Write(_content);
+    _sink.Write("}");
+    _sink.Flush();
+
+    _colorTable = {};
+    _content = {};
+}
+
+// Routine Description:
+// - Gets the index of a color in the color table, adding it if it isn't there yet.
+int RtfWriter::_GetColorIndex(const COLORREF color)
+{
+    const auto [found, inserted] = _colorIndexes.try_emplace(color, gsl::narrow_cast<int>(_colorIndexes.size() + 1));
+    if (inserted)
+    {
+        _colorTable.append("\\red");
+        _colorTable.append(std::to_string(GetRValue(color)));
+        _colorTable.append("\\green");
+        _colorTable.append(std::to_string(GetGValue(color)));
+        _colorTable.append("\\blue");
+        _colorTable.append(std::to_string(GetBValue(color)));
+        _colorTable.push_back(';');
+    }
+    return found->second;
+}
+
+// Routine Description:
+// - Creates the file, or empties it if it's already there.
+// Arguments:
+// - path - The path of the file.
+TextFile::TextFile(const std::wstring_view path) :
+    _file{},
+    _utf8{}
+{
+    _file.reset(CreateFileW(std::wstring{ path }.c_str(),
+                            GENERIC_WRITE,
+                            FILE_SHARE_READ,
+                            nullptr,
+                            CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                            nullptr));
+    THROW_LAST_ERROR_IF(!_file);
+}
+
+void TextFile::Write(const std::string_view bytes)
+{
+    auto remaining = bytes;
+    while (!remaining.empty())
+    {
+        const auto size = gsl::narrow_cast<DWORD>(std::min<size_t>(remaining.size(), std::numeric_limits<DWORD>::max()));
+        DWORD written = 0;
+        THROW_IF_WIN32_BOOL_FALSE(WriteFile(_file.get(), remaining.data(), size, &written, nullptr));
+        THROW_HR_IF(E_UNEXPECTED, written == 0);
+        remaining.remove_prefix(written);
+    }
+}
+
+void TextFile::Write(const std::wstring_view text)
+{
+    THROW_IF_FAILED(til::u16u8(text, _utf8));
+    Write(std::string_view{ _utf8 });
+}
@@ -0,0 +1,242 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TextSerializer.hpp
+
+Abstract:
+- Writes rows of a TextBuffer out as text, in one pass. The serializer walks
+  the cells of each row once, a run of attributes at a time, and hands the
+  text of every run to each of its writers. The writers turn it into plain
+  text, HTML or RTF, and hand that to a sink, a function that the caller
+  supplies. See TextBuffer::Serialize.
+- Writers collect their output and call their sink with large blocks of it,
+  so that a sink can append to a string or write to a file without being
+  called for every little piece. A block always ends where a write to it
+  ended, so it never splits a glyph.
+--*/
+
+#pragma once
+
+#include "Row.hpp"
+
+// The formats that a whole buffer can be exported to a file in. See TextBuffer::ExportToFile.
+enum class TextExportFormat
+{
+    PlainText,
+    Vt,
+    Html
+};
+
+// Collects the output of a writer and hands it to a function in blocks.
+template<typename CharT>
+class TextSink final
+{
+public:
+    using Function = std::function<void(const std::basic_string_view<CharT>)>;
+
+    explicit TextSink(Function function) :
+        _function{ std::move(function) },
+        _pending{},
+        _flushed{ 0 }
+    {
+    }
+
+    void Write(const std::basic_string_view<CharT> text)
+    {
+        _pending.append(text);
+        if (_pending.size() >= BlockSize)
+        {
+            Flush();
+        }
+    }
+
+    void Flush()
+    {
+        if (!_pending.empty())
+        {
+            _function(_pending);
+            _flushed += _pending.size();
+            _pending.clear();
+        }
+    }
+
+    // Gets how many characters have been written so far.
+    size_t GetPosition() const noexcept
+    {
+        return _flushed + _pending.size();
+    }
+
+private:
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    Function _function;
+    std::basic_string<CharT> _pending;
+    size_t _flushed;
+};
+
+class TextSerializer final
+{
+public:
+    // Gets the foreground and the background color of an attribute.
+    using AttributeColors = std::function<std::pair<COLORREF, COLORREF>(const TextAttribute&)>;
+
+    // Turns the text of the rows into a format. Begin and End are called once,
+    // NewRow between one row and the next, and Text for every run of
+    // attributes in a row, in order.
+    class Writer
+    {
+    public:
+        virtual ~Writer() = default;
+
+        virtual void Begin() = 0;
+        virtual void NewRow(const bool wrapped) = 0;
+        virtual void Text(const std::wstring_view text,
+                          const TextAttribute& attributes,
+                          const COLORREF foreground,
+                          const COLORREF background) = 0;
+        virtual void End() = 0;
+    };
+
+    TextSerializer(const bool trimTrailingWhitespace,
+                   AttributeColors getAttributeColors,
+                   const std::initializer_list<Writer*> writers);
+
+    void Begin();
+    void WriteRow(const ROW& row, const size_t left, const size_t right);
+    void End();
+
+private:
+    bool _trimTrailingWhitespace;
+    AttributeColors _getAttributeColors;
+    std::vector<Writer*> _writers;
+
+    size_t _rowCount;
+    bool _lastRowWrapped;
+    // The text of the run that's being written. Reused from run to run.
+    std::wstring _text;
+};
+
+// Writes the text, with a CR/LF at the end of every row that wasn't wrapped
+// if asked to, except the last.
+class PlainTextWriter final : public TextSerializer::Writer
+{
+public:
+    PlainTextWriter(TextSink<wchar_t>::Function sink, const bool includeCRLF);
+
+    void Begin() override;
+    void NewRow(const bool wrapped) override;
+    void Text(const std::wstring_view text, const TextAttribute& attributes, const COLORREF foreground, const COLORREF background) override;
+    void End() override;
+
+private:
+    TextSink<wchar_t> _sink;
+    bool _includeCRLF;
+};
+
+// Writes the text in UTF-8, with SGR sequences for every change of
+// attributes, so that printing it to a terminal shows the rows as they were.
+class VtWriter final : public TextSerializer::Writer
+{
+public:
+    explicit VtWriter(TextSink<char>::Function sink);
+
+    void Begin() override;
+    void NewRow(const bool wrapped) override;
+    void Text(const std::wstring_view text, const TextAttribute& attributes, const COLORREF foreground, const COLORREF background) override;
+    void End() override;
+
+private:
+    void _WriteColor(const TextColor color, const bool isForeground);
+
+    TextSink<char> _sink;
+    std::optional<TextAttribute> _attributes;
+    std::string _sequence;
+    std::string _utf8;
+};
+
+// Writes a HTML document in UTF-8, with a <SPAN> for every change of color.
+// With the clipboard header, the document is in the CF_HTML format. The
+// header has to be filled in with FillClipboardHeader once it's written.
+class HtmlWriter final : public TextSerializer::Writer
+{
+public:
+    HtmlWriter(TextSink<char>::Function sink,
+               const int fontHeightPoints,
+               const std::wstring_view fontFaceName,
+               const COLORREF backgroundColor,
+               const bool clipboardHeader);
+
+    void Begin() override;
+    void NewRow(const bool wrapped) override;
+    void Text(const std::wstring_view text, const TextAttribute& attributes, const COLORREF foreground, const COLORREF background) override;
+    void End() override;
+
+    void FillClipboardHeader(std::string& html) const;
+
+private:
+    void _WriteEscaped(const std::wstring_view text);
+
+    TextSink<char> _sink;
+    int _fontHeightPoints;
+    std::string _fontFaceName;
+    COLORREF _backgroundColor;
+    bool _clipboardHeader;
+
+    std::optional<COLORREF> _foreground;
+    std::optional<COLORREF> _background;
+    std::string _utf8;
+    // Where the document ends, to fill in the clipboard header.
+    size_t _htmlEnd;
+};
+
+// Writes a RTF document, with a change of the color of the text and its
+// highlight for every change of color.
+// The color table has to come before the text, but the colors are only
+// known once all the text has been seen. So the text is kept until End.
+class RtfWriter final : public TextSerializer::Writer
+{
+public:
+    RtfWriter(TextSink<char>::Function sink,
+              const int fontHeightPoints,
+              const std::wstring_view fontFaceName,
+              const COLORREF backgroundColor);
+
+    void Begin() override;
+    void NewRow(const bool wrapped) override;
+    void Text(const std::wstring_view text, const TextAttribute& attributes, const COLORREF foreground, const COLORREF background) override;
+    void End() override;
+
+private:
+    int _GetColorIndex(const COLORREF color);
+
+    TextSink<char> _sink;
+    int _fontHeightPoints;
+    std::string _fontFaceName;
+    COLORREF _backgroundColor;
+
+    std::optional<COLORREF> _foreground;
+    std::optional<COLORREF> _background;
+    std::string _utf8;
+
+    // The index of each color in the color table.
+    std::unordered_map<COLORREF, int> _colorIndexes;
+    std::string _colorTable;
+    std::string _content;
+};
+
+// A file that's written from the start, for the sinks of the writers.
+// Text is written in UTF-8.
+class TextFile final
+{
+public:
+    explicit TextFile(const std::wstring_view path);
+
+    void Write(const std::string_view bytes);
+    void Write(const std::wstring_view text);
+
+private:
+    wil::unique_hfile _file;
+    std::string _utf8;
+};
@@ -0,0 +1,293 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "TrigramIndex.hpp"
+
+#pragma hdrstop
+
+// The memory that a trigram takes up in _postings besides its list of lines:
+// the node that holds it and the bucket that points to the node.
+static constexpr size_t TrigramBytes = sizeof(std::pair<const uint64_t, std::vector<uint32_t>>) + 2 * sizeof(void*);
+
+TrigramIndex::TrigramIndex() noexcept :
+    _budget{ 0 },
+    _usage{ 0 },
+    _lineRows{},
+    _endRow{ 0 },
+    _firstLine{ 0 },
+    _postings{}
+{
+}
+
+// Routine Description:
+// - Sets how much memory the index may take up. Lines that are already in
+//   the index stay there, but no more are added while it's over the budget.
+// Arguments:
+// - bytes - The budget in bytes. With 0, no lines are added at all.
+// Return Value:
+// - <none>
+void TrigramIndex::SetBudget(const size_t bytes) noexcept
+{
+    _budget = bytes;
+}
+
+size_t TrigramIndex::GetBudget() const noexcept
+{
+    return _budget;
+}
+
+// Routine Description:
+// - Gets about how much memory the index takes up: the lists of lines and
+//   the first rows as they're allocated, and an estimate of the rest.
+// Return Value:
+// - The usage in bytes.
+size_t TrigramIndex::GetUsage() const noexcept
+{
+    return _usage;
+}
+
+// Routine Description:
+// - Adds the next line to the index. It has to start at the row after the
+//   last line, unless the index is empty.
+// Arguments:
+// - firstRow - The first absolute row of the line.
+// - lastRow - The last absolute row of the line.
+// - text - The text of the line.
+// Return Value:
+// - True if the line was added. False if the index is over its budget.
+bool TrigramIndex::AddLine(const int64_t firstRow, const int64_t lastRow, const std::wstring_view text)
+{
+    THROW_HR_IF(E_INVALIDARG, lastRow < firstRow || (size() != 0 && firstRow != _endRow));
+
+    if (_usage >= _budget || _lineRows.size() >= std::numeric_limits<uint32_t>::max())
+    {
+        return false;
+    }
+
+    const auto line = gsl::narrow_cast<uint32_t>(_lineRows.size());
+    auto capacity = _lineRows.capacity();
+    _lineRows.push_back(firstRow);
+    _usage += (_lineRows.capacity() - capacity) * sizeof(int64_t);
+    _endRow = lastRow + 1;
+
+    for (size_t i = 0; i + 2 < text.size(); ++i)
+    {
+        const auto key = _Key(til::at(text, i), til::at(text, i + 1), til::at(text, i + 2));
+        const auto [found, inserted] = _postings.try_emplace(key);
+        auto& lines = found->second;
+        if (inserted)
+        {
+            _usage += TrigramBytes;
+        }
+        else if (lines.back() == line)
+        {
+            // The trigram appeared earlier in the line already.
+            continue;
+        }
+
+        capacity = lines.capacity();
+        lines.push_back(line);
+        _usage += (lines.capacity() - capacity) * sizeof(uint32_t);
+    }
+
+    return true;
+}
+
+// Routine Description:
+// - Drops the lines that start before the given row from the index, since
+//   their first rows were dropped.
+// Arguments:
+// - row - The first absolute row that's still around.
+// Return Value:
+// - <none>
+void TrigramIndex::DropLinesBefore(const int64_t row) noexcept
+{
+    const auto kept = std::lower_bound(_lineRows.begin() + _firstLine, _lineRows.end(), row);
+    _firstLine = gsl::narrow_cast<size_t>(kept - _lineRows.begin());
+    if (_firstLine == _lineRows.size())
+    {
+        Clear();
+    }
+    else if (_firstLine * 2 >= _lineRows.size())
+    {
+        _Compact();
+    }
+}
+
+// Routine Description:
+// - Removes every line from the index and frees its memory.
+void TrigramIndex::Clear() noexcept
+{
+    _lineRows = {};
+    _endRow = 0;
+    _firstLine = 0;
+    _postings = {};
+    _usage = 0;
+}
+
+size_t TrigramIndex::size() const noexcept
+{
+    return _lineRows.size() - _firstLine;
+}
+
+// Routine Description:
+// - Gets the first absolute row of the first line in the index.
+int64_t TrigramIndex::GetFirstRow() const noexcept
+{
+    return size() == 0 ? _endRow : til::at(_lineRows, _firstLine);
+}
+
+// Routine Description:
+// - Gets the absolute row after the last line in the index, where the
+//   next line has to start.
+int64_t TrigramIndex::GetEndRow() const noexcept
+{
+    return _endRow;
+}
+
+// Routine Description:
+// - Finds the line in the index that starts at the given row.
+// Arguments:
+// - firstRow - The first absolute row of the line.
+// Return Value:
+// - The index of the line, or nothing if no line starts at that row.
+std::optional<size_t> TrigramIndex::FindLine(const int64_t firstRow) const noexcept
+{
+    if (firstRow < GetFirstRow() || firstRow >= _endRow)
+    {
+        return std::nullopt;
+    }
+
+    const auto found = std::lower_bound(_lineRows.begin() + _firstLine, _lineRows.end(), firstRow);
+    if (found == _lineRows.end() || *found != firstRow)
+    {
+        return std::nullopt;
+    }
+    return gsl::narrow_cast<size_t>(found - _lineRows.begin());
+}
+
+// Routine Description:
+// - Finds the first row of the line in the index that the given row is in.
+// Arguments:
+// - row - The absolute row.
+// Return Value:
+// - The first row of its line, or the row after the last line if it's not
+//   in the index.
+int64_t TrigramIndex::GetLineFirstRow(const int64_t row) const noexcept
+{
+    if (row < GetFirstRow() || row >= _endRow)
+    {
+        return _endRow;
+    }
+
+    const auto found = std::upper_bound(_lineRows.begin() + _firstLine, _lineRows.end(), row);
+    return *(found - 1);
+}
+
+// Routine Description:
+// - Gets the first and last absolute row of a line in the index.
+// Arguments:
+// - line - The index of the line.
+// Return Value:
+// - The first and the last row of the line.
+std::pair<int64_t, int64_t> TrigramIndex::GetLine(const size_t line) const
+{
+    const auto endRow = line + 1 < _lineRows.size() ? til::at(_lineRows, line + 1) : _endRow;
+    return { _lineRows.at(line), endRow - 1 };
+}
+
+// Routine Description:
+// - Finds the lines that have every trigram of the needle, so that they're
+//   the only ones that can contain it.
+// Arguments:
+// - needle - The search term.
+// - firstLine - The index of the first line to consider.
+// Return Value:
+// - The indexes of the lines, in order. Nothing if the needle is too short
+//   to have any trigrams, in which case every line has to be searched.
+std::optional<std::vector<size_t>> TrigramIndex::FindCandidates(const std::wstring_view needle, const size_t firstLine) const
+{
+    if (needle.size() < 3)
+    {
+        return std::nullopt;
+    }
+
+    std::vector<const std::vector<uint32_t>*> postings;
+    for (size_t i = 0; i + 2 < needle.size(); ++i)
+    {
+        const auto found = _postings.find(_Key(til::at(needle, i), til::at(needle, i + 1), til::at(needle, i + 2)));
+        if (found == _postings.end())
+        {
+            return std::vector<size_t>{};
+        }
+        postings.push_back(&found->second);
+    }
+
+    // Walk the shortest list and look each of its lines up in the others.
+    std::sort(postings.begin(), postings.end(), [](const auto a, const auto b) {
+        return a->size() < b->size() || (a->size() == b->size() && a < b);
+    });
+    postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+
+    std::vector<size_t> candidates;
+    const auto& shortest = *postings.front();
+    const auto first = std::lower_bound(shortest.begin(), shortest.end(), gsl::narrow_cast<uint32_t>(std::min<size_t>(firstLine, std::numeric_limits<uint32_t>::max())));
+    for (auto it = first; it != shortest.end(); ++it)
+    {
+        const auto line = *it;
+        if (std::all_of(postings.begin() + 1, postings.end(), [=](const auto lines) { return std::binary_search(lines->begin(), lines->end(), line); }))
+        {
+            candidates.push_back(line);
+        }
+    }
+    return candidates;
+}
+
+// Routine Description:
+// - Frees the memory of the lines that were dropped. Their entries are
+//   removed from the lists of lines, and the other entries are moved down.
+//   The usage is counted again from what's left.
+void TrigramIndex::_Compact() noexcept
+{
+    try
+    {
+        const auto dropped = gsl::narrow_cast<uint32_t>(_firstLine);
+        _usage = 0;
+        for (auto it = _postings.begin(); it != _postings.end();)
+        {
+            auto& lines = it->second;
+            lines.erase(lines.begin(), std::lower_bound(lines.begin(), lines.end(), dropped));
+            if (lines.empty())
+            {
+                it = _postings.erase(it);
+                continue;
+            }
+            for (auto& line : lines)
+            {
+                line -= dropped;
+            }
+            lines.shrink_to_fit();
+            _usage += TrigramBytes + lines.capacity() * sizeof(uint32_t);
+            ++it;
+        }
+        _lineRows.erase(_lineRows.begin(), _lineRows.begin() + _firstLine);
+        _lineRows.shrink_to_fit();
+        _usage += _lineRows.capacity() * sizeof(int64_t);
+        _firstLine = 0;
+    }
+    catch (...)
+    {
+        // Some of the lists may have been moved down already, so start over.
+        LOG_CAUGHT_EXCEPTION();
+        Clear();
+    }
+}
+
+// Routine Description:
+// - Gets the key of a trigram, folded to lower case.
+uint64_t TrigramIndex::_Key(const wchar_t a, const wchar_t b, const wchar_t c) noexcept
+{
+    return (uint64_t{ ::towlower(a) } << 32) | (uint64_t{ ::towlower(b) } << 16) | uint64_t{ ::towlower(c) };
+}
@@ -0,0 +1,63 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TrigramIndex.hpp
+
+Abstract:
+- An inverted index of the logical lines in the history, by the runs of
+  three characters (trigrams) that appear in their text. Any line that
+  contains a search term has to contain every trigram of the term, so
+  intersecting their lists of lines gives the only lines that need to be
+  searched. See SearchIndex.
+- Trigrams are folded to lower case, so the same index serves searches
+  whether the case has to match or not. The lines it returns may not
+  contain the term, but every line that does is returned.
+- Lines are added in order, and never change once they're added. When the
+  oldest rows are dropped, the lines they're in are dropped from the front
+  of the index. Their memory is freed once they're half of the index.
+- The memory the index takes up is counted, and no more lines are added
+  once it's over the budget. The lines after that are simply not indexed.
+--*/
+
+#pragma once
+
+class TrigramIndex final
+{
+public:
+    TrigramIndex() noexcept;
+
+    void SetBudget(const size_t bytes) noexcept;
+    size_t GetBudget() const noexcept;
+    size_t GetUsage() const noexcept;
+
+    bool AddLine(const int64_t firstRow, const int64_t lastRow, const std::wstring_view text);
+    void DropLinesBefore(const int64_t row) noexcept;
+    void Clear() noexcept;
+
+    size_t size() const noexcept;
+    int64_t GetFirstRow() const noexcept;
+    int64_t GetEndRow() const noexcept;
+    std::optional<size_t> FindLine(const int64_t firstRow) const noexcept;
+    int64_t GetLineFirstRow(const int64_t row) const noexcept;
+    std::pair<int64_t, int64_t> GetLine(const size_t line) const;
+
+    std::optional<std::vector<size_t>> FindCandidates(const std::wstring_view needle, const size_t firstLine) const;
+
+private:
+    static uint64_t _Key(const wchar_t a, const wchar_t b, const wchar_t c) noexcept;
+    void _Compact() noexcept;
+
+    size_t _budget;
+    size_t _usage;
+
+    // The first row of every line, and the row after the last line. The
+    // lines before _firstLine were dropped, but are still in the lists.
+    std::vector<int64_t> _lineRows;
+    int64_t _endRow;
+    size_t _firstLine;
+
+    // The lines that each trigram appears in, in order.
+    std::unordered_map<uint64_t, std::vector<uint32_t>> _postings;
+};
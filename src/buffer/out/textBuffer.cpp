@@ -5,6 +5,7 @@
 
 #include "textBuffer.hpp"
 #include "CharRow.hpp"
+#include "TextBufferExport.hpp"
 
 #include "../types/inc/utils.hpp"
 #include "../types/inc/convert.hpp"
@@ -34,22 +35,52 @@ TextBuffer::TextBuffer(const COORD screenBufferSize,
     _firstRow{ 0 },
     _currentAttributes{ defaultAttributes },
     _cursor{ cursorSize, *this },
+    _charBuffer{ _AllocateCharBuffer(screenBufferSize) },
+    _attributeTable{},
+    _attrRunPool{},
     _storage{},
-    _unicodeStorage{},
+    _lineIndex{},
+    _revision{ 0 },
+    _scrollback{ std::make_unique<Scrollback>() },
+    _pendingReflow{},
+    _reflowTarget{ nullptr },
     _renderTarget{ renderTarget },
     _size{},
     _currentHyperlinkId{ 1 },
-    _currentPatternId{ 0 }
-{
+    _currentPatternId{ 0 },
+    _patternLines{},
+    _patternLinesWidth{ 0 },
+    _patternText{},
+    _patternColumns{}
+{
+    // Once the table runs out of IDs, the ones that no row stores anymore are reused.
+    _attributeTable.SetMarker([this](TextAttributeTable& table) noexcept {
+        for (const auto& row : _storage)
+        {
+            row.GetAttrRow().MarkAttributes(table);
+        }
+    });
+
     // initialize ROWs
+    _storage.reserve(static_cast<size_t>(screenBufferSize.Y));
     for (size_t i = 0; i < static_cast<size_t>(screenBufferSize.Y); ++i)
     {
-        _storage.emplace_back(static_cast<SHORT>(i), screenBufferSize.X, _currentAttributes, this);
+        _storage.emplace_back(_GetCharBufferRow(_charBuffer, screenBufferSize.X, i), _currentAttributes, _attributeTable, &_attrRunPool, this, i);
     }
+    _lineIndex.Reset(_storage.size());
 
     _UpdateSize();
 }
 
+TextBuffer::~TextBuffer()
+{
+    // A buffer that was reflowed from this one may not have copied all its rows yet.
+    if (_reflowTarget && _reflowTarget->_pendingReflow)
+    {
+        _reflowTarget->_pendingReflow->Detach(*this);
+    }
+}
+
 // Routine Description:
 // - Copies properties from another text buffer into this one.
 // - This is primarily to copy properties that would otherwise not be specified during CreateInstance
@@ -82,11 +113,11 @@ UINT TextBuffer::TotalRowCount() const noexcept
 // - const reference to the requested row. Asserts if out of bounds.
 const ROW& TextBuffer::GetRowByOffset(const size_t index) const
 {
-    const size_t totalRows = TotalRowCount();
-
-    // Rows are stored circularly, so the index you ask for is offset by the start position and mod the total of rows.
-    const size_t offsetIndex = (_firstRow + index) % totalRows;
-    return _storage.at(offsetIndex);
+    if (_pendingReflow)
+    {
+        _pendingReflow->Write(index, index);
+    }
+    return _storage.at(_GetStorageIndex(index));
 }
 
 // Routine Description:
@@ -98,11 +129,241 @@ const ROW& TextBuffer::GetRowByOffset(const size_t index) const
 // - reference to the requested row. Asserts if out of bounds.
 ROW& TextBuffer::GetRowByOffset(const size_t index)
 {
-    const size_t totalRows = TotalRowCount();
+    if (_pendingReflow)
+    {
+        _pendingReflow->Write(index, index);
+    }
+    return _storage.at(_GetStorageIndex(index));
+}
+
+// Routine Description:
+// - Retrieves a row by its absolute row, which counts all the rows that
+//   scrolled off the top of the buffer before it. Rows above the buffer
+//   come from the scrollback. This is the only way to reach those rows: the
+//   viewport and selection only address the rows of the buffer.
+// Arguments:
+// - row - The absolute row, from GetScrollback().GetFirstRow() up to
+//   GetFirstAbsoluteRow() plus the height of the buffer.
+// Return Value:
+// - const reference to the requested row. Throws if out of bounds.
+const ROW& TextBuffer::GetRowByAbsoluteIndex(const int64_t row) const
+{
+    const auto firstRow = GetFirstAbsoluteRow();
+    if (row < firstRow)
+    {
+        _scrollback->FinishRewrap();
+        return _scrollback->GetRow(row);
+    }
+    return GetRowByOffset(gsl::narrow_cast<size_t>(row - firstRow));
+}
+
+// Routine Description:
+// - Gets the absolute row of the top row of the buffer, which is the number
+//   of rows that scrolled off before it. It only ever grows as the buffer
+//   scrolls, so it can be used to track rows across scrolling.
+// Return Value:
+// - The absolute row of the row at offset 0.
+int64_t TextBuffer::GetFirstAbsoluteRow() const noexcept
+{
+    return _scrollback->GetEndRow();
+}
+
+// Routine Description:
+// - Sets how much memory the rows that scroll off the top of the buffer may
+//   take up. The oldest rows are dropped once they take up more than that.
+// Arguments:
+// - bytes - The budget in bytes. 0 drops rows as they scroll off.
+void TextBuffer::SetScrollbackBudget(const size_t bytes) noexcept
+{
+    _scrollback->SetBudget(bytes);
+}
+
+// Routine Description:
+// - Sets how many of the rows that scrolled off the top of the buffer may be
+//   kept, whether they're in memory or spilled to disk.
+// Arguments:
+// - rows - The number of rows.
+void TextBuffer::SetScrollbackRowLimit(const size_t rows) noexcept
+{
+    _scrollback->SetRowLimit(rows);
+}
+
+// Routine Description:
+// - Sets how many of the rows that scrolled off the top of the buffer are
+//   kept as they are. The older ones are packed until they're needed again.
+// Arguments:
+// - rows - The number of rows, counting up from the top of the buffer.
+void TextBuffer::SetScrollbackColdThreshold(const size_t rows) noexcept
+{
+    _scrollback->SetColdThreshold(rows);
+}
+
+// Routine Description:
+// - Sets whether the packed rows that scrolled off the top of the buffer are
+//   spilled to a temporary file, so that they don't take up memory. Only the
+//   row limit applies to the spilled rows, not the budget.
+// Arguments:
+// - spill - Whether to spill them.
+void TextBuffer::SetScrollbackSpillToDisk(const bool spill) noexcept
+{
+    _scrollback->SetSpillToDisk(spill);
+}
+
+// Routine Description:
+// - Drops the rows that scrolled off the top of the buffer. The absolute
+//   rows of the rows in the buffer stay the same.
+void TextBuffer::ClearScrollback() noexcept
+{
+    _scrollback->Clear();
+}
+
+// Routine Description:
+// - Gets the rows that scrolled off the top of the buffer. If the buffer was
+//   resized since they were last asked for, they're rewrapped first.
+const Scrollback& TextBuffer::GetScrollback() const noexcept
+{
+    _scrollback->FinishRewrap();
+    return *_scrollback;
+}
+
+// Routine Description:
+// - Converts an offset from the first row of the buffer into an index into the storage.
+// Arguments:
+// - offset - Number of rows down from the first row of the buffer.
+// Return Value:
+// - The index into _storage. Not in bounds if the offset wasn't either.
+size_t TextBuffer::_GetStorageIndex(const size_t offset) const noexcept
+{
+    // Rows are stored circularly, starting at _firstRow. Wrapping around
+    // once is all that an offset in bounds needs, and cheaper than a modulo.
+    auto index = _firstRow + offset;
+    if (index >= _storage.size())
+    {
+        index -= _storage.size();
+    }
+    return index;
+}
+
+// Routine Description:
+// - Called by the rows when their wrap status changes, to keep the logical line index up to date.
+// Arguments:
+// - rowIndex - The index of the row in _storage.
+// - wrapForced - The new wrap status of the row.
+// Return Value:
+// - <none>
+void TextBuffer::_NotifyWrapForced(const size_t rowIndex, const bool wrapForced) noexcept
+{
+    _lineIndex.SetWrapped(rowIndex, wrapForced);
+    til::at(_storage, rowIndex).MarkChanged();
+}
+
+// Routine Description:
+// - Advances the revision of the buffer, for a row that just changed.
+// Return Value:
+// - The new revision, which the row records.
+uint64_t TextBuffer::_NextRevision() noexcept
+{
+    return ++_revision;
+}
+
+// Routine Description:
+// - Gets the revision of the buffer, which advances whenever any of its rows
+//   change. Rows keep their revision while the buffer scrolls, since a row
+//   keeps its absolute index (see GetFirstAbsoluteRow) as it moves up.
+//   Rows that are moved around otherwise are marked as changed.
+// Return Value:
+// - The revision. Pass it to GetRowsChangedSince later on.
+uint64_t TextBuffer::GetRevision() const noexcept
+{
+    return _revision;
+}
+
+// Routine Description:
+// - Finds the rows that changed after the buffer was at a revision.
+// Arguments:
+// - revision - A revision that GetRevision returned earlier.
+// - firstRow - The offset of the first row to check.
+// - lastRow - The offset of the last row to check, inclusive.
+// Return Value:
+// - The offsets of the rows that changed, in order. Nothing is checked if
+//   the buffer didn't change at all.
+std::vector<size_t> TextBuffer::GetRowsChangedSince(const uint64_t revision, const size_t firstRow, const size_t lastRow) const
+{
+    std::vector<size_t> rows;
+    if (revision >= _revision)
+    {
+        return rows;
+    }
+
+    const auto endRow = std::min<size_t>(lastRow + 1, _storage.size());
+    for (auto i = firstRow; i < endRow; ++i)
+    {
+        if (GetRowByOffset(i).GetRevision() > revision)
+        {
+            rows.push_back(i);
+        }
+    }
+    return rows;
+}
+
+// Routine Description:
+// - Reads the wrap status of every row into the logical line index, after
+//   the rows were rearranged without telling it.
+void TextBuffer::_RebuildLineIndex()
+{
+    _lineIndex.Reset(_storage.size());
+    for (size_t i = 0; i < _storage.size(); ++i)
+    {
+        _lineIndex.SetWrapped(i, til::at(_storage, i).GetCharRow().WasWrapForced());
+    }
+}
+
+// Routine Description:
+// - Gets the logical line that a row is a part of: the rows above it that
+//   wrapped into it, and the rows below it that it wrapped into.
+// Arguments:
+// - row - The offset of the row from the first row of the buffer.
+// Return Value:
+// - The logical line. Throws if the row is out of bounds.
+TextBuffer::LogicalLine TextBuffer::GetLogicalLineAt(const size_t row) const
+{
+    THROW_HR_IF(E_INVALIDARG, row >= _storage.size());
+    if (_pendingReflow)
+    {
+        _pendingReflow->Write(row, row);
+    }
+
+    const auto index = _GetStorageIndex(row);
+    const auto above = _lineIndex.CountWrappedBefore(index, row);
+    // The last row of the buffer doesn't wrap into anything, even if it's marked that way.
+    const auto below = _lineIndex.CountWrappedFrom(index, _storage.size() - 1 - row);
+    return { row - above, above + below + 1 };
+}
+
+// Routine Description:
+// - Gets the logical lines that have rows in the given range, in order.
+//   The first one may start above the range, and the last one may end below it.
+// Arguments:
+// - firstRow - The offset of the first row of the range.
+// - lastRow - The offset of the last row of the range, inclusive.
+// Return Value:
+// - The logical lines. Throws if the range is out of bounds.
+std::vector<TextBuffer::LogicalLine> TextBuffer::GetLogicalLines(const size_t firstRow, const size_t lastRow) const
+{
+    THROW_HR_IF(E_INVALIDARG, firstRow > lastRow || lastRow >= _storage.size());
+    if (_pendingReflow)
+    {
+        _pendingReflow->Write(firstRow, lastRow);
+    }
 
-    // Rows are stored circularly, so the index you ask for is offset by the start position and mod the total of rows.
-    const size_t offsetIndex = (_firstRow + index) % totalRows;
-    return _storage.at(offsetIndex);
+    std::vector<LogicalLine> lines;
+    lines.emplace_back(GetLogicalLineAt(firstRow));
+    for (auto row = lines.back().firstRow + lines.back().rowCount; row <= lastRow; row += lines.back().rowCount)
+    {
+        const auto below = _lineIndex.CountWrappedFrom(_GetStorageIndex(row), _storage.size() - 1 - row);
+        lines.push_back({ row, below + 1 });
+    }
+    return lines;
 }
 
 // Routine Description:
@@ -253,7 +514,7 @@ bool TextBuffer::_AssertValidDoubleByteSequence(const DbcsAttribute dbcsAttribut
         // Erase previous character into an N type.
         try
         {
-            prevRow.GetCharRow().ClearCell(coordPrevPosition.X);
+            prevRow.ClearColumn(coordPrevPosition.X);
         }
         catch (...)
         {
@@ -295,8 +556,9 @@ bool TextBuffer::_PrepareForDoubleByteSequence(const DbcsAttribute dbcsAttribute
         if (GetCursor().GetPosition().X == sBufferWidth - 1)
         {
             // set that we're wrapping for double byte reasons
-            CharRow& charRow = GetRowByOffset(GetCursor().GetPosition().Y).GetCharRow();
-            charRow.SetDoubleBytePadded(true);
+            ROW& row = GetRowByOffset(GetCursor().GetPosition().Y);
+            row.GetCharRow().SetDoubleBytePadded(true);
+            row.MarkChanged();
 
             // then move the cursor forward and onto the next row
             fSuccess = IncrementCursor();
@@ -305,6 +567,49 @@ bool TextBuffer::_PrepareForDoubleByteSequence(const DbcsAttribute dbcsAttribute
     return fSuccess;
 }
 
+// Routine Description:
+// - Inserts a range of cells of a row at the cursor and advances the cursor
+//   past them, the same way as inserting them one at a time with
+//   InsertCharacter would.
+// Arguments:
+// - source - The row to copy the cells from. It may belong to another buffer.
+// - sourceColumn - The first column of source to copy.
+// - count - The number of cells to copy. They must all be single width and
+//   fit into the rest of the cursor's row.
+// Return Value:
+// - true if we successfully inserted the cells.
+bool TextBuffer::_InsertCells(const ROW& source, const short sourceColumn, const short count)
+{
+    // Only the first cell can follow a leading byte. The others follow single width cells.
+    if (!_PrepareForDoubleByteSequence(source.GetCharRow().DbcsAttrAt(sourceColumn)))
+    {
+        return false;
+    }
+
+    const COORD position = GetCursor().GetPosition();
+    ROW& row = GetRowByOffset(position.Y);
+    row.MarkChanged();
+
+    try
+    {
+        row.GetCharRow().CopyCellsFrom(source.GetCharRow(), sourceColumn, count, position.X);
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return false;
+    }
+
+    if (FAILED(row.GetAttrRow().CopyAttrsToEnd(source.GetAttrRow(), sourceColumn, count, position.X)))
+    {
+        return false;
+    }
+
+    // Put the cursor onto the last cell, so that advancing it wraps the row if the cells filled it.
+    GetCursor().SetXPosition(position.X + count - 1);
+    return IncrementCursor();
+}
+
 // Routine Description:
 // - Writes cells to the output buffer. Writes at the cursor.
 // Arguments:
@@ -389,6 +694,135 @@ OutputCellIterator TextBuffer::WriteLine(const OutputCellIterator givenIt,
     return newIt;
 }
 
+// Routine Description:
+// - Measures the run of printable ASCII at the start of the text. Such text
+//   can be written with WriteAscii, since every character takes up one cell.
+// Arguments:
+// - text - The text to measure
+// Return Value:
+// - The number of characters from the start of the text that are printable ASCII.
+size_t TextBuffer::MeasurePrintableAscii(const std::wstring_view text) noexcept
+{
+    const auto end = std::find_if(text.begin(), text.end(), [](const wchar_t wch) noexcept {
+        return wch < L' ' || wch > L'~';
+    });
+    return gsl::narrow_cast<size_t>(end - text.begin());
+}
+
+// Routine Description:
+// - Writes a run of printable ASCII in a single color to one row of the
+//   output buffer. The row is written the same way as WriteLine would, but
+//   without going through an OutputCellIterator one cell at a time.
+// Arguments:
+// - text - Printable ASCII characters. See MeasurePrintableAscii.
+// - target - Coordinate targeted within output buffer
+// - attr - The color of the text
+// - wrap - change the wrap flag if we filled the last column of the row.
+// Return Value:
+// - The number of columns written. Text that doesn't fit into the row isn't written.
+size_t TextBuffer::WriteAscii(const std::wstring_view text,
+                              const COORD target,
+                              const TextAttribute& attr,
+                              const std::optional<bool> wrap)
+{
+    // If we're not in bounds, exit early.
+    if (!GetSize().IsInBounds(target))
+    {
+        return 0;
+    }
+
+    const auto written = GetRowByOffset(target.Y).WriteAscii(text, target.X, attr, wrap);
+
+    const Viewport paint = Viewport::FromDimensions(target, { gsl::narrow<SHORT>(written), 1 });
+    _NotifyPaint(paint);
+
+    return written;
+}
+
+// Routine Description:
+// - Fills a range of cells with one character in one color, starting at the
+//   target and continuing onto the rows below it. This is what Write does
+//   with a fill iterator, but whole rows are filled at a time, and rows that
+//   are filled completely are reset to a single color run.
+// Arguments:
+// - wch - The character to fill with
+// - attr - The color to fill with
+// - target - The first cell to fill
+// - count - The number of cells to fill. Cells beyond the end of the buffer are ignored.
+// - wrap - change the wrap flag of the rows whose last column is filled.
+// Return Value:
+// - The number of cells filled.
+size_t TextBuffer::FillCells(const wchar_t wch,
+                             const TextAttribute& attr,
+                             const COORD target,
+                             const size_t count,
+                             const std::optional<bool> wrap)
+{
+    // A fill iterator without a limit would fill forever.
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    // Full width characters take up two cells each, which only the iterator knows how to lay out.
+    if (IsGlyphFullWidth(wch))
+    {
+        const OutputCellIterator it{ wch, attr, count };
+        return Write(it, target, wrap).GetCellDistance(it);
+    }
+
+    const auto size = GetSize();
+    auto lineTarget = target;
+    size_t filled = 0;
+    while (filled < count && size.IsInBounds(lineTarget))
+    {
+        const auto written = GetRowByOffset(lineTarget.Y).FillCells(wch, attr, lineTarget.X, count - filled, wrap);
+        _NotifyPaint(Viewport::FromDimensions(lineTarget, { gsl::narrow<SHORT>(written), 1 }));
+        filled += written;
+
+        lineTarget.X = 0;
+        ++lineTarget.Y;
+    }
+    return filled;
+}
+
+// Routine Description:
+// - Fills a rectangle of cells with one character in one color.
+// Arguments:
+// - wch - The character to fill with
+// - attr - The color to fill with
+// - rect - The cells to fill. The part outside of the buffer is ignored.
+// Return Value:
+// - <none>
+void TextBuffer::FillRect(const wchar_t wch,
+                          const TextAttribute& attr,
+                          const Viewport& rect)
+{
+    const auto clipped = Viewport::Intersect(GetSize(), rect);
+    if (!clipped.IsValid())
+    {
+        return;
+    }
+
+    const auto fullWidth = IsGlyphFullWidth(wch);
+    const auto width = gsl::narrow_cast<size_t>(clipped.Width());
+    for (auto y = clipped.Top(); y < clipped.BottomExclusive(); ++y)
+    {
+        const COORD target{ clipped.Left(), y };
+        if (fullWidth)
+        {
+            WriteLine(OutputCellIterator{ wch, attr }, target, false, clipped.RightInclusive());
+            continue;
+        }
+
+        // Writing a line up to a right limit unwraps the row, so filling it does too.
+        auto& row = GetRowByOffset(y);
+        row.FillCells(wch, attr, target.X, width);
+        row.GetCharRow().SetWrapForced(false);
+        _NotifyPaint(Viewport::FromDimensions(target, { clipped.Width(), 1 }));
+    }
+}
+
 //Routine Description:
 // - Inserts one codepoint into the buffer at the current cursor position and advances the cursor as appropriate.
 //Arguments:
@@ -413,6 +847,7 @@ bool TextBuffer::InsertCharacter(const std::wstring_view chars,
 
         // Get the row associated with the given logical position
         ROW& Row = GetRowByOffset(iRow);
+        Row.MarkChanged();
 
         // Store character and double byte data
         CharRow& charRow = Row.GetCharRow();
@@ -420,8 +855,9 @@ bool TextBuffer::InsertCharacter(const std::wstring_view chars,
 
         try
         {
-            charRow.GlyphAt(iCol) = chars;
+            // The attribute goes first, so that storing the glyph gets the last word on whether it's stored.
             charRow.DbcsAttrAt(iCol) = dbcsAttribute;
+            charRow.GlyphAt(iCol) = chars;
         }
         catch (...)
         {
@@ -556,6 +992,20 @@ bool TextBuffer::IncrementCircularBuffer(const bool inVtMode)
     // to the logical position 0 in the window (cursor coordinates and all other coordinates).
     _renderTarget.TriggerCircling();
 
+    // If Reflow didn't write the first row yet, it's only worth writing if the scrollback keeps it.
+    if (_pendingReflow && _scrollback->GetBudget() != 0)
+    {
+        try
+        {
+            _pendingReflow->Write(0, 0);
+        }
+        catch (...)
+        {
+            LOG_HR(wil::ResultFromCaughtException());
+            return false;
+        }
+    }
+
     // Prune hyperlinks to delete obsolete references
     _PruneHyperlinks();
 
@@ -567,17 +1017,22 @@ bool TextBuffer::IncrementCircularBuffer(const bool inVtMode)
         // the current background color, but with no meta attributes set.
         fillAttributes.SetStandardErase();
     }
-    const bool fSuccess = _storage.at(_firstRow).Reset(fillAttributes);
+    auto& firstRow = _storage.at(_firstRow);
+    _scrollback->Append(firstRow);
+    const bool fSuccess = firstRow.Reset(fillAttributes);
     if (fSuccess)
     {
         // Now proceed to increment.
         // Incrementing it will cause the next line down to become the new "top" of the window (the new "0" in logical coordinates)
-        _firstRow++;
+        _firstRow = _GetStorageIndex(1);
 
-        // If we pass up the height of the buffer, loop back to 0.
-        if (_firstRow >= GetSize().Height())
+        if (_pendingReflow)
         {
-            _firstRow = 0;
+            _pendingReflow->ForgetScrolledOff();
+            if (_pendingReflow->empty())
+            {
+                _pendingReflow.reset();
+            }
         }
     }
     return fSuccess;
@@ -659,7 +1114,7 @@ COORD TextBuffer::_GetPreviousFromCursor() const noexcept
     return coordPosition;
 }
 
-const SHORT TextBuffer::GetFirstRowIndex() const noexcept
+size_t TextBuffer::GetFirstRowIndex() const noexcept
 {
     return _firstRow;
 }
@@ -674,7 +1129,7 @@ void TextBuffer::_UpdateSize()
     _size = Viewport::FromDimensions({ 0, 0 }, { gsl::narrow<SHORT>(_storage.at(0).size()), gsl::narrow<SHORT>(_storage.size()) });
 }
 
-void TextBuffer::_SetFirstRowIndex(const SHORT FirstRowIndex) noexcept
+void TextBuffer::_SetFirstRowIndex(const size_t FirstRowIndex) noexcept
 {
     _firstRow = FirstRowIndex;
 }
@@ -687,18 +1142,19 @@ void TextBuffer::ScrollRows(const SHORT firstRow, const SHORT size, const SHORT
         return;
     }
 
-    // OK. We're about to play games by moving rows around within the deque to
-    // scroll a massive region in a faster way than copying things.
-    // To make this easier, first correct the circular buffer to have the first row be 0 again.
-    if (_firstRow != 0)
+    // The rows that Reflow didn't write yet can't be moved around.
+    if (_pendingReflow)
     {
-        // Rotate the buffer to put the first row at the front.
-        std::rotate(_storage.begin(), _storage.begin() + _firstRow, _storage.end());
-
-        // The first row is now at the top.
-        _firstRow = 0;
+        const auto first = std::min(firstRow, gsl::narrow_cast<SHORT>(firstRow + delta));
+        const auto end = std::max(firstRow + size, firstRow + size + delta);
+        _pendingReflow->Write(gsl::narrow_cast<size_t>(std::max<int>(first, 0)), gsl::narrow_cast<size_t>(std::max(end - 1, 0)));
     }
 
+    // OK. We're about to play games by moving rows around within the circular
+    // buffer to scroll a massive region in a faster way than copying things.
+    // The layouts below are in offsets from the first row of the buffer.
+    // Only the rows of the region are moved, wherever the first row is.
+
     // Rotate just the subsection specified
     if (delta < 0)
     {
@@ -735,7 +1191,7 @@ void TextBuffer::ScrollRows(const SHORT firstRow, const SHORT size, const SHORT
         // | 10
         // | 11
         // - end
-        std::rotate(_storage.begin() + firstRow + delta, _storage.begin() + firstRow, _storage.begin() + firstRow + size);
+        _RotateRows(gsl::narrow<size_t>(firstRow + delta), gsl::narrow<size_t>(firstRow), gsl::narrow<size_t>(firstRow + size));
     }
     else
     {
@@ -772,12 +1228,46 @@ void TextBuffer::ScrollRows(const SHORT firstRow, const SHORT size, const SHORT
         // | 10
         // | 11
         // - end
-        std::rotate(_storage.begin() + firstRow, _storage.begin() + firstRow + size, _storage.begin() + firstRow + size + delta);
+        _RotateRows(gsl::narrow<size_t>(firstRow), gsl::narrow<size_t>(firstRow + size), gsl::narrow<size_t>(firstRow + size + delta));
     }
+}
+
+// Routine Description:
+// - Like std::rotate, but on offsets from the first row of the buffer, so
+//   the rows may wrap around the end of the storage. The rows are swapped
+//   with the reversal algorithm, which only touches the rows in the range.
+// Arguments:
+// - first - The offset of the first row to rotate.
+// - middle - The offset of the row that becomes the first one.
+// - last - The offset one past the last row to rotate.
+void TextBuffer::_RotateRows(const size_t first, const size_t middle, const size_t last)
+{
+    const auto reverse = [this](size_t begin, size_t end) {
+        for (; begin < end && begin < --end; ++begin)
+        {
+            const auto beginIndex = _GetStorageIndex(begin);
+            const auto endIndex = _GetStorageIndex(end);
+            auto& beginRow = til::at(_storage, beginIndex);
+            auto& endRow = til::at(_storage, endIndex);
+            std::swap(beginRow, endRow);
+            beginRow.GetCharRow().SetRowIndex(beginIndex);
+            endRow.GetCharRow().SetRowIndex(endIndex);
+            _lineIndex.Swap(beginIndex, endIndex);
+        }
+    };
+
+    reverse(first, middle);
+    reverse(middle, last);
+    reverse(first, last);
 
-    // Renumber the IDs now that we've rearranged where the rows sit within the buffer.
-    // Refreshing should also delegate to the UnicodeStorage to re-key all the stored unicode sequences (where applicable).
-    _RefreshRowIDs(std::nullopt);
+    // Every row in the range moved to another offset.
+    if (first != middle && middle != last)
+    {
+        for (auto i = first; i < last; ++i)
+        {
+            GetRowByOffset(i).MarkChanged();
+        }
+    }
 }
 
 Cursor& TextBuffer::GetCursor() noexcept
@@ -807,8 +1297,12 @@ void TextBuffer::Reset()
 {
     const auto attr = GetCurrentAttributes();
 
+    // The rows that Reflow didn't write yet would be cleared anyway.
+    _pendingReflow.reset();
+
     for (auto& row : _storage)
     {
+        row.MarkChanged();
         row.GetCharRow().Reset();
         row.GetAttrRow().Reset(attr);
     }
@@ -826,7 +1320,12 @@ void TextBuffer::Reset()
 
     try
     {
-        const auto currentSize = GetSize().Dimensions();
+        if (_pendingReflow)
+        {
+            _pendingReflow->WriteAll();
+            _pendingReflow.reset();
+        }
+
         const auto attributes = GetCurrentAttributes();
 
         SHORT TopRow = 0; // new top row of the screen buffer
@@ -834,34 +1333,60 @@ void TextBuffer::Reset()
         {
             TopRow = GetCursor().GetPosition().Y - newSize.Y + 1;
         }
-        const SHORT TopRowIndex = (GetFirstRowIndex() + TopRow) % currentSize.Y;
+        // The cursor isn't necessarily within the buffer yet, so TopRow might not be either.
+        const auto TopRowIndex = _GetStorageIndex(TopRow % _storage.size());
 
-        // rotate rows until the top row is at index 0
-        const ROW& newTopRow = _storage.at(TopRowIndex);
-        while (&newTopRow != &_storage.front())
+        // The rows above the new top row scroll off the top of the buffer.
+        for (size_t i = 0; i < std::min<size_t>(TopRow, _storage.size()); ++i)
         {
-            _storage.push_back(std::move(_storage.front()));
-            _storage.pop_front();
+            _scrollback->Append(GetRowByOffset(i));
         }
 
+        // rotate rows until the top row is at index 0
+        std::rotate(_storage.begin(), _storage.begin() + TopRowIndex, _storage.end());
+
         _SetFirstRowIndex(0);
 
         // realloc in the Y direction
         // remove rows if we're shrinking
-        while (_storage.size() > static_cast<size_t>(newSize.Y))
+        if (_storage.size() > static_cast<size_t>(newSize.Y))
+        {
+            _storage.erase(_storage.begin() + newSize.Y, _storage.end());
+        }
+        _storage.reserve(static_cast<size_t>(newSize.Y));
+
+        // Resize the attributes first, since that's what can fail. Once the cells start
+        // moving over to the new cell buffer, no row may be left behind in the old one.
+        for (auto& row : _storage)
+        {
+            row.GetAttrRow().Resize(newSize.X);
+        }
+
+        // realloc in the X direction
+        auto newCharBuffer = _AllocateCharBuffer(newSize);
+        for (size_t i = 0; i < _storage.size(); ++i)
         {
-            _storage.pop_back();
+            til::at(_storage, i).GetCharRow().Resize(_GetCharBufferRow(newCharBuffer, newSize.X, i));
         }
+        _charBuffer = std::move(newCharBuffer);
+
         // add rows if we're growing
         while (_storage.size() < static_cast<size_t>(newSize.Y))
         {
-            _storage.emplace_back(static_cast<short>(_storage.size()), newSize.X, attributes, this);
+            const auto i = _storage.size();
+            _storage.emplace_back(_GetCharBufferRow(_charBuffer, newSize.X, i), attributes, _attributeTable, &_attrRunPool, this, i);
         }
 
-        // Now that we've tampered with the row placement, refresh all the row IDs.
-        // Also take advantage of the row ID refresh loop to resize the rows in the X dimension
-        // and cleanup the UnicodeStorage characters that might fall outside the resized buffer.
-        _RefreshRowIDs(newSize.X);
+        // The rows were rotated and dropped behind the index's back.
+        _RebuildLineIndex();
+
+        // Every row moved, changed its width, or is new.
+        for (size_t i = 0; i < _storage.size(); ++i)
+        {
+            auto& row = til::at(_storage, i);
+            row.GetCharRow().SetRowIndex(i);
+            row.MarkChanged();
+        }
 
         // Update the cached size value
         _UpdateSize();
@@ -871,51 +1396,32 @@ void TextBuffer::Reset()
     return S_OK;
 }
 
-const UnicodeStorage& TextBuffer::GetUnicodeStorage() const noexcept
-{
-    return _unicodeStorage;
-}
-
-UnicodeStorage& TextBuffer::GetUnicodeStorage() noexcept
+// Routine Description:
+// - Allocates the cells for all rows of a buffer of the given size.
+//   They're all initialized to spaces.
+// Arguments:
+// - size - The size of the buffer, in cells.
+// Return Value:
+// - The cell buffer. Row y starts at cell y * width.
+std::unique_ptr<CharRowCell[]> TextBuffer::_AllocateCharBuffer(const COORD size)
 {
-    return _unicodeStorage;
+    return std::make_unique<CharRowCell[]>(gsl::narrow<size_t>(size.X) * gsl::narrow<size_t>(size.Y));
 }
 
 // Routine Description:
-// - Method to help refresh all the Row IDs after manipulating the row
-//   by shuffling pointers around.
-// - This will also update parent pointers that are stored in depth within the buffer
-//   (e.g. it will update CharRow parents pointing at Rows that might have been moved around)
-// - Optionally takes a new row width if we're resizing to perform a resize operation and cleanup
-//   any high unicode (UnicodeStorage) runs while we're already looping through the rows.
+// - Gets the cells of one row of a cell buffer.
 // Arguments:
-// - newRowWidth - Optional new value for the row width.
-void TextBuffer::_RefreshRowIDs(std::optional<SHORT> newRowWidth)
+// - charBuffer - The cell buffer, from _AllocateCharBuffer.
+// - width - The width of the rows in the cell buffer.
+// - row - The row to get the cells for.
+// Return Value:
+// - The cells of the row.
+gsl::span<CharRowCell> TextBuffer::_GetCharBufferRow(const std::unique_ptr<CharRowCell[]>& charBuffer, const SHORT width, const size_t row) noexcept
 {
-    std::unordered_map<SHORT, SHORT> rowMap;
-    SHORT i = 0;
-    for (auto& it : _storage)
-    {
-        // Build a map so we can update Unicode Storage
-        rowMap.emplace(it.GetId(), i);
-
-        // Update the IDs
-        it.SetId(i++);
-
-        // Also update the char row parent pointers as they can get shuffled up in the rotates.
-        it.GetCharRow().UpdateParent(&it);
-
-        // Resize the rows in the X dimension if we have a new width
-        if (newRowWidth.has_value())
-        {
-            // Realloc in the X direction
-            THROW_IF_FAILED(it.Resize(newRowWidth.value()));
-        }
-    }
-
-    // Give the new mapping to Unicode Storage
-    _unicodeStorage.Remap(rowMap, newRowWidth);
-}
+    const auto rowWidth = gsl::narrow_cast<size_t>(width);
+#pragma warning(suppress : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+    return { charBuffer.get() + row * rowWidth, rowWidth };
+}
 
 void TextBuffer::_NotifyPaint(const Viewport& viewport) const
 {
@@ -944,14 +1450,10 @@ ROW& TextBuffer::_GetFirstRow()
 // - will throw exception if called with the first row of the text buffer
 ROW& TextBuffer::_GetPrevRowNoWrap(const ROW& Row)
 {
-    int prevRowIndex = Row.GetId() - 1;
-    if (prevRowIndex < 0)
-    {
-        prevRowIndex = TotalRowCount() - 1;
-    }
-
-    THROW_HR_IF(E_FAIL, Row.GetId() == _firstRow);
-    return _storage.at(prevRowIndex);
+    // The rows don't know where they are, but they're all stored in _storage.
+    const auto index = gsl::narrow<size_t>(&Row - _storage.data());
+    THROW_HR_IF(E_FAIL, index == _firstRow);
+    return _storage.at(index == 0 ? _storage.size() - 1 : index - 1);
 }
 
 // Method Description:
@@ -1238,20 +1740,33 @@ void TextBuffer::_PruneHyperlinks()
         // we have found all hyperlink references in the first row and put them in refs,
         // now we need to search the rest of the buffer (i.e. all the rows except the first)
         // to see if those references are anywhere else
-        for (size_t i = 1; i != total; ++i)
-        {
-            const auto nextRowRefs = GetRowByOffset(i).GetAttrRow().GetHyperlinks();
-            for (auto id : nextRowRefs)
+        // The rows that Reflow didn't write yet are blank, so they're searched
+        // for in the rows that they're copied from instead.
+        const auto search = [&](const ROW& row) {
+            for (auto id : row.GetAttrRow().GetHyperlinks())
             {
                 if (firstRowRefs.find(id) != firstRowRefs.end())
                 {
                     firstRowRefs.erase(id);
                 }
             }
-            if (firstRowRefs.empty())
+            // No more hyperlink references left to search for, terminate early
+            return firstRowRefs.empty();
+        };
+        bool found = false;
+        for (size_t i = 1; i != total && !found; ++i)
+        {
+            found = search(til::at(_storage, _GetStorageIndex(i)));
+        }
+        if (_pendingReflow)
+        {
+            for (const auto& segment : _pendingReflow->_segments)
             {
-                // No more hyperlink references left to search for, terminate early
-                break;
+                const auto& source = *segment.source;
+                for (auto i = segment.sourceFirstRow; i < segment.sourceFirstRow + segment.sourceRowCount && !found; ++i)
+                {
+                    found = search(til::at(source._storage, source._GetStorageIndex(i)));
+                }
             }
         }
     }
@@ -1634,377 +2149,53 @@ const TextBuffer::TextAndColor TextBuffer::GetText(const bool includeCRLF,
 }
 
 // Routine Description:
-// - Generates a CF_HTML compliant structure based on the passed in text and color data
+// - Writes the text of the selected region out through a serializer, in one
+//   pass over its rows. See TextSerializer.
 // Arguments:
-// - rows - the text and color data we will format & encapsulate
-// - backgroundColor - default background color for characters, also used in padding
-// - fontHeightPoints - the unscaled font height
-// - fontFaceName - the name of the font used
+// - selectionRects - the rectangular regions from which the data will be extracted from the buffer (i.e.: selection rects)
+// - serializer - the serializer with the writers to write the text with
 // Return Value:
-// - string containing the generated HTML
-std::string TextBuffer::GenHTML(const TextAndColor& rows,
-                                const int fontHeightPoints,
-                                const std::wstring_view fontFaceName,
-                                const COLORREF backgroundColor)
+// - <none>
+void TextBuffer::Serialize(const std::vector<SMALL_RECT>& selectionRects, TextSerializer& serializer) const
 {
-    try
-    {
-        std::ostringstream htmlBuilder;
-
-        // First we have to add some standard
-        // HTML boiler plate required for CF_HTML
-        // as part of the HTML Clipboard format
-        const std::string htmlHeader =
-            "<!DOCTYPE><HTML><HEAD></HEAD><BODY>";
-        htmlBuilder << htmlHeader;
-
-        htmlBuilder << "<!--StartFragment -->";
-
-        // apply global style in div element
-        {
-            htmlBuilder << "<DIV STYLE=\"";
-            htmlBuilder << "display:inline-block;";
-            htmlBuilder << "white-space:pre;";
-
-            htmlBuilder << "background-color:";
-            htmlBuilder << Utils::ColorToHexString(backgroundColor);
-            htmlBuilder << ";";
-
-            htmlBuilder << "font-family:";
-            htmlBuilder << "'";
-            htmlBuilder << ConvertToA(CP_UTF8, fontFaceName);
-            htmlBuilder << "',";
-            // even with different font, add monospace as fallback
-            htmlBuilder << "monospace;";
-
-            htmlBuilder << "font-size:";
-            htmlBuilder << fontHeightPoints;
-            htmlBuilder << "pt;";
-
-            // note: MS Word doesn't support padding (in this way at least)
-            htmlBuilder << "padding:";
-            htmlBuilder << 4; // todo: customizable padding
-            htmlBuilder << "px;";
-
-            htmlBuilder << "\">";
-        }
-
-        // copy text and info color from buffer
-        bool hasWrittenAnyText = false;
-        std::optional<COLORREF> fgColor = std::nullopt;
-        std::optional<COLORREF> bkColor = std::nullopt;
-        for (size_t row = 0; row < rows.text.size(); row++)
-        {
-            size_t startOffset = 0;
-
-            if (row != 0)
-            {
-                htmlBuilder << "<BR>";
-            }
-
-            for (size_t col = 0; col < rows.text.at(row).length(); col++)
-            {
-                const auto writeAccumulatedChars = [&](bool includeCurrent) {
-                    if (col >= startOffset)
-                    {
-                        const auto unescapedText = ConvertToA(CP_UTF8, std::wstring_view(rows.text.at(row)).substr(startOffset, col - startOffset + includeCurrent));
-                        for (const auto c : unescapedText)
-                        {
-                            switch (c)
-                            {
-                            case '<':
-                                htmlBuilder << "&lt;";
-                                break;
-                            case '>':
-                                htmlBuilder << "&gt;";
-                                break;
-                            case '&':
-                                htmlBuilder << "&amp;";
-                                break;
-                            default:
-                                htmlBuilder << c;
-                            }
-                        }
-
-                        startOffset = col;
-                    }
-                };
-
-                if (rows.text.at(row).at(col) == '\r' || rows.text.at(row).at(col) == '\n')
-                {
-                    // do not include \r nor \n as they don't have color attributes
-                    // and are not HTML friendly. For line break use '<BR>' instead.
-                    writeAccumulatedChars(false);
-                    break;
-                }
-
-                bool colorChanged = false;
-                if (!fgColor.has_value() || rows.FgAttr.at(row).at(col) != fgColor.value())
-                {
-                    fgColor = rows.FgAttr.at(row).at(col);
-                    colorChanged = true;
-                }
-
-                if (!bkColor.has_value() || rows.BkAttr.at(row).at(col) != bkColor.value())
-                {
-                    bkColor = rows.BkAttr.at(row).at(col);
-                    colorChanged = true;
-                }
-
-                if (colorChanged)
-                {
-                    writeAccumulatedChars(false);
-
-                    if (hasWrittenAnyText)
-                    {
-                        htmlBuilder << "</SPAN>";
-                    }
-
-                    htmlBuilder << "<SPAN STYLE=\"";
-                    htmlBuilder << "color:";
-                    htmlBuilder << Utils::ColorToHexString(fgColor.value());
-                    htmlBuilder << ";";
-                    htmlBuilder << "background-color:";
-                    htmlBuilder << Utils::ColorToHexString(bkColor.value());
-                    htmlBuilder << ";";
-                    htmlBuilder << "\">";
-                }
-
-                hasWrittenAnyText = true;
-
-                // if this is the last character in the row, flush the whole row
-                if (col == rows.text.at(row).length() - 1)
-                {
-                    writeAccumulatedChars(true);
-                }
-            }
-        }
-
-        if (hasWrittenAnyText)
-        {
-            // last opened span wasn't closed in loop above, so close it now
-            htmlBuilder << "</SPAN>";
-        }
-
-        htmlBuilder << "</DIV>";
-
-        htmlBuilder << "<!--EndFragment -->";
-
-        constexpr std::string_view HtmlFooter = "</BODY></HTML>";
-        htmlBuilder << HtmlFooter;
-
-        // once filled with values, there will be exactly 157 bytes in the clipboard header
-        constexpr size_t ClipboardHeaderSize = 157;
-
-        // these values are byte offsets from start of clipboard
-        const size_t htmlStartPos = ClipboardHeaderSize;
-        const size_t htmlEndPos = ClipboardHeaderSize + gsl::narrow<size_t>(htmlBuilder.tellp());
-        const size_t fragStartPos = ClipboardHeaderSize + gsl::narrow<size_t>(htmlHeader.length());
-        const size_t fragEndPos = htmlEndPos - HtmlFooter.length();
-
-        // header required by HTML 0.9 format
-        std::ostringstream clipHeaderBuilder;
-        clipHeaderBuilder << "Version:0.9\r\n";
-        clipHeaderBuilder << std::setfill('0');
-        clipHeaderBuilder << "StartHTML:" << std::setw(10) << htmlStartPos << "\r\n";
-        clipHeaderBuilder << "EndHTML:" << std::setw(10) << htmlEndPos << "\r\n";
-        clipHeaderBuilder << "StartFragment:" << std::setw(10) << fragStartPos << "\r\n";
-        clipHeaderBuilder << "EndFragment:" << std::setw(10) << fragEndPos << "\r\n";
-        clipHeaderBuilder << "StartSelection:" << std::setw(10) << fragStartPos << "\r\n";
-        clipHeaderBuilder << "EndSelection:" << std::setw(10) << fragEndPos << "\r\n";
-
-        return clipHeaderBuilder.str() + htmlBuilder.str();
-    }
-    catch (...)
+    serializer.Begin();
+    for (const auto& rect : selectionRects)
     {
-        LOG_HR(wil::ResultFromCaughtException());
-        return {};
+        const auto& row = GetRowByOffset(gsl::narrow<size_t>(rect.Top));
+        serializer.WriteRow(row, gsl::narrow<size_t>(rect.Left), gsl::narrow<size_t>(rect.Right) + 1);
     }
+    serializer.End();
 }
 
 // Routine Description:
-// - Generates an RTF document based on the passed in text and color data
-//   RTF 1.5 Spec: https://www.biblioscape.com/rtf15_spec.htm
-// Arguments:
-// - rows - the text and color data we will format & encapsulate
-// - backgroundColor - default background color for characters, also used in padding
-// - fontHeightPoints - the unscaled font height
-// - fontFaceName - the name of the font used
-// - htmlTitle - value used in title tag of html header. Used to name the application
+// - Writes out every row that's kept to a file, from the oldest row in the
+//   scrollback to the last row of the buffer that has text in it. The spaces
+//   at the end of the rows that weren't wrapped are left out.
+// - The rows are copied and written a chunk at a time, see TextBufferExport.
+//   To export a buffer that's shared with other threads without keeping it
+//   locked, use TextBufferExport directly, and only lock it to copy rows.
+// Arguments:
+// - path - the path of the file. It's replaced if it's already there.
+// - format - the format to write the file in. The text is in UTF-8 in all of them.
+// - GetAttributeColors - function used to map TextAttribute to RGB COLORREFs, for HTML
+// - fontHeightPoints - the unscaled font height, for HTML
+// - fontFaceName - the name of the font used, for HTML
+// - backgroundColor - default background color for characters, for HTML
 // Return Value:
-// - string containing the generated RTF
-std::string TextBuffer::GenRTF(const TextAndColor& rows, const int fontHeightPoints, const std::wstring_view fontFaceName, const COLORREF backgroundColor)
+// - <none>
+void TextBuffer::ExportToFile(const std::wstring_view path,
+                              const TextExportFormat format,
+                              const TextSerializer::AttributeColors& GetAttributeColors,
+                              const int fontHeightPoints,
+                              const std::wstring_view fontFaceName,
+                              const COLORREF backgroundColor) const
 {
-    try
-    {
-        std::ostringstream rtfBuilder;
-
-        // start rtf
-        rtfBuilder << "{";
-
-        // Standard RTF header.
-        // This is similar to the header generated by WordPad.
-        // \ansi - specifies that the ANSI char set is used in the current doc
-        // \ansicpg1252 - represents the ANSI code page which is used to perform the Unicode to ANSI conversion when writing RTF text
-        // \deff0 - specifies that the default font for the document is the one at index 0 in the font table
-        // \nouicompat - ?
-        rtfBuilder << "\\rtf1\\ansi\\ansicpg1252\\deff0\\nouicompat";
-
-        // font table
-        rtfBuilder << "{\\fonttbl{\\f0\\fmodern\\fcharset0 " << ConvertToA(CP_UTF8, fontFaceName) << ";}}";
-
-        // map to keep track of colors:
-        // keys are colors represented by COLORREF
-        // values are indices of the corresponding colors in the color table
-        std::unordered_map<COLORREF, int> colorMap;
-        int nextColorIndex = 1; // leave 0 for the default color and start from 1.
-
-        // RTF color table
-        std::ostringstream colorTableBuilder;
-        colorTableBuilder << "{\\colortbl ;";
-        colorTableBuilder << "\\red" << static_cast<int>(GetRValue(backgroundColor))
-                          << "\\green" << static_cast<int>(GetGValue(backgroundColor))
-                          << "\\blue" << static_cast<int>(GetBValue(backgroundColor))
-                          << ";";
-        colorMap[backgroundColor] = nextColorIndex++;
-
-        // content
-        std::ostringstream contentBuilder;
-        contentBuilder << "\\viewkind4\\uc4";
-
-        // paragraph styles
-        // \fs specifies font size in half-points i.e. \fs20 results in a font size
-        // of 10 pts. That's why, font size is multiplied by 2 here.
-        contentBuilder << "\\pard\\slmult1\\f0\\fs" << std::to_string(2 * fontHeightPoints)
-                       << "\\highlight1"
-                       << " ";
-
-        std::optional<COLORREF> fgColor = std::nullopt;
-        std::optional<COLORREF> bkColor = std::nullopt;
-        for (size_t row = 0; row < rows.text.size(); ++row)
-        {
-            size_t startOffset = 0;
-
-            if (row != 0)
-            {
-                contentBuilder << "\\line "; // new line
-            }
-
-            for (size_t col = 0; col < rows.text.at(row).length(); ++col)
-            {
-                const auto writeAccumulatedChars = [&](bool includeCurrent) {
-                    if (col >= startOffset)
-                    {
-                        const auto unescapedText = ConvertToA(CP_UTF8, std::wstring_view(rows.text.at(row)).substr(startOffset, col - startOffset + includeCurrent));
-                        for (const auto c : unescapedText)
-                        {
-                            switch (c)
-                            {
-                            case '\\':
-                            case '{':
-                            case '}':
-                                contentBuilder << "\\" << c;
-                                break;
-                            default:
-                                contentBuilder << c;
-                            }
-                        }
-
-                        startOffset = col;
-                    }
-                };
-
-                if (rows.text.at(row).at(col) == '\r' || rows.text.at(row).at(col) == '\n')
-                {
-                    // do not include \r nor \n as they don't have color attributes.
-                    // For line break use \line instead.
-                    writeAccumulatedChars(false);
-                    break;
-                }
-
-                bool colorChanged = false;
-                if (!fgColor.has_value() || rows.FgAttr.at(row).at(col) != fgColor.value())
-                {
-                    fgColor = rows.FgAttr.at(row).at(col);
-                    colorChanged = true;
-                }
-
-                if (!bkColor.has_value() || rows.BkAttr.at(row).at(col) != bkColor.value())
-                {
-                    bkColor = rows.BkAttr.at(row).at(col);
-                    colorChanged = true;
-                }
-
-                if (colorChanged)
-                {
-                    writeAccumulatedChars(false);
-
-                    int bkColorIndex = 0;
-                    if (colorMap.find(bkColor.value()) != colorMap.end())
-                    {
-                        // color already exists in the map, just retrieve the index
-                        bkColorIndex = colorMap[bkColor.value()];
-                    }
-                    else
-                    {
-                        // color not present in the map, so add it
-                        colorTableBuilder << "\\red" << static_cast<int>(GetRValue(bkColor.value()))
-                                          << "\\green" << static_cast<int>(GetGValue(bkColor.value()))
-                                          << "\\blue" << static_cast<int>(GetBValue(bkColor.value()))
-                                          << ";";
-                        colorMap[bkColor.value()] = nextColorIndex;
-                        bkColorIndex = nextColorIndex++;
-                    }
-
-                    int fgColorIndex = 0;
-                    if (colorMap.find(fgColor.value()) != colorMap.end())
-                    {
-                        // color already exists in the map, just retrieve the index
-                        fgColorIndex = colorMap[fgColor.value()];
-                    }
-                    else
-                    {
-                        // color not present in the map, so add it
-                        colorTableBuilder << "\\red" << static_cast<int>(GetRValue(fgColor.value()))
-                                          << "\\green" << static_cast<int>(GetGValue(fgColor.value()))
-                                          << "\\blue" << static_cast<int>(GetBValue(fgColor.value()))
-                                          << ";";
-                        colorMap[fgColor.value()] = nextColorIndex;
-                        fgColorIndex = nextColorIndex++;
-                    }
-
-                    contentBuilder << "\\highlight" << bkColorIndex
-                                   << "\\cf" << fgColorIndex
-                                   << " ";
-                }
-
-                // if this is the last character in the row, flush the whole row
-                if (col == rows.text.at(row).length() - 1)
-                {
-                    writeAccumulatedChars(true);
-                }
-            }
-        }
-
-        // end colortbl
-        colorTableBuilder << "}";
-
-        // add color table to the final RTF
-        rtfBuilder << colorTableBuilder.str();
-
-        // add the text content to the final RTF
-        rtfBuilder << contentBuilder.str();
-
-        // end rtf
-        rtfBuilder << "}";
-
-        return rtfBuilder.str();
-    }
-    catch (...)
+    TextBufferExport exporter{ path, format, fontHeightPoints, fontFaceName, backgroundColor };
+    while (exporter.CopyRows(*this, GetAttributeColors))
     {
-        LOG_HR(wil::ResultFromCaughtException());
-        return {};
+        exporter.WriteRows();
     }
+    exporter.Finish();
 }
 
 // Function Description:
@@ -2012,6 +2203,17 @@ std::string TextBuffer::GenRTF(const TextAndColor& rows, const int fontHeightPoi
 //   can have different dimensions than the old buffer. If it does, then this
 //   function will attempt to maintain the logical contents of the old buffer,
 //   by continuing wrapped lines onto the next line in the new buffer.
+// - The rows of a logical line (the rows that are joined because text wrapped
+//   off their end) are poured into the new buffer a run of cells at a time.
+//   Only double width cells are inserted one at a time.
+// - The scrollback is handed to the new buffer as it is. It's rewrapped to
+//   the new width the next time its rows are asked for, so that resizing
+//   doesn't take longer the more history there is.
+// - For the same reason, only the rows from the logical line above the cursor,
+//   the viewports and the last character on are reprinted right away. The
+//   lines above them are only laid out, and their rows are written as they're
+//   asked for (see PendingReflow). They're copied from the old buffer, so
+//   hand it over to the new one with AdoptReflowSource once it's replaced.
 // Arguments:
 // - oldBuffer - the text buffer to copy the contents FROM
 // - newBuffer - the text buffer to copy the contents TO
@@ -2039,14 +2241,120 @@ HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer,
 
     const short cOldRowsTotal = cOldLastChar.Y + 1;
     const short cOldColsTotal = oldBuffer.GetSize().Width();
+    const short cNewColsTotal = newBuffer.GetSize().Width();
+
+    // Find the first row to reprint: the start of the logical line above the
+    // cursor, the viewports and the last character. Callers look at the row
+    // above the new viewport, so that one's included.
+    short iFirstReprintedRow = std::min(cOldCursorPos.Y, cOldLastChar.Y);
+    if (positionInfo.has_value())
+    {
+        iFirstReprintedRow = std::min({ iFirstReprintedRow,
+                                        positionInfo.value().get().mutableViewportTop,
+                                        positionInfo.value().get().visibleViewportTop });
+    }
+    iFirstReprintedRow = std::max<short>(iFirstReprintedRow - 1, 0);
+    try
+    {
+        while (iFirstReprintedRow > 0 && _JoinsNextRow(oldBuffer.GetRowByOffset(iFirstReprintedRow - 1)))
+        {
+            iFirstReprintedRow--;
+        }
+
+        // The segments of the old buffer above that row are laid out from the rows that
+        // they're copied from. The others are written, so that their rows can be copied.
+        if (oldBuffer._pendingReflow)
+        {
+            oldBuffer._pendingReflow->WriteUnshared(iFirstReprintedRow);
+        }
+        // A buffer may only be reflowed into one buffer at a time.
+        if (oldBuffer._reflowTarget && oldBuffer._reflowTarget != &newBuffer)
+        {
+            oldBuffer._reflowTarget->_pendingReflow->Detach(oldBuffer);
+        }
+    }
+    CATCH_RETURN();
+
+    // The old buffer's segments are only read from here on, and its rows are
+    // read as they are, so put them aside until it's done.
+    newBuffer._pendingReflow.reset();
+    auto oldPendingReflow = std::move(oldBuffer._pendingReflow);
+    auto restorePendingReflow = wil::scope_exit([&]() noexcept {
+        oldBuffer._pendingReflow = std::move(oldPendingReflow);
+    });
+
+    // The rows that scroll off the top of the new buffer while we reprint
+    // continue the scrollback of the old one, so hand it over.
+    // If reflowing fails, the old buffer stays in use, so it gets its
+    // scrollback back, without the rows that were reprinted so far.
+    std::swap(oldBuffer._scrollback, newBuffer._scrollback);
+    const auto scrollbackEnd = newBuffer._scrollback->GetEndRow();
+    auto restoreScrollback = wil::scope_exit([&]() noexcept {
+        newBuffer._scrollback->Truncate(scrollbackEnd);
+        std::swap(oldBuffer._scrollback, newBuffer._scrollback);
+    });
+
+    // Lay out the rows above the first one to reprint, a segment at a time.
+    // Each one ends at the end of a logical line.
+    size_t coldRows = 0;
+    try
+    {
+        auto pendingReflow = std::make_unique<PendingReflow>(newBuffer, oldBuffer);
+        const auto oldSegmentCount = oldPendingReflow ? oldPendingReflow->_segments.size() : 0;
+        size_t oldSegmentIndex = 0;
+        for (size_t iOldRow = 0; iOldRow < gsl::narrow_cast<size_t>(iFirstReprintedRow);)
+        {
+            const auto oldSegment = oldSegmentIndex < oldSegmentCount ? &til::at(oldPendingReflow->_segments, oldSegmentIndex) : nullptr;
+            PendingReflow::Segment segment{ scrollbackEnd + gsl::narrow_cast<int64_t>(coldRows) };
+            if (oldSegment && oldSegment->firstRow == scrollbackEnd + gsl::narrow_cast<int64_t>(iOldRow))
+            {
+                segment.source = oldSegment->source;
+                segment.sharedSource = oldSegment->sharedSource;
+                segment.sourceFirstRow = oldSegment->sourceFirstRow;
+                segment.sourceRowCount = oldSegment->sourceRowCount;
+                iOldRow += oldSegment->rowCount;
+                oldSegmentIndex++;
+            }
+            else
+            {
+                // The old buffer's own rows, up to its next segment.
+                const auto endRow = oldSegment ? gsl::narrow_cast<size_t>(oldSegment->firstRow - scrollbackEnd) : gsl::narrow_cast<size_t>(iFirstReprintedRow);
+                segment.source = &oldBuffer;
+                segment.sourceFirstRow = iOldRow;
+                bool joinsNextRow;
+                do
+                {
+                    joinsNextRow = _JoinsNextRow(oldBuffer.GetRowByOffset(iOldRow));
+                    iOldRow++;
+                } while (iOldRow < endRow && (joinsNextRow || iOldRow - segment.sourceFirstRow < PendingReflow::SegmentRows));
+                segment.sourceRowCount = iOldRow - segment.sourceFirstRow;
+            }
+            segment.rowCount = newBuffer._ReflowRows(*segment.source, segment.sourceFirstRow, segment.sourceRowCount, std::nullopt);
+            coldRows += segment.rowCount;
+            pendingReflow->Add(std::move(segment));
+        }
+        if (!pendingReflow->empty())
+        {
+            newBuffer._pendingReflow = std::move(pendingReflow);
+        }
+    }
+    CATCH_RETURN();
+
+    // Move the cursor below them, as if they were reprinted.
+    HRESULT hr = S_OK;
+    const auto cNewRowsTotal = newBuffer._storage.size();
+    for (auto circled = coldRows; circled >= cNewRowsTotal && SUCCEEDED(hr); --circled)
+    {
+        hr = newBuffer.IncrementCircularBuffer() ? hr : E_OUTOFMEMORY;
+    }
+    newCursor.SetPosition({ 0, gsl::narrow_cast<short>(std::min(coldRows, cNewRowsTotal - 1)) });
 
     COORD cNewCursorPos = { 0 };
     bool fFoundCursorPos = false;
     bool foundOldMutable = false;
     bool foundOldVisible = false;
-    HRESULT hr = S_OK;
-    // Loop through all the rows of the old buffer and reprint them into the new buffer
-    for (short iOldRow = 0; iOldRow < cOldRowsTotal; iOldRow++)
+    // Loop through the rest of the rows of the old buffer and reprint them into the new buffer
+    for (short iOldRow = iFirstReprintedRow; iOldRow < cOldRowsTotal && SUCCEEDED(hr); iOldRow++)
     {
         // Fetch the row and its "right" which is the last printable character.
         const ROW& row = oldBuffer.GetRowByOffset(iOldRow);
@@ -2079,26 +2387,51 @@ HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer,
 
         // Loop through every character in the current row (up to
         // the "right" boundary, which is one past the final valid
-        // character)
-        for (short iOldCol = 0; iOldCol < iRight; iOldCol++)
+        // character), a run of cells at a time. A run ends at a
+        // double width cell or at the end of the new buffer's row.
+        for (short iOldCol = 0; iOldCol < iRight;)
         {
-            if (iOldCol == cOldCursorPos.X && iOldRow == cOldCursorPos.Y)
-            {
-                cNewCursorPos = newCursor.GetPosition();
-                fFoundCursorPos = true;
-            }
-
+            const COORD coordNewPos = newCursor.GetPosition();
             try
             {
-                // TODO: MSFT: 19446208 - this should just use an iterator and the inserter...
-                const auto glyph = row.GetCharRow().GlyphAt(iOldCol);
-                const auto dbcsAttr = row.GetCharRow().DbcsAttrAt(iOldCol);
-                const auto textAttr = row.GetAttrRow().GetAttrByColumn(iOldCol);
+                short cCells = 0;
+                while (cCells < cNewColsTotal - coordNewPos.X &&
+                       iOldCol + cCells < iRight &&
+                       charRow.DbcsAttrAt(gsl::narrow_cast<size_t>(iOldCol) + cCells).IsSingle())
+                {
+                    cCells++;
+                }
 
-                if (!newBuffer.InsertCharacter(glyph, dbcsAttr, textAttr))
+                // Every cell of a run lands on the row that the run starts on.
+                if (iOldRow == cOldCursorPos.Y && cOldCursorPos.X >= iOldCol && cOldCursorPos.X < iOldCol + std::max<short>(cCells, 1))
                 {
-                    hr = E_OUTOFMEMORY;
-                    break;
+                    cNewCursorPos = coordNewPos;
+                    cNewCursorPos.X += cOldCursorPos.X - iOldCol;
+                    fFoundCursorPos = true;
+                }
+
+                if (cCells == 0)
+                {
+                    // TODO: MSFT: 19446208 - this should just use an iterator and the inserter...
+                    const auto glyph = charRow.GlyphAt(iOldCol);
+                    const auto dbcsAttr = charRow.DbcsAttrAt(iOldCol);
+                    const auto textAttr = row.GetAttrRow().GetAttrByColumn(iOldCol);
+
+                    if (!newBuffer.InsertCharacter(glyph, dbcsAttr, textAttr))
+                    {
+                        hr = E_OUTOFMEMORY;
+                        break;
+                    }
+                    iOldCol++;
+                }
+                else
+                {
+                    if (!newBuffer._InsertCells(row, iOldCol, cCells))
+                    {
+                        hr = E_OUTOFMEMORY;
+                        break;
+                    }
+                    iOldCol += cCells;
                 }
             }
             CATCH_RETURN();
@@ -2255,11 +2588,165 @@ HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer,
 
         // Set size back to real size as it will be taking over the rendering duties.
         newCursor.SetSize(ulSize);
+
+        // The rows that scrolled off while reprinting have the new width already.
+        if (cNewColsTotal != cOldColsTotal || newBuffer._scrollback->IsRewrapPending())
+        {
+            newBuffer._scrollback->Rewrap(scrollbackEnd, cNewColsTotal);
+        }
+        restoreScrollback.release();
     }
 
     return hr;
 }
 
+// Routine Description:
+// - Takes over the buffer that this one was reflowed from, once it's been
+//   replaced. The rows that Reflow didn't write yet are copied from it, so
+//   it's kept until they're all written. Any other buffer is just freed.
+// Arguments:
+// - source - The old buffer that was passed to Reflow.
+void TextBuffer::AdoptReflowSource(std::unique_ptr<TextBuffer> source) noexcept
+{
+    if (source && _pendingReflow && _pendingReflow->_source == source.get())
+    {
+        try
+        {
+            // If it can't be shared, it writes the rows into this buffer as it's freed.
+            _pendingReflow->Adopt(std::shared_ptr<const TextBuffer>{ std::move(source) });
+        }
+        CATCH_LOG();
+    }
+}
+
+// Routine Description:
+// - Reprints rows of another buffer at the width of this one, the same way
+//   that Reflow does, or just counts the rows that they'd take.
+// Arguments:
+// - source - The buffer to copy the rows from. Its rows are read as they are.
+// - sourceFirstRow - The offset of the first row to copy.
+// - sourceRowCount - The number of rows to copy. The last one has to end a logical line.
+// - firstRow - The absolute row to start at, or nullopt to only count the
+//   rows. Only the rows that are in this buffer are written.
+// - skippedRows - The number of rows at the top that were written already.
+// Return Value:
+// - The number of rows, including the one that the line break after the last row moves onto.
+size_t TextBuffer::_ReflowRows(const TextBuffer& source, const size_t sourceFirstRow, const size_t sourceRowCount, const std::optional<int64_t> firstRow, const size_t skippedRows)
+{
+    const auto width = gsl::narrow_cast<size_t>(_size.Width());
+    const auto bufferFirstRow = GetFirstAbsoluteRow();
+    size_t x = 0;
+    size_t y = 0;
+
+    const auto getRow = [&](const size_t row) -> ROW* {
+        const auto offset = firstRow.has_value() ? firstRow.value() + gsl::narrow_cast<int64_t>(row) - bufferFirstRow : -1;
+        if (row < skippedRows || offset < 0 || offset >= gsl::narrow_cast<int64_t>(_storage.size()))
+        {
+            return nullptr;
+        }
+        return &til::at(_storage, _GetStorageIndex(gsl::narrow_cast<size_t>(offset)));
+    };
+    // Like _AssertValidDoubleByteSequence, erase a leading cell that isn't followed by its trailing one.
+    const auto prepare = [&](const DbcsAttribute dbcsAttribute) {
+        const auto previous = x > 0 ? getRow(y) : (y > 0 ? getRow(y - 1) : nullptr);
+        const auto column = x > 0 ? x - 1 : width - 1;
+        if (previous && !dbcsAttribute.IsTrailing() && previous->GetCharRow().DbcsAttrAt(column).IsLeading())
+        {
+            previous->ClearColumn(column);
+        }
+    };
+    // Like IncrementCursor, wrap onto the next row once the cells fill the row.
+    const auto advance = [&](const size_t cells) {
+        x += cells;
+        if (x == width)
+        {
+            if (const auto row = getRow(y))
+            {
+                row->GetCharRow().SetWrapForced(true);
+            }
+            x = 0;
+            y++;
+        }
+    };
+
+    for (auto i = sourceFirstRow; i < sourceFirstRow + sourceRowCount; ++i)
+    {
+        const auto& sourceRow = til::at(source._storage, source._GetStorageIndex(i));
+        const auto& charRow = sourceRow.GetCharRow();
+        auto right = charRow.MeasureRight();
+        if (charRow.WasWrapForced())
+        {
+            right = charRow.size() - (charRow.WasDoubleBytePadded() ? 1 : 0);
+        }
+
+        for (size_t column = 0; column < right;)
+        {
+            const auto dbcsAttribute = charRow.DbcsAttrAt(column);
+            prepare(dbcsAttribute);
+            if (dbcsAttribute.IsSingle())
+            {
+                size_t cells = 1;
+                while (cells < width - x && column + cells < right && charRow.DbcsAttrAt(column + cells).IsSingle())
+                {
+                    cells++;
+                }
+                if (const auto row = getRow(y))
+                {
+                    row->MarkChanged();
+                    row->GetCharRow().CopyCellsFrom(charRow, column, cells, x);
+                    THROW_IF_FAILED(row->GetAttrRow().CopyAttrsToEnd(sourceRow.GetAttrRow(), column, cells, x));
+                }
+                column += cells;
+                advance(cells);
+            }
+            else
+            {
+                // Like _PrepareForDoubleByteSequence, pad the last column instead of leading in it.
+                if (dbcsAttribute.IsLeading() && x == width - 1)
+                {
+                    if (const auto row = getRow(y))
+                    {
+                        row->GetCharRow().SetDoubleBytePadded(true);
+                        row->MarkChanged();
+                    }
+                    advance(1);
+                }
+                if (const auto row = getRow(y))
+                {
+                    row->MarkChanged();
+                    auto& newCharRow = row->GetCharRow();
+                    newCharRow.DbcsAttrAt(x) = dbcsAttribute;
+                    newCharRow.GlyphAt(x) = static_cast<std::wstring_view>(charRow.GlyphAt(column));
+                    THROW_HR_IF(E_OUTOFMEMORY, !row->GetAttrRow().SetAttrToEnd(gsl::narrow_cast<UINT>(x), sourceRow.GetAttrRow().GetAttrByColumn(column)));
+                }
+                column++;
+                advance(1);
+            }
+        }
+
+        if (!_JoinsNextRow(sourceRow))
+        {
+            x = 0;
+            y++;
+        }
+    }
+    return y;
+}
+
+// Routine Description:
+// - Checks whether Reflow joins a row with the next one into a logical line,
+//   rather than breaking the line after it: when text wrapped off its end,
+//   or when its text reaches its end.
+// Arguments:
+// - row - The row.
+// Return Value:
+// - true if the row continues onto the next.
+bool TextBuffer::_JoinsNextRow(const ROW& row) noexcept
+{
+    const auto& charRow = row.GetCharRow();
+    return charRow.WasWrapForced() || charRow.MeasureRight() >= charRow.size();
+}
+
 // Method Description:
 // - Adds or updates a hyperlink in our hyperlink table
 // Arguments:
@@ -2376,7 +2863,8 @@ void TextBuffer::CopyHyperlinkMaps(const TextBuffer& other)
 const size_t TextBuffer::AddPatternRecognizer(const std::wstring_view regexString)
 {
     ++_currentPatternId;
-    _idsAndPatterns.emplace(std::make_pair(_currentPatternId, regexString));
+    _idsAndPatterns.emplace(_currentPatternId, PatternMatcher{ regexString });
+    _patternLines.clear();
     return _currentPatternId;
 }
 
@@ -2388,62 +2876,66 @@ void TextBuffer::CopyPatterns(const TextBuffer& OtherBuffer)
 {
     _idsAndPatterns = OtherBuffer._idsAndPatterns;
     _currentPatternId = OtherBuffer._currentPatternId;
+    _patternLines.clear();
 }
 
 // Method Description:
-// - Finds patterns within the requested region of the text buffer
+// - Finds patterns within the requested region of the text buffer.
+//   A pattern can span the rows of a logical line, but not a line break.
+// - The matches of each line are kept until the next call, and only the
+//   lines that have a row that changed since then are searched again.
 // Arguments:
 // - The firstRow to start searching from
 // - The lastRow to search
 // Return value:
 // - An interval tree containing the patterns found
-PointTree TextBuffer::GetPatterns(const size_t firstRow, const size_t lastRow) const
+PointTree TextBuffer::GetPatterns(const size_t firstRow, const size_t lastRow)
 {
     PointTree::interval_vector intervals;
 
-    std::wstring concatAll;
     const auto rowSize = GetRowByOffset(0).size();
-    concatAll.reserve(rowSize * (lastRow - firstRow + 1));
-
-    // to deal with text that spans multiple lines, we will first concatenate
-    // all the text into one string and find the patterns in that string
-    for (auto i = firstRow; i <= lastRow; ++i)
+    if (_patternLinesWidth != rowSize)
     {
-        auto row = GetRowByOffset(i);
-        concatAll += row.GetCharRow().GetText();
+        _patternLines.clear();
+        _patternLinesWidth = rowSize;
     }
 
-    // for each pattern we know of, iterate through the string
-    for (const auto& idAndPattern : _idsAndPatterns)
-    {
-        std::wregex regexObj{ idAndPattern.second };
+    // Only the lines in this region are kept for next time.
+    std::unordered_map<int64_t, _PatternLine> lines;
 
-        // search through the run with our regex object
-        auto words_begin = std::wsregex_iterator(concatAll.begin(), concatAll.end(), regexObj);
-        auto words_end = std::wsregex_iterator();
+    // to deal with text that spans multiple rows, we find the patterns in the
+    // text of the rows of each logical line at once. Only the rows within the
+    // region are included.
+    for (const auto& line : GetLogicalLines(firstRow, lastRow))
+    {
+        const auto lineFirstRow = std::max(line.firstRow, firstRow);
+        const auto lineLastRow = std::min(line.firstRow + line.rowCount - 1, lastRow);
+        const auto rowCount = lineLastRow - lineFirstRow + 1;
 
-        size_t lenUpToThis = 0;
-        for (auto i = words_begin; i != words_end; ++i)
+        // Rows keep their absolute index and revision as the buffer scrolls,
+        // so a line that only moved up is still found.
+        const auto absoluteRow = GetFirstAbsoluteRow() + gsl::narrow_cast<int64_t>(lineFirstRow);
+        auto& found = lines[absoluteRow];
+        const auto previous = _patternLines.find(absoluteRow);
+        if (previous != _patternLines.end() &&
+            previous->second.rowCount == rowCount &&
+            GetRowsChangedSince(previous->second.revision, lineFirstRow, lineLastRow).empty())
         {
-            // record the locations -
-            // when we find a match, the prefix is text that is between this
-            // match and the previous match, so we use the size of the prefix
-            // along with the size of the match to determine the locations
-            size_t prefixSize = 0;
-
-            for (const auto ch : i->prefix().str())
-            {
-                prefixSize += IsGlyphFullWidth(ch) ? 2 : 1;
-            }
-            const auto start = lenUpToThis + prefixSize;
-            size_t matchSize = 0;
-            for (const auto ch : i->str())
-            {
-                matchSize += IsGlyphFullWidth(ch) ? 2 : 1;
-            }
-            const auto end = start + matchSize;
-            lenUpToThis = end;
+            found = std::move(previous->second);
+        }
+        else
+        {
+            found.rowCount = rowCount;
+            found.revision = _revision;
+            _FindPatterns(lineFirstRow, lineLastRow, found);
+        }
 
+        // the positions are relative to the first row of the region
+        const auto lineStart = (lineFirstRow - firstRow) * rowSize;
+        for (const auto& [matchStart, matchEnd, patternId] : found.matches)
+        {
+            const auto start = lineStart + matchStart;
+            const auto end = lineStart + matchEnd;
             const til::point startCoord{ gsl::narrow<SHORT>(start % rowSize), gsl::narrow<SHORT>(start / rowSize) };
             const til::point endCoord{ gsl::narrow<SHORT>(end % rowSize), gsl::narrow<SHORT>(end / rowSize) };
 
@@ -2452,9 +2944,55 @@ PointTree TextBuffer::GetPatterns(const size_t firstRow, const size_t lastRow) c
             // Keeping these relative to the viewport for now because its the renderer
             // that actually uses these locations and the renderer works relative to
             // the viewport
-            intervals.push_back(PointTree::interval(startCoord, endCoord, idAndPattern.first));
+            intervals.push_back(PointTree::interval(startCoord, endCoord, patternId));
         }
     }
+    _patternLines = std::move(lines);
+
     PointTree result(std::move(intervals));
     return result;
 }
+
+// Method Description:
+// - Searches the text of some rows for every pattern.
+// Arguments:
+// - firstRow - The offset of the first row of the text.
+// - lastRow - The offset of the last row of the text, inclusive.
+// - line - Receives the matches, in cells from the start of the first row.
+// Return value:
+// - <none>
+void TextBuffer::_FindPatterns(const size_t firstRow, const size_t lastRow, _PatternLine& line)
+{
+    // The column of each character is noted as the text is put together, so
+    // that the positions of the matches don't have to be measured afterwards.
+    _patternText.clear();
+    _patternColumns.clear();
+    size_t lineColumn = 0;
+    for (auto i = firstRow; i <= lastRow; ++i)
+    {
+        const auto& charRow = GetRowByOffset(i).GetCharRow();
+        for (size_t column = 0; column < charRow.size(); ++column)
+        {
+            if (!charRow.DbcsAttrAt(column).IsTrailing())
+            {
+                for (const auto wch : charRow.GlyphAt(column))
+                {
+                    _patternText.push_back(wch);
+                    _patternColumns.push_back(lineColumn + column);
+                }
+            }
+        }
+        lineColumn += charRow.size();
+    }
+    // A match that runs to the end of the text ends after its last cell.
+    _patternColumns.push_back(lineColumn);
+
+    line.matches.clear();
+    for (const auto& [patternId, matcher] : _idsAndPatterns)
+    {
+        for (auto match = matcher.Find(_patternText, 0); match; match = matcher.Find(_patternText, match->second))
+        {
+            line.matches.emplace_back(til::at(_patternColumns, match->first), til::at(_patternColumns, match->second), patternId);
+        }
+    }
+}
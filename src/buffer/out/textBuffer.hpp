@@ -50,9 +50,13 @@ filling in the last row, and updating the screen.
 #pragma once
 
 #include "cursor.h"
+#include "LogicalLineIndex.hpp"
+#include "PatternMatcher.hpp"
+#include "PendingReflow.hpp"
 #include "Row.hpp"
+#include "Scrollback.hpp"
 #include "TextAttribute.hpp"
-#include "UnicodeStorage.hpp"
+#include "TextSerializer.hpp"
 #include "../types/inc/Viewport.hpp"
 
 #include "../buffer/out/textBufferCellIterator.hpp"
@@ -68,6 +72,7 @@ public:
                const UINT cursorSize,
                Microsoft::Console::Render::IRenderTarget& renderTarget);
     TextBuffer(const TextBuffer& a) = delete;
+    ~TextBuffer();
 
     // Used for duplicating properties to another text buffer
     void CopyProperties(const TextBuffer& OtherBuffer) noexcept;
@@ -76,6 +81,16 @@ public:
     const ROW& GetRowByOffset(const size_t index) const;
     ROW& GetRowByOffset(const size_t index);
 
+    // scrollback, in absolute rows
+    const ROW& GetRowByAbsoluteIndex(const int64_t row) const;
+    int64_t GetFirstAbsoluteRow() const noexcept;
+    void SetScrollbackBudget(const size_t bytes) noexcept;
+    void SetScrollbackRowLimit(const size_t rows) noexcept;
+    void SetScrollbackColdThreshold(const size_t rows) noexcept;
+    void SetScrollbackSpillToDisk(const bool spill) noexcept;
+    void ClearScrollback() noexcept;
+    const Scrollback& GetScrollback() const noexcept;
+
     TextBufferCellIterator GetCellDataAt(const COORD at) const;
     TextBufferCellIterator GetCellLineDataAt(const COORD at) const;
     TextBufferCellIterator GetCellDataAt(const COORD at, const Microsoft::Console::Types::Viewport limit) const;
@@ -95,6 +110,21 @@ public:
                                  const std::optional<bool> setWrap = std::nullopt,
                                  const std::optional<size_t> limitRight = std::nullopt);
 
+    static size_t MeasurePrintableAscii(const std::wstring_view text) noexcept;
+    size_t WriteAscii(const std::wstring_view text,
+                      const COORD target,
+                      const TextAttribute& attr,
+                      const std::optional<bool> wrap = true);
+
+    size_t FillCells(const wchar_t wch,
+                     const TextAttribute& attr,
+                     const COORD target,
+                     const size_t count,
+                     const std::optional<bool> wrap = true);
+    void FillRect(const wchar_t wch,
+                  const TextAttribute& attr,
+                  const Microsoft::Console::Types::Viewport& rect);
+
     bool InsertCharacter(const wchar_t wch, const DbcsAttribute dbcsAttribute, const TextAttribute attr);
     bool InsertCharacter(const std::wstring_view chars, const DbcsAttribute dbcsAttribute, const TextAttribute attr);
     bool IncrementCursor();
@@ -108,12 +138,27 @@ public:
     Cursor& GetCursor() noexcept;
     const Cursor& GetCursor() const noexcept;
 
-    const SHORT GetFirstRowIndex() const noexcept;
+    size_t GetFirstRowIndex() const noexcept;
 
     const Microsoft::Console::Types::Viewport GetSize() const noexcept;
 
     void ScrollRows(const SHORT firstRow, const SHORT size, const SHORT delta);
 
+    // A logical line is a row and the rows that its text wrapped onto.
+    struct LogicalLine
+    {
+        // The offset of the first row of the line. The rows that scrolled off
+        // the top of the buffer aren't counted.
+        size_t firstRow;
+        size_t rowCount;
+    };
+
+    LogicalLine GetLogicalLineAt(const size_t row) const;
+    std::vector<LogicalLine> GetLogicalLines(const size_t firstRow, const size_t lastRow) const;
+
+    uint64_t GetRevision() const noexcept;
+    std::vector<size_t> GetRowsChangedSince(const uint64_t revision, const size_t firstRow, const size_t lastRow) const;
+
     UINT TotalRowCount() const noexcept;
 
     [[nodiscard]] TextAttribute GetCurrentAttributes() const noexcept;
@@ -124,9 +169,6 @@ public:
 
     [[nodiscard]] HRESULT ResizeTraditional(const COORD newSize) noexcept;
 
-    const UnicodeStorage& GetUnicodeStorage() const noexcept;
-    UnicodeStorage& GetUnicodeStorage() noexcept;
-
     Microsoft::Console::Render::IRenderTarget& GetRenderTarget() noexcept;
 
     const COORD GetWordStart(const COORD target, const std::wstring_view wordDelimiters, bool accessibilityMode = false) const;
@@ -161,15 +203,13 @@ public:
                                const std::vector<SMALL_RECT>& textRects,
                                std::function<std::pair<COLORREF, COLORREF>(const TextAttribute&)> GetAttributeColors = nullptr) const;
 
-    static std::string GenHTML(const TextAndColor& rows,
-                               const int fontHeightPoints,
-                               const std::wstring_view fontFaceName,
-                               const COLORREF backgroundColor);
-
-    static std::string GenRTF(const TextAndColor& rows,
-                              const int fontHeightPoints,
-                              const std::wstring_view fontFaceName,
-                              const COLORREF backgroundColor);
+    void Serialize(const std::vector<SMALL_RECT>& selectionRects, TextSerializer& serializer) const;
+    void ExportToFile(const std::wstring_view path,
+                      const TextExportFormat format,
+                      const TextSerializer::AttributeColors& GetAttributeColors,
+                      const int fontHeightPoints,
+                      const std::wstring_view fontFaceName,
+                      const COLORREF backgroundColor) const;
 
     struct PositionInformation
     {
@@ -181,33 +221,59 @@ public:
                           TextBuffer& newBuffer,
                           const std::optional<Microsoft::Console::Types::Viewport> lastCharacterViewport,
                           std::optional<std::reference_wrapper<PositionInformation>> positionInfo);
+    void AdoptReflowSource(std::unique_ptr<TextBuffer> source) noexcept;
 
     const size_t AddPatternRecognizer(const std::wstring_view regexString);
     void CopyPatterns(const TextBuffer& OtherBuffer);
-    interval_tree::IntervalTree<til::point, size_t> GetPatterns(const size_t firstRow, const size_t lastRow) const;
+    interval_tree::IntervalTree<til::point, size_t> GetPatterns(const size_t firstRow, const size_t lastRow);
 
 private:
     void _UpdateSize();
     Microsoft::Console::Types::Viewport _size;
-    std::deque<ROW> _storage;
+
+    // The cells of all rows are allocated at once, as one block of
+    // width * height cells. The rows only point into it.
+    std::unique_ptr<CharRowCell[]> _charBuffer;
+    // The attributes of all rows are interned in this table, and their runs
+    // are allocated from this pool, which carves them out of larger blocks.
+    // Both must outlive the rows.
+    TextAttributeTable _attributeTable;
+    std::pmr::unsynchronized_pool_resource _attrRunPool;
+    std::vector<ROW> _storage;
+    // Which of the rows in _storage wrap into the next, kept up to date by the rows.
+    LogicalLineIndex _lineIndex;
+    // Counts the changes to the rows. Each row records the revision it last changed in.
+    uint64_t _revision;
+    // The rows that scrolled off the top. It can't be moved, as its rows
+    // point into it, but it's handed over to the new buffer on reflow.
+    std::unique_ptr<Scrollback> _scrollback;
+    // The rows that Reflow laid out but hasn't written yet, if any.
+    std::unique_ptr<PendingReflow> _pendingReflow;
+    // The buffer that was reflowed from this one while it still copies rows from it.
+    TextBuffer* _reflowTarget;
     Cursor _cursor;
 
-    SHORT _firstRow; // indexes top row (not necessarily 0)
+    size_t _firstRow; // indexes top row (not necessarily 0)
 
     TextAttribute _currentAttributes;
 
-    // storage location for glyphs that can't fit into the buffer normally
-    UnicodeStorage _unicodeStorage;
-
     std::unordered_map<uint16_t, std::wstring> _hyperlinkMap;
     std::unordered_map<std::wstring, uint16_t> _hyperlinkCustomIdMap;
     uint16_t _currentHyperlinkId;
 
-    void _RefreshRowIDs(std::optional<SHORT> newRowWidth);
+    size_t _GetStorageIndex(const size_t offset) const noexcept;
+    void _NotifyWrapForced(const size_t rowIndex, const bool wrapForced) noexcept;
+    void _RebuildLineIndex();
+    uint64_t _NextRevision() noexcept;
+    void _RotateRows(const size_t first, const size_t middle, const size_t last);
+    size_t _ReflowRows(const TextBuffer& source, const size_t sourceFirstRow, const size_t sourceRowCount, const std::optional<int64_t> firstRow, const size_t skippedRows = 0);
+    static bool _JoinsNextRow(const ROW& row) noexcept;
+    static std::unique_ptr<CharRowCell[]> _AllocateCharBuffer(const COORD size);
+    static gsl::span<CharRowCell> _GetCharBufferRow(const std::unique_ptr<CharRowCell[]>& charBuffer, const SHORT width, const size_t row) noexcept;
 
     Microsoft::Console::Render::IRenderTarget& _renderTarget;
 
-    void _SetFirstRowIndex(const SHORT FirstRowIndex) noexcept;
+    void _SetFirstRowIndex(const size_t FirstRowIndex) noexcept;
 
     COORD _GetPreviousFromCursor() const noexcept;
 
@@ -218,6 +284,7 @@ private:
 
     // Assist with maintaining proper buffer state for Double Byte character sequences
     bool _PrepareForDoubleByteSequence(const DbcsAttribute dbcsAttribute);
+    bool _InsertCells(const ROW& source, const short sourceColumn, const short count);
     bool _AssertValidDoubleByteSequence(const DbcsAttribute dbcsAttribute);
 
     ROW& _GetFirstRow();
@@ -233,8 +300,32 @@ private:
 
     void _PruneHyperlinks();
 
-    std::unordered_map<size_t, std::wstring> _idsAndPatterns;
+    // The patterns found in a logical line, or in the part of it that was searched.
+    struct _PatternLine
+    {
+        size_t rowCount;
+        // The revision of the buffer when the line was searched. See GetRevision.
+        uint64_t revision;
+        // The start and end of each match, in cells from the start of the
+        // line, and the ID of its pattern.
+        std::vector<std::tuple<size_t, size_t, size_t>> matches;
+    };
+
+    void _FindPatterns(const size_t firstRow, const size_t lastRow, _PatternLine& line);
+
+    std::unordered_map<size_t, PatternMatcher> _idsAndPatterns;
     size_t _currentPatternId;
+    // The lines that GetPatterns searched last time, by the absolute index of
+    // their first row, so that only the ones that changed are searched again.
+    std::unordered_map<int64_t, _PatternLine> _patternLines;
+    size_t _patternLinesWidth;
+    // Reused by _FindPatterns: the text of a line, and the column of each of its characters.
+    std::wstring _patternText;
+    std::vector<size_t> _patternColumns;
+
+    friend class CharRow;
+    friend class PendingReflow;
+    friend class ROW;
 
 #ifdef UNIT_TESTING
     friend class TextBufferTests;
@@ -265,3 +265,16 @@ const OutputCellView* TextBufferCellIterator::operator->() const noexcept
 {
     return &_view;
 }
+
+// Routine Description:
+// - Gets the ID that the attribute of the cell is interned as. The attributes
+//   of two cells of the same buffer are equal if and only if their IDs are,
+//   which is cheaper to compare than the attributes themselves.
+// Arguments:
+// - <none> - Uses current position
+// Return Value:
+// - The ID of the attribute.
+TextAttributeTable::Id TextBufferCellIterator::GetAttributeId() const
+{
+    return _attrIter.GetId();
+}
@@ -21,6 +21,7 @@ Author(s):
 #include "../../types/inc/viewport.hpp"
 
 class TextBuffer;
+class ROW;
 
 class TextBufferCellIterator
 {
@@ -47,6 +48,8 @@ public:
     const OutputCellView& operator*() const noexcept;
     const OutputCellView* operator->() const noexcept;
 
+    TextAttributeTable::Id GetAttributeId() const;
+
 protected:
     void _SetPos(const COORD newPos);
     void _GenerateView();
@@ -0,0 +1,102 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../LogicalLineIndex.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class LogicalLineIndexTests
+{
+    TEST_CLASS(LogicalLineIndexTests);
+
+    TEST_METHOD(SetWrappedIgnoresRowsBeyondStorage);
+    TEST_METHOD(CountsRunsAcrossWords);
+    TEST_METHOD(CountsAroundStorageEnd);
+    TEST_METHOD(SwapTradesFlags);
+};
+
+void LogicalLineIndexTests::SetWrappedIgnoresRowsBeyondStorage()
+{
+    LogicalLineIndex index;
+    index.Reset(10);
+    VERIFY_ARE_EQUAL(10u, index.size());
+
+    index.SetWrapped(3, true);
+    index.SetWrapped(10, true);
+    VERIFY_IS_TRUE(index.IsWrapped(3));
+    VERIFY_IS_FALSE(index.IsWrapped(10));
+
+    index.SetWrapped(3, false);
+    VERIFY_IS_FALSE(index.IsWrapped(3));
+
+    Log::Comment(L"Resetting unwraps every row.");
+    index.SetWrapped(5, true);
+    index.Reset(10);
+    VERIFY_IS_FALSE(index.IsWrapped(5));
+}
+
+void LogicalLineIndexTests::CountsRunsAcrossWords()
+{
+    LogicalLineIndex index;
+    index.Reset(200);
+    for (size_t i = 20; i < 150; ++i)
+    {
+        index.SetWrapped(i, true);
+    }
+
+    // Rows 20 through 149 wrap, so rows 20 through 150 are one line.
+    VERIFY_ARE_EQUAL(130u, index.CountWrappedFrom(20, 180));
+    VERIFY_ARE_EQUAL(80u, index.CountWrappedFrom(70, 130));
+    VERIFY_ARE_EQUAL(0u, index.CountWrappedFrom(150, 50));
+    VERIFY_ARE_EQUAL(130u, index.CountWrappedBefore(150, 150));
+    VERIFY_ARE_EQUAL(50u, index.CountWrappedBefore(70, 70));
+    VERIFY_ARE_EQUAL(0u, index.CountWrappedBefore(20, 20));
+
+    Log::Comment(L"The counts stop at the limit even if the line goes on.");
+    VERIFY_ARE_EQUAL(10u, index.CountWrappedFrom(70, 10));
+    VERIFY_ARE_EQUAL(10u, index.CountWrappedBefore(70, 10));
+}
+
+void LogicalLineIndexTests::CountsAroundStorageEnd()
+{
+    LogicalLineIndex index;
+    index.Reset(40);
+    for (const size_t i : { 37, 38, 39, 0, 1 })
+    {
+        index.SetWrapped(i, true);
+    }
+
+    Log::Comment(L"The storage is circular, so a line can continue from its last row to its first.");
+    VERIFY_ARE_EQUAL(5u, index.CountWrappedFrom(37, 40));
+    VERIFY_ARE_EQUAL(5u, index.CountWrappedBefore(2, 40));
+    VERIFY_ARE_EQUAL(3u, index.CountWrappedBefore(0, 40));
+
+    Log::Comment(L"If every row wraps, the counts are only bounded by the limit.");
+    for (size_t i = 0; i < 40; ++i)
+    {
+        index.SetWrapped(i, true);
+    }
+    VERIFY_ARE_EQUAL(39u, index.CountWrappedFrom(5, 39));
+    VERIFY_ARE_EQUAL(39u, index.CountWrappedBefore(5, 39));
+}
+
+void LogicalLineIndexTests::SwapTradesFlags()
+{
+    LogicalLineIndex index;
+    index.Reset(64);
+    index.SetWrapped(2, true);
+
+    index.Swap(2, 40);
+    VERIFY_IS_FALSE(index.IsWrapped(2));
+    VERIFY_IS_TRUE(index.IsWrapped(40));
+
+    index.Swap(40, 41);
+    VERIFY_IS_FALSE(index.IsWrapped(40));
+    VERIFY_IS_TRUE(index.IsWrapped(41));
+}
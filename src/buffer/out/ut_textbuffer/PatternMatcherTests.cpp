@@ -0,0 +1,112 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../PatternMatcher.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class PatternMatcherTests
+{
+    TEST_CLASS(PatternMatcherTests);
+
+    TEST_METHOD(FindsWhatRegexFinds);
+    TEST_METHOD(LooksBeforeOffset);
+    TEST_METHOD(FallsBackToRegex);
+};
+
+namespace
+{
+    std::vector<std::pair<size_t, size_t>> findAll(const PatternMatcher& matcher, const std::wstring_view text)
+    {
+        std::vector<std::pair<size_t, size_t>> matches;
+        for (auto match = matcher.Find(text, 0); match; match = matcher.Find(text, match->second))
+        {
+            matches.emplace_back(*match);
+        }
+        return matches;
+    }
+
+    std::vector<std::pair<size_t, size_t>> findAllWithRegex(const std::wstring_view pattern, const std::wstring& text)
+    {
+        const std::wregex regex{ pattern.data(), pattern.size() };
+        std::vector<std::pair<size_t, size_t>> matches;
+        for (auto it = std::wsregex_iterator(text.begin(), text.end(), regex); it != std::wsregex_iterator(); ++it)
+        {
+            if (it->length(0) > 0)
+            {
+                matches.emplace_back(it->position(0), it->position(0) + it->length(0));
+            }
+        }
+        return matches;
+    }
+}
+
+void PatternMatcherTests::FindsWhatRegexFinds()
+{
+    const std::wstring_view patterns[] = {
+        LR"(\b(https?|ftp|file)://[-A-Za-z0-9+&@#/%?=~_|$!:,.;]*[A-Za-z0-9+&@#/%=~_|$])",
+        L"ab+c",
+        L"(a|ab)(c|bcd)",
+        L"(ab|a)(bc|c)?",
+        L"a{2,3}",
+        L"(?:ab)+?c",
+        L"[^a-c ]+",
+        L"\\d+|\\w+",
+        L"\\bab\\B",
+        L"^ab|b$",
+        L"x?y??",
+        L"(a*)*b",
+    };
+    const std::wstring texts[] = {
+        L"see http://example.com/a?b=c, and https://x.y/z. ftp://files/",
+        L"abc abbc ac abbbcd abcd",
+        L"aaaaa ab_ba abab abababc",
+        L"a1b2 y xy xyy 12 ab",
+        L"not a url: http:// or https://. either",
+    };
+
+    for (const auto pattern : patterns)
+    {
+        const PatternMatcher matcher{ pattern };
+        VERIFY_IS_TRUE(matcher.IsCompiled());
+        for (const auto& text : texts)
+        {
+            Log::Comment(NoThrowString().Format(L"Searching '%s' for '%s'", text.c_str(), std::wstring{ pattern }.c_str()));
+            VERIFY_IS_TRUE(findAllWithRegex(pattern, text) == findAll(matcher, text));
+        }
+    }
+}
+
+void PatternMatcherTests::LooksBeforeOffset()
+{
+    const PatternMatcher matcher{ L"\\bab" };
+    const std::wstring_view text{ L"xab ab" };
+
+    Log::Comment(L"The character before the offset still counts for \\b.");
+    const auto match = matcher.Find(text, 1);
+    VERIFY_IS_TRUE(match.has_value());
+    VERIFY_ARE_EQUAL(4u, match->first);
+    VERIFY_ARE_EQUAL(6u, match->second);
+
+    VERIFY_IS_FALSE(matcher.Find(text, 5).has_value());
+}
+
+void PatternMatcherTests::FallsBackToRegex()
+{
+    Log::Comment(L"Back-references need backtracking, so they're left to std::wregex.");
+    const PatternMatcher matcher{ L"(a+)b\\1" };
+    VERIFY_IS_FALSE(matcher.IsCompiled());
+    const auto match = matcher.Find(L"xaabaa", 0);
+    VERIFY_IS_TRUE(match.has_value());
+    VERIFY_ARE_EQUAL(1u, match->first);
+    VERIFY_ARE_EQUAL(6u, match->second);
+
+    Log::Comment(L"Patterns that aren't valid throw like std::wregex does.");
+    VERIFY_THROWS(PatternMatcher{ L"(ab" }, std::regex_error);
+}
@@ -0,0 +1,140 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../TextAttributeTable.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class TextAttributeTableTests
+{
+    TEST_CLASS(TextAttributeTableTests);
+
+    TEST_METHOD(InternReturnsOneIdPerAttribute);
+    TEST_METHOD(FullTableThrowsWithoutMarker);
+    TEST_METHOD(FullTableReclaimsUnmarkedIds);
+    TEST_METHOD(ReserveReclaimsUpFront);
+
+    static TextAttribute _GetDistinctAttribute(const size_t index) noexcept;
+    static void _Fill(TextAttributeTable& table);
+};
+
+// Routine Description:
+// - Gets an attribute that's different for every index below 2^24.
+TextAttribute TextAttributeTableTests::_GetDistinctAttribute(const size_t index) noexcept
+{
+    TextAttribute attr{};
+    attr.SetForeground(RGB(index & 0xff, (index >> 8) & 0xff, (index >> 16) & 0xff));
+    return attr;
+}
+
+// Routine Description:
+// - Interns as many distinct attributes as the table can hold.
+void TextAttributeTableTests::_Fill(TextAttributeTable& table)
+{
+    for (size_t i = 0; i < TextAttributeTable::MaxEntries; ++i)
+    {
+        table.Intern(_GetDistinctAttribute(i));
+    }
+    VERIFY_ARE_EQUAL(TextAttributeTable::MaxEntries, table.size());
+}
+
+void TextAttributeTableTests::InternReturnsOneIdPerAttribute()
+{
+    TextAttributeTable table;
+
+    const TextAttribute red{ FOREGROUND_RED };
+    const TextAttribute blue{ FOREGROUND_BLUE };
+
+    const auto redId = table.Intern(red);
+    const auto blueId = table.Intern(blue);
+    VERIFY_ARE_NOT_EQUAL(redId, blueId);
+    VERIFY_ARE_EQUAL(redId, table.Intern(TextAttribute{ FOREGROUND_RED }));
+    VERIFY_ARE_EQUAL(2u, table.size());
+
+    VERIFY_ARE_EQUAL(red, table.Get(redId));
+    VERIFY_ARE_EQUAL(blue, table.Get(blueId));
+
+    VERIFY_ARE_EQUAL(blueId, table.Find(blue).value());
+    VERIFY_IS_FALSE(table.Find(TextAttribute{ FOREGROUND_GREEN }).has_value());
+}
+
+void TextAttributeTableTests::FullTableThrowsWithoutMarker()
+{
+    TextAttributeTable table;
+    _Fill(table);
+
+    // Attributes that are interned already still get their ID.
+    VERIFY_ARE_EQUAL(_GetDistinctAttribute(42), table.Get(table.Intern(_GetDistinctAttribute(42))));
+
+    VERIFY_THROWS_SPECIFIC(table.Intern(_GetDistinctAttribute(TextAttributeTable::MaxEntries)),
+                           wil::ResultException,
+                           [](wil::ResultException& e) { return e.GetErrorCode() == E_OUTOFMEMORY; });
+}
+
+void TextAttributeTableTests::FullTableReclaimsUnmarkedIds()
+{
+    TextAttributeTable table;
+    const auto kept = table.Intern(_GetDistinctAttribute(0));
+    _Fill(table);
+
+    size_t collections = 0;
+    table.SetMarker([&](TextAttributeTable& marked) noexcept {
+        ++collections;
+        marked.Mark(kept);
+    });
+
+    const auto fresh = _GetDistinctAttribute(TextAttributeTable::MaxEntries);
+    const auto freshId = table.Intern(fresh);
+    VERIFY_ARE_EQUAL(1u, collections);
+    VERIFY_ARE_EQUAL(fresh, table.Get(freshId));
+
+    Log::Comment(L"Only the marked attribute survives the collection.");
+    VERIFY_ARE_EQUAL(2u, table.size());
+    VERIFY_ARE_EQUAL(_GetDistinctAttribute(0), table.Get(kept));
+    VERIFY_IS_FALSE(table.Find(_GetDistinctAttribute(1)).has_value());
+
+    Log::Comment(L"There's plenty of room now, so the next attributes don't collect again.");
+    table.Intern(_GetDistinctAttribute(1));
+    VERIFY_ARE_EQUAL(1u, collections);
+}
+
+void TextAttributeTableTests::ReserveReclaimsUpFront()
+{
+    TextAttributeTable table;
+    _Fill(table);
+
+    size_t collections = 0;
+    table.SetMarker([&](TextAttributeTable&) noexcept { ++collections; });
+
+    table.Reserve(3);
+    VERIFY_ARE_EQUAL(1u, collections);
+
+    Log::Comment(L"The reserved attributes are interned without collecting, so none of them are reclaimed by the next ones.");
+    std::vector<TextAttributeTable::Id> ids;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        ids.push_back(table.Intern(_GetDistinctAttribute(TextAttributeTable::MaxEntries + i)));
+    }
+    VERIFY_ARE_EQUAL(1u, collections);
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        VERIFY_ARE_EQUAL(_GetDistinctAttribute(TextAttributeTable::MaxEntries + i), table.Get(ids[i]));
+    }
+
+    Log::Comment(L"Reserving more IDs than there are throws once even collecting doesn't help.");
+    table.SetMarker([](TextAttributeTable& marked) noexcept {
+        for (size_t i = 0; i < TextAttributeTable::MaxEntries; ++i)
+        {
+            marked.Mark(gsl::narrow_cast<TextAttributeTable::Id>(i));
+        }
+    });
+    VERIFY_THROWS_SPECIFIC(table.Reserve(TextAttributeTable::MaxEntries),
+                           wil::ResultException,
+                           [](wil::ResultException& e) { return e.GetErrorCode() == E_OUTOFMEMORY; });
+}
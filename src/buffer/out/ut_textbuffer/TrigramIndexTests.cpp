@@ -0,0 +1,98 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../TrigramIndex.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class TrigramIndexTests
+{
+    TEST_CLASS(TrigramIndexTests);
+
+    TEST_METHOD(FindsLinesWithEveryTrigram);
+    TEST_METHOD(KeepsLinesInOrder);
+    TEST_METHOD(StopsAtBudget);
+};
+
+void TrigramIndexTests::FindsLinesWithEveryTrigram()
+{
+    TrigramIndex index;
+    index.SetBudget(SIZE_MAX);
+    VERIFY_IS_TRUE(index.AddLine(0, 0, L"hello world"));
+    VERIFY_IS_TRUE(index.AddLine(1, 2, L"say hello"));
+    VERIFY_IS_TRUE(index.AddLine(3, 3, L"HELLO"));
+    VERIFY_IS_TRUE(index.AddLine(4, 4, L"hel ell"));
+
+    Log::Comment(L"The trigrams are folded to lower case.");
+    VERIFY_IS_TRUE((std::vector<size_t>{ 0, 1, 2 }) == index.FindCandidates(L"hello", 0));
+    VERIFY_IS_TRUE((std::vector<size_t>{ 0, 1, 2 }) == index.FindCandidates(L"HeLLo", 0));
+    VERIFY_IS_TRUE((std::vector<size_t>{ 1, 2 }) == index.FindCandidates(L"hello", 1));
+    VERIFY_IS_TRUE((std::vector<size_t>{ 0 }) == index.FindCandidates(L"lo wo", 0));
+
+    Log::Comment(L"A line has every trigram of the needle, but not necessarily the needle.");
+    VERIFY_IS_TRUE((std::vector<size_t>{ 0, 1, 2, 3 }) == index.FindCandidates(L"hell", 0));
+
+    Log::Comment(L"A trigram that's in no line means there are no candidates at all.");
+    VERIFY_IS_TRUE((std::vector<size_t>{}) == index.FindCandidates(L"hellx", 0));
+
+    Log::Comment(L"A needle that's too short to have a trigram has to be searched for in every line.");
+    VERIFY_IS_FALSE(index.FindCandidates(L"he", 0).has_value());
+}
+
+void TrigramIndexTests::KeepsLinesInOrder()
+{
+    TrigramIndex index;
+    index.SetBudget(SIZE_MAX);
+    VERIFY_ARE_EQUAL(0u, index.size());
+    VERIFY_IS_FALSE(index.FindLine(0).has_value());
+
+    VERIFY_IS_TRUE(index.AddLine(10, 10, L"abc"));
+    VERIFY_IS_TRUE(index.AddLine(11, 13, L"def"));
+    VERIFY_ARE_EQUAL(2u, index.size());
+    VERIFY_ARE_EQUAL(10, index.GetFirstRow());
+    VERIFY_ARE_EQUAL(14, index.GetEndRow());
+
+    VERIFY_ARE_EQUAL(1u, index.FindLine(11).value());
+    VERIFY_IS_FALSE(index.FindLine(12).has_value());
+    VERIFY_IS_FALSE(index.FindLine(14).has_value());
+    VERIFY_IS_TRUE((std::pair<int64_t, int64_t>{ 11, 13 }) == index.GetLine(1));
+
+    Log::Comment(L"The next line has to start where the last one ended.");
+    VERIFY_THROWS_SPECIFIC(index.AddLine(15, 15, L"ghi"), wil::ResultException, [](wil::ResultException& e) { return e.GetErrorCode() == E_INVALIDARG; });
+
+    index.Clear();
+    VERIFY_ARE_EQUAL(0u, index.size());
+    VERIFY_ARE_EQUAL(0u, index.GetUsage());
+    VERIFY_IS_TRUE(index.AddLine(20, 20, L"ghi"));
+    VERIFY_ARE_EQUAL(20, index.GetFirstRow());
+}
+
+void TrigramIndexTests::StopsAtBudget()
+{
+    TrigramIndex index;
+
+    Log::Comment(L"Without a budget, nothing is indexed.");
+    VERIFY_IS_FALSE(index.AddLine(0, 0, L"abcdef"));
+    VERIFY_ARE_EQUAL(0u, index.size());
+
+    index.SetBudget(4096);
+    int64_t row = 0;
+    while (index.AddLine(row, row, L"row" + std::to_wstring(row) + L";"))
+    {
+        ++row;
+    }
+
+    Log::Comment(L"The lines are added until the usage goes over the budget.");
+    VERIFY_IS_GREATER_THAN(row, 0);
+    VERIFY_ARE_EQUAL(gsl::narrow_cast<size_t>(row), index.size());
+    VERIFY_IS_GREATER_THAN_OR_EQUAL(index.GetUsage(), index.GetBudget());
+
+    Log::Comment(L"The lines that were added can still be found.");
+    VERIFY_IS_TRUE((std::vector<size_t>{ 1 }) == index.FindCandidates(L"row1;", 0));
+}
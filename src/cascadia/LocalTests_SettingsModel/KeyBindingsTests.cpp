@@ -48,6 +48,8 @@ namespace SettingsModelLocalTests
 
         TEST_METHOD(TestScrollArgs);
 
+        TEST_METHOD(TestExportBufferArgs);
+
         TEST_CLASS_SETUP(ClassSetup)
         {
             InitializeJsonReader();
@@ -529,4 +531,57 @@ namespace SettingsModelLocalTests
             VERIFY_THROWS(invalidKeyMap->LayerJson(bindingsInvalidJson);, std::exception);
         }
     }
+
+    void KeyBindingsTests::TestExportBufferArgs()
+    {
+        const std::string bindings0String{ R"([
+            { "keys": ["ctrl+a"], "command": { "action": "exportBuffer", "path": "C:\\buffer.txt" } },
+            { "keys": ["ctrl+b"], "command": { "action": "exportBuffer", "path": "C:\\buffer.log", "format": "vt" } },
+            { "keys": ["ctrl+c"], "command": { "action": "exportBuffer", "path": "C:\\buffer.html", "format": "html" } },
+            { "keys": ["ctrl+d"], "command": { "action": "exportBuffer" } }
+        ])" };
+
+        const auto bindings0Json = VerifyParseSucceeded(bindings0String);
+
+        auto keymap = winrt::make_self<implementation::KeyMapping>();
+        VERIFY_IS_NOT_NULL(keymap);
+        VERIFY_ARE_EQUAL(0u, keymap->_keyShortcuts.size());
+        const auto warnings = keymap->LayerJson(bindings0Json);
+
+        Log::Comment(L"The binding without a path isn't bound, and warns about it.");
+        VERIFY_ARE_EQUAL(3u, keymap->_keyShortcuts.size());
+        VERIFY_ARE_EQUAL(1u, warnings.size());
+        VERIFY_ARE_EQUAL(SettingsLoadWarnings::MissingRequiredParameter, warnings.at(0));
+
+        {
+            KeyChord kc{ true, false, false, static_cast<int32_t>('A') };
+            auto actionAndArgs = ::TestUtils::GetActionAndArgs(*keymap, kc);
+            VERIFY_ARE_EQUAL(ShortcutAction::ExportBuffer, actionAndArgs.Action());
+            const auto& realArgs = actionAndArgs.Args().try_as<ExportBufferArgs>();
+            VERIFY_IS_NOT_NULL(realArgs);
+            // Verify the args have the expected value
+            VERIFY_ARE_EQUAL(L"C:\\buffer.txt", realArgs.Path());
+            VERIFY_ARE_EQUAL(ExportFormat::PlainText, realArgs.Format());
+        }
+        {
+            KeyChord kc{ true, false, false, static_cast<int32_t>('B') };
+            auto actionAndArgs = ::TestUtils::GetActionAndArgs(*keymap, kc);
+            VERIFY_ARE_EQUAL(ShortcutAction::ExportBuffer, actionAndArgs.Action());
+            const auto& realArgs = actionAndArgs.Args().try_as<ExportBufferArgs>();
+            VERIFY_IS_NOT_NULL(realArgs);
+            // Verify the args have the expected value
+            VERIFY_ARE_EQUAL(L"C:\\buffer.log", realArgs.Path());
+            VERIFY_ARE_EQUAL(ExportFormat::Vt, realArgs.Format());
+        }
+        {
+            KeyChord kc{ true, false, false, static_cast<int32_t>('C') };
+            auto actionAndArgs = ::TestUtils::GetActionAndArgs(*keymap, kc);
+            VERIFY_ARE_EQUAL(ShortcutAction::ExportBuffer, actionAndArgs.Action());
+            const auto& realArgs = actionAndArgs.Args().try_as<ExportBufferArgs>();
+            VERIFY_IS_NOT_NULL(realArgs);
+            // Verify the args have the expected value
+            VERIFY_ARE_EQUAL(L"C:\\buffer.html", realArgs.Path());
+            VERIFY_ARE_EQUAL(ExportFormat::Html, realArgs.Format());
+        }
+    }
 }
@@ -118,8 +118,7 @@ try
             {
                 try
                 {
-                    const auto bufferData = terminal->_terminal->RetrieveSelectedTextFromBuffer(false);
-                    LOG_IF_FAILED(terminal->_CopyTextToSystemClipboard(bufferData, true));
+                    LOG_IF_FAILED(terminal->_CopyTextToSystemClipboard(true));
                     TerminalClearSelection(terminal);
                 }
                 CATCH_LOG();
@@ -633,16 +632,9 @@ const wchar_t* _stdcall TerminalGetSelection(void* terminal)
 {
     auto publicTerminal = static_cast<HwndTerminal*>(terminal);
 
-    const auto bufferData = publicTerminal->_terminal->RetrieveSelectedTextFromBuffer(false);
+    const auto selectedText = publicTerminal->_terminal->RetrieveSelectedTextFromBuffer(false);
     publicTerminal->_ClearSelection();
 
-    // convert text: vector<string> --> string
-    std::wstring selectedText;
-    for (const auto& text : bufferData.text)
-    {
-        selectedText += text;
-    }
-
     auto returnText = wil::make_cotaskmem_string_nothrow(selectedText.c_str());
     return returnText.release();
 }
@@ -843,19 +835,31 @@ void __stdcall TerminalKillFocus(void* terminal)
 }
 
 // Routine Description:
-// - Copies the text given onto the global system clipboard.
+// - Copies the selected text onto the global system clipboard.
 // Arguments:
-// - rows - Rows of text data to copy
 // - fAlsoCopyFormatting - true if the color and formatting should also be copied, false otherwise
-HRESULT HwndTerminal::_CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows, bool const fAlsoCopyFormatting)
+HRESULT HwndTerminal::_CopyTextToSystemClipboard(bool const fAlsoCopyFormatting)
 try
 {
-    std::wstring finalString;
+    const auto& fontData = _actualFont;
+    int const iFontHeightPoints = fontData.GetUnscaledSize().Y; // this renderer uses points already
+    const COLORREF bgColor = _terminal->GetAttributeColors(_terminal->GetDefaultBrushColors()).second;
 
-    // Concatenate strings into one giant string to put onto the clipboard.
-    for (const auto& str : rows.text)
+    // Write the text and its formats out in one pass over the selection.
+    std::wstring finalString;
+    std::string HTMLToPlaceOnClip;
+    std::string RTFToPlaceOnClip;
+    PlainTextWriter textWriter{ [&](const std::wstring_view chunk) { finalString.append(chunk); }, true };
+    HtmlWriter htmlWriter{ [&](const std::string_view chunk) { HTMLToPlaceOnClip.append(chunk); }, iFontHeightPoints, fontData.GetFaceName(), bgColor, true };
+    RtfWriter rtfWriter{ [&](const std::string_view chunk) { RTFToPlaceOnClip.append(chunk); }, iFontHeightPoints, fontData.GetFaceName(), bgColor };
+    if (fAlsoCopyFormatting)
     {
-        finalString += str;
+        _terminal->SerializeSelection(false, { &textWriter, &htmlWriter, &rtfWriter });
+        htmlWriter.FillClipboardHeader(HTMLToPlaceOnClip);
+    }
+    else
+    {
+        _terminal->SerializeSelection(false, { &textWriter });
     }
 
     // allocate the final clipboard data
@@ -886,14 +890,7 @@ try
 
         if (fAlsoCopyFormatting)
         {
-            const auto& fontData = _actualFont;
-            int const iFontHeightPoints = fontData.GetUnscaledSize().Y; // this renderer uses points already
-            const COLORREF bgColor = _terminal->GetAttributeColors(_terminal->GetDefaultBrushColors()).second;
-
-            std::string HTMLToPlaceOnClip = TextBuffer::GenHTML(rows, iFontHeightPoints, fontData.GetFaceName(), bgColor);
             _CopyToSystemClipboard(HTMLToPlaceOnClip, L"HTML Format");
-
-            std::string RTFToPlaceOnClip = TextBuffer::GenRTF(rows, iFontHeightPoints, fontData.GetFaceName(), bgColor);
             _CopyToSystemClipboard(RTFToPlaceOnClip, L"Rich Text Format");
         }
     }
@@ -531,4 +531,23 @@ namespace winrt::TerminalApp::implementation
 
         args.Handled(true);
     }
+
+    void TerminalPage::_HandleExportBuffer(const IInspectable& /*sender*/,
+                                           const ActionEventArgs& args)
+    {
+        args.Handled(false);
+        if (const auto& realArgs = args.ActionArgs().try_as<ExportBufferArgs>())
+        {
+            if (auto focusedTab = _GetFocusedTab())
+            {
+                if (auto activeTab = _GetTerminalTabImpl(focusedTab))
+                {
+                    if (auto activeControl = activeTab->GetActiveTerminalControl())
+                    {
+                        args.Handled(activeControl.ExportBuffer(realArgs.Path(), realArgs.Format()));
+                    }
+                }
+            }
+        }
+    }
 }
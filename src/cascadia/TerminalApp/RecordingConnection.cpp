@@ -0,0 +1,124 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "RecordingConnection.h"
+
+#include "../../types/inc/utils.hpp"
+
+using namespace ::winrt::Microsoft::Terminal::TerminalConnection;
+using namespace ::winrt::Windows::Foundation;
+namespace winrt::Microsoft::TerminalApp::implementation
+{
+    RecordingConnection::RecordingConnection(ITerminalConnection wrappedConnection,
+                                             const std::filesystem::path& path,
+                                             const uint32_t rows,
+                                             const uint32_t columns) :
+        _wrappedConnection{ std::move(wrappedConnection) },
+        _encoder{ columns, rows },
+        _file{ path, std::ios::binary | std::ios::trunc },
+        _start{ std::chrono::steady_clock::now() }
+    {
+        THROW_HR_IF(E_FAIL, !_file.is_open());
+        _WritePending();
+
+        _outputRevoker = _wrappedConnection.TerminalOutput(winrt::auto_revoke, { this, &RecordingConnection::_OutputHandler });
+        _stateChangedRevoker = _wrappedConnection.StateChanged(winrt::auto_revoke, [this](auto&& /*s*/, auto&& /*e*/) {
+            _StateChangedHandlers(*this, nullptr);
+        });
+    }
+
+    RecordingConnection::~RecordingConnection()
+    {
+    }
+
+    void RecordingConnection::Start()
+    {
+        _wrappedConnection.Start();
+    }
+
+    void RecordingConnection::WriteInput(hstring const& data)
+    {
+        _wrappedConnection.WriteInput(data);
+    }
+
+    void RecordingConnection::Resize(uint32_t rows, uint32_t columns)
+    {
+        {
+            std::scoped_lock lock{ _captureMutex };
+            _encoder.Resize(_Elapsed(), columns, rows);
+            _WritePending();
+        }
+        _wrappedConnection.Resize(rows, columns);
+    }
+
+    void RecordingConnection::Close()
+    {
+        _outputRevoker.revoke();
+        _stateChangedRevoker.revoke();
+        _wrappedConnection.Close();
+
+        std::scoped_lock lock{ _captureMutex };
+        _file.close();
+    }
+
+    ConnectionState RecordingConnection::State() const noexcept
+    {
+        return _wrappedConnection.State();
+    }
+
+    void RecordingConnection::_OutputHandler(const hstring str)
+    {
+        {
+            std::scoped_lock lock{ _captureMutex };
+            _encoder.Output(_Elapsed(), str);
+            _WritePending();
+        }
+        _TerminalOutputHandlers(str);
+    }
+
+    std::chrono::microseconds RecordingConnection::_Elapsed() const noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start);
+    }
+
+    // Moves what the encoder produced into the file. The stream buffers it,
+    // so this doesn't write to disk for every chunk of output.
+    // Must be called with the _captureMutex held, except from the constructor.
+    void RecordingConnection::_WritePending()
+    {
+        if (_file.is_open())
+        {
+            const auto pending = _encoder.Pending();
+            _file.write(pending.data(), gsl::narrow_cast<std::streamsize>(pending.size()));
+        }
+        _encoder.ClearPending();
+    }
+}
+
+// Function Description
+// - Wraps a connection in one that records everything it outputs into a new
+//   capture file in the given directory. If the file can't be created, the
+//   connection is returned unchanged, so the session still works.
+// Arguments:
+// - baseConnection - The connection to record.
+// - directory - The directory to create the capture file in.
+// - rows, columns - The initial size of the terminal.
+// Return Value:
+// - The connection to use in place of baseConnection.
+ITerminalConnection OpenRecordingConnection(ITerminalConnection baseConnection,
+                                            const std::filesystem::path& directory,
+                                            const uint32_t rows,
+                                            const uint32_t columns)
+try
+{
+    using namespace winrt::Microsoft::TerminalApp::implementation;
+    std::filesystem::create_directories(directory);
+    const auto path = directory / (::Microsoft::Console::Utils::GuidToString(::Microsoft::Console::Utils::CreateGuid()) + L".vtcap");
+    return winrt::make<RecordingConnection>(baseConnection, path, rows, columns);
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return baseConnection;
+}
@@ -0,0 +1,53 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <winrt/Microsoft.Terminal.TerminalConnection.h>
+#include "../../inc/cppwinrt_utils.h"
+#include "../../types/inc/VtCapture.hpp"
+
+namespace winrt::Microsoft::TerminalApp::implementation
+{
+    // RecordingConnection wraps a connection like the DebugTapConnection does,
+    // and writes its output and resizes to a capture file as they happen.
+    // The capture can be replayed without the application with VtBench --replay.
+    class RecordingConnection : public winrt::implements<RecordingConnection, winrt::Microsoft::Terminal::TerminalConnection::ITerminalConnection>
+    {
+    public:
+        RecordingConnection(Microsoft::Terminal::TerminalConnection::ITerminalConnection wrappedConnection,
+                            const std::filesystem::path& path,
+                            const uint32_t rows,
+                            const uint32_t columns);
+        ~RecordingConnection();
+        void Start();
+        void WriteInput(hstring const& data);
+        void Resize(uint32_t rows, uint32_t columns);
+        void Close();
+        winrt::Microsoft::Terminal::TerminalConnection::ConnectionState State() const noexcept;
+
+        WINRT_CALLBACK(TerminalOutput, winrt::Microsoft::Terminal::TerminalConnection::TerminalOutputHandler);
+
+        TYPED_EVENT(StateChanged, winrt::Microsoft::Terminal::TerminalConnection::ITerminalConnection, winrt::Windows::Foundation::IInspectable);
+
+    private:
+        void _OutputHandler(const hstring str);
+        std::chrono::microseconds _Elapsed() const noexcept;
+        void _WritePending();
+
+        winrt::Microsoft::Terminal::TerminalConnection::ITerminalConnection::TerminalOutput_revoker _outputRevoker;
+        winrt::Microsoft::Terminal::TerminalConnection::ITerminalConnection::StateChanged_revoker _stateChangedRevoker;
+        winrt::Microsoft::Terminal::TerminalConnection::ITerminalConnection _wrappedConnection;
+
+        // Output arrives on the connection's thread, resizes on the UI thread.
+        std::mutex _captureMutex;
+        ::Microsoft::Console::Utils::VtCaptureEncoder _encoder;
+        std::ofstream _file;
+        std::chrono::steady_clock::time_point _start;
+    };
+}
+
+winrt::Microsoft::Terminal::TerminalConnection::ITerminalConnection OpenRecordingConnection(winrt::Microsoft::Terminal::TerminalConnection::ITerminalConnection baseConnection,
+                                                                                            const std::filesystem::path& directory,
+                                                                                            const uint32_t rows,
+                                                                                            const uint32_t columns);
@@ -237,6 +237,11 @@ namespace winrt::TerminalApp::implementation
             _TabSearchHandlers(*this, eventArgs);
             break;
         }
+        case ShortcutAction::ExportBuffer:
+        {
+            _ExportBufferHandlers(*this, eventArgs);
+            break;
+        }
         default:
             return false;
         }
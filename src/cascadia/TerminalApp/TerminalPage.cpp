@@ -16,6 +16,7 @@
 #include "TabRowControl.h"
 #include "ColorHelper.h"
 #include "DebugTapConnection.h"
+#include "RecordingConnection.h"
 
 using namespace winrt;
 using namespace winrt::Windows::Foundation::Collections;
@@ -802,6 +803,14 @@ namespace winrt::TerminalApp::implementation
             connection = conhostConn;
         }
 
+        if (const auto recordingDirectory = _settings.GlobalSettings().RecordingDirectory(); !recordingDirectory.empty())
+        {
+            connection = OpenRecordingConnection(connection,
+                                                 std::wstring_view{ recordingDirectory },
+                                                 settings.InitialRows(),
+                                                 settings.InitialCols());
+        }
+
         TraceLoggingWrite(
             g_hTerminalAppProvider,
             "ConnectionCreated",
@@ -920,6 +929,7 @@ namespace winrt::TerminalApp::implementation
         _actionDispatch->CloseOtherTabs({ this, &TerminalPage::_HandleCloseOtherTabs });
         _actionDispatch->CloseTabsAfter({ this, &TerminalPage::_HandleCloseTabsAfter });
         _actionDispatch->TabSearch({ this, &TerminalPage::_HandleOpenTabSearch });
+        _actionDispatch->ExportBuffer({ this, &TerminalPage::_HandleExportBuffer });
     }
 
     // Method Description:
@@ -81,6 +81,9 @@ namespace winrt::TerminalApp::implementation
     {
         // Fill in the Terminal Setting's CoreSettings from the profile
         _HistorySize = profile.HistorySize();
+        _SearchOnlyHistory = profile.SearchOnlyHistory();
+        _ScrollbackColdRows = profile.ScrollbackColdRows();
+        _ScrollbackSpillToDisk = profile.ScrollbackSpillToDisk();
         _SnapOnInput = profile.SnapOnInput();
         _AltGrAliasing = profile.AltGrAliasing();
         _CursorHeight = profile.CursorHeight();
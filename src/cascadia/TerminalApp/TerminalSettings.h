@@ -57,6 +57,9 @@ namespace winrt::TerminalApp::implementation
         GETSET_PROPERTY(uint32_t, DefaultBackground, DEFAULT_BACKGROUND_WITH_ALPHA);
         GETSET_PROPERTY(uint32_t, SelectionBackground, DEFAULT_FOREGROUND);
         GETSET_PROPERTY(int32_t, HistorySize, DEFAULT_HISTORY_SIZE);
+        GETSET_PROPERTY(bool, SearchOnlyHistory, false);
+        GETSET_PROPERTY(int32_t, ScrollbackColdRows, 1024);
+        GETSET_PROPERTY(bool, ScrollbackSpillToDisk, false);
         GETSET_PROPERTY(int32_t, InitialRows, 30);
         GETSET_PROPERTY(int32_t, InitialCols, 80);
 
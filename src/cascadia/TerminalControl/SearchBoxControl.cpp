@@ -128,6 +128,25 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         return false;
     }
 
+    // Method Description:
+    // - Shows which of the matches is selected, and how many there are, next
+    //   to the search text. Nothing is shown if there are no matches.
+    // Arguments:
+    // - totalMatches: the number of matches in the buffer
+    // - currentMatch: the index of the selected match
+    // Return Value:
+    // - <none>
+    void SearchBoxControl::SetStatus(int32_t totalMatches, int32_t currentMatch)
+    {
+        if (totalMatches <= 0)
+        {
+            StatusBox().Text(L"");
+            return;
+        }
+
+        StatusBox().Text(winrt::hstring{ fmt::format(L"{}/{}", currentMatch + 1, totalMatches) });
+    }
+
     // Method Description:
     // - Handler for clicking the GoBackward button. This change the value of _goForward,
     //   mark GoBackward button as checked and ensure GoForward button
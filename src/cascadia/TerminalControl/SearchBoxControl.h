@@ -30,6 +30,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
 
         void SetFocusOnTextbox();
         bool ContainsFocus();
+        void SetStatus(int32_t totalMatches, int32_t currentMatch);
 
         void GoBackwardClicked(winrt::Windows::Foundation::IInspectable const& /*sender*/, winrt::Windows::UI::Xaml::RoutedEventArgs const& /*e*/);
         void GoForwardClicked(winrt::Windows::Foundation::IInspectable const& /*sender*/, winrt::Windows::UI::Xaml::RoutedEventArgs const& /*e*/);
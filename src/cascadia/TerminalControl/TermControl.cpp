@@ -38,6 +38,12 @@ constexpr const auto TsfRedrawInterval = std::chrono::milliseconds(100);
 // The minimum delay between updating the locations of regex patterns
 constexpr const auto UpdatePatternLocationsInterval = std::chrono::milliseconds(500);
 
+// The minimum delay between indexing slices of the history for search,
+// the most rows indexed at once, and how much memory the index may take up.
+constexpr const auto IndexScrollbackInterval = std::chrono::milliseconds(100);
+constexpr const size_t IndexScrollbackRows = 4096;
+constexpr const size_t ScrollbackIndexBudget = 64 * 1024 * 1024;
+
 DEFINE_ENUM_FLAG_OPERATORS(winrt::Microsoft::Terminal::TerminalControl::CopyFormat);
 
 namespace winrt::Microsoft::Terminal::TerminalControl::implementation
@@ -79,7 +85,8 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         _lastMouseClickTimestamp{},
         _lastMouseClickPos{},
         _selectionNeedsToBeCopied{ false },
-        _searchBox{ nullptr }
+        _searchBox{ nullptr },
+        _indexingScrollback{ false }
     {
         _EnsureStaticInitialization();
         InitializeComponent();
@@ -113,6 +120,10 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         auto onReceiveOutputFn = [this](const hstring str) {
             _terminal->Write(str);
             _updatePatternLocations->Run();
+            if (_indexingScrollback)
+            {
+                _indexScrollback->Run();
+            }
         };
         _connectionOutputEventToken = _connection.TerminalOutput(onReceiveOutputFn);
 
@@ -162,6 +173,16 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
             UpdatePatternLocationsInterval,
             Dispatcher());
 
+        _indexScrollback = std::make_shared<ThrottledFunc<>>(
+            [weakThis = get_weak()]() {
+                if (auto control{ weakThis.get() })
+                {
+                    control->_IndexScrollback();
+                }
+            },
+            IndexScrollbackInterval,
+            Dispatcher());
+
         _updateScrollBar = std::make_shared<ThrottledFunc<ScrollBarUpdate>>(
             [weakThis = get_weak()](const auto& update) {
                 if (auto control{ weakThis.get() })
@@ -204,13 +225,50 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
                 _searchBox.copy_from(winrt::get_self<implementation::SearchBoxControl>(searchBox));
                 _searchBox->Visibility(Visibility::Visible);
                 _searchBox->SetFocusOnTextbox();
+
+                // Once the user has searched, keep an index of the scrollback
+                // up to date, so that searching it again is quick.
+                if (!_indexingScrollback)
+                {
+                    _searchIndex.SetTrigramBudget(ScrollbackIndexBudget);
+                    _indexingScrollback = true;
+                    _indexScrollback->Run();
+                }
             }
         }
     }
 
+    // Method Description:
+    // - Adds a slice of the history to the search index: the rows that
+    //   scrolled off into the scrollback, then the rows of the buffer above
+    //   the mutable viewport. Schedules the next slice if there are more.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void TermControl::_IndexScrollback()
+    {
+        if (_closing)
+        {
+            return;
+        }
+
+        auto lock = _terminal->LockForWriting();
+        const auto& buffer = _terminal->GetTextBuffer();
+        const auto viewportRow = buffer.GetFirstAbsoluteRow() + _terminal->ViewStartIndex();
+        if (_searchIndex.IndexScrollback(buffer, viewportRow, IndexScrollbackRows))
+        {
+            _indexScrollback->Run();
+        }
+    }
+
     // Method Description:
     // - Search text in text buffer. This is triggered if the user click
     //   search button or press enter.
+    // - Every match is kept in _searchIndex, which only searches the rows
+    //   that changed since the last search, so that the search box can show
+    //   how many there are. They're all highlighted, and the one after (or
+    //   before) the selection is selected.
     // Arguments:
     // - text: the text to search
     // - goForward: boolean that represents if the current search direction is forward
@@ -224,27 +282,59 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
             return;
         }
 
-        const Search::Direction direction = goForward ?
-                                                Search::Direction::Forward :
-                                                Search::Direction::Backward;
+        auto lock = _terminal->LockForWriting();
 
-        const Search::Sensitivity sensitivity = caseSensitive ?
-                                                    Search::Sensitivity::CaseSensitive :
-                                                    Search::Sensitivity::CaseInsensitive;
+        const auto& buffer = _terminal->GetTextBuffer();
+        _searchIndex.SetNeedle(text, caseSensitive);
+        _searchIndex.Update(buffer);
 
-        Search search(*GetUiaData(), text.c_str(), direction, sensitivity);
-        auto lock = _terminal->LockForWriting();
-        if (search.FindNext())
+        const auto& matches = _searchIndex.GetMatches();
+        _terminal->SetSearchHighlights(matches);
+
+        // The matches in the scrollback are counted, but only the ones in the buffer can be selected.
+        const auto bufferRow = buffer.GetFirstAbsoluteRow();
+        const auto first = std::partition_point(matches.begin(), matches.end(), [=](const auto& match) {
+            return match.start.y() < bufferRow;
+        });
+        if (first == matches.end())
         {
-            _terminal->SetBlockSelection(false);
-            search.Select();
-            _renderer->TriggerSelection();
+            _searchBox->SetStatus(gsl::narrow_cast<int32_t>(matches.size()), -1);
+            return;
         }
+
+        auto current = goForward ? first : matches.end() - 1;
+        if (_terminal->IsSelectionActive())
+        {
+            const auto anchor = _terminal->GetSelectionAnchor();
+            const til::point anchorPoint{ gsl::narrow_cast<ptrdiff_t>(anchor.X), gsl::narrow_cast<ptrdiff_t>(bufferRow + anchor.Y) };
+            if (goForward)
+            {
+                current = std::upper_bound(first, matches.end(), anchorPoint, [](const auto& point, const auto& match) {
+                    return point < match.start;
+                });
+                current = current == matches.end() ? first : current;
+            }
+            else
+            {
+                current = std::lower_bound(first, matches.end(), anchorPoint, [](const auto& match, const auto& point) {
+                    return match.start < point;
+                });
+                current = current == first ? matches.end() - 1 : current - 1;
+            }
+        }
+
+        const auto toBuffer = [=](const til::point point) {
+            return COORD{ gsl::narrow_cast<SHORT>(point.x()), gsl::narrow_cast<SHORT>(point.y() - bufferRow) };
+        };
+        _terminal->SetBlockSelection(false);
+        _terminal->SelectNewRegion(toBuffer(current->start), toBuffer(current->end));
+        _renderer->TriggerSelection();
+        _searchBox->SetStatus(gsl::narrow_cast<int32_t>(matches.size()), gsl::narrow_cast<int32_t>(current - matches.begin()));
     }
 
     // Method Description:
     // - The handler for the close button or pressing "Esc" when focusing on the
-    //   search dialog.
+    //   search dialog. The matches of the last search aren't highlighted anymore.
     // Arguments:
     // - IInspectable: not used
     // - RoutedEventArgs: not used
@@ -254,6 +344,11 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
     {
         _searchBox->Visibility(Visibility::Collapsed);
 
+        {
+            auto lock = _terminal->LockForWriting();
+            _terminal->SetSearchHighlights({});
+        }
+
         // Set focus back to terminal control
         this->Focus(FocusState::Programmatic);
     }
@@ -289,25 +384,29 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
 
             auto lock = _terminal->LockForWriting();
 
-            // Update DxEngine settings under the lock
-            _renderEngine->SetSelectionBackground(_settings.SelectionBackground());
+            // Update DxEngine settings under the lock. Frames are painted from a
+            // snapshot without holding it though, so lock the engine as well.
+            {
+                const auto engineLock = _renderer->LockEngines();
+                _renderEngine->SetSelectionBackground(_settings.SelectionBackground());
 
-            _renderEngine->SetRetroTerminalEffects(_settings.RetroTerminalEffect());
-            _renderEngine->SetForceFullRepaintRendering(_settings.ForceFullRepaintRendering());
-            _renderEngine->SetSoftwareRendering(_settings.SoftwareRendering());
+                _renderEngine->SetRetroTerminalEffects(_settings.RetroTerminalEffect());
+                _renderEngine->SetForceFullRepaintRendering(_settings.ForceFullRepaintRendering());
+                _renderEngine->SetSoftwareRendering(_settings.SoftwareRendering());
 
-            switch (_settings.AntialiasingMode())
-            {
-            case TextAntialiasingMode::Cleartype:
-                _renderEngine->SetAntialiasingMode(D2D1_TEXT_ANTIALIAS_MODE_CLEARTYPE);
-                break;
-            case TextAntialiasingMode::Aliased:
-                _renderEngine->SetAntialiasingMode(D2D1_TEXT_ANTIALIAS_MODE_ALIASED);
-                break;
-            case TextAntialiasingMode::Grayscale:
-            default:
-                _renderEngine->SetAntialiasingMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE);
-                break;
+                switch (_settings.AntialiasingMode())
+                {
+                case TextAntialiasingMode::Cleartype:
+                    _renderEngine->SetAntialiasingMode(D2D1_TEXT_ANTIALIAS_MODE_CLEARTYPE);
+                    break;
+                case TextAntialiasingMode::Aliased:
+                    _renderEngine->SetAntialiasingMode(D2D1_TEXT_ANTIALIAS_MODE_ALIASED);
+                    break;
+                case TextAntialiasingMode::Grayscale:
+                default:
+                    _renderEngine->SetAntialiasingMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE);
+                    break;
+                }
             }
 
             // Refresh our font with the renderer
@@ -335,6 +434,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
     void TermControl::ToggleRetroEffect()
     {
         auto lock = _terminal->LockForWriting();
+        const auto engineLock = _renderer->LockEngines();
         _renderEngine->SetRetroTerminalEffects(!_renderEngine->GetRetroTerminalEffects());
     }
 
@@ -452,6 +552,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
             // GH#5098: Inform the engine of the new opacity of the default text background.
             if (_renderEngine)
             {
+                const auto engineLock = _renderer->LockEngines();
                 _renderEngine->SetDefaultTextBackgroundOpacity(::base::saturated_cast<float>(_settings.TintOpacity()));
             }
         }
@@ -463,6 +564,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
             // GH#5098: Inform the engine of the new opacity of the default text background.
             if (_renderEngine)
             {
+                const auto engineLock = _renderer->LockEngines();
                 _renderEngine->SetDefaultTextBackgroundOpacity(1.0f);
             }
         }
@@ -648,6 +750,10 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
 
             THROW_IF_FAILED(localPointerToThread->Initialize(_renderer.get()));
 
+            // Paint from a snapshot of the rows that changed, so that output
+            // from the connection doesn't have to wait for each frame.
+            _renderer->SetSnapshotRendering(true);
+
             // Set up the DX Engine
             auto dxEngine = std::make_unique<::Microsoft::Console::Render::DxEngine>();
             _renderer->AddRenderEngine(dxEngine.get());
@@ -1365,8 +1471,12 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
                 {
                     _lastHoveredId = newId;
                     _lastHoveredInterval = newInterval;
-                    _renderEngine->UpdateHyperlinkHoveredId(newId);
-                    _renderer->UpdateLastHoveredInterval(newInterval);
+                    {
+                        // The render thread reads both while it paints a frame.
+                        const auto engineLock = _renderer->LockEngines();
+                        _renderEngine->UpdateHyperlinkHoveredId(newId);
+                        _renderer->UpdateLastHoveredInterval(newInterval);
+                    }
                     _renderer->TriggerRedrawAll();
                 }
             }
@@ -1592,6 +1702,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
                     // GH#5098: Inform the engine of the new opacity of the default text background.
                     if (_renderEngine)
                     {
+                        const auto engineLock = _renderer->LockEngines();
                         _renderEngine->SetDefaultTextBackgroundOpacity(::base::saturated_cast<float>(_settings.TintOpacity()));
                     }
                 }
@@ -2251,7 +2362,10 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         _terminal->ClearSelection();
 
         // Tell the dx engine that our window is now the new size.
-        THROW_IF_FAILED(_renderEngine->SetWindowSize(size));
+        {
+            const auto engineLock = _renderer->LockEngines();
+            THROW_IF_FAILED(_renderEngine->SetWindowSize(size));
+        }
 
         // Invalidate everything
         _renderer->TriggerRedrawAll();
@@ -2266,6 +2380,14 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         const HRESULT hr = _terminal->UserResize({ vp.Width(), vp.Height() });
         if (SUCCEEDED(hr) && hr != S_FALSE)
         {
+            // The terminal has a new buffer now, so all of it has to be searched
+            // again, and the rows of the highlighted matches don't hold them anymore.
+            _searchIndex.Invalidate();
+            _terminal->SetSearchHighlights({});
+            if (_indexingScrollback)
+            {
+                _indexScrollback->Run();
+            }
             _connection.Resize(vp.Height(), vp.Width());
         }
     }
@@ -2372,35 +2494,33 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         // Mark the current selection as copied
         _selectionNeedsToBeCopied = false;
 
-        // extract text from buffer
-        const auto bufferData = _terminal->RetrieveSelectedTextFromBuffer(singleLine);
+        // extract text from buffer, along with the HTML and RTF formats
+        // GH#5347 - Don't provide a title for the generated HTML, as many
+        // web applications will paste the title first, followed by the HTML
+        // content, which is unexpected.
+        const bool copyHtml = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::HTML);
+        const bool copyRtf = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::RTF);
 
-        // convert text: vector<string> --> string
         std::wstring textData;
-        for (const auto& text : bufferData.text)
+        std::string htmlData;
+        std::string rtfData;
+        PlainTextWriter textWriter{ [&](const std::wstring_view chunk) { textData.append(chunk); }, !singleLine };
+        HtmlWriter htmlWriter{ [&](const std::string_view chunk) { htmlData.append(chunk); },
+                               _actualFont.GetUnscaledSize().Y,
+                               _actualFont.GetFaceName(),
+                               _settings.DefaultBackground(),
+                               true };
+        RtfWriter rtfWriter{ [&](const std::string_view chunk) { rtfData.append(chunk); },
+                             _actualFont.GetUnscaledSize().Y,
+                             _actualFont.GetFaceName(),
+                             _settings.DefaultBackground() };
+
+        _terminal->SerializeSelection(singleLine, { &textWriter, copyHtml ? &htmlWriter : nullptr, copyRtf ? &rtfWriter : nullptr });
+        if (copyHtml)
         {
-            textData += text;
+            htmlWriter.FillClipboardHeader(htmlData);
         }
 
-        // convert text to HTML format
-        // GH#5347 - Don't provide a title for the generated HTML, as many
-        // web applications will paste the title first, followed by the HTML
-        // content, which is unexpected.
-        const auto htmlData = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::HTML) ?
-                                  TextBuffer::GenHTML(bufferData,
-                                                      _actualFont.GetUnscaledSize().Y,
-                                                      _actualFont.GetFaceName(),
-                                                      _settings.DefaultBackground()) :
-                                  "";
-
-        // convert to RTF format
-        const auto rtfData = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::RTF) ?
-                                 TextBuffer::GenRTF(bufferData,
-                                                    _actualFont.GetUnscaledSize().Y,
-                                                    _actualFont.GetFaceName(),
-                                                    _settings.DefaultBackground()) :
-                                 "";
-
         if (!_settings.CopyOnSelect())
         {
             _terminal->ClearSelection();
@@ -2416,6 +2536,69 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         return true;
     }
 
+    // Method Description:
+    // - Writes the whole buffer, scrollback included, out to a file. The file
+    //   is created right away, but it's written on a background thread, so
+    //   that exporting a large buffer doesn't hold up the UI.
+    // Arguments:
+    // - path: the path of the file. It's replaced if it's already there.
+    // - format: the format to write the file in
+    // Return Value:
+    // - true if the file was created and the export started
+    bool TermControl::ExportBuffer(const winrt::hstring& path, const ExportFormat format)
+    {
+        if (_closing)
+        {
+            return false;
+        }
+
+        try
+        {
+            TextExportFormat textFormat;
+            switch (format)
+            {
+            case ExportFormat::Vt:
+                textFormat = TextExportFormat::Vt;
+                break;
+            case ExportFormat::Html:
+                textFormat = TextExportFormat::Html;
+                break;
+            default:
+                textFormat = TextExportFormat::PlainText;
+                break;
+            }
+
+            auto exporter = std::make_unique<TextBufferExport>(path,
+                                                               textFormat,
+                                                               _actualFont.GetUnscaledSize().Y,
+                                                               _actualFont.GetFaceName(),
+                                                               _settings.DefaultBackground());
+            _AsyncExportBuffer(std::move(exporter));
+            return true;
+        }
+        CATCH_LOG();
+        return false;
+    }
+
+    // Method Description:
+    // - Writes the buffer out through an export on a background thread. The
+    //   terminal is only locked while each chunk of rows is copied.
+    // Arguments:
+    // - exporter: the export, with its file created
+    // Return Value:
+    // - <none>
+    winrt::fire_and_forget TermControl::_AsyncExportBuffer(std::unique_ptr<TextBufferExport> exporter)
+    {
+        auto strongThis{ get_strong() };
+        co_await winrt::resume_background();
+
+        try
+        {
+            _terminal->ExportBuffer(*exporter);
+        }
+        CATCH_LOG();
+    }
+
     // Method Description:
     // - Initiate a paste operation.
     void TermControl::PasteTextFromClipboard()
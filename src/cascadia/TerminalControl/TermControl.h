@@ -13,7 +13,7 @@
 #include "../../renderer/dx/DxRenderer.hpp"
 #include "../../renderer/uia/UiaRenderer.hpp"
 #include "../../cascadia/TerminalCore/Terminal.hpp"
-#include "../buffer/out/search.h"
+#include "../buffer/out/SearchIndex.hpp"
 #include "cppwinrt_utils.h"
 #include "SearchBoxControl.h"
 #include "ThrottledFunc.h"
@@ -108,6 +108,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         hstring GetProfileName() const;
 
         bool CopySelectionToClipboard(bool singleLine, const Windows::Foundation::IReference<CopyFormat>& formats);
+        bool ExportBuffer(const winrt::hstring& path, const ExportFormat format);
         void PasteTextFromClipboard();
         void Close();
         Windows::Foundation::Size CharacterDimensions() const;
@@ -186,6 +187,8 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         bool _initializedTerminal;
 
         winrt::com_ptr<SearchBoxControl> _searchBox;
+        SearchIndex _searchIndex;
+        std::atomic<bool> _indexingScrollback;
 
         event_token _connectionOutputEventToken;
         TerminalConnection::ITerminalConnection::StateChanged_revoker _connectionStateChangedRevoker;
@@ -206,6 +209,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         std::shared_ptr<ThrottledFunc<>> _tsfTryRedrawCanvas;
 
         std::shared_ptr<ThrottledFunc<>> _updatePatternLocations;
+        std::shared_ptr<ThrottledFunc<>> _indexScrollback;
 
         struct ScrollBarUpdate
         {
@@ -325,6 +329,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         double _GetAutoScrollSpeed(double cursorDistanceFromBorder) const;
 
         void _Search(const winrt::hstring& text, const bool goForward, const bool caseSensitive);
+        void _IndexScrollback();
         void _CloseSearchBoxControl(const winrt::Windows::Foundation::IInspectable& sender, Windows::UI::Xaml::RoutedEventArgs const& args);
 
         // TSFInputControl Handlers
@@ -333,6 +338,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         void _FontInfoHandler(const IInspectable& sender, const FontInfoEventArgs& eventArgs);
 
         winrt::fire_and_forget _AsyncCloseConnection();
+        winrt::fire_and_forget _AsyncExportBuffer(std::unique_ptr<TextBufferExport> exporter);
     };
 }
 
@@ -100,7 +100,28 @@ void Terminal::CreateFromSettings(ICoreSettings settings,
                               Utils::ClampToShortMax(settings.InitialRows(), 1) };
 
     // TODO:MSFT:20642297 - Support infinite scrollback here, if HistorySize is -1
-    Create(viewportSize, Utils::ClampToShortMax(settings.HistorySize(), 0), renderTarget);
+    const auto historySize = std::max(settings.HistorySize(), 0);
+    Create(viewportSize, Utils::ClampToShortMax(historySize, 0), renderTarget);
+
+    // The buffer can only address as many rows as fit into a SHORT. If asked
+    // to, the rest of the history is kept in its scrollback, which may take up
+    // as much memory as those rows would at the initial width. The viewport,
+    // selection and renderer can't reach those rows: they only serve search
+    // and export, which read rows by their absolute index.
+    // If the packed rows are spilled to disk, only the rows that aren't packed
+    // have to fit into memory, along with the block that's being filled.
+    const auto extraRows = historySize - (_buffer->GetSize().Height() - viewportSize.Y);
+    if (settings.SearchOnlyHistory() && extraRows > 0)
+    {
+        const auto rowLimit = gsl::narrow_cast<size_t>(extraRows);
+        const auto coldRows = gsl::narrow_cast<size_t>(std::max(settings.ScrollbackColdRows(), 0));
+        const auto spill = settings.ScrollbackSpillToDisk();
+        const auto residentRows = spill ? std::min(rowLimit, coldRows + 2 * Scrollback::BlockRows) : rowLimit;
+        _buffer->SetScrollbackBudget(residentRows * Scrollback::EstimateRowBytes(viewportSize.X));
+        _buffer->SetScrollbackRowLimit(rowLimit);
+        _buffer->SetScrollbackColdThreshold(coldRows);
+        _buffer->SetScrollbackSpillToDisk(spill);
+    }
 
     UpdateSettings(settings);
 }
@@ -329,7 +350,7 @@ void Terminal::UpdateSettings(ICoreSettings settings)
             {
                 try
                 {
-                    auto row = newTextBuffer->GetRowByOffset(::base::ClampSub(proposedTop, 1));
+                    const auto& row = newTextBuffer->GetRowByOffset(::base::ClampSub(proposedTop, 1));
                     if (row.GetCharRow().WasWrapForced())
                     {
                         proposedTop--;
@@ -365,6 +386,8 @@ void Terminal::UpdateSettings(ICoreSettings settings)
     _mutableViewport = Viewport::FromDimensions({ 0, proposedTop }, viewportSize);
 
     _buffer.swap(newTextBuffer);
+    // The history of the new buffer is written from the old one as it's read.
+    _buffer->AdoptReflowSource(std::move(newTextBuffer));
 
     // GH#3494: Maintain scrollbar position during resize
     // Make sure that we don't scroll past the mutableViewport at the bottom of the buffer
@@ -394,6 +417,32 @@ void Terminal::Write(std::wstring_view stringView)
     _stateMachine->ProcessString(stringView);
 }
 
+// Method Description:
+// - Writes the whole buffer, scrollback included, out through an export, a
+//   chunk of rows at a time. The terminal is only locked while a chunk is
+//   copied, not while it's written to the file, so output carries on while
+//   a large buffer is exported. Call it off the UI thread.
+// Arguments:
+// - exporter: the export to write the rows out through
+// Return Value:
+// - <none>
+void Terminal::ExportBuffer(TextBufferExport& exporter)
+{
+    const auto GetAttributeColors = std::bind(&Terminal::GetAttributeColors, this, std::placeholders::_1);
+    auto copied = false;
+    do
+    {
+        {
+            // Reading rows may write the ones that a resize left pending, so
+            // this takes the lock for writing.
+            auto lock = LockForWriting();
+            copied = exporter.CopyRows(*_buffer, GetAttributeColors);
+        }
+        exporter.WriteRows();
+    } while (copied);
+    exporter.Finish();
+}
+
 // Method Description:
 // - Attempts to snap to the bottom of the buffer, if SnapOnInput is true. Does
 //   nothing if SnapOnInput is set to false, or we're already at the bottom of
@@ -886,6 +935,22 @@ void Terminal::_WriteBuffer(const std::wstring_view& stringView)
         const COORD cursorPosBefore = cursor.GetPosition();
         COORD proposedCursorPosition = cursorPosBefore;
 
+        // Printable ASCII is copied into the row in one go, as much of it as
+        // fits onto the cursor's row. Only that much is measured, so that a
+        // long run isn't scanned again for every row that it fills.
+        const auto columnsLeft = gsl::narrow_cast<size_t>(std::max(0, _buffer->GetSize().Width() - cursorPosBefore.X));
+        if (const auto ascii = TextBuffer::MeasurePrintableAscii(stringView.substr(i, columnsLeft)); ascii != 0)
+        {
+            const auto written = _buffer->WriteAscii(stringView.substr(i, ascii), cursorPosBefore, _buffer->GetCurrentAttributes());
+            if (written != 0)
+            {
+                proposedCursorPosition.X += gsl::narrow<SHORT>(written);
+                i += written - 1;
+                _AdjustCursorPosition(proposedCursorPosition);
+                continue;
+            }
+        }
+
         // TODO: MSFT 21006766
         // This is not great but I need it demoable. Fix by making a buffer stream writer.
         //
@@ -1177,6 +1242,23 @@ void Terminal::ClearPatternTree() noexcept
     _InvalidatePatternTree(oldTree);
 }
 
+// Method Description:
+// - Sets the search matches to highlight, and repaints the screen with them.
+// - This is called by TerminalControl, with the terminal locked, whenever it
+//   searches. The matches are by absolute row, so they stay on their text as
+//   it scrolls. Pass none to clear them.
+// Arguments:
+// - matches: the matches, in order, see SearchIndex::GetMatches
+void Terminal::SetSearchHighlights(std::vector<SearchIndex::Match> matches)
+{
+    if (matches.empty() && _searchHighlights.empty())
+    {
+        return;
+    }
+    _searchHighlights = std::move(matches);
+    _buffer->GetRenderTarget().TriggerRedrawAll();
+}
+
 // Method Description:
 // - Returns the tab color
 // If the starting color exits, it's value is preferred
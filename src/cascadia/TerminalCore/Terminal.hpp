@@ -6,6 +6,8 @@
 #include <conattrs.hpp>
 
 #include "../../buffer/out/textBuffer.hpp"
+#include "../../buffer/out/TextBufferExport.hpp"
+#include "../../buffer/out/SearchIndex.hpp"
 #include "../../renderer/inc/BlinkingState.hpp"
 #include "../../terminal/parser/StateMachine.hpp"
 #include "../../terminal/input/terminalInput.hpp"
@@ -66,6 +68,8 @@ public:
     // Write goes through the parser
     void Write(std::wstring_view stringView);
 
+    void ExportBuffer(TextBufferExport& exporter);
+
     [[nodiscard]] std::shared_lock<std::shared_mutex> LockForReading();
     [[nodiscard]] std::unique_lock<std::shared_mutex> LockForWriting();
 
@@ -165,6 +169,7 @@ public:
     const std::wstring GetHyperlinkUri(uint16_t id) const noexcept override;
     const std::wstring GetHyperlinkCustomId(uint16_t id) const noexcept override;
     const std::vector<size_t> GetPatternId(const COORD location) const noexcept override;
+    std::vector<Microsoft::Console::Types::Viewport> GetSearchHighlightRects() noexcept override;
 #pragma endregion
 
 #pragma region IUiaData
@@ -195,6 +200,8 @@ public:
     void UpdatePatterns() noexcept;
     void ClearPatternTree() noexcept;
 
+    void SetSearchHighlights(std::vector<SearchIndex::Match> matches);
+
     const std::optional<til::color> GetTabColor() const noexcept;
 
     Microsoft::Console::Render::BlinkingState& GetBlinkingState() const noexcept;
@@ -215,7 +222,8 @@ public:
     void SetSelectionEnd(const COORD position, std::optional<SelectionExpansionMode> newExpansionMode = std::nullopt);
     void SetBlockSelection(const bool isEnabled) noexcept;
 
-    const TextBuffer::TextAndColor RetrieveSelectedTextFromBuffer(bool trimTrailingWhitespace) const;
+    std::wstring RetrieveSelectedTextFromBuffer(bool singleLine) const;
+    void SerializeSelection(bool singleLine, const std::initializer_list<TextSerializer::Writer*> writers) const;
 #pragma endregion
 
 private:
@@ -295,6 +303,10 @@ private:
     //      Either way, we should make this behavior controlled by a setting.
 
     interval_tree::IntervalTree<til::point, size_t> _patternIntervalTree;
+
+    // The matches of the last search, in order, by absolute row. The ones in
+    // the viewport are highlighted.
+    std::vector<SearchIndex::Match> _searchHighlights;
     void _InvalidatePatternTree(interval_tree::IntervalTree<til::point, size_t>& tree);
     void _InvalidateFromCoords(const COORD start, const COORD end);
 
@@ -209,8 +209,7 @@ try
     const auto viewport = _GetMutableViewport();
     const short distanceToRight = viewport.RightExclusive() - absoluteCursorPos.X;
     const short fillLimit = std::min(static_cast<short>(numChars), distanceToRight);
-    const auto eraseIter = OutputCellIterator(UNICODE_SPACE, _buffer->GetCurrentAttributes(), fillLimit);
-    _buffer->Write(eraseIter, absoluteCursorPos);
+    _buffer->FillCells(UNICODE_SPACE, _buffer->GetCurrentAttributes(), absoluteCursorPos, fillLimit);
     return true;
 }
 CATCH_LOG_RETURN_FALSE()
@@ -253,10 +252,8 @@ try
         return false;
     }
 
-    const auto eraseIter = OutputCellIterator(UNICODE_SPACE, _buffer->GetCurrentAttributes(), nlength);
-
     // Explicitly turn off end-of-line wrap-flag-setting when erasing cells.
-    _buffer->Write(eraseIter, startPos, false);
+    _buffer->FillCells(UNICODE_SPACE, _buffer->GetCurrentAttributes(), startPos, nlength, false);
     return true;
 }
 CATCH_LOG_RETURN_FALSE()
@@ -325,6 +322,9 @@ try
             _buffer->GetRowByOffset(i).Reset(_buffer->GetCurrentAttributes());
         }
 
+        // The rows that scrolled off the top of the buffer are part of the scrollback too.
+        _buffer->ClearScrollback();
+
         // Reset the scroll offset now because there's nothing for the user to 'scroll' to
         _scrollOffset = 0;
 
@@ -249,16 +249,28 @@ void Terminal::ClearSelection()
 // - singleLine: collapse all of the text to one line
 // Return Value:
 // - wstring text from buffer. If extended to multiple lines, each line is separated by \r\n
-const TextBuffer::TextAndColor Terminal::RetrieveSelectedTextFromBuffer(bool singleLine) const
+std::wstring Terminal::RetrieveSelectedTextFromBuffer(bool singleLine) const
+{
+    std::wstring text;
+    PlainTextWriter writer{ [&](const std::wstring_view chunk) { text.append(chunk); }, !singleLine };
+    SerializeSelection(singleLine, { &writer });
+    return text;
+}
+
+// Method Description:
+// - write the highlighted portion of text buffer out in one pass, in the
+//   formats of the given writers
+// Arguments:
+// - singleLine: collapse all of the text to one line
+// - writers: the writers to write the text with. The ones that are null are left out.
+void Terminal::SerializeSelection(bool singleLine, const std::initializer_list<TextSerializer::Writer*> writers) const
 {
     const auto selectionRects = _GetSelectionRects();
 
     const auto GetAttributeColors = std::bind(&Terminal::GetAttributeColors, this, std::placeholders::_1);
 
-    return _buffer->GetText(!singleLine,
-                            !singleLine,
-                            selectionRects,
-                            GetAttributeColors);
+    TextSerializer serializer{ !singleLine, GetAttributeColors, writers };
+    _buffer->Serialize(selectionRects, serializer);
 }
 
 // Method Description:
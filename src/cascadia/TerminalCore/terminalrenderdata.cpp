@@ -159,6 +159,50 @@ const std::vector<size_t> Terminal::GetPatternId(const COORD location) const noe
     return {};
 }
 
+// Method Description:
+// - Gets the parts of the rows in the viewport that the search matches cover.
+// Return Value:
+// - One rectangle per row of each match, in buffer coordinates.
+std::vector<Microsoft::Console::Types::Viewport> Terminal::GetSearchHighlightRects() noexcept
+try
+{
+    std::vector<Viewport> result;
+    if (_searchHighlights.empty())
+    {
+        return result;
+    }
+
+    const auto bufferRow = _buffer->GetFirstAbsoluteRow();
+    const auto viewport = _GetVisibleViewport();
+    const auto top = bufferRow + viewport.Top();
+    const auto bottom = bufferRow + viewport.BottomInclusive();
+    const auto lastColumn = _buffer->GetSize().RightInclusive();
+
+    // The matches are in order, and so are their ends, so the ones that end
+    // above the viewport can be skipped all at once.
+    auto match = std::partition_point(_searchHighlights.begin(), _searchHighlights.end(), [=](const auto& highlight) {
+        return highlight.end.y() < top;
+    });
+    for (; match != _searchHighlights.end() && match->start.y() <= bottom; ++match)
+    {
+        const auto firstRow = std::max<int64_t>(match->start.y(), top);
+        const auto lastRow = std::min<int64_t>(match->end.y(), bottom);
+        for (auto row = firstRow; row <= lastRow; ++row)
+        {
+            const auto left = row == match->start.y() ? match->start.x() : 0;
+            const auto right = row == match->end.y() ? match->end.x() : lastColumn;
+            const auto y = gsl::narrow_cast<SHORT>(row - bufferRow);
+            result.emplace_back(Viewport::FromInclusive({ gsl::narrow_cast<SHORT>(left), y, gsl::narrow_cast<SHORT>(right), y }));
+        }
+    }
+    return result;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return {};
+}
+
 std::vector<Microsoft::Console::Types::Viewport> Terminal::GetSelectionRects() noexcept
 try
 {
@@ -16,6 +16,7 @@ static constexpr std::string_view CloseWindowKey{ "closeWindow" };
 static constexpr std::string_view CopyTextKey{ "copy" };
 static constexpr std::string_view DuplicateTabKey{ "duplicateTab" };
 static constexpr std::string_view ExecuteCommandlineKey{ "wt" };
+static constexpr std::string_view ExportBufferKey{ "exportBuffer" };
 static constexpr std::string_view FindKey{ "find" };
 static constexpr std::string_view MoveFocusKey{ "moveFocus" };
 static constexpr std::string_view NewTabKey{ "newTab" };
@@ -74,6 +75,7 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         { CopyTextKey, ShortcutAction::CopyText },
         { DuplicateTabKey, ShortcutAction::DuplicateTab },
         { ExecuteCommandlineKey, ShortcutAction::ExecuteCommandline },
+        { ExportBufferKey, ShortcutAction::ExportBuffer },
         { FindKey, ShortcutAction::Find },
         { MoveFocusKey, ShortcutAction::MoveFocus },
         { NewTabKey, ShortcutAction::NewTab },
@@ -121,6 +123,7 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         { ShortcutAction::CloseTabsAfter, CloseTabsAfterArgs::FromJson },
         { ShortcutAction::CopyText, CopyTextArgs::FromJson },
         { ShortcutAction::ExecuteCommandline, ExecuteCommandlineArgs::FromJson },
+        { ShortcutAction::ExportBuffer, ExportBufferArgs::FromJson },
         { ShortcutAction::MoveFocus, MoveFocusArgs::FromJson },
         { ShortcutAction::NewTab, NewTabArgs::FromJson },
         { ShortcutAction::OpenSettings, OpenSettingsArgs::FromJson },
@@ -267,6 +270,7 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
                 { ShortcutAction::CopyText, RS_(L"CopyTextCommandKey") },
                 { ShortcutAction::DuplicateTab, RS_(L"DuplicateTabCommandKey") },
                 { ShortcutAction::ExecuteCommandline, RS_(L"ExecuteCommandlineCommandKey") },
+                { ShortcutAction::ExportBuffer, L"" }, // Intentionally omitted, must be generated by GenerateName
                 { ShortcutAction::Find, RS_(L"FindCommandKey") },
                 { ShortcutAction::Invalid, L"" },
                 { ShortcutAction::MoveFocus, RS_(L"MoveFocusCommandKey") },
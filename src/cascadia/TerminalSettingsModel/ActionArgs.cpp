@@ -22,6 +22,7 @@
 #include "ExecuteCommandlineArgs.g.cpp"
 #include "CloseOtherTabsArgs.g.cpp"
 #include "CloseTabsAfterArgs.g.cpp"
+#include "ExportBufferArgs.g.cpp"
 
 #include <LibraryResources.h>
 
@@ -393,4 +394,13 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         }
         return RS_(L"ScrollDownCommandKey");
     }
+
+    winrt::hstring ExportBufferArgs::GenerateName() const
+    {
+        // "Export buffer to {_Path}"
+        return winrt::hstring{
+            fmt::format(std::wstring_view(RS_(L"ExportBufferCommandKey")),
+                        _Path.c_str())
+        };
+    }
 }
@@ -24,6 +24,7 @@
 #include "CloseTabsAfterArgs.g.h"
 #include "ScrollUpArgs.g.h"
 #include "ScrollDownArgs.g.h"
+#include "ExportBufferArgs.g.h"
 
 #include "../../cascadia/inc/cppwinrt_utils.h"
 #include "JsonUtils.h"
@@ -742,6 +743,49 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
             return *copy;
         }
     };
+
+    struct ExportBufferArgs : public ExportBufferArgsT<ExportBufferArgs>
+    {
+        ExportBufferArgs() = default;
+        GETSET_PROPERTY(winrt::hstring, Path, L"");
+        GETSET_PROPERTY(TerminalControl::ExportFormat, Format, TerminalControl::ExportFormat::PlainText);
+
+        static constexpr std::string_view PathKey{ "path" };
+        static constexpr std::string_view FormatKey{ "format" };
+
+    public:
+        hstring GenerateName() const;
+
+        bool Equals(const IActionArgs& other)
+        {
+            auto otherAsUs = other.try_as<ExportBufferArgs>();
+            if (otherAsUs)
+            {
+                return otherAsUs->_Path == _Path &&
+                       otherAsUs->_Format == _Format;
+            }
+            return false;
+        };
+        static FromJsonResult FromJson(const Json::Value& json)
+        {
+            // LOAD BEARING: Not using make_self here _will_ break you in the future!
+            auto args = winrt::make_self<ExportBufferArgs>();
+            JsonUtils::GetValueForKey(json, PathKey, args->_Path);
+            JsonUtils::GetValueForKey(json, FormatKey, args->_Format);
+            if (args->_Path.empty())
+            {
+                return { nullptr, { SettingsLoadWarnings::MissingRequiredParameter } };
+            }
+            return { *args, {} };
+        }
+        IActionArgs Copy() const
+        {
+            auto copy{ winrt::make_self<ExportBufferArgs>() };
+            copy->_Path = _Path;
+            copy->_Format = _Format;
+            return *copy;
+        }
+    };
 }
 
 namespace winrt::Microsoft::Terminal::Settings::Model::factory_implementation
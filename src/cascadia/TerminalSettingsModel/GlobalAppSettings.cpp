@@ -46,6 +46,7 @@ static constexpr std::string_view DebugFeaturesKey{ "debugFeatures" };
 static constexpr std::string_view ForceFullRepaintRenderingKey{ "experimental.rendering.forceFullRepaint" };
 static constexpr std::string_view SoftwareRenderingKey{ "experimental.rendering.software" };
 static constexpr std::string_view ForceVTInputKey{ "experimental.input.forceVT" };
+static constexpr std::string_view RecordingDirectoryKey{ "experimental.recordingDirectory" };
 
 #ifdef _DEBUG
 static constexpr bool debugFeaturesDefault{ true };
@@ -109,6 +110,7 @@ winrt::com_ptr<GlobalAppSettings> GlobalAppSettings::Copy() const
     globals->_ForceFullRepaintRendering = _ForceFullRepaintRendering;
     globals->_SoftwareRendering = _SoftwareRendering;
     globals->_ForceVTInput = _ForceVTInput;
+    globals->_RecordingDirectory = _RecordingDirectory;
     globals->_DebugFeaturesEnabled = _DebugFeaturesEnabled;
     globals->_StartOnUserLogin = _StartOnUserLogin;
     globals->_AlwaysOnTop = _AlwaysOnTop;
@@ -286,6 +288,7 @@ void GlobalAppSettings::LayerJson(const Json::Value& json)
 
     JsonUtils::GetValueForKey(json, SoftwareRenderingKey, _SoftwareRendering);
     JsonUtils::GetValueForKey(json, ForceVTInputKey, _ForceVTInput);
+    JsonUtils::GetValueForKey(json, RecordingDirectoryKey, _RecordingDirectory);
 
     JsonUtils::GetValueForKey(json, EnableStartupTaskKey, _StartOnUserLogin);
 
@@ -384,6 +387,7 @@ Json::Value GlobalAppSettings::ToJson() const
     JsonUtils::SetValueForKey(json, ForceFullRepaintRenderingKey,   _ForceFullRepaintRendering);
     JsonUtils::SetValueForKey(json, SoftwareRenderingKey,           _SoftwareRendering);
     JsonUtils::SetValueForKey(json, ForceVTInputKey,                _ForceVTInput);
+    JsonUtils::SetValueForKey(json, RecordingDirectoryKey,          _RecordingDirectory);
     JsonUtils::SetValueForKey(json, EnableStartupTaskKey,           _StartOnUserLogin);
     JsonUtils::SetValueForKey(json, AlwaysOnTopKey,                 _AlwaysOnTop);
     JsonUtils::SetValueForKey(json, TabSwitcherModeKey,             _TabSwitcherMode);
@@ -80,6 +80,7 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         GETSET_SETTING(bool, ForceFullRepaintRendering, false);
         GETSET_SETTING(bool, SoftwareRendering, false);
         GETSET_SETTING(bool, ForceVTInput, false);
+        GETSET_SETTING(hstring, RecordingDirectory, L"");
         GETSET_SETTING(bool, DebugFeaturesEnabled, _getDefaultDebugFeaturesValue());
         GETSET_SETTING(bool, StartOnUserLogin, false);
         GETSET_SETTING(bool, AlwaysOnTop, false);
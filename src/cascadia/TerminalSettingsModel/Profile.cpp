@@ -32,6 +32,9 @@ static constexpr std::string_view SelectionBackgroundKey{ "selectionBackground"
 static constexpr std::string_view TabTitleKey{ "tabTitle" };
 static constexpr std::string_view SuppressApplicationTitleKey{ "suppressApplicationTitle" };
 static constexpr std::string_view HistorySizeKey{ "historySize" };
+static constexpr std::string_view SearchOnlyHistoryKey{ "experimental.searchOnlyHistory" };
+static constexpr std::string_view ScrollbackColdRowsKey{ "experimental.scrollbackColdRows" };
+static constexpr std::string_view ScrollbackSpillToDiskKey{ "experimental.scrollbackSpillToDisk" };
 static constexpr std::string_view SnapOnInputKey{ "snapOnInput" };
 static constexpr std::string_view AltGrAliasingKey{ "altGrAliasing" };
 static constexpr std::string_view CursorColorKey{ "cursorColor" };
@@ -104,6 +107,9 @@ winrt::com_ptr<Profile> Profile::CopySettings(winrt::com_ptr<Profile> source)
     profile->_SelectionBackground = source->_SelectionBackground;
     profile->_CursorColor = source->_CursorColor;
     profile->_HistorySize = source->_HistorySize;
+    profile->_SearchOnlyHistory = source->_SearchOnlyHistory;
+    profile->_ScrollbackColdRows = source->_ScrollbackColdRows;
+    profile->_ScrollbackSpillToDisk = source->_ScrollbackSpillToDisk;
     profile->_SnapOnInput = source->_SnapOnInput;
     profile->_AltGrAliasing = source->_AltGrAliasing;
     profile->_CursorShape = source->_CursorShape;
@@ -302,6 +308,9 @@ void Profile::LayerJson(const Json::Value& json)
 
     // TODO:MSFT:20642297 - Use a sentinel value (-1) for "Infinite scrollback"
     JsonUtils::GetValueForKey(json, HistorySizeKey, _HistorySize);
+    JsonUtils::GetValueForKey(json, SearchOnlyHistoryKey, _SearchOnlyHistory);
+    JsonUtils::GetValueForKey(json, ScrollbackColdRowsKey, _ScrollbackColdRows);
+    JsonUtils::GetValueForKey(json, ScrollbackSpillToDiskKey, _ScrollbackSpillToDisk);
     JsonUtils::GetValueForKey(json, SnapOnInputKey, _SnapOnInput);
     JsonUtils::GetValueForKey(json, AltGrAliasingKey, _AltGrAliasing);
     JsonUtils::GetValueForKey(json, CursorHeightKey, _CursorHeight);
@@ -546,6 +555,9 @@ Json::Value Profile::ToJson() const
 
     // TODO:MSFT:20642297 - Use a sentinel value (-1) for "Infinite scrollback"
     JsonUtils::SetValueForKey(json, HistorySizeKey, _HistorySize);
+    JsonUtils::SetValueForKey(json, SearchOnlyHistoryKey, _SearchOnlyHistory);
+    JsonUtils::SetValueForKey(json, ScrollbackColdRowsKey, _ScrollbackColdRows);
+    JsonUtils::SetValueForKey(json, ScrollbackSpillToDiskKey, _ScrollbackSpillToDisk);
     JsonUtils::SetValueForKey(json, SnapOnInputKey, _SnapOnInput);
     JsonUtils::SetValueForKey(json, AltGrAliasingKey, _AltGrAliasing);
     JsonUtils::SetValueForKey(json, CursorHeightKey, _CursorHeight);
@@ -111,6 +111,9 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         GETSET_NULLABLE_SETTING(Windows::UI::Color, CursorColor, nullptr);
 
         GETSET_SETTING(int32_t, HistorySize, DEFAULT_HISTORY_SIZE);
+        GETSET_SETTING(bool, SearchOnlyHistory, false);
+        GETSET_SETTING(int32_t, ScrollbackColdRows, 1024);
+        GETSET_SETTING(bool, ScrollbackSpillToDisk, false);
         GETSET_SETTING(bool, SnapOnInput, true);
         GETSET_SETTING(bool, AltGrAliasing, true);
 
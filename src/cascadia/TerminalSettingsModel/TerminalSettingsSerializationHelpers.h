@@ -257,6 +257,15 @@ JSON_FLAG_MAPPER(::winrt::Microsoft::Terminal::TerminalControl::CopyFormat)
     }
 };
 
+JSON_ENUM_MAPPER(::winrt::Microsoft::Terminal::TerminalControl::ExportFormat)
+{
+    JSON_MAPPINGS(3) = {
+        pair_type{ "text", ValueType::PlainText },
+        pair_type{ "vt", ValueType::Vt },
+        pair_type{ "html", ValueType::Html },
+    };
+};
+
 // Type Description:
 // - Helper for converting the initial position string into
 //   2 coordinate values. We allow users to only provide one coordinate,
@@ -24,6 +24,9 @@ namespace TerminalCoreUnitTests
 
         // property getters - all implemented
         int32_t HistorySize() { return _historySize; }
+        bool SearchOnlyHistory() { return _searchOnlyHistory; }
+        int32_t ScrollbackColdRows() { return _scrollbackColdRows; }
+        bool ScrollbackSpillToDisk() { return _scrollbackSpillToDisk; }
         int32_t InitialRows() { return _initialRows; }
         int32_t InitialCols() { return _initialCols; }
         uint32_t DefaultForeground() { return COLOR_WHITE; }
@@ -45,6 +48,9 @@ namespace TerminalCoreUnitTests
 
         // property setters - all unimplemented
         void HistorySize(int32_t) {}
+        void SearchOnlyHistory(bool searchOnlyHistory) { _searchOnlyHistory = searchOnlyHistory; }
+        void ScrollbackColdRows(int32_t scrollbackColdRows) { _scrollbackColdRows = scrollbackColdRows; }
+        void ScrollbackSpillToDisk(bool scrollbackSpillToDisk) { _scrollbackSpillToDisk = scrollbackSpillToDisk; }
         void InitialRows(int32_t) {}
         void InitialCols(int32_t) {}
         void DefaultForeground(uint32_t) {}
@@ -66,6 +72,9 @@ namespace TerminalCoreUnitTests
 
     private:
         int32_t _historySize;
+        bool _searchOnlyHistory{ false };
+        int32_t _scrollbackColdRows{ 1024 };
+        bool _scrollbackSpillToDisk{ false };
         int32_t _initialRows;
         int32_t _initialCols;
         bool _copyOnSelect{ false };
@@ -26,6 +26,9 @@ namespace TerminalCoreUnitTests
 
         TEST_METHOD(ScreenWidthAndHeightAreClampedToBounds);
         TEST_METHOD(ScrollbackHistorySizeIsClampedToBounds);
+        TEST_METHOD(SearchOnlyHistoryIsOptIn);
+        TEST_METHOD(ScrollbackColdRowsAreApplied);
+        TEST_METHOD(ScrollbackSpillToDiskIsApplied);
 
         TEST_METHOD(ResizeIsClampedToBounds);
     };
@@ -95,6 +98,89 @@ void ScreenSizeLimitsTest::ScrollbackHistorySizeIsClampedToBounds()
     VERIFY_ARE_EQUAL(farTooBigHistorySizeTerminal.GetTextBuffer().TotalRowCount(), static_cast<unsigned int>(SHRT_MAX), L"History size that is far too large is clamped to SHRT_MAX - initial row count");
 }
 
+void ScreenSizeLimitsTest::SearchOnlyHistoryIsOptIn()
+{
+    // History that the buffer can't address is only kept in its scrollback
+    // when the profile asks for it, as it can't be scrolled to or selected.
+
+    const unsigned int visibleRowCount = 100;
+    DummyRenderTarget emptyRenderTarget;
+
+    auto defaultSettings = winrt::make<MockTermSettings>(99999999, visibleRowCount, 100);
+    Terminal defaultTerminal;
+    defaultTerminal.CreateFromSettings(defaultSettings, emptyRenderTarget);
+    VERIFY_ARE_EQUAL(defaultTerminal.GetTextBuffer().TotalRowCount(), static_cast<unsigned int>(SHRT_MAX));
+    VERIFY_ARE_EQUAL(defaultTerminal.GetTextBuffer().GetScrollback().GetBudget(), size_t{ 0 }, L"History beyond SHRT_MAX rows isn't kept by default");
+
+    auto searchOnlySettings = winrt::make<MockTermSettings>(99999999, visibleRowCount, 100);
+    searchOnlySettings.SearchOnlyHistory(true);
+    Terminal searchOnlyTerminal;
+    searchOnlyTerminal.CreateFromSettings(searchOnlySettings, emptyRenderTarget);
+    VERIFY_ARE_EQUAL(searchOnlyTerminal.GetTextBuffer().TotalRowCount(), static_cast<unsigned int>(SHRT_MAX));
+    VERIFY_IS_GREATER_THAN(searchOnlyTerminal.GetTextBuffer().GetScrollback().GetBudget(), size_t{ 0 }, L"History beyond SHRT_MAX rows is kept when asked to");
+
+    auto addressableSettings = winrt::make<MockTermSettings>(SHRT_MAX - visibleRowCount, visibleRowCount, 100);
+    addressableSettings.SearchOnlyHistory(true);
+    Terminal addressableTerminal;
+    addressableTerminal.CreateFromSettings(addressableSettings, emptyRenderTarget);
+    VERIFY_ARE_EQUAL(addressableTerminal.GetTextBuffer().GetScrollback().GetBudget(), size_t{ 0 }, L"History that fits into the buffer needs no scrollback");
+}
+
+void ScreenSizeLimitsTest::ScrollbackColdRowsAreApplied()
+{
+    const unsigned int visibleRowCount = 100;
+    DummyRenderTarget emptyRenderTarget;
+
+    auto defaultSettings = winrt::make<MockTermSettings>(99999999, visibleRowCount, 100);
+    defaultSettings.SearchOnlyHistory(true);
+    Terminal defaultTerminal;
+    defaultTerminal.CreateFromSettings(defaultSettings, emptyRenderTarget);
+    VERIFY_ARE_EQUAL(defaultTerminal.GetTextBuffer().GetScrollback().GetColdThreshold(), size_t{ 1024 });
+
+    auto coldSettings = winrt::make<MockTermSettings>(99999999, visibleRowCount, 100);
+    coldSettings.SearchOnlyHistory(true);
+    coldSettings.ScrollbackColdRows(256);
+    Terminal coldTerminal;
+    coldTerminal.CreateFromSettings(coldSettings, emptyRenderTarget);
+    VERIFY_ARE_EQUAL(coldTerminal.GetTextBuffer().GetScrollback().GetColdThreshold(), size_t{ 256 });
+
+    auto negativeSettings = winrt::make<MockTermSettings>(99999999, visibleRowCount, 100);
+    negativeSettings.SearchOnlyHistory(true);
+    negativeSettings.ScrollbackColdRows(-1);
+    Terminal negativeTerminal;
+    negativeTerminal.CreateFromSettings(negativeSettings, emptyRenderTarget);
+    VERIFY_ARE_EQUAL(negativeTerminal.GetTextBuffer().GetScrollback().GetColdThreshold(), size_t{ 0 }, L"A negative row count packs all rows");
+}
+
+void ScreenSizeLimitsTest::ScrollbackSpillToDiskIsApplied()
+{
+    // Rows that are spilled to disk don't count against the budget, so it
+    // only has to leave room for the rows that are kept in memory. The
+    // history size still limits how many rows are kept.
+
+    const unsigned int visibleRowCount = 100;
+    const int32_t historySize = 99999999;
+    DummyRenderTarget emptyRenderTarget;
+
+    auto residentSettings = winrt::make<MockTermSettings>(historySize, visibleRowCount, 100);
+    residentSettings.SearchOnlyHistory(true);
+    Terminal residentTerminal;
+    residentTerminal.CreateFromSettings(residentSettings, emptyRenderTarget);
+    const auto& residentScrollback = residentTerminal.GetTextBuffer().GetScrollback();
+    VERIFY_IS_FALSE(residentScrollback.GetSpillToDisk());
+
+    auto spillingSettings = winrt::make<MockTermSettings>(historySize, visibleRowCount, 100);
+    spillingSettings.SearchOnlyHistory(true);
+    spillingSettings.ScrollbackSpillToDisk(true);
+    Terminal spillingTerminal;
+    spillingTerminal.CreateFromSettings(spillingSettings, emptyRenderTarget);
+    const auto& spillingScrollback = spillingTerminal.GetTextBuffer().GetScrollback();
+    VERIFY_IS_TRUE(spillingScrollback.GetSpillToDisk());
+    VERIFY_IS_LESS_THAN(spillingScrollback.GetBudget(), residentScrollback.GetBudget());
+    VERIFY_ARE_EQUAL(residentScrollback.GetRowLimit(), spillingScrollback.GetRowLimit());
+    VERIFY_IS_LESS_THAN(residentScrollback.GetRowLimit(), static_cast<size_t>(historySize));
+}
+
 void ScreenSizeLimitsTest::ResizeIsClampedToBounds()
 {
     // What is actually clamped is the number of rows in the internal history buffer,
@@ -41,6 +41,8 @@ class TerminalCoreUnitTests::TerminalBufferTests final
 
     TEST_METHOD(DontSnapToOutputTest);
 
+    TEST_METHOD(TestSearchHighlightRects);
+
     TEST_METHOD_SETUP(MethodSetup)
     {
         // STEP 1: Set up the Terminal
@@ -233,3 +235,43 @@ void TerminalBufferTests::DontSnapToOutputTest()
     VERIFY_ARE_EQUAL(TerminalViewHeight, seventhView.BottomExclusive());
     VERIFY_ARE_EQUAL(TerminalHistoryLength, term->_scrollOffset);
 }
+
+void TerminalBufferTests::TestSearchHighlightRects()
+{
+    auto& termTb = *term->_buffer;
+    auto& termSm = *term->_stateMachine;
+
+    // -1 so that we don't print the last \n
+    for (int i = 0; i < TerminalViewHeight + 19 - 1; i++)
+    {
+        termSm.ProcessString(L"x\n");
+    }
+    VERIFY_ARE_EQUAL(19, term->GetViewport().Top());
+
+    const auto bufferRow = termTb.GetFirstAbsoluteRow();
+    const auto match = [=](const ptrdiff_t left, const ptrdiff_t top, const ptrdiff_t right, const ptrdiff_t bottom) {
+        return SearchIndex::Match{ til::point{ left, bufferRow + top }, til::point{ right, bufferRow + bottom } };
+    };
+    term->SetSearchHighlights({ match(2, 18, 4, 18),
+                                match(2, 20, 4, 20),
+                                match(78, 25, 1, 26),
+                                match(2, 60, 4, 60) });
+
+    Log::Comment(L"Only the matches in the viewport are highlighted, one rectangle per row.");
+    auto rects = term->GetSearchHighlightRects();
+    VERIFY_ARE_EQUAL(3u, rects.size());
+    VERIFY_ARE_EQUAL((SMALL_RECT{ 2, 20, 4, 20 }), rects.at(0).ToInclusive());
+    VERIFY_ARE_EQUAL((SMALL_RECT{ 78, 25, 79, 25 }), rects.at(1).ToInclusive());
+    VERIFY_ARE_EQUAL((SMALL_RECT{ 0, 26, 1, 26 }), rects.at(2).ToInclusive());
+
+    Log::Comment(L"Scroll up, so that the first match is in the viewport too.");
+    term->_scrollOffset = 9;
+    VERIFY_ARE_EQUAL(10, term->GetViewport().Top());
+    rects = term->GetSearchHighlightRects();
+    VERIFY_ARE_EQUAL(4u, rects.size());
+    VERIFY_ARE_EQUAL((SMALL_RECT{ 2, 18, 4, 18 }), rects.at(0).ToInclusive());
+
+    Log::Comment(L"Clearing the matches clears the highlights.");
+    term->SetSearchHighlights({});
+    VERIFY_ARE_EQUAL(0u, term->GetSearchHighlightRects().size());
+}
@@ -28,7 +28,6 @@ VtInputThread::VtInputThread(_In_ wil::unique_hfile hPipe,
                              const bool inheritCursor) :
     _hFile{ std::move(hPipe) },
     _hThread{},
-    _u8State{},
     _dwThreadId{ 0 },
     _exitRequested{ false },
     _exitResult{ S_OK }
@@ -72,14 +71,9 @@ VtInputThread::VtInputThread(_In_ wil::unique_hfile hPipe,
 
     try
     {
-        std::wstring wstr{};
-        auto hr = til::u8u16(u8Str, wstr, _u8State);
-        // If we hit a parsing error, eat it. It's bad utf-8, we can't do anything with it.
-        if (FAILED(hr))
-        {
-            return S_FALSE;
-        }
-        _pInputStateMachine->ProcessString(wstr);
+        // The state machine takes UTF-8 directly and handles code points
+        // that are split across reads.
+        _pInputStateMachine->ProcessString(u8Str);
     }
     CATCH_RETURN();
 
@@ -532,15 +532,26 @@ constexpr unsigned int LOCAL_BUFFER_SIZE = 100;
             }
 
             // line was wrapped if we're writing up to the end of the current row
-            OutputCellIterator it(std::wstring_view(LocalBuffer, i), Attributes);
-            const auto itEnd = screenInfo.Write(it);
+            // Printable ASCII is copied into the row without walking it cell by cell.
+            const std::wstring_view chunk{ LocalBuffer, i };
+            size_t cellsWritten;
+            if (TextBuffer::MeasurePrintableAscii(chunk) == chunk.size())
+            {
+                cellsWritten = textBuffer.WriteAscii(chunk, CursorPosition, Attributes);
+            }
+            else
+            {
+                OutputCellIterator it(chunk, Attributes);
+                const auto itEnd = screenInfo.Write(it);
+                cellsWritten = itEnd.GetCellDistance(it);
+            }
 
             // Notify accessibility
             screenInfo.NotifyAccessibilityEventing(CursorPosition.X, CursorPosition.Y, CursorPosition.X + gsl::narrow<SHORT>(i - 1), CursorPosition.Y);
 
             // The number of "spaces" or "cells" we have consumed needs to be reported and stored for later
             // when/if we need to erase the command line.
-            TempNumSpaces += itEnd.GetCellDistance(it);
+            TempNumSpaces += cellsWritten;
             CursorPosition.X = XPosition;
 
             // enforce a delayed newline if we're about to pass the end and the WC_DELAY_EOL_WRAP flag is set.
@@ -850,6 +861,7 @@ constexpr unsigned int LOCAL_BUFFER_SIZE = 100;
                 // Additionally, this padding is only called for IsConsoleFullWidth (a.k.a. when a character
                 // is too wide to fit on the current line).
                 charRow.SetDoubleBytePadded(true);
+                Row.MarkChanged();
 
                 Status = AdjustCursorPosition(screenInfo, CursorPosition, dwFlags & WC_KEEP_CURSOR_VISIBLE, psScrollY);
                 continue;
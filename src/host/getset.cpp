@@ -2193,8 +2193,7 @@ void DoSrvPrivateMoveToBottom(SCREEN_INFORMATION& screenInfo)
             fillAttrs.SetStandardErase();
         }
 
-        const auto fillData = OutputCellIterator{ fillChar, fillAttrs, fillLength };
-        screenInfo.Write(fillData, startPosition, false);
+        screenInfo.GetTextBuffer().FillCells(fillChar, fillAttrs, startPosition, fillLength, false);
 
         // Notify accessibility
         auto endPosition = startPosition;
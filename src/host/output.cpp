@@ -382,13 +382,15 @@ void ScrollRegion(SCREEN_INFORMATION& screenInfo,
 
     // Determine the cell we will use to fill in any revealed/uncovered space.
     // We generally use exactly what was given to us.
-    OutputCellIterator fillData(fillCharGiven, fillAttrsGiven);
+    auto fillChar = fillCharGiven;
+    auto fillAttrs = fillAttrsGiven;
 
     // However, if the character is null and we were given a null attribute (represented as legacy 0),
     // then we'll just fill with spaces and whatever the buffer's default colors are.
     if (fillCharGiven == UNICODE_NULL && fillAttrsGiven == TextAttribute{ 0 })
     {
-        fillData = OutputCellIterator(UNICODE_SPACE, screenInfo.GetAttributes());
+        fillChar = UNICODE_SPACE;
+        fillAttrs = screenInfo.GetAttributes();
     }
 
     // ------ 4. PREP TARGET ------
@@ -450,7 +452,7 @@ void ScrollRegion(SCREEN_INFORMATION& screenInfo,
     for (size_t i = 0; i < remaining.size(); i++)
     {
         const auto& view = remaining.at(i);
-        screenInfo.WriteRect(fillData, view);
+        screenInfo.GetTextBuffer().FillRect(fillChar, fillAttrs, view);
     }
 }
 
@@ -354,6 +354,12 @@ const std::vector<size_t> RenderData::GetPatternId(const COORD /*location*/) con
     return {};
 }
 
+// The find dialog in conhost selects one match at a time, so nothing is highlighted.
+std::vector<Viewport> RenderData::GetSearchHighlightRects() noexcept
+{
+    return {};
+}
+
 // Routine Description:
 // - Converts a text attribute into the RGB values that should be presented, applying
 //   relevant table translation information and preferences.
@@ -60,6 +60,8 @@ public:
     const std::wstring GetHyperlinkCustomId(uint16_t id) const noexcept override;
 
     const std::vector<size_t> GetPatternId(const COORD location) const noexcept override;
+
+    std::vector<Microsoft::Console::Types::Viewport> GetSearchHighlightRects() noexcept override;
 #pragma endregion
 
 #pragma region IUiaData
@@ -40,6 +40,7 @@ Author(s):
 #define ID_CONSOLE_EDIT         0xFFF6
 #define ID_CONSOLE_CONTROL      0xFFF7
 #define ID_CONSOLE_DEFAULTS     0xFFF8
+#define ID_CONSOLE_EXPORT       0xFFF9
 
 // MENU IDs
 #define ID_CONSOLE_SYSTEMMENU   500
@@ -51,4 +52,10 @@ Author(s):
 #define ID_CONSOLE_FINDUP       603
 #define ID_CONSOLE_FINDDOWN     604
 
+#define ID_CONSOLE_EXPORTDLG    610
+#define ID_CONSOLE_EXPORTPATH   611
+#define ID_CONSOLE_EXPORTTEXT   612
+#define ID_CONSOLE_EXPORTVT     613
+#define ID_CONSOLE_EXPORTHTML   614
+
 // clang-format on
@@ -1444,6 +1444,8 @@ bool SCREEN_INFORMATION::IsMaximizedY() const
         LOG_IF_FAILED(SetViewportOrigin(false, coordCursorHeightDiff, true));
 
         _textBuffer.swap(newTextBuffer);
+        // The history of the new buffer is written from the old one as it's read.
+        _textBuffer->AdoptReflowSource(std::move(newTextBuffer));
     }
 
     return NTSTATUS_FROM_HRESULT(hr);
@@ -2216,12 +2218,13 @@ void SCREEN_INFORMATION::SetViewport(const Viewport& newViewport,
 
     // Update all the rows in the current viewport with the standard erase attributes,
     // i.e. the current background color, but with no meta attributes set.
+    // The viewport is below the last character, so its rows only hold spaces,
+    // and filling them with spaces only changes their colors.
     auto fillAttributes = GetAttributes();
     fillAttributes.SetStandardErase();
     auto fillPosition = COORD{ 0, _viewport.Top() };
     auto fillLength = gsl::narrow_cast<size_t>(_viewport.Height() * GetBufferSize().Width());
-    auto fillData = OutputCellIterator{ fillAttributes, fillLength };
-    Write(fillData, fillPosition, false);
+    _textBuffer->FillCells(UNICODE_SPACE, fillAttributes, fillPosition, fillLength, false);
 
     return S_OK;
 }
@@ -2541,6 +2544,7 @@ void SCREEN_INFORMATION::InitializeCursorRowAttributes()
         auto fillAttributes = GetAttributes();
         fillAttributes.SetStandardErase();
         row.GetAttrRow().SetAttrToEnd(0, fillAttributes);
+        row.MarkChanged();
     }
 }
 
@@ -63,6 +63,7 @@ namespace WEX
 
 class AttrRowTests
 {
+    TextAttributeTable _table;
     ATTR_ROW* pSingle;
     ATTR_ROW* pChain;
 
@@ -80,9 +81,32 @@ class AttrRowTests
 
     TEST_CLASS(AttrRowTests);
 
+    // Sets a run of a row, interning its attribute in the table of the tests.
+    void _SetRun(ATTR_ROW& row, const size_t index, const TextAttribute attr, const size_t length)
+    {
+        row._list[index] = { gsl::narrow<uint16_t>(length), _table.Intern(attr) };
+    }
+
+    // Gets a run of a row along with its attribute.
+    TextAttributeRun _GetRun(const ATTR_ROW& row, const size_t index)
+    {
+        const auto& run = row._list[index];
+        return { run.length, _table.Get(run.id) };
+    }
+
+    std::vector<TextAttributeRun> _GetRuns(const ATTR_ROW& row)
+    {
+        std::vector<TextAttributeRun> runs;
+        for (size_t i = 0; i < row._list.size(); ++i)
+        {
+            runs.push_back(_GetRun(row, i));
+        }
+        return runs;
+    }
+
     TEST_METHOD_SETUP(MethodSetup)
     {
-        pSingle = new ATTR_ROW(_sDefaultLength, _DefaultAttr);
+        pSingle = new ATTR_ROW(_sDefaultLength, _DefaultAttr, _table);
 
         // Segment length is the expected length divided by the row length
         // E.g. row of 80, 4 segments, 20 segment length each
@@ -102,26 +126,20 @@ class AttrRowTests
         }
 
         // Create the chain
-        pChain = new ATTR_ROW(_sDefaultLength, _DefaultAttr);
+        pChain = new ATTR_ROW(_sDefaultLength, _DefaultAttr, _table);
         pChain->_list.resize(sChainSegmentsNeeded);
 
         // Attach all chain segments that are even multiples of the row length
         for (short iChain = 0; iChain < _sDefaultChainLength; iChain++)
         {
-            TextAttributeRun* pRun = &pChain->_list[iChain];
-
-            pRun->SetAttributes(TextAttribute{ gsl::narrow_cast<WORD>(iChain) }); // Just use the chain position as the value
-            pRun->SetLength(sChainSegLength);
+            _SetRun(*pChain, iChain, TextAttribute{ gsl::narrow_cast<WORD>(iChain) }, sChainSegLength); // Just use the chain position as the value
         }
 
         if (sChainLeftover > 0)
         {
             // If we had a leftover, then this chain is one longer than we expected (the default length)
             // So use it as the index (because indices start at 0)
-            TextAttributeRun* pRun = &pChain->_list[_sDefaultChainLength];
-
-            pRun->SetAttributes(_DefaultChainAttr);
-            pRun->SetLength(sChainLeftover);
+            _SetRun(*pChain, _sDefaultChainLength, _DefaultChainAttr, sChainLeftover);
         }
 
         return true;
@@ -152,8 +170,8 @@ class AttrRowTests
             pUnderTest->Reset(attr);
 
             VERIFY_ARE_EQUAL(pUnderTest->_list.size(), 1u);
-            VERIFY_ARE_EQUAL(pUnderTest->_list[0].GetAttributes(), attr);
-            VERIFY_ARE_EQUAL(pUnderTest->_list[0].GetLength(), (unsigned int)_sDefaultLength);
+            VERIFY_ARE_EQUAL(_GetRun(*pUnderTest, 0).GetAttributes(), attr);
+            VERIFY_ARE_EQUAL(_GetRun(*pUnderTest, 0).GetLength(), (unsigned int)_sDefaultLength);
         }
     }
 
@@ -236,7 +254,7 @@ class AttrRowTests
     }
 
     void LogChain(_In_ PCWSTR pwszPrefix,
-                  std::vector<TextAttributeRun>& chain)
+                  const gsl::span<const TextAttributeRun> chain)
     {
         NoThrowString str(pwszPrefix);
 
@@ -266,16 +284,13 @@ class AttrRowTests
 
         // Set up our "original row" that we are going to try to insert into.
         // This will represent a 10 column run of R3->B5->G2 that we will use for all tests.
-        ATTR_ROW originalRow{ static_cast<UINT>(_sDefaultLength), _DefaultAttr };
+        ATTR_ROW originalRow{ static_cast<UINT>(_sDefaultLength), _DefaultAttr, _table };
         originalRow._list.resize(3);
         originalRow._cchRowWidth = 10;
-        originalRow._list[0].SetAttributes(TextAttribute{ 'R' });
-        originalRow._list[0].SetLength(3);
-        originalRow._list[1].SetAttributes(TextAttribute{ 'B' });
-        originalRow._list[1].SetLength(5);
-        originalRow._list[2].SetAttributes(TextAttribute{ 'G' });
-        originalRow._list[2].SetLength(2);
-        LogChain(L"Original: ", originalRow._list);
+        _SetRun(originalRow, 0, TextAttribute{ 'R' }, 3);
+        _SetRun(originalRow, 1, TextAttribute{ 'B' }, 5);
+        _SetRun(originalRow, 2, TextAttribute{ 'G' }, 2);
+        LogChain(L"Original: ", _GetRuns(originalRow));
 
         // Set up our "insertion run"
         size_t cInsertRow = 1;
@@ -353,11 +368,11 @@ class AttrRowTests
         std::copy_n(packedRun.get(), cPackedRun, std::back_inserter(packedRunExpected));
 
         LogChain(L"Expected: ", packedRunExpected);
-        LogChain(L"Actual: ", originalRow._list);
+        LogChain(L"Actual: ", _GetRuns(originalRow));
 
         for (size_t testIndex = 0; testIndex < cPackedRun; testIndex++)
         {
-            VERIFY_ARE_EQUAL(packedRun[testIndex], originalRow._list[testIndex]);
+            VERIFY_ARE_EQUAL(packedRun[testIndex], _GetRun(originalRow, testIndex));
         }
     }
 
@@ -539,31 +554,27 @@ class AttrRowTests
         Log::Comment(L"Reverse iterate through ubuntu prompt");
         {
             // Create attr row representing a buffer that's 121 wide.
-            auto chain = std::make_unique<ATTR_ROW>(121, _DefaultAttr);
+            auto chain = std::make_unique<ATTR_ROW>(121, _DefaultAttr, _table);
 
             // The repro case had 4 chain segments.
             chain->_list.resize(4);
 
             // The color 10 went for the first 18.
-            chain->_list[0].SetAttributes(TextAttribute(0xA));
-            chain->_list[0].SetLength(18);
+            _SetRun(*chain, 0, TextAttribute(0xA), 18);
 
             // Default color for the next 1
-            chain->_list[1].SetAttributes(TextAttribute());
-            chain->_list[1].SetLength(1);
+            _SetRun(*chain, 1, TextAttribute(), 1);
 
             // Color 12 for the next 29
-            chain->_list[2].SetAttributes(TextAttribute(0xC));
-            chain->_list[2].SetLength(29);
+            _SetRun(*chain, 2, TextAttribute(0xC), 29);
 
             // Then default color to end the run
-            chain->_list[3].SetAttributes(TextAttribute());
-            chain->_list[3].SetLength(73);
+            _SetRun(*chain, 3, TextAttribute(), 73);
 
             // The sum of the lengths should be 121.
-            VERIFY_ARE_EQUAL(chain->_cchRowWidth, chain->_list[0]._cchLength + chain->_list[1]._cchLength + chain->_list[2]._cchLength + chain->_list[3]._cchLength);
+            VERIFY_ARE_EQUAL(chain->_cchRowWidth, chain->_list[0].length + chain->_list[1].length + chain->_list[2].length + chain->_list[3].length);
 
-            auto index = chain->_list[0].GetLength();
+            auto index = _GetRun(*chain, 0).GetLength();
             auto stepSize = 1;
             testWalk(chain.get(), index, stepSize);
         }
@@ -571,25 +582,22 @@ class AttrRowTests
         Log::Comment(L"Reverse iterate across a text run in the chain");
         {
             // Create attr row representing a buffer that's 3 wide.
-            auto chain = std::make_unique<ATTR_ROW>(3, _DefaultAttr);
+            auto chain = std::make_unique<ATTR_ROW>(3, _DefaultAttr, _table);
 
             // The repro case had 3 chain segments.
             chain->_list.resize(3);
 
             // The color 10 went for the first 1.
-            chain->_list[0].SetAttributes(TextAttribute(0xA));
-            chain->_list[0].SetLength(1);
+            _SetRun(*chain, 0, TextAttribute(0xA), 1);
 
             // The color 11 for the next 1
-            chain->_list[1].SetAttributes(TextAttribute(0xB));
-            chain->_list[1].SetLength(1);
+            _SetRun(*chain, 1, TextAttribute(0xB), 1);
 
             // Color 12 for the next 1
-            chain->_list[2].SetAttributes(TextAttribute(0xC));
-            chain->_list[2].SetLength(1);
+            _SetRun(*chain, 2, TextAttribute(0xC), 1);
 
             // The sum of the lengths should be 3.
-            VERIFY_ARE_EQUAL(chain->_cchRowWidth, chain->_list[0]._cchLength + chain->_list[1]._cchLength + chain->_list[2]._cchLength);
+            VERIFY_ARE_EQUAL(chain->_cchRowWidth, chain->_list[0].length + chain->_list[1].length + chain->_list[2].length);
 
             // on 'ABC', step from B to A
             auto index = 1;
@@ -600,25 +608,22 @@ class AttrRowTests
         Log::Comment(L"Reverse iterate across two text runs in the chain");
         {
             // Create attr row representing a buffer that's 3 wide.
-            auto chain = std::make_unique<ATTR_ROW>(3, _DefaultAttr);
+            auto chain = std::make_unique<ATTR_ROW>(3, _DefaultAttr, _table);
 
             // The repro case had 3 chain segments.
             chain->_list.resize(3);
 
             // The color 10 went for the first 1.
-            chain->_list[0].SetAttributes(TextAttribute(0xA));
-            chain->_list[0].SetLength(1);
+            _SetRun(*chain, 0, TextAttribute(0xA), 1);
 
             // The color 11 for the next 1
-            chain->_list[1].SetAttributes(TextAttribute(0xB));
-            chain->_list[1].SetLength(1);
+            _SetRun(*chain, 1, TextAttribute(0xB), 1);
 
             // Color 12 for the next 1
-            chain->_list[2].SetAttributes(TextAttribute(0xC));
-            chain->_list[2].SetLength(1);
+            _SetRun(*chain, 2, TextAttribute(0xC), 1);
 
             // The sum of the lengths should be 3.
-            VERIFY_ARE_EQUAL(chain->_cchRowWidth, chain->_list[0]._cchLength + chain->_list[1]._cchLength + chain->_list[2]._cchLength);
+            VERIFY_ARE_EQUAL(chain->_cchRowWidth, chain->_list[0].length + chain->_list[1].length + chain->_list[2].length);
 
             // on 'ABC', step from C to A
             auto index = 2;
@@ -642,11 +647,11 @@ class AttrRowTests
         // Was 1 (single), should now have 2 segments
         VERIFY_ARE_EQUAL(pSingle->_list.size(), 2u);
 
-        VERIFY_ARE_EQUAL(pSingle->_list[0].GetAttributes(), _DefaultAttr);
-        VERIFY_ARE_EQUAL(pSingle->_list[0].GetLength(), (unsigned int)(_sDefaultLength - (_sDefaultLength - iTestIndex)));
+        VERIFY_ARE_EQUAL(_GetRun(*pSingle, 0).GetAttributes(), _DefaultAttr);
+        VERIFY_ARE_EQUAL(_GetRun(*pSingle, 0).GetLength(), (unsigned int)(_sDefaultLength - (_sDefaultLength - iTestIndex)));
 
-        VERIFY_ARE_EQUAL(pSingle->_list[1].GetAttributes(), TestAttr);
-        VERIFY_ARE_EQUAL(pSingle->_list[1].GetLength(), (unsigned int)(_sDefaultLength - iTestIndex));
+        VERIFY_ARE_EQUAL(_GetRun(*pSingle, 1).GetAttributes(), TestAttr);
+        VERIFY_ARE_EQUAL(_GetRun(*pSingle, 1).GetLength(), (unsigned int)(_sDefaultLength - iTestIndex));
 
         Log::Comment(L"SetAttrToEnd for existing chain of multiple colors.");
         pChain->SetAttrToEnd(iTestIndex, TestAttr);
@@ -655,20 +660,20 @@ class AttrRowTests
         VERIFY_ARE_EQUAL(pChain->_list.size(), 5u);
 
         // Verify chain colors and lengths
-        VERIFY_ARE_EQUAL(TextAttribute(0), pChain->_list[0].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[0].GetLength(), (unsigned int)13);
+        VERIFY_ARE_EQUAL(TextAttribute(0), _GetRun(*pChain, 0).GetAttributes());
+        VERIFY_ARE_EQUAL(_GetRun(*pChain, 0).GetLength(), (unsigned int)13);
 
-        VERIFY_ARE_EQUAL(TextAttribute(1), pChain->_list[1].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[1].GetLength(), (unsigned int)13);
+        VERIFY_ARE_EQUAL(TextAttribute(1), _GetRun(*pChain, 1).GetAttributes());
+        VERIFY_ARE_EQUAL(_GetRun(*pChain, 1).GetLength(), (unsigned int)13);
 
-        VERIFY_ARE_EQUAL(TextAttribute(2), pChain->_list[2].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[2].GetLength(), (unsigned int)13);
+        VERIFY_ARE_EQUAL(TextAttribute(2), _GetRun(*pChain, 2).GetAttributes());
+        VERIFY_ARE_EQUAL(_GetRun(*pChain, 2).GetLength(), (unsigned int)13);
 
-        VERIFY_ARE_EQUAL(TextAttribute(3), pChain->_list[3].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[3].GetLength(), (unsigned int)11);
+        VERIFY_ARE_EQUAL(TextAttribute(3), _GetRun(*pChain, 3).GetAttributes());
+        VERIFY_ARE_EQUAL(_GetRun(*pChain, 3).GetLength(), (unsigned int)11);
 
-        VERIFY_ARE_EQUAL(TestAttr, pChain->_list[4].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[4].GetLength(), (unsigned int)30);
+        VERIFY_ARE_EQUAL(TestAttr, _GetRun(*pChain, 4).GetAttributes());
+        VERIFY_ARE_EQUAL(_GetRun(*pChain, 4).GetLength(), (unsigned int)30);
 
         Log::Comment(L"SECOND: Set index to 0 to test replacing anything with a single");
 
@@ -684,10 +689,10 @@ class AttrRowTests
             VERIFY_ARE_EQUAL(pUnderTest->_list.size(), 1u);
 
             // singular pair should contain the color
-            VERIFY_ARE_EQUAL(pUnderTest->_list[0].GetAttributes(), TestAttr);
+            VERIFY_ARE_EQUAL(_GetRun(*pUnderTest, 0).GetAttributes(), TestAttr);
 
             // and its length should be the length of the whole string
-            VERIFY_ARE_EQUAL(pUnderTest->_list[0].GetLength(), (unsigned int)_sDefaultLength);
+            VERIFY_ARE_EQUAL(_GetRun(*pUnderTest, 0).GetLength(), (unsigned int)_sDefaultLength);
         }
     }
 
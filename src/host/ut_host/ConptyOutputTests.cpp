@@ -120,6 +120,10 @@ class ConptyOutputTests
     TEST_METHOD(WriteAFewSimpleLines);
     TEST_METHOD(InvalidateUntilOneBeforeEnd);
 
+    TEST_METHOD(SnapshotCopiesOnlyDirtyRows);
+    TEST_METHOD(SnapshotReinternsAttributes);
+    TEST_METHOD(InvalidationsDuringSnapshotFrameAreReplayed);
+
 private:
     bool _writeCallback(const char* const pch, size_t const cch);
     void _flushFirstFrame();
@@ -364,3 +368,103 @@ void ConptyOutputTests::InvalidateUntilOneBeforeEnd()
 
     VERIFY_SUCCEEDED(renderer.PaintFrame());
 }
+
+void ConptyOutputTests::SnapshotCopiesOnlyDirtyRows()
+{
+    Log::Comment(NoThrowString().Format(
+        L"Capture a snapshot of one dirty row, then another, and make sure the "
+        L"rows that weren't dirty are left as they were"));
+
+    auto& g = ServiceLocator::LocateGlobals();
+    auto& gci = g.getConsoleInformation();
+    auto& si = gci.GetActiveOutputBuffer();
+    auto& sm = si.GetStateMachine();
+
+    sm.ProcessString(L"AAA\r\n");
+    sm.ProcessString(L"BBB");
+
+    RenderSnapshot snapshot;
+    VERIFY_IS_TRUE(snapshot.Capture(gci.renderData, { til::rectangle{ 0, 1, TerminalViewWidth, 2 } }));
+    {
+        const auto& snapshotBuffer = snapshot.GetTextBuffer();
+        VERIFY_ARE_EQUAL(L" ", snapshotBuffer.GetCellDataAt({ 0, 0 })->Chars());
+        VERIFY_ARE_EQUAL(L"B", snapshotBuffer.GetCellDataAt({ 0, 1 })->Chars());
+    }
+
+    Log::Comment(L"Overwrite the second row, but only mark the first one dirty.");
+    sm.ProcessString(L"\x1b[2;1HCCC");
+
+    VERIFY_IS_TRUE(snapshot.Capture(gci.renderData, { til::rectangle{ 0, 0, TerminalViewWidth, 1 } }));
+    {
+        const auto& snapshotBuffer = snapshot.GetTextBuffer();
+        VERIFY_ARE_EQUAL(L"A", snapshotBuffer.GetCellDataAt({ 0, 0 })->Chars());
+        VERIFY_ARE_EQUAL(L"B", snapshotBuffer.GetCellDataAt({ 0, 1 })->Chars());
+    }
+}
+
+void ConptyOutputTests::SnapshotReinternsAttributes()
+{
+    Log::Comment(NoThrowString().Format(
+        L"The snapshot's buffer has an attribute table of its own. Make sure "
+        L"the rows it copies keep their attributes and colors, even though "
+        L"they have other IDs in its table"));
+
+    auto& g = ServiceLocator::LocateGlobals();
+    auto& gci = g.getConsoleInformation();
+    auto& si = gci.GetActiveOutputBuffer();
+    auto& sm = si.GetStateMachine();
+    auto& tb = si.GetTextBuffer();
+
+    // The first row interns red and green before blue, so blue has a higher
+    // ID in the buffer's table than in the snapshot's, which only sees blue.
+    sm.ProcessString(L"\x1b[31mR\x1b[32mG\x1b[m\r\n");
+    sm.ProcessString(L"\x1b[34mB\x1b[m");
+
+    RenderSnapshot snapshot;
+    VERIFY_IS_TRUE(snapshot.Capture(gci.renderData, { til::rectangle{ 0, 1, TerminalViewWidth, 2 } }));
+
+    const auto& snapshotBuffer = snapshot.GetTextBuffer();
+    const auto blue = tb.GetCellDataAt({ 0, 1 })->TextAttr();
+    VERIFY_ARE_NOT_EQUAL(tb.GetRowByOffset(1).GetAttrRow().begin().GetId(),
+                         snapshotBuffer.GetRowByOffset(1).GetAttrRow().begin().GetId());
+    VERIFY_ARE_EQUAL(blue, snapshotBuffer.GetCellDataAt({ 0, 1 })->TextAttr());
+    VERIFY_ARE_EQUAL(tb.GetCellDataAt({ 1, 1 })->TextAttr(), snapshotBuffer.GetCellDataAt({ 1, 1 })->TextAttr());
+
+    Log::Comment(L"The colors were looked up while the row was copied.");
+    VERIFY_ARE_EQUAL(gci.LookupAttributeColors(blue), snapshot.GetAttributeColors(blue));
+}
+
+void ConptyOutputTests::InvalidationsDuringSnapshotFrameAreReplayed()
+{
+    Log::Comment(NoThrowString().Format(
+        L"While a frame is painted from the snapshot, make sure invalidations "
+        L"are held back from the engines, and passed on once the frame ends"));
+
+    auto& g = ServiceLocator::LocateGlobals();
+    auto& renderer = *g.pRender;
+    auto& gci = g.getConsoleInformation();
+    auto& si = gci.GetActiveOutputBuffer();
+    auto& sm = si.GetStateMachine();
+    auto& engine = *renderer._rgpEngines.front();
+
+    _flushFirstFrame();
+    VERIFY_ARE_EQUAL(0u, engine.GetDirtyArea().size());
+
+    renderer._BeginSnapshotFrame();
+    sm.ProcessString(L"AAA");
+
+    VERIFY_ARE_NOT_EQUAL(0u, renderer._deferredInvalidations.size());
+    VERIFY_ARE_EQUAL(0u, engine.GetDirtyArea().size());
+
+    renderer._EndSnapshotFrame();
+
+    VERIFY_ARE_EQUAL(0u, renderer._deferredInvalidations.size());
+    const auto dirtyArea = engine.GetDirtyArea();
+    VERIFY_ARE_NOT_EQUAL(0u, dirtyArea.size());
+    VERIFY_ARE_EQUAL(0, dirtyArea.front().top());
+
+    Log::Comment(L"The next frame is painted from the data again, with the text that was written.");
+    expectedOutput.push_back("AAA");
+
+    VERIFY_SUCCEEDED(renderer.PaintFrame());
+}
@@ -10,10 +10,14 @@
 #include "globals.h"
 #include "../buffer/out/textBuffer.hpp"
 #include "../buffer/out/CharRow.hpp"
+#include "../buffer/out/SearchIndex.hpp"
+#include "../buffer/out/TextBufferExport.hpp"
 
 #include "input.h"
 #include "_stream.h"
 
+#include <fstream>
+
 #include "../interactivity/inc/ServiceLocator.hpp"
 #include "../renderer/inc/DummyRenderTarget.hpp"
 
@@ -137,12 +141,31 @@ class TextBufferTests
     TEST_METHOD(TestRepeatCharacter);
 
     TEST_METHOD(ResizeTraditional);
+    TEST_METHOD(ResizeTraditionalMovesRowsToNewCellBuffer);
+    TEST_METHOD(ScrollRowsAcrossStorageEnd);
+    TEST_METHOD(ScrollbackKeepsRowsThatScrollOff);
+    TEST_METHOD(ScrollbackPacksColdRows);
+    TEST_METHOD(ScrollbackSpillsToDisk);
+    TEST_METHOD(ScrollbackKeepsSpilledRowsBeyondBudget);
+    TEST_METHOD(ScrollbackRewrapsLogicalLinesLazily);
+    TEST_METHOD(ScrollbackKeepsAbsoluteRowsWhenRewrapFails);
+    TEST_METHOD(ReflowWritesHistoryLazily);
+    TEST_METHOD(LogicalLinesFollowWrappedRows);
+    TEST_METHOD(PatternsDontCrossLineBreaks);
+    TEST_METHOD(PatternsFollowChangedRows);
+    TEST_METHOD(WriteAsciiMatchesWrite);
+    TEST_METHOD(FillCellsMatchesWrite);
+    TEST_METHOD(RowRevisionsTrackChanges);
+    TEST_METHOD(SearchIndexFindsEveryMatch);
+    TEST_METHOD(SearchIndexSkipsLinesWithoutTrigrams);
+    TEST_METHOD(SearchIndexCoversBufferHistory);
 
     TEST_METHOD(ResizeTraditionalRotationPreservesHighUnicode);
     TEST_METHOD(ScrollBufferRotationPreservesHighUnicode);
 
     TEST_METHOD(ResizeTraditionalHighUnicodeRowRemoval);
     TEST_METHOD(ResizeTraditionalHighUnicodeColumnRemoval);
+    TEST_METHOD(ResizeTraditionalHighUnicodeOverwrite);
 
     TEST_METHOD(TestBurrito);
 
@@ -153,6 +176,9 @@ class TextBufferTests
 
     TEST_METHOD(GetTextRects);
     TEST_METHOD(GetText);
+    TEST_METHOD(SerializeWritesEveryFormat);
+    TEST_METHOD(ExportWritesEveryRow);
+    TEST_METHOD(ExportSkipsRowsDroppedBetweenChunks);
 
     TEST_METHOD(HyperlinkTrim);
     TEST_METHOD(NoHyperlinkTrim);
@@ -189,7 +215,13 @@ void TextBufferTests::TestBufferRowByOffset()
     short sId = csBufferHeight / 2 - 5;
 
     const ROW& row = textBuffer.GetRowByOffset(sId);
-    VERIFY_ARE_EQUAL(row.GetId(), sId);
+    VERIFY_ARE_EQUAL(&textBuffer._storage.at(textBuffer._GetStorageIndex(sId)), &row);
+
+    Log::Comment(L"Offsets wrap around the end of the storage.");
+    textBuffer._firstRow = textBuffer._storage.size() - 1;
+    VERIFY_ARE_EQUAL(&textBuffer._storage.back(), &textBuffer.GetRowByOffset(0));
+    VERIFY_ARE_EQUAL(&textBuffer._storage.front(), &textBuffer.GetRowByOffset(1));
+    textBuffer._firstRow = 0;
 }
 
 void TextBufferTests::TestWrapFlag()
@@ -626,7 +658,7 @@ void TextBufferTests::TestIncrementCircularBuffer()
         textBuffer.IncrementCircularBuffer();
 
         // validate that first row has moved
-        VERIFY_ARE_EQUAL(textBuffer._firstRow, iNextRowIndex); // first row has incremented
+        VERIFY_ARE_EQUAL(static_cast<size_t>(iNextRowIndex), textBuffer._firstRow); // first row has incremented
         VERIFY_ARE_NOT_EQUAL(textBuffer._GetFirstRow(), FirstRow); // the old first row is no longer the first
 
         // ensure old first row has been emptied
@@ -1828,8 +1860,850 @@ void TextBufferTests::ResizeTraditional()
     }
 }
 
+// The cells of all rows live in one cell buffer. This tests that a resize moves every row
+// into the new cell buffer, in row order, even after scrolling shuffled the rows around.
+void TextBufferTests::ResizeTraditionalMovesRowsToNewCellBuffer()
+{
+    const COORD bufferSize{ 10, 6 };
+    TextBuffer buffer(bufferSize, TextAttribute{}, 12, _renderTarget);
+
+    Log::Comment(L"Fill each row with its own letter and shuffle the rows around.");
+    for (SHORT y = 0; y < bufferSize.Y; y++)
+    {
+        const std::wstring text(bufferSize.X, static_cast<wchar_t>(L'A' + y));
+        buffer.WriteLine(OutputCellIterator{ text }, { 0, y });
+    }
+    buffer.ScrollRows(1, 2, 3);
+    VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+
+    std::vector<std::wstring> expectedRows;
+    for (SHORT y = 0; y < bufferSize.Y; y++)
+    {
+        expectedRows.emplace_back(buffer.GetRowByOffset(y).GetText());
+    }
+
+    Log::Comment(L"Widen the buffer and add a row.");
+    const COORD newSize{ 14, 7 };
+    VERIFY_SUCCEEDED(buffer.ResizeTraditional(newSize));
+
+    const auto cellBuffer = buffer._charBuffer.get();
+    for (SHORT y = 0; y < newSize.Y; y++)
+    {
+        auto& row = buffer.GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(static_cast<size_t>(newSize.X), row.size());
+        VERIFY_IS_TRUE(cellBuffer + y * newSize.X == &*row.GetCharRow().begin());
+
+        const auto expected = y < bufferSize.Y ? til::at(expectedRows, y) + std::wstring(newSize.X - bufferSize.X, L' ') : std::wstring(newSize.X, L' ');
+        VERIFY_ARE_EQUAL(expected, row.GetText());
+    }
+}
+
+void TextBufferTests::ScrollRowsAcrossStorageEnd()
+{
+    const COORD bufferSize{ 4, 6 };
+    TextBuffer buffer(bufferSize, TextAttribute{}, 12, _renderTarget);
+
+    Log::Comment(L"Circle the buffer, so that the rows wrap around the end of the storage.");
+    for (auto i = 0; i < 4; i++)
+    {
+        VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+    }
+    for (SHORT y = 0; y < bufferSize.Y; y++)
+    {
+        const std::wstring text(bufferSize.X, static_cast<wchar_t>(L'A' + y));
+        buffer.WriteLine(OutputCellIterator{ text }, { 0, y });
+    }
+
+    Log::Comment(L"Move rows 1 to 3 down by 2, across the end of the storage.");
+    buffer.ScrollRows(1, 3, 2);
+
+    const std::wstring_view expected{ L"AEFBCD" };
+    for (SHORT y = 0; y < bufferSize.Y; y++)
+    {
+        VERIFY_ARE_EQUAL(std::wstring(bufferSize.X, til::at(expected, y)), buffer.GetRowByOffset(y).GetText());
+    }
+    VERIFY_ARE_EQUAL(4u, buffer._firstRow, L"Scrolling shouldn't move the first row.");
+
+    Log::Comment(L"And back up again.");
+    buffer.ScrollRows(3, 3, -2);
+    for (SHORT y = 0; y < bufferSize.Y; y++)
+    {
+        VERIFY_ARE_EQUAL(std::wstring(bufferSize.X, static_cast<wchar_t>(L'A' + y)), buffer.GetRowByOffset(y).GetText());
+    }
+}
+
+void TextBufferTests::ScrollbackKeepsRowsThatScrollOff()
+{
+    const COORD bufferSize{ 8, 4 };
+    TextBuffer buffer(bufferSize, TextAttribute{}, 12, _renderTarget);
+    const auto rowText = [&](const int64_t row) {
+        auto text = std::to_wstring(row);
+        text.resize(bufferSize.X, L' ');
+        return text;
+    };
+
+    Log::Comment(L"Without a budget, rows are dropped, but still counted.");
+    VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+    VERIFY_ARE_EQUAL(1, buffer.GetFirstAbsoluteRow());
+    VERIFY_ARE_EQUAL(0u, buffer.GetScrollback().size());
+
+    Log::Comment(L"Scroll more rows through the buffer than it can address.");
+    buffer.SetScrollbackBudget(SIZE_MAX);
+    const int64_t rowCount = SHRT_MAX + 1000;
+    for (auto row = buffer.GetFirstAbsoluteRow(); row < rowCount; row++)
+    {
+        buffer.WriteLine(OutputCellIterator{ rowText(row) }, { 0, 0 });
+        VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+    }
+
+    const auto& scrollback = buffer.GetScrollback();
+    VERIFY_ARE_EQUAL(rowCount, buffer.GetFirstAbsoluteRow());
+    VERIFY_ARE_EQUAL(1, scrollback.GetFirstRow());
+    const int64_t rowsToCheck[]{ 1, 2, 1000, rowCount - 1 };
+    for (const auto row : rowsToCheck)
+    {
+        VERIFY_ARE_EQUAL(rowText(row), buffer.GetRowByAbsoluteIndex(row).GetText());
+    }
+    VERIFY_ARE_EQUAL(std::wstring(bufferSize.X, L' '), buffer.GetRowByAbsoluteIndex(rowCount).GetText());
+    VERIFY_THROWS(buffer.GetRowByAbsoluteIndex(0), wil::ResultException);
+
+    Log::Comment(L"Lowering the budget drops the oldest rows a block at a time.");
+    const auto budget = Scrollback::EstimateRowBytes(bufferSize.X) * 1000;
+    buffer.SetScrollbackBudget(budget);
+    VERIFY_IS_LESS_THAN_OR_EQUAL(scrollback.GetUsage(), budget);
+    VERIFY_IS_GREATER_THAN(scrollback.GetFirstRow(), 1);
+    VERIFY_ARE_EQUAL(0, (scrollback.GetFirstRow() - 1) % static_cast<int64_t>(Scrollback::BlockRows));
+    VERIFY_ARE_EQUAL(rowText(rowCount - 1), buffer.GetRowByAbsoluteIndex(rowCount - 1).GetText());
+
+    Log::Comment(L"Reflowing hands the scrollback over to the new buffer, which rewraps it to its width.");
+    TextBuffer newBuffer({ 10, 4 }, TextAttribute{}, 12, _renderTarget);
+    const auto firstRow = scrollback.GetFirstRow();
+    VERIFY_SUCCEEDED(TextBuffer::Reflow(buffer, newBuffer, std::nullopt, std::nullopt));
+    VERIFY_ARE_EQUAL(firstRow, newBuffer.GetScrollback().GetFirstRow());
+    VERIFY_ARE_EQUAL(rowText(firstRow) + L"  ", newBuffer.GetRowByAbsoluteIndex(firstRow).GetText());
+    VERIFY_ARE_EQUAL(0u, buffer.GetScrollback().size());
+}
+
+void TextBufferTests::ScrollbackPacksColdRows()
+{
+    const COORD bufferSize{ 12, 4 };
+    TextBuffer hotBuffer(bufferSize, TextAttribute{}, 12, _renderTarget);
+    TextBuffer coldBuffer(bufferSize, TextAttribute{}, 12, _renderTarget);
+    hotBuffer.SetScrollbackBudget(SIZE_MAX);
+    coldBuffer.SetScrollbackBudget(SIZE_MAX);
+    hotBuffer.SetScrollbackColdThreshold(SIZE_MAX);
+    coldBuffer.SetScrollbackColdThreshold(Scrollback::BlockRows);
+
+    Log::Comment(L"Scroll rows with wide and surrogate pair glyphs, colors and wrapping through both buffers.");
+    const int64_t rowCount = Scrollback::BlockRows * 8;
+    for (int64_t row = 0; row < rowCount; row++)
+    {
+        const auto text = std::to_wstring(row) + L"\x3042\xD83D\xDE00";
+        const TextAttribute attr{ gsl::narrow_cast<WORD>(row % 0x100) };
+        const auto wrap = row % 3 == 0;
+        for (auto buffer : { &hotBuffer, &coldBuffer })
+        {
+            buffer->WriteLine(OutputCellIterator{ text, attr }, { gsl::narrow_cast<SHORT>(row % 4), 0 }, wrap);
+            VERIFY_IS_TRUE(buffer->IncrementCircularBuffer());
+        }
+    }
+
+    Log::Comment(L"The blocks that end a block or more before the end are packed, which takes up less memory.");
+    const auto& hotScrollback = hotBuffer.GetScrollback();
+    const auto& coldScrollback = coldBuffer.GetScrollback();
+    VERIFY_ARE_EQUAL(0u, hotScrollback._packedBlocks);
+    VERIFY_ARE_EQUAL(coldScrollback._blocks.size() - 1, coldScrollback._packedBlocks);
+    VERIFY_IS_LESS_THAN(coldScrollback.GetUsage() * 2, hotScrollback.GetUsage());
+
+    Log::Comment(L"Packed rows read back the same as the ones that were kept as they are.");
+    VERIFY_ARE_EQUAL(hotScrollback.GetFirstRow(), coldScrollback.GetFirstRow());
+    VERIFY_ARE_EQUAL(hotScrollback.GetEndRow(), coldScrollback.GetEndRow());
+    for (auto row = hotScrollback.GetFirstRow(); row < hotScrollback.GetEndRow(); row++)
+    {
+        const auto& expected = hotBuffer.GetRowByAbsoluteIndex(row);
+        const auto& actual = coldBuffer.GetRowByAbsoluteIndex(row);
+        VERIFY_ARE_EQUAL(expected.GetText(), actual.GetText());
+        VERIFY_ARE_EQUAL(expected.GetCharRow().WasWrapForced(), actual.GetCharRow().WasWrapForced());
+        for (size_t column = 0; column < expected.size(); column++)
+        {
+            VERIFY_IS_TRUE(expected.GetCharRow().DbcsAttrAt(column) == actual.GetCharRow().DbcsAttrAt(column));
+            VERIFY_ARE_EQUAL(expected.GetAttrRow().GetAttrByColumn(column), actual.GetAttrRow().GetAttrByColumn(column));
+        }
+    }
+
+    Log::Comment(L"An unpacked row stays valid while rows of another block are read.");
+    const auto& oldRow = coldBuffer.GetRowByAbsoluteIndex(coldScrollback.GetFirstRow());
+    const auto oldText = oldRow.GetText();
+    coldBuffer.GetRowByAbsoluteIndex(coldScrollback.GetFirstRow() + Scrollback::BlockRows);
+    VERIFY_ARE_EQUAL(oldText, oldRow.GetText());
+}
+
+void TextBufferTests::ScrollbackSpillsToDisk()
+{
+    const COORD bufferSize{ 12, 4 };
+    TextBuffer buffer(bufferSize, TextAttribute{}, 12, _renderTarget);
+    buffer.SetScrollbackBudget(SIZE_MAX);
+    buffer.SetScrollbackColdThreshold(Scrollback::BlockRows);
+    buffer.SetScrollbackSpillToDisk(true);
+    const auto rowText = [&](const int64_t row) {
+        auto text = std::to_wstring(row);
+        text.resize(bufferSize.X, L' ');
+        return text;
+    };
+
+    Log::Comment(L"Packed blocks are spilled to the file as they're packed.");
+    const int64_t rowCount = Scrollback::BlockRows * 16;
+    for (auto row = buffer.GetFirstAbsoluteRow(); row < rowCount; row++)
+    {
+        buffer.WriteLine(OutputCellIterator{ rowText(row) }, { 0, 0 });
+        VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+    }
+
+    const auto& scrollback = buffer.GetScrollback();
+    const auto spilled = scrollback.GetStats();
+    VERIFY_IS_GREATER_THAN(spilled.spilledBytes, 0u);
+    VERIFY_IS_GREATER_THAN_OR_EQUAL(spilled.fileBytes, spilled.spilledBytes);
+    VERIFY_IS_LESS_THAN(spilled.residentBytes, gsl::narrow_cast<size_t>(spilled.spilledBytes));
+    VERIFY_ARE_EQUAL(scrollback.GetUsage(), spilled.residentBytes);
+
+    Log::Comment(L"Spilled rows are mapped back in when they're asked for.");
+    for (auto row = scrollback.GetFirstRow(); row < scrollback.GetEndRow(); row++)
+    {
+        VERIFY_ARE_EQUAL(rowText(row), buffer.GetRowByAbsoluteIndex(row).GetText());
+    }
+    VERIFY_IS_GREATER_THAN(scrollback.GetStats().unpackedBytes, 0u);
+
+    Log::Comment(L"Turning spilling off reads the blocks back into memory and closes the file.");
+    buffer.SetScrollbackSpillToDisk(false);
+    const auto resident = scrollback.GetStats();
+    VERIFY_ARE_EQUAL(0u, resident.spilledBytes);
+    VERIFY_ARE_EQUAL(0u, resident.fileBytes);
+    VERIFY_ARE_EQUAL(scrollback.GetUsage(), resident.residentBytes);
+    for (auto row = scrollback.GetFirstRow(); row < scrollback.GetEndRow(); row++)
+    {
+        VERIFY_ARE_EQUAL(rowText(row), buffer.GetRowByAbsoluteIndex(row).GetText());
+    }
+
+    Log::Comment(L"Lowering the row limit frees the extents of the dropped blocks for reuse.");
+    buffer.SetScrollbackSpillToDisk(true);
+    const auto fileBytes = scrollback.GetStats().fileBytes;
+    buffer.SetScrollbackRowLimit(scrollback.size() / 2);
+    for (auto row = buffer.GetFirstAbsoluteRow(); row < rowCount * 4; row++)
+    {
+        buffer.WriteLine(OutputCellIterator{ rowText(row) }, { 0, 0 });
+        VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+    }
+    VERIFY_ARE_EQUAL(fileBytes, scrollback.GetStats().fileBytes);
+    VERIFY_ARE_EQUAL(rowText(scrollback.GetFirstRow()), buffer.GetRowByAbsoluteIndex(scrollback.GetFirstRow()).GetText());
+}
+
+void TextBufferTests::ScrollbackKeepsSpilledRowsBeyondBudget()
+{
+    const COORD bufferSize{ 12, 4 };
+    const auto budget = Scrollback::BlockRows * 4 * Scrollback::EstimateRowBytes(bufferSize.X);
+    TextBuffer residentBuffer(bufferSize, TextAttribute{}, 12, _renderTarget);
+    TextBuffer spillingBuffer(bufferSize, TextAttribute{}, 12, _renderTarget);
+    for (auto buffer : { &residentBuffer, &spillingBuffer })
+    {
+        buffer->SetScrollbackBudget(budget);
+        buffer->SetScrollbackColdThreshold(Scrollback::BlockRows);
+    }
+    spillingBuffer.SetScrollbackSpillToDisk(true);
+    const auto rowText = [&](const int64_t row) {
+        auto text = std::to_wstring(row);
+        text.resize(bufferSize.X, L' ');
+        return text;
+    };
+
+    const int64_t rowCount = Scrollback::BlockRows * 64;
+    for (int64_t row = 0; row < rowCount; row++)
+    {
+        for (auto buffer : { &residentBuffer, &spillingBuffer })
+        {
+            buffer->WriteLine(OutputCellIterator{ rowText(row) }, { 0, 0 });
+            VERIFY_IS_TRUE(buffer->IncrementCircularBuffer());
+        }
+    }
+
+    Log::Comment(L"Rows that are kept in memory are dropped once they don't fit into the budget.");
+    const auto& resident = residentBuffer.GetScrollback();
+    VERIFY_IS_GREATER_THAN(resident.GetFirstRow(), 0);
+    VERIFY_IS_LESS_THAN_OR_EQUAL(resident.GetUsage(), budget);
+
+    Log::Comment(L"Spilled rows don't count against the budget, so all of them are kept.");
+    const auto& spilling = spillingBuffer.GetScrollback();
+    VERIFY_ARE_EQUAL(0, spilling.GetFirstRow());
+    VERIFY_IS_LESS_THAN_OR_EQUAL(spilling.GetUsage(), budget);
+    VERIFY_IS_GREATER_THAN(spilling.GetStats().spilledBytes, uint64_t{ budget });
+    for (auto row = spilling.GetFirstRow(); row < spilling.GetEndRow(); row++)
+    {
+        VERIFY_ARE_EQUAL(rowText(row), spillingBuffer.GetRowByAbsoluteIndex(row).GetText());
+    }
+
+    Log::Comment(L"The row limit still applies to them.");
+    spillingBuffer.SetScrollbackRowLimit(Scrollback::BlockRows * 8);
+    VERIFY_IS_GREATER_THAN_OR_EQUAL(spilling.size(), Scrollback::BlockRows * 8);
+    VERIFY_IS_LESS_THAN(spilling.size(), Scrollback::BlockRows * 9);
+    VERIFY_ARE_EQUAL(rowText(spilling.GetFirstRow()), spillingBuffer.GetRowByAbsoluteIndex(spilling.GetFirstRow()).GetText());
+}
+
+void TextBufferTests::ScrollbackRewrapsLogicalLinesLazily()
+{
+    TextBuffer buffer({ 10, 4 }, TextAttribute{}, 12, _renderTarget);
+    buffer.SetScrollbackBudget(SIZE_MAX);
+    buffer.SetScrollbackColdThreshold(Scrollback::BlockRows);
+    const auto lineText = [](const int64_t line) {
+        auto text = std::to_wstring(line);
+        text.resize(25, L'x');
+        return text;
+    };
+    const auto lineAttr = [](const int64_t line) {
+        return TextAttribute{ gsl::narrow_cast<WORD>(line % 0x100) };
+    };
+
+    Log::Comment(L"Scroll lines that wrap over three rows through the buffer.");
+    const int64_t lineCount = Scrollback::BlockRows * 2;
+    for (int64_t line = 0; line < lineCount; line++)
+    {
+        const auto text = lineText(line);
+        for (size_t offset = 0; offset < text.size(); offset += 10)
+        {
+            const auto wrap = offset + 10 < text.size();
+            buffer.WriteLine(OutputCellIterator{ text.substr(offset, 10), lineAttr(line) }, { 0, 0 }, wrap);
+            VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+        }
+    }
+
+    const auto endRow = buffer.GetFirstAbsoluteRow();
+    VERIFY_ARE_EQUAL(gsl::narrow_cast<size_t>(lineCount * 3), buffer.GetScrollback().size());
+
+    Log::Comment(L"Resizing doesn't rewrap the scrollback until its rows are asked for, however often it happens.");
+    TextBuffer widerBuffer({ 20, 4 }, TextAttribute{}, 12, _renderTarget);
+    TextBuffer widestBuffer({ 30, 4 }, TextAttribute{}, 12, _renderTarget);
+    VERIFY_SUCCEEDED(TextBuffer::Reflow(buffer, widerBuffer, std::nullopt, std::nullopt));
+    VERIFY_SUCCEEDED(TextBuffer::Reflow(widerBuffer, widestBuffer, std::nullopt, std::nullopt));
+    VERIFY_IS_TRUE(widestBuffer._scrollback->IsRewrapPending());
+    VERIFY_ARE_EQUAL(endRow, widestBuffer.GetFirstAbsoluteRow());
+
+    Log::Comment(L"Each line fits into a single row now. The rows still end where they did.");
+    const auto& scrollback = widestBuffer.GetScrollback();
+    VERIFY_IS_FALSE(scrollback.IsRewrapPending());
+    VERIFY_ARE_EQUAL(endRow, scrollback.GetEndRow());
+    VERIFY_ARE_EQUAL(gsl::narrow_cast<size_t>(lineCount), scrollback.size());
+    for (int64_t line = 0; line < lineCount; line++)
+    {
+        const auto& row = widestBuffer.GetRowByAbsoluteIndex(scrollback.GetFirstRow() + line);
+        VERIFY_ARE_EQUAL(lineText(line) + std::wstring(5, L' '), row.GetText());
+        VERIFY_IS_FALSE(row.GetCharRow().WasWrapForced());
+        VERIFY_ARE_EQUAL(lineAttr(line), row.GetAttrRow().GetAttrByColumn(24));
+    }
+
+    Log::Comment(L"Narrowing splits the lines again. Rows that scroll off before that are kept as they are.");
+    TextBuffer narrowBuffer({ 12, 4 }, TextAttribute{}, 12, _renderTarget);
+    VERIFY_SUCCEEDED(TextBuffer::Reflow(widestBuffer, narrowBuffer, std::nullopt, std::nullopt));
+    const std::wstring lastRowText(12, L'n');
+    narrowBuffer.WriteLine(OutputCellIterator{ lastRowText }, { 0, 0 });
+    VERIFY_IS_TRUE(narrowBuffer.IncrementCircularBuffer());
+    VERIFY_IS_TRUE(narrowBuffer._scrollback->IsRewrapPending());
+
+    const auto& narrowScrollback = narrowBuffer.GetScrollback();
+    VERIFY_ARE_EQUAL(endRow + 1, narrowScrollback.GetEndRow());
+    VERIFY_ARE_EQUAL(gsl::narrow_cast<size_t>(lineCount * 3 + 1), narrowScrollback.size());
+    for (int64_t line = 0; line < lineCount; line++)
+    {
+        const auto text = lineText(line);
+        for (size_t part = 0; part < 3; part++)
+        {
+            auto expected = text.substr(part * 12, 12);
+            expected.resize(12, L' ');
+            const auto& row = narrowBuffer.GetRowByAbsoluteIndex(narrowScrollback.GetFirstRow() + line * 3 + part);
+            VERIFY_ARE_EQUAL(expected, row.GetText());
+            VERIFY_ARE_EQUAL(part < 2, row.GetCharRow().WasWrapForced());
+        }
+    }
+    VERIFY_ARE_EQUAL(lastRowText, narrowBuffer.GetRowByAbsoluteIndex(endRow).GetText());
+}
+
+void TextBufferTests::ScrollbackKeepsAbsoluteRowsWhenRewrapFails()
+{
+    TextBuffer buffer({ 10, 4 }, TextAttribute{}, 12, _renderTarget);
+    buffer.SetScrollbackBudget(SIZE_MAX);
+    buffer.SetScrollbackColdThreshold(Scrollback::BlockRows);
+
+    Log::Comment(L"Scroll enough wrapped rows through the buffer that the oldest block is packed.");
+    const int64_t rowCount = Scrollback::BlockRows * 3;
+    for (int64_t row = 0; row < rowCount; row++)
+    {
+        buffer.WriteLine(OutputCellIterator{ std::wstring(10, L'x') }, { 0, 0 }, true);
+        VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+    }
+
+    const auto endRow = buffer.GetFirstAbsoluteRow();
+    VERIFY_ARE_EQUAL(rowCount, endRow);
+    VERIFY_IS_TRUE(buffer._scrollback->_blocks.front().IsPacked());
+
+    Log::Comment(L"Corrupt the packed block, so that rewrapping fails as it unpacks it.");
+    buffer._scrollback->_blocks.front().cellsUsed = 0;
+
+    TextBuffer widerBuffer({ 20, 4 }, TextAttribute{}, 12, _renderTarget);
+    VERIFY_SUCCEEDED(TextBuffer::Reflow(buffer, widerBuffer, std::nullopt, std::nullopt));
+    VERIFY_IS_TRUE(widerBuffer._scrollback->IsRewrapPending());
+    VERIFY_ARE_EQUAL(endRow, widerBuffer.GetFirstAbsoluteRow());
+
+    Log::Comment(L"The rows are dropped, but the absolute rows of the buffer don't go back.");
+    const auto& scrollback = widerBuffer.GetScrollback();
+    VERIFY_IS_FALSE(scrollback.IsRewrapPending());
+    VERIFY_ARE_EQUAL(0u, scrollback.size());
+    VERIFY_ARE_EQUAL(endRow, scrollback.GetEndRow());
+    VERIFY_ARE_EQUAL(endRow, widerBuffer.GetFirstAbsoluteRow());
+
+    Log::Comment(L"Rows that scroll off afterwards continue from there.");
+    VERIFY_IS_TRUE(widerBuffer.IncrementCircularBuffer());
+    VERIFY_ARE_EQUAL(endRow + 1, widerBuffer.GetFirstAbsoluteRow());
+    VERIFY_ARE_EQUAL(endRow, scrollback.GetFirstRow());
+}
+
+void TextBufferTests::ReflowWritesHistoryLazily()
+{
+    const auto lineText = [](const int64_t line) {
+        auto text = std::to_wstring(line);
+        text.resize(15, gsl::narrow_cast<wchar_t>(L'a' + line % 26));
+        return text;
+    };
+    const auto lineAttr = [](const int64_t line) {
+        return TextAttribute{ gsl::narrow_cast<WORD>(line % 0x100) };
+    };
+    const SHORT lineCount = 80;
+    const auto makeBuffer = [&]() {
+        auto buffer = std::make_unique<TextBuffer>(COORD{ 10, 200 }, TextAttribute{}, 12, _renderTarget);
+        for (SHORT line = 0; line < lineCount; line++)
+        {
+            const auto text = lineText(line);
+            buffer->WriteLine(OutputCellIterator{ text.substr(0, 10), lineAttr(line) }, { 0, gsl::narrow_cast<SHORT>(line * 2) }, true);
+            buffer->WriteLine(OutputCellIterator{ text.substr(10), lineAttr(line) }, { 0, gsl::narrow_cast<SHORT>(line * 2 + 1) }, false);
+        }
+        buffer->GetCursor().SetPosition({ 0, lineCount * 2 });
+        return buffer;
+    };
+    const auto verifyLines = [&](const TextBuffer& buffer) {
+        const auto width = gsl::narrow_cast<size_t>(buffer.GetSize().Width());
+        for (SHORT line = 0; line < lineCount; line++)
+        {
+            const auto& row = buffer.GetRowByOffset(line);
+            VERIFY_ARE_EQUAL(lineText(line) + std::wstring(width - 15, L' '), row.GetText());
+            VERIFY_IS_FALSE(row.GetCharRow().WasWrapForced());
+            VERIFY_ARE_EQUAL(lineAttr(line), row.GetAttrRow().GetAttrByColumn(14));
+        }
+        VERIFY_ARE_EQUAL(lineCount, buffer.GetCursor().GetPosition().Y);
+    };
+
+    Log::Comment(L"Only the line above the cursor is reprinted. The lines above it are laid out in segments of 32 lines.");
+    Log::Comment(L"The segment right above the reprinted rows is written, as reprinting looks at the row before it.");
+    auto oldBuffer = makeBuffer();
+    TextBuffer newBuffer({ 20, 200 }, TextAttribute{}, 12, _renderTarget);
+    VERIFY_SUCCEEDED(TextBuffer::Reflow(*oldBuffer, newBuffer, std::nullopt, std::nullopt));
+    VERIFY_IS_NOT_NULL(newBuffer._pendingReflow.get());
+    VERIFY_ARE_EQUAL(2u, newBuffer._pendingReflow->_segments.size());
+    VERIFY_ARE_EQUAL(64, newBuffer._pendingReflow->_segments.back().firstRow + gsl::narrow_cast<int64_t>(newBuffer._pendingReflow->_segments.back().rowCount));
+
+    Log::Comment(L"Asking for a row writes the segment that it's in.");
+    VERIFY_ARE_EQUAL(lineText(40) + std::wstring(5, L' '), newBuffer.GetRowByOffset(40).GetText());
+    VERIFY_ARE_EQUAL(1u, newBuffer._pendingReflow->_segments.size());
+
+    Log::Comment(L"Once the old buffer is handed over, resizing again lays the segments out from its rows.");
+    const auto source = oldBuffer.get();
+    newBuffer.AdoptReflowSource(std::move(oldBuffer));
+    TextBuffer narrowBuffer({ 16, 200 }, TextAttribute{}, 12, _renderTarget);
+    VERIFY_SUCCEEDED(TextBuffer::Reflow(newBuffer, narrowBuffer, std::nullopt, std::nullopt));
+    VERIFY_IS_NOT_NULL(narrowBuffer._pendingReflow.get());
+    VERIFY_ARE_EQUAL(source, narrowBuffer._pendingReflow->_segments.front().source);
+    verifyLines(narrowBuffer);
+    VERIFY_IS_TRUE(narrowBuffer._pendingReflow->empty());
+    verifyLines(newBuffer);
+
+    Log::Comment(L"If the old buffer is destroyed before it's handed over, it writes the rows first.");
+    oldBuffer = makeBuffer();
+    TextBuffer widerBuffer({ 20, 200 }, TextAttribute{}, 12, _renderTarget);
+    VERIFY_SUCCEEDED(TextBuffer::Reflow(*oldBuffer, widerBuffer, std::nullopt, std::nullopt));
+    VERIFY_IS_FALSE(widerBuffer._pendingReflow->empty());
+    oldBuffer.reset();
+    VERIFY_IS_TRUE(widerBuffer._pendingReflow->empty());
+    verifyLines(widerBuffer);
+}
+
+void TextBufferTests::LogicalLinesFollowWrappedRows()
+{
+    TextBuffer buffer({ 10, 6 }, TextAttribute{}, 12, _renderTarget);
+
+    Log::Comment(L"Write a line over rows 1 through 3 and single-row lines around it.");
+    buffer.WriteLine(OutputCellIterator{ L"0" }, { 0, 0 });
+    buffer.WriteLine(OutputCellIterator{ L"aaaaaaaaaa" }, { 0, 1 }, true);
+    buffer.WriteLine(OutputCellIterator{ L"aaaaaaaaaa" }, { 0, 2 }, true);
+    buffer.WriteLine(OutputCellIterator{ L"aa" }, { 0, 3 }, false);
+
+    const auto verifyLine = [&](const size_t row, const size_t firstRow, const size_t rowCount) {
+        const auto line = buffer.GetLogicalLineAt(row);
+        VERIFY_ARE_EQUAL(firstRow, line.firstRow);
+        VERIFY_ARE_EQUAL(rowCount, line.rowCount);
+    };
+    verifyLine(0, 0, 1);
+    verifyLine(1, 1, 3);
+    verifyLine(3, 1, 3);
+    verifyLine(4, 4, 1);
+
+    auto lines = buffer.GetLogicalLines(2, 5);
+    VERIFY_ARE_EQUAL(3u, lines.size());
+    VERIFY_ARE_EQUAL(1u, til::at(lines, 0).firstRow);
+    VERIFY_ARE_EQUAL(3u, til::at(lines, 0).rowCount);
+    VERIFY_ARE_EQUAL(4u, til::at(lines, 1).firstRow);
+    VERIFY_ARE_EQUAL(5u, til::at(lines, 2).firstRow);
+
+    Log::Comment(L"The index follows the rows as the buffer scrolls.");
+    VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+    verifyLine(0, 0, 3);
+    verifyLine(2, 0, 3);
+    verifyLine(3, 3, 1);
+
+    buffer.ScrollRows(0, 3, 2);
+    verifyLine(1, 1, 1);
+    verifyLine(2, 2, 3);
+    verifyLine(4, 2, 3);
+    verifyLine(5, 5, 1);
+
+    Log::Comment(L"Rows that stop wrapping split their line.");
+    buffer.GetRowByOffset(2).GetCharRow().SetWrapForced(false);
+    verifyLine(2, 2, 1);
+    verifyLine(4, 3, 2);
+
+    Log::Comment(L"Resizing keeps the index in step with the rows.");
+    VERIFY_SUCCEEDED(buffer.ResizeTraditional({ 10, 8 }));
+    verifyLine(3, 3, 2);
+    verifyLine(5, 5, 1);
+}
+
+void TextBufferTests::PatternsDontCrossLineBreaks()
+{
+    TextBuffer buffer({ 10, 4 }, TextAttribute{}, 12, _renderTarget);
+    const auto patternId = buffer.AddPatternRecognizer(L"ab+c");
+
+    buffer.WriteLine(OutputCellIterator{ L"xxxxxxxabb" }, { 0, 0 }, true);
+    buffer.WriteLine(OutputCellIterator{ L"bc" }, { 0, 1 }, false);
+    buffer.WriteLine(OutputCellIterator{ L"xxxxxxxxab" }, { 0, 2 }, false);
+    buffer.WriteLine(OutputCellIterator{ L"bc" }, { 0, 3 }, false);
+
+    const auto patterns = buffer.GetPatterns(0, 3);
+    Log::Comment(L"The match over the wrapped row is found, the one over the line break isn't.");
+    const auto found = patterns.findOverlapping(til::point{ 0, 0 }, til::point{ 9, 3 });
+    VERIFY_ARE_EQUAL(1u, found.size());
+    VERIFY_ARE_EQUAL(til::point(7, 0), found.front().start);
+    VERIFY_ARE_EQUAL(til::point(2, 1), found.front().stop);
+    VERIFY_ARE_EQUAL(patternId, found.front().value);
+}
+
+void TextBufferTests::PatternsFollowChangedRows()
+{
+    TextBuffer buffer({ 10, 4 }, TextAttribute{}, 12, _renderTarget);
+    const auto patternId = buffer.AddPatternRecognizer(L"ab+c");
+
+    buffer.WriteLine(OutputCellIterator{ L"abc" }, { 0, 0 }, false);
+    buffer.WriteLine(OutputCellIterator{ L"xx\x4e2d" L"abbc" }, { 0, 2 }, false);
+
+    const auto verifyMatches = [&](const std::vector<std::pair<til::point, til::point>>& expected) {
+        const auto patterns = buffer.GetPatterns(0, 3);
+        auto found = patterns.findOverlapping(til::point{ 0, 0 }, til::point{ 9, 3 });
+        std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) { return a.start < b.start; });
+        VERIFY_ARE_EQUAL(expected.size(), found.size());
+        for (size_t i = 0; i < std::min(expected.size(), found.size()); ++i)
+        {
+            VERIFY_ARE_EQUAL(til::at(expected, i).first, til::at(found, i).start);
+            VERIFY_ARE_EQUAL(til::at(expected, i).second, til::at(found, i).stop);
+            VERIFY_ARE_EQUAL(patternId, til::at(found, i).value);
+        }
+    };
+
+    Log::Comment(L"The positions are in cells, so the wide glyph counts twice.");
+    verifyMatches({ { { 0, 0 }, { 3, 0 } }, { { 4, 2 }, { 8, 2 } } });
+
+    Log::Comment(L"Changing a row finds its patterns again. The other rows keep theirs.");
+    buffer.WriteLine(OutputCellIterator{ L"x" }, { 1, 0 }, false);
+    verifyMatches({ { { 4, 2 }, { 8, 2 } } });
+
+    Log::Comment(L"The matches move up as the buffer scrolls.");
+    VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+    verifyMatches({ { { 4, 1 }, { 8, 1 } } });
+
+    Log::Comment(L"Wrapping a row joins its text to the next row's.");
+    buffer.WriteLine(OutputCellIterator{ L"xxxxxxxxxa" }, { 0, 0 }, true);
+    verifyMatches({ { { 4, 1 }, { 8, 1 } } });
+    buffer.WriteLine(OutputCellIterator{ L"bc" }, { 0, 1 }, false);
+    verifyMatches({ { { 9, 0 }, { 2, 1 } }, { { 4, 1 }, { 8, 1 } } });
+}
+
+void TextBufferTests::WriteAsciiMatchesWrite()
+{
+    const TextAttribute red{ FOREGROUND_RED };
+    const TextAttribute blue{ FOREGROUND_BLUE };
+    TextBuffer expected({ 10, 3 }, TextAttribute{}, 12, _renderTarget);
+    TextBuffer actual({ 10, 3 }, TextAttribute{}, 12, _renderTarget);
+
+    Log::Comment(L"Only the printable ASCII at the start of the text is measured.");
+    VERIFY_ARE_EQUAL(5u, TextBuffer::MeasurePrintableAscii(L"a b~c\x7f"));
+    VERIFY_ARE_EQUAL(2u, TextBuffer::MeasurePrintableAscii(L"ab\r\n"));
+    VERIFY_ARE_EQUAL(0u, TextBuffer::MeasurePrintableAscii(L"\x3042"));
+
+    const auto write = [&](const std::wstring_view text, const COORD target, const TextAttribute& attr) {
+        const OutputCellIterator it{ text, attr };
+        const auto written = expected.WriteLine(it, target, true).GetCellDistance(it);
+        VERIFY_ARE_EQUAL(written, actual.WriteAscii(text, target, attr));
+    };
+
+    Log::Comment(L"Overwrite a wide glyph and a stored glyph, then fill a row up to its end.");
+    for (auto buffer : { &expected, &actual })
+    {
+        buffer->Write(OutputCellIterator{ L"0123456789", blue }, { 0, 0 }, false);
+        buffer->Write(OutputCellIterator{ L"\x3042\xd83d\xde00" }, { 2, 0 }, false);
+    }
+    write(L"abc", { 2, 0 }, red);
+    write(L"lmnopqrstuvwxyz", { 6, 1 }, red);
+    write(L"ab", { 0, 2 }, TextAttribute{});
+
+    for (short y = 0; y < 3; y++)
+    {
+        const auto& expectedRow = expected.GetRowByOffset(y);
+        const auto& actualRow = actual.GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(expectedRow.GetText(), actualRow.GetText());
+        VERIFY_ARE_EQUAL(expectedRow.GetCharRow().WasWrapForced(), actualRow.GetCharRow().WasWrapForced());
+        for (size_t x = 0; x < 10; x++)
+        {
+            VERIFY_ARE_EQUAL(expectedRow.GetAttrRow().GetAttrByColumn(x), actualRow.GetAttrRow().GetAttrByColumn(x));
+            VERIFY_ARE_EQUAL(expectedRow.GetCharRow().DbcsAttrAt(x), actualRow.GetCharRow().DbcsAttrAt(x));
+        }
+    }
+    VERIFY_IS_TRUE(actual.GetRowByOffset(1).GetCharRow().WasWrapForced());
+}
+
+void TextBufferTests::FillCellsMatchesWrite()
+{
+    const TextAttribute red{ FOREGROUND_RED };
+    const TextAttribute blue{ BACKGROUND_BLUE };
+    TextBuffer expected({ 10, 5 }, TextAttribute{}, 12, _renderTarget);
+    TextBuffer actual({ 10, 5 }, TextAttribute{}, 12, _renderTarget);
+
+    for (auto buffer : { &expected, &actual })
+    {
+        for (short y = 0; y < 5; y++)
+        {
+            buffer->Write(OutputCellIterator{ L"a\x3042\xd83d\xde00bcdefg", red }, { 0, y }, true);
+        }
+    }
+
+    Log::Comment(L"Fill part of a row, then from the middle of a row over the next one and part of another.");
+    const auto fill = [&](const wchar_t wch, const TextAttribute& attr, const COORD target, const size_t count, const std::optional<bool> wrap) {
+        const OutputCellIterator it{ wch, attr, count };
+        const auto written = expected.Write(it, target, wrap).GetCellDistance(it);
+        VERIFY_ARE_EQUAL(written, actual.FillCells(wch, attr, target, count, wrap));
+    };
+    fill(L' ', blue, { 2, 0 }, 3, false);
+    fill(L'x', blue, { 5, 1 }, 18, true);
+    fill(L'\x3042', red, { 0, 4 }, 6, false);
+
+    Log::Comment(L"Fill a rectangle, which unwraps the rows it covers.");
+    expected.WriteLine(OutputCellIterator{ L'-', red }, { 3, 3 }, false, 6);
+    actual.FillRect(L'-', red, Viewport::FromInclusive({ 3, 3, 6, 3 }));
+
+    for (short y = 0; y < 5; y++)
+    {
+        const auto& expectedRow = expected.GetRowByOffset(y);
+        const auto& actualRow = actual.GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(expectedRow.GetText(), actualRow.GetText());
+        VERIFY_ARE_EQUAL(expectedRow.GetCharRow().WasWrapForced(), actualRow.GetCharRow().WasWrapForced());
+        for (size_t x = 0; x < 10; x++)
+        {
+            VERIFY_ARE_EQUAL(expectedRow.GetAttrRow().GetAttrByColumn(x), actualRow.GetAttrRow().GetAttrByColumn(x));
+            VERIFY_ARE_EQUAL(expectedRow.GetCharRow().DbcsAttrAt(x), actualRow.GetCharRow().DbcsAttrAt(x));
+        }
+    }
+
+    Log::Comment(L"A row that's filled completely has a single color run.");
+    VERIFY_ARE_EQUAL(1u, actual.GetRowByOffset(2).GetAttrRow().GetNumberOfRuns());
+    VERIFY_IS_TRUE(actual.GetRowByOffset(2).GetCharRow().WasWrapForced());
+    VERIFY_IS_FALSE(actual.GetRowByOffset(3).GetCharRow().WasWrapForced());
+}
+
+void TextBufferTests::RowRevisionsTrackChanges()
+{
+    TextBuffer buffer({ 10, 5 }, TextAttribute{}, 12, _renderTarget);
+    VERIFY_ARE_EQUAL(0u, buffer.GetRevision());
+    VERIFY_IS_TRUE(buffer.GetRowsChangedSince(0, 0, 4).empty());
+
+    Log::Comment(L"Writing and filling change only the rows they touch.");
+    buffer.WriteLine(OutputCellIterator{ L"abc" }, { 0, 1 });
+    buffer.FillCells(L' ', TextAttribute{}, { 5, 3 }, 2);
+    const auto afterWrites = buffer.GetRevision();
+    VERIFY_IS_TRUE((std::vector<size_t>{ 1, 3 }) == buffer.GetRowsChangedSince(0, 0, 4));
+    VERIFY_IS_TRUE((std::vector<size_t>{ 3 }) == buffer.GetRowsChangedSince(0, 2, 4));
+    VERIFY_IS_TRUE(buffer.GetRowsChangedSince(afterWrites, 0, 4).empty());
+
+    Log::Comment(L"Reading rows doesn't change them, changing their wrap status does.");
+    (void)buffer.GetRowByOffset(2).GetCharRow().GetText();
+    buffer.GetRowByOffset(4).GetCharRow().SetWrapForced(true);
+    VERIFY_IS_TRUE((std::vector<size_t>{ 4 }) == buffer.GetRowsChangedSince(afterWrites, 0, 4));
+
+    Log::Comment(L"Scrolling the buffer only changes the new row at the bottom.");
+    const auto beforeScroll = buffer.GetRevision();
+    VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+    VERIFY_IS_TRUE((std::vector<size_t>{ 4 }) == buffer.GetRowsChangedSince(beforeScroll, 0, 4));
+
+    Log::Comment(L"Rows that are scrolled within a region change, since they moved.");
+    const auto beforeRegion = buffer.GetRevision();
+    buffer.ScrollRows(1, 2, 1);
+    VERIFY_IS_TRUE((std::vector<size_t>{ 1, 2, 3 }) == buffer.GetRowsChangedSince(beforeRegion, 0, 4));
+    VERIFY_IS_GREATER_THAN(buffer.GetRevision(), beforeRegion);
+}
+
+void TextBufferTests::SearchIndexFindsEveryMatch()
+{
+    TextBuffer buffer({ 10, 3 }, TextAttribute{}, 12, _renderTarget);
+    buffer.SetScrollbackBudget(SIZE_MAX);
+    buffer.WriteLine(OutputCellIterator{ L"Ab ab" }, { 0, 0 }, false);
+    buffer.WriteLine(OutputCellIterator{ L"xxxxxxxxxa" }, { 0, 1 }, true);
+    buffer.WriteLine(OutputCellIterator{ L"b \x4e2d" }, { 0, 2 }, false);
+
+    SearchIndex index;
+    const auto verifyMatches = [&](const std::vector<std::pair<til::point, til::point>>& expected) {
+        index.Update(buffer);
+        const auto& matches = index.GetMatches();
+        VERIFY_ARE_EQUAL(expected.size(), matches.size());
+        for (size_t i = 0; i < std::min(expected.size(), matches.size()); ++i)
+        {
+            VERIFY_ARE_EQUAL(til::at(expected, i).first, til::at(matches, i).start);
+            VERIFY_ARE_EQUAL(til::at(expected, i).second, til::at(matches, i).end);
+        }
+    };
+
+    Log::Comment(L"Matches are found in any case, and across wrapped rows.");
+    index.SetNeedle(L"ab", false);
+    verifyMatches({ { { 0, 0 }, { 1, 0 } }, { { 3, 0 }, { 4, 0 } }, { { 9, 1 }, { 0, 2 } } });
+
+    Log::Comment(L"Unless the case has to match.");
+    index.SetNeedle(L"ab", true);
+    verifyMatches({ { { 3, 0 }, { 4, 0 } }, { { 9, 1 }, { 0, 2 } } });
+
+    Log::Comment(L"A match ends on the last cell of a wide glyph.");
+    index.SetNeedle(L"b \x4e2d", true);
+    verifyMatches({ { { 0, 2 }, { 3, 2 } } });
+
+    Log::Comment(L"Changing a row finds its matches again.");
+    index.SetNeedle(L"ab", true);
+    buffer.WriteLine(OutputCellIterator{ L"x" }, { 3, 0 }, false);
+    verifyMatches({ { { 9, 1 }, { 0, 2 } } });
+
+    Log::Comment(L"The rows keep their absolute rows as the buffer scrolls, and rows that scroll off are still searched.");
+    buffer.WriteLine(OutputCellIterator{ L"ab" }, { 0, 0 }, false);
+    VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+    buffer.WriteLine(OutputCellIterator{ L"ab" }, { 0, 2 }, false);
+    verifyMatches({ { { 0, 0 }, { 1, 0 } }, { { 9, 1 }, { 0, 2 } }, { { 0, 3 }, { 1, 3 } } });
+
+    Log::Comment(L"The matches in rows that are dropped from the scrollback are dropped too.");
+    buffer.ClearScrollback();
+    verifyMatches({ { { 9, 1 }, { 0, 2 } }, { { 0, 3 }, { 1, 3 } } });
+}
+
+void TextBufferTests::SearchIndexSkipsLinesWithoutTrigrams()
+{
+    TextBuffer buffer({ 10, 3 }, TextAttribute{}, 12, _renderTarget);
+    buffer.SetScrollbackBudget(SIZE_MAX);
+    const std::wstring_view lines[] = { L"one two", L"xxxxxxxxxt", L"hree four", L"two three", L"five", L"six" };
+    for (const auto line : lines)
+    {
+        buffer.WriteLine(OutputCellIterator{ line }, { 0, 2 }, line.size() == 10);
+        VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+    }
+
+    SearchIndex index;
+    Log::Comment(L"Without a budget, nothing is indexed.");
+    VERIFY_IS_FALSE(index.IndexScrollback(buffer, buffer.GetFirstAbsoluteRow(), SIZE_MAX));
+    VERIFY_ARE_EQUAL(0u, index._trigrams.GetUsage());
+
+    index.SetTrigramBudget(SIZE_MAX);
+    Log::Comment(L"The scrollback is indexed a slice at a time.");
+    VERIFY_IS_TRUE(index.IndexScrollback(buffer, buffer.GetFirstAbsoluteRow(), 2));
+    VERIFY_IS_FALSE(index.IndexScrollback(buffer, buffer.GetFirstAbsoluteRow(), SIZE_MAX));
+    VERIFY_IS_GREATER_THAN(index._trigrams.GetUsage(), 0u);
+
+    const auto verifyMatches = [&](const std::vector<std::pair<til::point, til::point>>& expected) {
+        index.Update(buffer);
+        const auto& matches = index.GetMatches();
+        VERIFY_ARE_EQUAL(expected.size(), matches.size());
+        for (size_t i = 0; i < std::min(expected.size(), matches.size()); ++i)
+        {
+            VERIFY_ARE_EQUAL(til::at(expected, i).first, til::at(matches, i).start);
+            VERIFY_ARE_EQUAL(til::at(expected, i).second, til::at(matches, i).end);
+        }
+    };
+
+    Log::Comment(L"The indexed lines are found like any others, across wrapped rows too.");
+    index.SetNeedle(L"three", true);
+    verifyMatches({ { { 9, 3 }, { 3, 4 } }, { { 4, 5 }, { 8, 5 } } });
+    index.SetNeedle(L"TWO", false);
+    verifyMatches({ { { 4, 2 }, { 6, 2 } }, { { 0, 5 }, { 2, 5 } } });
+
+    Log::Comment(L"Dropping rows from the scrollback drops the index, until it's built again.");
+    buffer.ClearScrollback();
+    VERIFY_IS_FALSE(index.IndexScrollback(buffer, buffer.GetFirstAbsoluteRow(), SIZE_MAX));
+    VERIFY_ARE_EQUAL(0u, index._trigrams.GetUsage());
+    verifyMatches({});
+}
+
+void TextBufferTests::SearchIndexCoversBufferHistory()
+{
+    TextBuffer buffer({ 10, 6 }, TextAttribute{}, 12, _renderTarget);
+    const std::array<std::wstring_view, 5> lines{ L"one two", L"xxxxxxxxxt", L"hree four", L"two three", L"five" };
+    for (SHORT row = 0; row < 5; row++)
+    {
+        buffer.WriteLine(OutputCellIterator{ til::at(lines, row) }, { 0, row }, til::at(lines, row).size() == 10);
+    }
+
+    SearchIndex index;
+    index.SetTrigramBudget(SIZE_MAX);
+    const auto verifyMatches = [&](const std::vector<std::pair<til::point, til::point>>& expected) {
+        index.Update(buffer);
+        const auto& matches = index.GetMatches();
+        VERIFY_ARE_EQUAL(expected.size(), matches.size());
+        for (size_t i = 0; i < std::min(expected.size(), matches.size()); ++i)
+        {
+            VERIFY_ARE_EQUAL(til::at(expected, i).first, til::at(matches, i).start);
+            VERIFY_ARE_EQUAL(til::at(expected, i).second, til::at(matches, i).end);
+        }
+    };
+
+    Log::Comment(L"Without any scrollback, the rows above the viewport are indexed.");
+    VERIFY_IS_FALSE(index.IndexScrollback(buffer, 4, SIZE_MAX));
+    VERIFY_ARE_EQUAL(3u, index._trigrams.size());
+    VERIFY_ARE_EQUAL(4, index._trigrams.GetEndRow());
+
+    Log::Comment(L"Only the indexed lines that might contain the term are searched, and the rows below them as usual.");
+    index.SetNeedle(L"three", true);
+    verifyMatches({ { { 9, 1 }, { 3, 2 } }, { { 4, 3 }, { 8, 3 } } });
+    buffer.WriteLine(OutputCellIterator{ L"three" }, { 0, 4 });
+    verifyMatches({ { { 9, 1 }, { 3, 2 } }, { { 4, 3 }, { 8, 3 } }, { { 0, 4 }, { 4, 4 } } });
+
+    Log::Comment(L"Changing a row of an indexed line drops the index.");
+    buffer.WriteLine(OutputCellIterator{ L"three" }, { 0, 0 });
+    verifyMatches({ { { 0, 0 }, { 4, 0 } }, { { 9, 1 }, { 3, 2 } }, { { 4, 3 }, { 8, 3 } }, { { 0, 4 }, { 4, 4 } } });
+    VERIFY_ARE_EQUAL(0u, index._trigrams.size());
+
+    Log::Comment(L"Rows that scroll off drop the lines they start, without dropping the rest.");
+    VERIFY_IS_FALSE(index.IndexScrollback(buffer, 4, SIZE_MAX));
+    VERIFY_ARE_EQUAL(3u, index._trigrams.size());
+    VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+    verifyMatches({ { { 9, 1 }, { 3, 2 } }, { { 4, 3 }, { 8, 3 } }, { { 0, 4 }, { 4, 4 } } });
+    VERIFY_ARE_EQUAL(2u, index._trigrams.size());
+    VERIFY_ARE_EQUAL(1, index._trigrams.GetFirstRow());
+}
+
 // This tests that when buffer storage rows are rotated around during a resize traditional operation,
-// that the Unicode Storage-held high unicode items like emoji rotate properly with it.
+// that the high unicode items like emoji that the rows store rotate properly with them.
 void TextBufferTests::ResizeTraditionalRotationPreservesHighUnicode()
 {
     // Set up a text buffer for us
@@ -1854,7 +2728,7 @@ void TextBufferTests::ResizeTraditionalRotationPreservesHighUnicode()
     VERIFY_ARE_EQUAL(String(bButton), String(readBackText.data(), gsl::narrow<int>(readBackText.size())));
 
     // Make it the first row in the buffer so it will rotate around when we resize and cause renumbering
-    const SHORT delta = _buffer->GetFirstRowIndex() - pos.Y;
+    const SHORT delta = gsl::narrow<SHORT>(_buffer->GetFirstRowIndex()) - pos.Y;
     const COORD newPos{ pos.X, pos.Y + delta };
 
     _buffer->_SetFirstRowIndex(pos.Y);
@@ -1871,7 +2745,7 @@ void TextBufferTests::ResizeTraditionalRotationPreservesHighUnicode()
 }
 
 // This tests that when buffer storage rows are rotated around during a scroll buffer operation,
-// that the Unicode Storage-held high unicode items like emoji rotate properly with it.
+// that the high unicode items like emoji that the rows store rotate properly with them.
 void TextBufferTests::ScrollBufferRotationPreservesHighUnicode()
 {
     // Set up a text buffer for us
@@ -1911,7 +2785,7 @@ void TextBufferTests::ScrollBufferRotationPreservesHighUnicode()
 }
 
 // This tests that rows removed from the buffer while resizing traditionally will also drop the high unicode
-// characters from the Unicode Storage buffer
+// characters that they stored
 void TextBufferTests::ResizeTraditionalHighUnicodeRowRemoval()
 {
     // Set up a text buffer for us
@@ -1935,18 +2809,21 @@ void TextBufferTests::ResizeTraditionalHighUnicodeRowRemoval()
     const auto readBackText = *readBack;
     VERIFY_ARE_EQUAL(String(emoji), String(readBackText.data(), gsl::narrow<int>(readBackText.size())));
 
-    VERIFY_ARE_EQUAL(1u, _buffer->GetUnicodeStorage()._map.size(), L"There should be one item in the map.");
+    VERIFY_ARE_EQUAL(1u, _buffer->_storage[pos.Y].GetCharRow()._storedGlyphs.size(), L"The row should store one glyph.");
 
     // Perform resize to trim off the row of the buffer that included the emoji
     COORD trimmedBufferSize{ bufferSize.X, bufferSize.Y - 1 };
 
     VERIFY_NT_SUCCESS(_buffer->ResizeTraditional(trimmedBufferSize));
 
-    VERIFY_IS_TRUE(_buffer->GetUnicodeStorage()._map.empty(), L"The map should now be empty.");
+    for (const auto& row : _buffer->_storage)
+    {
+        VERIFY_IS_TRUE(row.GetCharRow()._storedGlyphs.empty(), L"No row should store a glyph now.");
+    }
 }
 
 // This tests that columns removed from the buffer while resizing traditionally will also drop the high unicode
-// characters from the Unicode Storage buffer
+// characters that their rows stored
 void TextBufferTests::ResizeTraditionalHighUnicodeColumnRemoval()
 {
     // Set up a text buffer for us
@@ -1970,14 +2847,52 @@ void TextBufferTests::ResizeTraditionalHighUnicodeColumnRemoval()
     const auto readBackText = *readBack;
     VERIFY_ARE_EQUAL(String(emoji), String(readBackText.data(), gsl::narrow<int>(readBackText.size())));
 
-    VERIFY_ARE_EQUAL(1u, _buffer->GetUnicodeStorage()._map.size(), L"There should be one item in the map.");
+    VERIFY_ARE_EQUAL(1u, _buffer->_storage[pos.Y].GetCharRow()._storedGlyphs.size(), L"The row should store one glyph.");
 
     // Perform resize to trim off the column of the buffer that included the emoji
     COORD trimmedBufferSize{ bufferSize.X - 1, bufferSize.Y };
 
     VERIFY_NT_SUCCESS(_buffer->ResizeTraditional(trimmedBufferSize));
 
-    VERIFY_IS_TRUE(_buffer->GetUnicodeStorage()._map.empty(), L"The map should now be empty.");
+    VERIFY_IS_TRUE(_buffer->_storage[pos.Y].GetCharRow()._storedGlyphs.empty(), L"The row shouldn't store a glyph now.");
+}
+
+// This tests that overwriting high unicode characters over and over again doesn't grow the glyphs that the row
+// stores without bound, and that the glyphs still in the row survive the cleanup
+void TextBufferTests::ResizeTraditionalHighUnicodeOverwrite()
+{
+    // Set up a text buffer for us
+    const COORD bufferSize{ 10, 2 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    auto& charRow = _buffer->_storage[0].GetCharRow();
+
+    // This is the peach emoji: 🍑
+    const auto peach = L"\xD83C\xDF51";
+    charRow.GlyphAt(0) = peach;
+
+    // This is the eggplant emoji: 🍆
+    const auto eggplant = L"\xD83C\xDF46";
+    const size_t maxStoredGlyphs = 2 * bufferSize.X;
+    for (auto i = 0; i < 100; ++i)
+    {
+        charRow.GlyphAt(1) = eggplant;
+        VERIFY_IS_LESS_THAN_OR_EQUAL(charRow._storedGlyphs.size(), maxStoredGlyphs);
+    }
+
+    const auto peachText = *_buffer->GetTextDataAt({ 0, 0 });
+    VERIFY_ARE_EQUAL(String(peach), String(peachText.data(), gsl::narrow<int>(peachText.size())));
+    const auto eggplantText = *_buffer->GetTextDataAt({ 1, 0 });
+    VERIFY_ARE_EQUAL(String(eggplant), String(eggplantText.data(), gsl::narrow<int>(eggplantText.size())));
+
+    // Once the eggplant is overwritten with a plain character, compacting the table drops it.
+    charRow.GlyphAt(1) = L"x";
+    VERIFY_NT_SUCCESS(_buffer->ResizeTraditional(bufferSize));
+    VERIFY_ARE_EQUAL(1u, _buffer->_storage[0].GetCharRow()._storedGlyphs.size());
+    const auto xText = *_buffer->GetTextDataAt({ 1, 0 });
+    VERIFY_ARE_EQUAL(String(L"x"), String(xText.data(), gsl::narrow<int>(xText.size())));
 }
 
 void TextBufferTests::TestBurrito()
@@ -2529,6 +3444,156 @@ void TextBufferTests::GetText()
     }
 }
 
+void TextBufferTests::SerializeWritesEveryFormat()
+{
+    TextBuffer buffer({ 10, 3 }, TextAttribute{}, 12, _renderTarget);
+    buffer.WriteLine(OutputCellIterator{ L"a<b ", TextAttribute{ 0x1f } }, { 0, 0 }, false);
+    buffer.WriteLine(OutputCellIterator{ L"c{d}", TextAttribute{ 0x2f } }, { 0, 1 }, false);
+    const auto textRects = buffer.GetTextRects({ 0, 0 }, { 4, 1 });
+
+    const auto GetAttributeColors = [](const TextAttribute& attr) {
+        const auto foreground = attr.GetLegacyAttributes() == 0x1f ? RGB(0xff, 0, 0) : RGB(0, 0xff, 0);
+        return std::pair<COLORREF, COLORREF>{ foreground, RGB(0, 0, 0xff) };
+    };
+
+    std::wstring text;
+    std::string html;
+    std::string rtf;
+    PlainTextWriter textWriter{ [&](const std::wstring_view chunk) { text.append(chunk); }, true };
+    HtmlWriter htmlWriter{ [&](const std::string_view chunk) { html.append(chunk); }, 12, L"Consolas", RGB(0, 0, 0), true };
+    RtfWriter rtfWriter{ [&](const std::string_view chunk) { rtf.append(chunk); }, 12, L"Consolas", RGB(0, 0, 0) };
+    TextSerializer serializer{ true, GetAttributeColors, { &textWriter, &htmlWriter, &rtfWriter } };
+    buffer.Serialize(textRects, serializer);
+    htmlWriter.FillClipboardHeader(html);
+
+    Log::Comment(L"Every writer gets the same text, with the trailing whitespace trimmed.");
+    VERIFY_ARE_EQUAL(std::wstring{ L"a<b\r\nc{d}" }, text);
+
+    Log::Comment(L"The HTML has a span for every change of color, and the offsets of the fragment in its header.");
+    VERIFY_ARE_NOT_EQUAL(std::string::npos, html.find("<SPAN STYLE=\"color:#FF0000;background-color:#0000FF;\">a&lt;b<BR></SPAN>"
+                                                      "<SPAN STYLE=\"color:#00FF00;background-color:#0000FF;\">c{d}</SPAN></DIV>"));
+    VERIFY_ARE_EQUAL(0u, html.find("Version:0.9\r\nStartHTML:0000000157\r\n"));
+    VERIFY_ARE_NOT_EQUAL(std::string::npos, html.find(fmt::format("EndHTML:{:010}\r\n", html.size())));
+
+    Log::Comment(L"The RTF has every color in its table, and a change of color for every run.");
+    VERIFY_ARE_NOT_EQUAL(std::string::npos, rtf.find("{\\colortbl ;\\red0\\green0\\blue0;\\red0\\green0\\blue255;\\red255\\green0\\blue0;\\red0\\green255\\blue0;}"));
+    VERIFY_ARE_NOT_EQUAL(std::string::npos, rtf.find("\\highlight2\\cf3 a<b\\line \\highlight2\\cf4 c\\{d\\}}"));
+}
+
+void TextBufferTests::ExportWritesEveryRow()
+{
+    TextBuffer buffer({ 10, 3 }, TextAttribute{}, 12, _renderTarget);
+    buffer.SetScrollbackBudget(SIZE_MAX);
+
+    TextAttribute red{};
+    red.SetIndexedForeground(FOREGROUND_RED);
+    red.SetBold(true);
+    TextAttribute rgb{};
+    rgb.SetBackground(RGB(1, 2, 3));
+
+    Log::Comment(L"Write more rows than fit in the buffer, so that the first ones go to the scrollback.");
+    auto& cursor = buffer.GetCursor();
+    for (auto i = 0; i < 5; ++i)
+    {
+        const auto text = L"row" + std::to_wstring(i);
+        buffer.WriteLine(OutputCellIterator{ text, i % 2 == 0 ? red : rgb }, { 0, cursor.GetPosition().Y }, false);
+        if (cursor.GetPosition().Y == 2)
+        {
+            buffer.IncrementCircularBuffer();
+        }
+        else
+        {
+            cursor.SetYPosition(cursor.GetPosition().Y + 1);
+        }
+    }
+
+    wchar_t directory[MAX_PATH + 1];
+    wchar_t path[MAX_PATH + 1];
+    VERIFY_ARE_NOT_EQUAL(0u, GetTempPathW(ARRAYSIZE(directory), directory));
+    VERIFY_ARE_NOT_EQUAL(0u, GetTempFileNameW(directory, L"exp", 0, path));
+    auto deleteFile = wil::scope_exit([&]() { DeleteFileW(path); });
+
+    const auto readFile = [&]() {
+        std::ifstream file{ path, std::ios::binary };
+        return std::string{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+    };
+
+    const auto GetAttributeColors = [](const TextAttribute&) {
+        return std::pair<COLORREF, COLORREF>{ RGB(0xff, 0xff, 0xff), RGB(0, 0, 0) };
+    };
+
+    Log::Comment(L"The plain text has every row, from the oldest one in the scrollback.");
+    buffer.ExportToFile(path, TextExportFormat::PlainText, GetAttributeColors, 12, L"Consolas", RGB(0, 0, 0));
+    VERIFY_ARE_EQUAL(std::string{ "row0\r\nrow1\r\nrow2\r\nrow3\r\nrow4" }, readFile());
+
+    Log::Comment(L"The VT has a SGR sequence for every change of attributes, with the colors in the xterm order.");
+    buffer.ExportToFile(path, TextExportFormat::Vt, GetAttributeColors, 12, L"Consolas", RGB(0, 0, 0));
+    VERIFY_ARE_EQUAL(std::string{ "\x1b[0;1;31mrow0\r\n"
+                                  "\x1b[0;48;2;1;2;3mrow1\r\n"
+                                  "\x1b[0;1;31mrow2\r\n"
+                                  "\x1b[0;48;2;1;2;3mrow3\r\n"
+                                  "\x1b[0;1;31mrow4\x1b[0m" },
+                      readFile());
+
+    Log::Comment(L"The HTML is a whole document, without the clipboard header.");
+    buffer.ExportToFile(path, TextExportFormat::Html, GetAttributeColors, 12, L"Consolas", RGB(0, 0, 0));
+    const auto html = readFile();
+    VERIFY_ARE_EQUAL(0u, html.find("<!DOCTYPE><HTML>"));
+    VERIFY_ARE_NOT_EQUAL(std::string::npos, html.find(">row0<BR>row1<BR>row2<BR>row3<BR>row4</SPAN></DIV>"));
+}
+
+void TextBufferTests::ExportSkipsRowsDroppedBetweenChunks()
+{
+    constexpr SHORT rowCount = 300;
+    constexpr auto droppedRows = TextBufferExport::ChunkRows + 14;
+    TextBuffer buffer({ 10, rowCount }, TextAttribute{}, 12, _renderTarget);
+    buffer.SetScrollbackBudget(0);
+    for (SHORT i = 0; i < rowCount; ++i)
+    {
+        buffer.WriteLine(OutputCellIterator{ L"row" + std::to_wstring(i) }, { 0, i }, false);
+    }
+
+    wchar_t directory[MAX_PATH + 1];
+    wchar_t path[MAX_PATH + 1];
+    VERIFY_ARE_NOT_EQUAL(0u, GetTempPathW(ARRAYSIZE(directory), directory));
+    VERIFY_ARE_NOT_EQUAL(0u, GetTempFileNameW(directory, L"exp", 0, path));
+    auto deleteFile = wil::scope_exit([&]() { DeleteFileW(path); });
+
+    const auto GetAttributeColors = [](const TextAttribute&) {
+        return std::pair<COLORREF, COLORREF>{ RGB(0xff, 0xff, 0xff), RGB(0, 0, 0) };
+    };
+
+    {
+        TextBufferExport exporter{ path, TextExportFormat::PlainText, 12, L"Consolas", RGB(0, 0, 0) };
+
+        Log::Comment(L"The first chunk is copied, then output scrolls the rows after it out of the buffer.");
+        VERIFY_IS_TRUE(exporter.CopyRows(buffer, GetAttributeColors));
+        for (size_t i = 0; i < droppedRows; ++i)
+        {
+            buffer.IncrementCircularBuffer();
+        }
+        VERIFY_ARE_EQUAL(gsl::narrow_cast<int64_t>(droppedRows), buffer.GetScrollback().GetFirstRow());
+        exporter.WriteRows();
+
+        Log::Comment(L"The export carries on from the first row that's left, and stops at the row that was last when it started.");
+        VERIFY_IS_TRUE(exporter.CopyRows(buffer, GetAttributeColors));
+        exporter.WriteRows();
+        VERIFY_IS_FALSE(exporter.CopyRows(buffer, GetAttributeColors));
+        exporter.Finish();
+    }
+
+    std::string expected;
+    for (size_t i = 0; i < rowCount; ++i)
+    {
+        if (i < TextBufferExport::ChunkRows || i >= droppedRows)
+        {
+            expected += (expected.empty() ? "row" : "\r\nrow") + std::to_string(i);
+        }
+    }
+    std::ifstream file{ path, std::ios::binary };
+    VERIFY_ARE_EQUAL(expected, (std::string{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} }));
+}
+
 // This tests that when we increment the circular buffer, obsolete hyperlink references
 // are removed from the hyperlink map
 void TextBufferTests::HyperlinkTrim()
@@ -406,6 +406,11 @@ public:
     {
         return {};
     }
+
+    std::vector<Microsoft::Console::Types::Viewport> GetSearchHighlightRects() noexcept override
+    {
+        return {};
+    }
 };
 
 void VtIoTests::RendererDtorAndThread()
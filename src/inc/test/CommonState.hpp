@@ -203,7 +203,8 @@ public:
         for (SHORT iRow = 0; iRow < cRowsToFill; iRow++)
         {
             ROW& row = textBuffer.GetRowByOffset(iRow);
-            FillRow(&row);
+            // odd rows forced a wrap
+            FillRow(&row, iRow % 2 != 0);
         }
 
         textBuffer.GetCursor().SetYPosition(cRowsToFill);
@@ -240,7 +241,7 @@ private:
     std::unique_ptr<TextBuffer> m_backupTextBufferInfo;
     std::unique_ptr<INPUT_READ_HANDLE_DATA> m_readHandle;
 
-    void FillRow(ROW* pRow)
+    void FillRow(ROW* pRow, const bool wrapForced)
     {
         // fill a row
         // 9 characters, 6 spaces. 15 total
@@ -286,15 +287,7 @@ private:
         Attr = TextAttribute(BACKGROUND_GREEN);
         pRow->GetAttrRow().SetAttrToEnd(7, Attr);
 
-        // odd rows forced a wrap
-        if (pRow->GetId() % 2 != 0)
-        {
-            pRow->GetCharRow().SetWrapForced(true);
-        }
-        else
-        {
-            pRow->GetCharRow().SetWrapForced(false);
-        }
+        pRow->GetCharRow().SetWrapForced(wrapForced);
     }
 
     void FillBisect(ROW* pRow)
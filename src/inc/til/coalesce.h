@@ -18,7 +18,7 @@ namespace til
     template<typename T>
     T coalesce_value(const std::optional<T>& base)
     {
-        static_assert(false, "coalesce_value must be passed a base non-optional value to be used if all optionals are empty");
+        static_assert(!std::is_same_v<T, T>, "coalesce_value must be passed a base non-optional value to be used if all optionals are empty");
         return T{};
     }
 
@@ -469,7 +469,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
 #pragma region RECTANGLE VS SIZE
         // ADD will grow the total area of the rectangle. The sign is the direction to grow.
-        rectangle operator+(const size& size) const
+        rectangle operator+(const til::size& size) const
         {
             // Fetch the pieces of the rectangle.
             auto l = left();
@@ -554,14 +554,14 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             return rectangle{ til::point{ l, t }, til::point{ r, b } };
         }
 
-        rectangle& operator+=(const size& size)
+        rectangle& operator+=(const til::size& size)
         {
             *this = *this + size;
             return *this;
         }
 
         // SUB will shrink the total area of the rectangle. The sign is the direction to shrink.
-        rectangle operator-(const size& size) const
+        rectangle operator-(const til::size& size) const
         {
             // Fetch the pieces of the rectangle.
             auto l = left();
@@ -642,7 +642,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             return rectangle{ til::point{ l, t }, til::point{ r, b } };
         }
 
-        rectangle& operator-=(const size& size)
+        rectangle& operator-=(const til::size& size)
         {
             *this = *this - size;
             return *this;
@@ -650,7 +650,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
         // scale_up will scale the entire rectangle up by the size factor
         // This includes moving the origin.
-        rectangle scale_up(const size& size) const
+        rectangle scale_up(const til::size& size) const
         {
             const auto topLeft = _topLeft * size;
             const auto bottomRight = _bottomRight * size;
@@ -660,7 +660,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
         // scale_down will scale the entire rectangle down by the size factor,
         // but rounds the bottom-right corner out.
         // This includes moving the origin.
-        rectangle scale_down(const size& size) const
+        rectangle scale_down(const til::size& size) const
         {
             auto topLeft = _topLeft;
             auto bottomRight = _bottomRight;
@@ -769,7 +769,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             return _topLeft;
         }
 
-        size size() const
+        til::size size() const
         {
             return til::size{ width(), height() };
         }
@@ -12,6 +12,9 @@
 #define _TIL_SPSC_DETAIL_POSITION_IMPL_WIN 1
 #elif __linux__
 #define _TIL_SPSC_DETAIL_POSITION_IMPL_LINUX 1
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #else
 #define _TIL_SPSC_DETAIL_POSITION_IMPL_FALLBACK 1
 #endif
@@ -412,7 +415,7 @@ namespace til::spsc
         explicit producer(details::arc<T>* arc) noexcept :
             _arc(arc) {}
 
-        producer<T>(const producer<T>&) = delete;
+        producer(const producer<T>&) = delete;
         producer<T>& operator=(const producer<T>&) = delete;
 
         producer(producer<T>&& other) noexcept
@@ -530,7 +533,7 @@ namespace til::spsc
         explicit consumer(details::arc<T>* arc) noexcept :
             _arc(arc) {}
 
-        consumer<T>(const consumer<T>&) = delete;
+        consumer(const consumer<T>&) = delete;
         consumer<T>& operator=(const consumer<T>&) = delete;
 
         consumer(consumer<T>&& other) noexcept
@@ -220,29 +220,40 @@ void Clipboard::StoreSelectionToClipboard(bool const copyFormatting)
         includeCRLF = trimTrailingWhitespace = true;
     }
 
-    const auto text = buffer.GetText(includeCRLF,
-                                     trimTrailingWhitespace,
-                                     selectionRects,
-                                     GetAttributeColors);
+    const auto& fontData = gci.GetActiveOutputBuffer().GetCurrentFont();
+    int const iFontHeightPoints = fontData.GetUnscaledSize().Y * 72 / ServiceLocator::LocateGlobals().dpi;
+    const COLORREF bgColor = gci.GetDefaultBackground();
+
+    // Write the text and its formats out in one pass over the selection.
+    std::wstring text;
+    std::string html;
+    std::string rtf;
+    PlainTextWriter textWriter{ [&](const std::wstring_view chunk) { text.append(chunk); }, includeCRLF };
+    HtmlWriter htmlWriter{ [&](const std::string_view chunk) { html.append(chunk); }, iFontHeightPoints, fontData.GetFaceName(), bgColor, true };
+    RtfWriter rtfWriter{ [&](const std::string_view chunk) { rtf.append(chunk); }, iFontHeightPoints, fontData.GetFaceName(), bgColor };
+    if (copyFormatting)
+    {
+        TextSerializer serializer{ trimTrailingWhitespace, GetAttributeColors, { &textWriter, &htmlWriter, &rtfWriter } };
+        buffer.Serialize(selectionRects, serializer);
+        htmlWriter.FillClipboardHeader(html);
+    }
+    else
+    {
+        TextSerializer serializer{ trimTrailingWhitespace, GetAttributeColors, { &textWriter } };
+        buffer.Serialize(selectionRects, serializer);
+    }
 
-    CopyTextToSystemClipboard(text, copyFormatting);
+    CopyTextToSystemClipboard(text, html, rtf);
 }
 
 // Routine Description:
 // - Copies the text given onto the global system clipboard.
 // Arguments:
-// - rows - Rows of text data to copy
-// - fAlsoCopyFormatting - true if the color and formatting should also be copied, false otherwise
-void Clipboard::CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows, bool const fAlsoCopyFormatting)
+// - finalString - The text to copy
+// - html - The text in the HTML format. If empty, it isn't copied
+// - rtf - The text in the RTF format. If empty, it isn't copied
+void Clipboard::CopyTextToSystemClipboard(const std::wstring& finalString, const std::string& html, const std::string& rtf)
 {
-    std::wstring finalString;
-
-    // Concatenate strings into one giant string to put onto the clipboard.
-    for (const auto& str : rows.text)
-    {
-        finalString += str;
-    }
-
     // allocate the final clipboard data
     const size_t cchNeeded = finalString.size() + 1;
     const size_t cbNeeded = sizeof(wchar_t) * cchNeeded;
@@ -269,17 +280,14 @@ void Clipboard::CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows,
         THROW_LAST_ERROR_IF(!EmptyClipboard());
         THROW_LAST_ERROR_IF_NULL(SetClipboardData(CF_UNICODETEXT, globalHandle.get()));
 
-        if (fAlsoCopyFormatting)
+        if (!html.empty())
         {
-            const auto& fontData = ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetCurrentFont();
-            int const iFontHeightPoints = fontData.GetUnscaledSize().Y * 72 / ServiceLocator::LocateGlobals().dpi;
-            const COLORREF bgColor = ServiceLocator::LocateGlobals().getConsoleInformation().GetDefaultBackground();
-
-            std::string HTMLToPlaceOnClip = TextBuffer::GenHTML(rows, iFontHeightPoints, fontData.GetFaceName(), bgColor);
-            CopyToSystemClipboard(HTMLToPlaceOnClip, L"HTML Format");
+            CopyToSystemClipboard(html, L"HTML Format");
+        }
 
-            std::string RTFToPlaceOnClip = TextBuffer::GenRTF(rows, iFontHeightPoints, fontData.GetFaceName(), bgColor);
-            CopyToSystemClipboard(RTFToPlaceOnClip, L"Rich Text Format");
+        if (!rtf.empty())
+        {
+            CopyToSystemClipboard(rtf, L"Rich Text Format");
         }
     }
 
@@ -0,0 +1,160 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "export.h"
+#include "resource.h"
+#include "window.hpp"
+
+#include "..\..\buffer\out\TextBufferExport.hpp"
+#include "..\..\host\handle.h"
+
+#include "..\inc\ServiceLocator.hpp"
+
+#pragma hdrstop
+
+using namespace Microsoft::Console::Interactivity;
+
+// Routine Description:
+// - Writes the active screen buffer out through an export, a chunk of rows at
+//   a time. The console is only locked while a chunk is copied, not while
+//   it's written to the file, so output carries on while a large buffer is
+//   exported. If another screen buffer is made active in the meantime, the
+//   export ends where it is.
+// Arguments:
+// - lpParameter - The export, with its file created. The thread frees it.
+// Return Value:
+// - 0
+static DWORD WINAPI ExportThreadProc(LPVOID lpParameter)
+{
+    std::unique_ptr<TextBufferExport> exporter{ static_cast<TextBufferExport*>(lpParameter) };
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    const auto GetAttributeColors = std::bind(&CONSOLE_INFORMATION::LookupAttributeColors, &gci, std::placeholders::_1);
+
+    try
+    {
+        const SCREEN_INFORMATION* screenInfo = nullptr;
+        auto copied = false;
+        do
+        {
+            {
+                LockConsole();
+                auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+
+                const SCREEN_INFORMATION& activeScreenInfo = gci.GetActiveOutputBuffer().GetMainBuffer();
+                if (screenInfo == nullptr)
+                {
+                    screenInfo = &activeScreenInfo;
+                }
+                copied = screenInfo == &activeScreenInfo && exporter->CopyRows(activeScreenInfo.GetTextBuffer(), GetAttributeColors);
+            }
+            exporter->WriteRows();
+        } while (copied);
+        exporter->Finish();
+    }
+    CATCH_LOG();
+    return 0;
+}
+
+INT_PTR CALLBACK ExportDialogProc(HWND hWnd, UINT Message, WPARAM wParam, LPARAM lParam)
+{
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    // The path and the format that were used the last time, so that the
+    // next time the dialog is opened, it defaults to them.
+    static std::wstring lastExportPath;
+    static int lastExportFormat = ID_CONSOLE_EXPORTTEXT;
+
+    switch (Message)
+    {
+    case WM_INITDIALOG:
+        SetWindowLongPtrW(hWnd, DWLP_USER, lParam);
+        CheckRadioButton(hWnd, ID_CONSOLE_EXPORTTEXT, ID_CONSOLE_EXPORTHTML, lastExportFormat);
+        SetDlgItemText(hWnd, ID_CONSOLE_EXPORTPATH, lastExportPath.c_str());
+        return TRUE;
+    case WM_COMMAND:
+    {
+        switch (LOWORD(wParam))
+        {
+        case IDOK:
+        {
+            std::wstring path(GetWindowTextLengthW(GetDlgItem(hWnd, ID_CONSOLE_EXPORTPATH)) + 1, UNICODE_NULL);
+            path.resize(GetDlgItemTextW(hWnd, ID_CONSOLE_EXPORTPATH, path.data(), gsl::narrow_cast<int>(path.size())));
+            if (path.empty())
+            {
+                break;
+            }
+
+            TextExportFormat format;
+            if (IsDlgButtonChecked(hWnd, ID_CONSOLE_EXPORTVT))
+            {
+                lastExportFormat = ID_CONSOLE_EXPORTVT;
+                format = TextExportFormat::Vt;
+            }
+            else if (IsDlgButtonChecked(hWnd, ID_CONSOLE_EXPORTHTML))
+            {
+                lastExportFormat = ID_CONSOLE_EXPORTHTML;
+                format = TextExportFormat::Html;
+            }
+            else
+            {
+                lastExportFormat = ID_CONSOLE_EXPORTTEXT;
+                format = TextExportFormat::PlainText;
+            }
+            lastExportPath = path;
+
+            LockConsole();
+            auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+
+            SCREEN_INFORMATION& ScreenInfo = gci.GetActiveOutputBuffer();
+            try
+            {
+                const auto& fontData = ScreenInfo.GetCurrentFont();
+                int const iFontHeightPoints = fontData.GetUnscaledSize().Y * 72 / ServiceLocator::LocateGlobals().dpi;
+
+                // The file is created here, so that a path that can't be written
+                // to is reported right away. The rows are written out by a
+                // thread of their own, which takes the export over.
+                auto exporter = std::make_unique<TextBufferExport>(path, format, iFontHeightPoints, fontData.GetFaceName(), gci.GetDefaultBackground());
+                wil::unique_handle hThread{ CreateThread(nullptr, 0, ExportThreadProc, exporter.get(), 0, nullptr) };
+                THROW_LAST_ERROR_IF(!hThread);
+                exporter.release();
+            }
+            catch (...)
+            {
+                // The file couldn't be created. Leave the dialog open, so that another path can be tried.
+                LOG_CAUGHT_EXCEPTION();
+                ScreenInfo.SendNotifyBeep();
+                break;
+            }
+
+            EndDialog(hWnd, 0);
+            return TRUE;
+        }
+        case IDCANCEL:
+            EndDialog(hWnd, 0);
+            return TRUE;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return FALSE;
+}
+
+void DoExport()
+{
+    Globals& g = ServiceLocator::LocateGlobals();
+    Microsoft::Console::Types::IConsoleWindow* const pWindow = ServiceLocator::LocateConsoleWindow();
+
+    UnlockConsole();
+    if (pWindow != nullptr)
+    {
+        HWND const hwnd = pWindow->GetWindowHandle();
+
+        ++g.uiDialogBoxCount;
+        DialogBoxParamW(g.hInstance, MAKEINTRESOURCE(ID_CONSOLE_EXPORTDLG), hwnd, ExportDialogProc, (LPARAM) nullptr);
+        --g.uiDialogBoxCount;
+    }
+}
@@ -0,0 +1,14 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- export.h
+
+Abstract:
+- This file implements exporting the whole screen buffer to a file.
+--*/
+
+#pragma once
+
+void DoExport();
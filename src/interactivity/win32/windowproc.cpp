@@ -5,6 +5,7 @@
 
 #include "Clipboard.hpp"
 #include "ConsoleControl.hpp"
+#include "export.h"
 #include "find.h"
 #include "menu.hpp"
 #include "window.hpp"
@@ -537,7 +538,7 @@ using namespace Microsoft::Console::Types;
 
     case WM_COMMAND:
         // If this is an edit command from the context menu, treat it like a sys command.
-        if ((wParam < ID_CONSOLE_COPY) || (wParam > ID_CONSOLE_SELECTALL))
+        if (((wParam < ID_CONSOLE_COPY) || (wParam > ID_CONSOLE_SELECTALL)) && (wParam != ID_CONSOLE_EXPORT))
         {
             break;
         }
@@ -570,6 +571,11 @@ using namespace Microsoft::Console::Types;
         {
             Selection::Instance().SelectAll();
         }
+        else if (wParam == ID_CONSOLE_EXPORT)
+        {
+            DoExport();
+            Unlock = FALSE;
+        }
         else if (wParam == ID_CONSOLE_CONTROL)
         {
             Menu::s_ShowPropertiesDialog(hWnd, FALSE);
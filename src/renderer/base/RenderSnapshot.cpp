@@ -0,0 +1,357 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "RenderSnapshot.hpp"
+
+#pragma hdrstop
+
+using namespace Microsoft::Console::Render;
+using namespace Microsoft::Console::Types;
+
+RenderSnapshot::RenderSnapshot() :
+    _renderTarget{},
+    _buffer{},
+    _dirtyRows{},
+    _viewport{ Viewport::Empty() },
+    _textBufferEndPosition{ 0, 0 },
+    _fontInfo{},
+    _selectionRects{},
+    _searchHighlightRects{},
+    _defaultBrushColors{},
+    _defaultColors{ 0, 0 },
+    _attributeColors{},
+    _hyperlinks{},
+    _patternIds{},
+    _cursorPosition{ 0, 0 },
+    _cursorVisible{ false },
+    _cursorOn{ false },
+    _cursorHeight{ 0 },
+    _cursorStyle{ CursorType::Legacy },
+    _cursorPixelWidth{ 0 },
+    _cursorColor{ INVALID_COLOR },
+    _cursorDoubleWidth{ false },
+    _screenReversed{ false },
+    _gridLineDrawingAllowed{ false },
+    _consoleTitle{}
+{
+}
+
+// Routine Description:
+// - Copies what painting a frame reads out of the render data. The console
+//   must be locked while it's copied, but not while the frame is painted.
+// Arguments:
+// - data - The render data to copy from.
+// - dirtyAreas - The areas of the screen that the frame repaints. Only their rows are copied.
+// Return Value:
+// - True if the frame can be painted from the snapshot. False if the data has
+//   overlays, which aren't copied, so the frame has to be painted from the data.
+bool RenderSnapshot::Capture(IRenderData& data, const std::vector<til::rectangle>& dirtyAreas)
+{
+    if (!data.GetOverlays().empty())
+    {
+        return false;
+    }
+
+    const auto view = data.GetViewport();
+    const auto& buffer = data.GetTextBuffer();
+    const COORD size{ buffer.GetSize().Width(), view.Height() };
+    if (!_buffer || _buffer->GetSize().Dimensions() != size)
+    {
+        _buffer = std::make_unique<TextBuffer>(size, TextAttribute{}, 0, _renderTarget);
+    }
+
+    _viewport = Viewport::FromDimensions({ view.Left(), 0 }, view.Dimensions());
+    const COORD toSnapshot{ 0, gsl::narrow_cast<SHORT>(-view.Top()) };
+
+    _dirtyRows.assign(size.Y, false);
+    for (const auto& rect : dirtyAreas)
+    {
+        const auto top = std::clamp<ptrdiff_t>(rect.top(), 0, size.Y);
+        const auto bottom = std::clamp<ptrdiff_t>(rect.bottom(), top, size.Y);
+        std::fill(_dirtyRows.begin() + top, _dirtyRows.begin() + bottom, true);
+    }
+
+    _defaultBrushColors = data.GetDefaultBrushColors();
+    _defaultColors = data.GetAttributeColors(_defaultBrushColors);
+    _attributeColors.clear();
+    _attributeColors.emplace(_defaultBrushColors, _defaultColors);
+    _hyperlinks.clear();
+    _patternIds.clear();
+
+    for (SHORT row = 0; row < size.Y; ++row)
+    {
+        if (til::at(_dirtyRows, row))
+        {
+            _CaptureRow(data, buffer.GetRowByOffset(gsl::narrow_cast<size_t>(view.Top()) + row), row);
+        }
+    }
+
+    _textBufferEndPosition = data.GetTextBufferEndPosition();
+    _textBufferEndPosition.Y -= view.Top();
+    _fontInfo.emplace(data.GetFontInfo());
+
+    _selectionRects = data.GetSelectionRects();
+    for (auto& rect : _selectionRects)
+    {
+        rect = Viewport::Offset(rect, toSnapshot);
+    }
+
+    _searchHighlightRects = data.GetSearchHighlightRects();
+    for (auto& rect : _searchHighlightRects)
+    {
+        rect = Viewport::Offset(rect, toSnapshot);
+    }
+
+    _cursorVisible = data.IsCursorVisible();
+    _cursorPosition = data.GetCursorPosition();
+    _cursorPosition.Y -= view.Top();
+    _cursorOn = data.IsCursorOn();
+    _cursorHeight = data.GetCursorHeight();
+    _cursorStyle = data.GetCursorStyle();
+    _cursorPixelWidth = data.GetCursorPixelWidth();
+    _cursorColor = data.GetCursorColor();
+    _cursorDoubleWidth = _cursorVisible && data.IsCursorDoubleWidth();
+
+    _screenReversed = data.IsScreenReversed();
+    _gridLineDrawingAllowed = data.IsGridLineDrawingAllowed();
+    _consoleTitle = data.GetConsoleTitle();
+    return true;
+}
+
+// Routine Description:
+// - Copies a row into the snapshot, along with the colors, hyperlinks and
+//   patterns of its cells.
+// Arguments:
+// - data - The render data to look the colors, hyperlinks and patterns up in.
+// - source - The row of the data's buffer.
+// - row - The row of the snapshot, which is also its offset from the top of the viewport.
+// Return Value:
+// - <none>
+void RenderSnapshot::_CaptureRow(IRenderData& data, const ROW& source, const SHORT row)
+{
+    auto& copy = _buffer->GetRowByOffset(row);
+    copy.GetCharRow().CopyFrom(source.GetCharRow());
+    copy.GetAttrRow() = source.GetAttrRow();
+    copy.MarkChanged();
+
+    // The attribute only changes between runs, so it's enough to look at the first cell of each.
+    std::optional<TextAttributeTable::Id> runId;
+    for (auto it = copy.GetAttrRow().begin(); it; ++it)
+    {
+        if (runId == it.GetId())
+        {
+            continue;
+        }
+        runId = it.GetId();
+
+        const auto& attr = *it;
+        if (_attributeColors.find(attr) == _attributeColors.end())
+        {
+            _attributeColors.emplace(attr, data.GetAttributeColors(attr));
+        }
+
+        if (attr.IsHyperlink())
+        {
+            const auto id = attr.GetHyperlinkId();
+            if (_hyperlinks.find(id) == _hyperlinks.end())
+            {
+                _hyperlinks.emplace(id, std::make_pair(data.GetHyperlinkUri(id), data.GetHyperlinkCustomId(id)));
+            }
+        }
+    }
+
+    for (SHORT column = 0; column < _viewport.Width(); ++column)
+    {
+        const COORD cell{ column, row };
+        auto ids = data.GetPatternId(cell);
+        if (!ids.empty())
+        {
+            _patternIds.emplace_back(cell, std::move(ids));
+        }
+    }
+}
+
+#pragma region BaseData
+Viewport RenderSnapshot::GetViewport() noexcept
+{
+    return _viewport;
+}
+
+COORD RenderSnapshot::GetTextBufferEndPosition() const noexcept
+{
+    return _textBufferEndPosition;
+}
+
+const TextBuffer& RenderSnapshot::GetTextBuffer() noexcept
+{
+    return *_buffer;
+}
+
+const FontInfo& RenderSnapshot::GetFontInfo() noexcept
+{
+    return *_fontInfo;
+}
+
+std::vector<Viewport> RenderSnapshot::GetSelectionRects() noexcept
+try
+{
+    return _selectionRects;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return {};
+}
+
+// Method Description:
+// - The snapshot is only read by the render thread, so there's nothing to lock.
+void RenderSnapshot::LockConsole() noexcept
+{
+}
+
+void RenderSnapshot::UnlockConsole() noexcept
+{
+}
+#pragma endregion
+
+#pragma region IRenderData
+const TextAttribute RenderSnapshot::GetDefaultBrushColors() noexcept
+{
+    return _defaultBrushColors;
+}
+
+std::pair<COLORREF, COLORREF> RenderSnapshot::GetAttributeColors(const TextAttribute& attr) const noexcept
+{
+    // Every attribute of the copied rows was looked up while copying them.
+    // Any other one isn't painted by the frame, so it gets the default colors.
+    const auto it = _attributeColors.find(attr);
+    return it != _attributeColors.end() ? it->second : _defaultColors;
+}
+
+COORD RenderSnapshot::GetCursorPosition() const noexcept
+{
+    return _cursorPosition;
+}
+
+bool RenderSnapshot::IsCursorVisible() const noexcept
+{
+    return _cursorVisible;
+}
+
+bool RenderSnapshot::IsCursorOn() const noexcept
+{
+    return _cursorOn;
+}
+
+ULONG RenderSnapshot::GetCursorHeight() const noexcept
+{
+    return _cursorHeight;
+}
+
+CursorType RenderSnapshot::GetCursorStyle() const noexcept
+{
+    return _cursorStyle;
+}
+
+ULONG RenderSnapshot::GetCursorPixelWidth() const noexcept
+{
+    return _cursorPixelWidth;
+}
+
+COLORREF RenderSnapshot::GetCursorColor() const noexcept
+{
+    return _cursorColor;
+}
+
+bool RenderSnapshot::IsCursorDoubleWidth() const
+{
+    return _cursorDoubleWidth;
+}
+
+bool RenderSnapshot::IsScreenReversed() const noexcept
+{
+    return _screenReversed;
+}
+
+const std::vector<RenderOverlay> RenderSnapshot::GetOverlays() const noexcept
+{
+    return {};
+}
+
+const bool RenderSnapshot::IsGridLineDrawingAllowed() noexcept
+{
+    return _gridLineDrawingAllowed;
+}
+
+const std::wstring RenderSnapshot::GetConsoleTitle() const noexcept
+try
+{
+    return _consoleTitle;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return {};
+}
+
+const std::wstring RenderSnapshot::GetHyperlinkUri(uint16_t id) const noexcept
+try
+{
+    const auto it = _hyperlinks.find(id);
+    return it != _hyperlinks.end() ? it->second.first : std::wstring{};
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return {};
+}
+
+const std::wstring RenderSnapshot::GetHyperlinkCustomId(uint16_t id) const noexcept
+try
+{
+    const auto it = _hyperlinks.find(id);
+    return it != _hyperlinks.end() ? it->second.second : std::wstring{};
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return {};
+}
+
+// Method Description:
+// - Gets the pattern IDs of a cell of one of the copied rows.
+// Arguments:
+// - location - The cell, relative to the top left of the viewport.
+// Return Value:
+// - The pattern IDs of the cell.
+const std::vector<size_t> RenderSnapshot::GetPatternId(const COORD location) const noexcept
+try
+{
+    const auto it = std::lower_bound(_patternIds.begin(), _patternIds.end(), location, [](const auto& entry, const COORD cell) {
+        return std::tie(entry.first.Y, entry.first.X) < std::tie(cell.Y, cell.X);
+    });
+    if (it != _patternIds.end() && it->first == location)
+    {
+        return it->second;
+    }
+    return {};
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return {};
+}
+
+std::vector<Viewport> RenderSnapshot::GetSearchHighlightRects() noexcept
+try
+{
+    return _searchHighlightRects;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return {};
+}
+#pragma endregion
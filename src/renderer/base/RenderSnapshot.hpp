@@ -0,0 +1,113 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- RenderSnapshot.hpp
+
+Abstract:
+- A copy of what the renderer reads from the render data to paint a frame,
+  so that the frame can be painted after the console is unlocked.
+- Only the rows that the frame repaints are copied, into a buffer that's kept
+  from frame to frame. The buffer is as tall as the viewport, so the
+  snapshot's viewport starts at its top, and the cursor and selection are
+  moved up to match.
+- Overlays aren't copied. Frames that have any are painted from the data.
+--*/
+
+#pragma once
+
+#include "../inc/IRenderData.hpp"
+#include "../inc/DummyRenderTarget.hpp"
+
+#include "../../buffer/out/textBuffer.hpp"
+
+namespace Microsoft::Console::Render
+{
+    class RenderSnapshot final : public IRenderData
+    {
+    public:
+        RenderSnapshot();
+
+        bool Capture(IRenderData& data, const std::vector<til::rectangle>& dirtyAreas);
+
+#pragma region BaseData
+        Microsoft::Console::Types::Viewport GetViewport() noexcept override;
+        COORD GetTextBufferEndPosition() const noexcept override;
+        const TextBuffer& GetTextBuffer() noexcept override;
+        const FontInfo& GetFontInfo() noexcept override;
+
+        std::vector<Microsoft::Console::Types::Viewport> GetSelectionRects() noexcept override;
+
+        void LockConsole() noexcept override;
+        void UnlockConsole() noexcept override;
+#pragma endregion
+
+#pragma region IRenderData
+        const TextAttribute GetDefaultBrushColors() noexcept override;
+
+        std::pair<COLORREF, COLORREF> GetAttributeColors(const TextAttribute& attr) const noexcept override;
+
+        COORD GetCursorPosition() const noexcept override;
+        bool IsCursorVisible() const noexcept override;
+        bool IsCursorOn() const noexcept override;
+        ULONG GetCursorHeight() const noexcept override;
+        CursorType GetCursorStyle() const noexcept override;
+        ULONG GetCursorPixelWidth() const noexcept override;
+        COLORREF GetCursorColor() const noexcept override;
+        bool IsCursorDoubleWidth() const override;
+
+        bool IsScreenReversed() const noexcept override;
+
+        const std::vector<RenderOverlay> GetOverlays() const noexcept override;
+
+        const bool IsGridLineDrawingAllowed() noexcept override;
+
+        const std::wstring GetConsoleTitle() const noexcept override;
+
+        const std::wstring GetHyperlinkUri(uint16_t id) const noexcept override;
+        const std::wstring GetHyperlinkCustomId(uint16_t id) const noexcept override;
+
+        const std::vector<size_t> GetPatternId(const COORD location) const noexcept override;
+
+        std::vector<Microsoft::Console::Types::Viewport> GetSearchHighlightRects() noexcept override;
+#pragma endregion
+
+    private:
+        void _CaptureRow(IRenderData& data, const ROW& source, const SHORT row);
+
+        DummyRenderTarget _renderTarget;
+        // The copied rows, kept between frames so that they're only allocated when the size changes.
+        std::unique_ptr<TextBuffer> _buffer;
+        // Which rows of _buffer the current frame repaints.
+        std::vector<bool> _dirtyRows;
+
+        Microsoft::Console::Types::Viewport _viewport;
+        COORD _textBufferEndPosition;
+        std::optional<FontInfo> _fontInfo;
+        std::vector<Microsoft::Console::Types::Viewport> _selectionRects;
+        std::vector<Microsoft::Console::Types::Viewport> _searchHighlightRects;
+
+        TextAttribute _defaultBrushColors;
+        std::pair<COLORREF, COLORREF> _defaultColors;
+        // The colors of the attributes of the copied rows. They're looked up
+        // while copying, as the color table can only be read under the lock.
+        std::unordered_map<TextAttribute, std::pair<COLORREF, COLORREF>, TextAttributeTable::Hash> _attributeColors;
+        std::unordered_map<uint16_t, std::pair<std::wstring, std::wstring>> _hyperlinks;
+        // The cells of the copied rows that are part of a pattern, in row-major order.
+        std::vector<std::pair<COORD, std::vector<size_t>>> _patternIds;
+
+        COORD _cursorPosition;
+        bool _cursorVisible;
+        bool _cursorOn;
+        ULONG _cursorHeight;
+        CursorType _cursorStyle;
+        ULONG _cursorPixelWidth;
+        COLORREF _cursorColor;
+        bool _cursorDoubleWidth;
+
+        bool _screenReversed;
+        bool _gridLineDrawingAllowed;
+        std::wstring _consoleTitle;
+    };
+}
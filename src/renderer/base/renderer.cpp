@@ -29,6 +29,7 @@ Renderer::Renderer(IRenderData* pData,
                    const size_t cEngines,
                    std::unique_ptr<IRenderThread> thread) :
     _pData(THROW_HR_IF_NULL(E_INVALIDARG, pData)),
+    _pPaintData(pData),
     _pThread{ std::move(thread) },
     _destructing{ false },
     _clusterBuffer{},
@@ -116,9 +117,19 @@ try
         _pData->UnlockConsole();
     });
 
+    // The console lock is let go of early when painting from the snapshot,
+    // so the engines need a lock of their own.
+    std::unique_lock<std::mutex> engineLock{ _engineLock };
+
     // Last chance check if anything scrolled without an explicit invalidate notification since the last frame.
     _CheckViewportAndScroll();
 
+    // If we're keeping some buffers between calls, let them know about the viewport size
+    // so they can prepare the buffers for changes to either preallocate memory at once
+    // (instead of growing naturally) or shrink down to reduce usage as appropriate.
+    const size_t lineLength = gsl::narrow_cast<size_t>(_viewport.Width());
+    til::manage_vector(_clusterBuffer, lineLength, _shrinkThreshold);
+
     // Try to start painting a frame
     HRESULT const hr = pEngine->StartPaint();
     RETURN_IF_FAILED(hr);
@@ -133,10 +144,21 @@ try
 
     auto endPaint = wil::scope_exit([&]() {
         LOG_IF_FAILED(pEngine->EndPaint());
+
+        // Pass on whatever was invalidated while the frame was painted from the snapshot.
+        _EndSnapshotFrame();
     });
 
+    // Once the rows that this frame repaints are copied into the snapshot, the
+    // console can be unlocked, so that writing to it doesn't wait for the frame.
+    if (_snapshotRendering && _snapshot.Capture(*_pData, pEngine->GetDirtyArea()))
+    {
+        _BeginSnapshotFrame();
+        unlock.reset();
+    }
+
     // A. Prep Colors
-    RETURN_IF_FAILED(_UpdateDrawingBrushes(pEngine, _pData->GetDefaultBrushColors(), true));
+    RETURN_IF_FAILED(_UpdateDrawingBrushes(pEngine, _pPaintData->GetDefaultBrushColors(), true));
 
     // B. Perform Scroll Operations
     RETURN_IF_FAILED(_PerformScrolling(pEngine));
@@ -166,6 +188,7 @@ try
     endPaint.reset();
 
     // Force scope exit unlock to let go of global lock so other threads can run
+    engineLock.unlock();
     unlock.reset();
 
     // Trigger out-of-lock presentation for renderers that can support it
@@ -186,6 +209,79 @@ void Renderer::_NotifyPaintFrame()
     }
 }
 
+// Routine Description:
+// - Passes an invalidation on to every engine. While a frame is painted from
+//   the snapshot, the engines are busy with it on the render thread, so the
+//   invalidation is queued until the frame is done instead.
+// Arguments:
+// - invalidate - Invalidates an engine. It's kept around if it's queued, so it has to capture by value.
+// Return Value:
+// - <none>
+void Renderer::_InvalidateEngines(const std::function<void(IRenderEngine* const)>& invalidate)
+{
+    if (!_DeferInvalidation(invalidate))
+    {
+        for (IRenderEngine* const pEngine : _rgpEngines)
+        {
+            invalidate(pEngine);
+        }
+    }
+}
+
+// Routine Description:
+// - Queues an invalidation if a frame is being painted from the snapshot.
+// Arguments:
+// - invalidate - Invalidates an engine. It has to capture by value.
+// Return Value:
+// - True if it was queued. False if no such frame is being painted, so the engines can be invalidated right away.
+bool Renderer::_DeferInvalidation(const std::function<void(IRenderEngine* const)>& invalidate)
+{
+    std::lock_guard<std::mutex> guard{ _deferLock };
+    if (_paintingSnapshot)
+    {
+        _deferredInvalidations.emplace_back(invalidate);
+        return true;
+    }
+    return false;
+}
+
+// Routine Description:
+// - Switches the frame over to painting from the snapshot, which has to have
+//   been captured for it. Invalidations are queued from now on.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Renderer::_BeginSnapshotFrame()
+{
+    std::lock_guard<std::mutex> guard{ _deferLock };
+    _paintingSnapshot = true;
+    _pPaintData = &_snapshot;
+}
+
+// Routine Description:
+// - Passes the invalidations that were queued while the frame was painted
+//   from the snapshot on to the engines, in the order that they came in.
+//   Does nothing if the frame wasn't painted from the snapshot.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Renderer::_EndSnapshotFrame() noexcept
+{
+    std::lock_guard<std::mutex> guard{ _deferLock };
+    for (const auto& invalidate : _deferredInvalidations)
+    {
+        for (IRenderEngine* const pEngine : _rgpEngines)
+        {
+            invalidate(pEngine);
+        }
+    }
+    _deferredInvalidations.clear();
+    _paintingSnapshot = false;
+    _pPaintData = _pData;
+}
+
 // Routine Description:
 // - Called when the system has requested we redraw a portion of the console.
 // Arguments:
@@ -194,8 +290,8 @@ void Renderer::_NotifyPaintFrame()
 // - <none>
 void Renderer::TriggerSystemRedraw(const RECT* const prcDirtyClient)
 {
-    std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
-        LOG_IF_FAILED(pEngine->InvalidateSystem(prcDirtyClient));
+    _InvalidateEngines([rcDirtyClient = *prcDirtyClient](IRenderEngine* const pEngine) {
+        LOG_IF_FAILED(pEngine->InvalidateSystem(&rcDirtyClient));
     });
 
     _NotifyPaintFrame();
@@ -215,7 +311,7 @@ void Renderer::TriggerRedraw(const Viewport& region)
     if (view.TrimToViewport(&srUpdateRegion))
     {
         view.ConvertToOrigin(&srUpdateRegion);
-        std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
+        _InvalidateEngines([srUpdateRegion](IRenderEngine* const pEngine) {
             LOG_IF_FAILED(pEngine->Invalidate(&srUpdateRegion));
         });
 
@@ -251,17 +347,16 @@ void Renderer::TriggerRedrawCursor(const COORD* const pcoord)
     if (view.IsInBounds(updateCoord))
     {
         view.ConvertToOrigin(&updateCoord);
-        for (IRenderEngine* pEngine : _rgpEngines)
-        {
+        _InvalidateEngines([updateCoord, doubleWidth = _pData->IsCursorDoubleWidth()](IRenderEngine* const pEngine) {
             LOG_IF_FAILED(pEngine->InvalidateCursor(&updateCoord));
 
             // Double-wide cursors need to invalidate the right half as well.
-            if (_pData->IsCursorDoubleWidth())
+            if (doubleWidth)
             {
-                updateCoord.X++;
-                LOG_IF_FAILED(pEngine->InvalidateCursor(&updateCoord));
+                const COORD rightHalf{ gsl::narrow_cast<SHORT>(updateCoord.X + 1), updateCoord.Y };
+                LOG_IF_FAILED(pEngine->InvalidateCursor(&rightHalf));
             }
-        }
+        });
 
         _NotifyPaintFrame();
     }
@@ -276,7 +371,7 @@ void Renderer::TriggerRedrawCursor(const COORD* const pcoord)
 // - <none>
 void Renderer::TriggerRedrawAll()
 {
-    std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
+    _InvalidateEngines([](IRenderEngine* const pEngine) {
         LOG_IF_FAILED(pEngine->InvalidateAll());
     });
 
@@ -320,7 +415,7 @@ void Renderer::TriggerSelection()
     try
     {
         // Get selection rectangles
-        const auto rects = _GetSelectionRects();
+        const auto rects = _GetSelectionRects(_pData);
 
         // Restrict all previous selection rectangles to inside the current viewport bounds
         for (auto& sr : _previousSelection)
@@ -338,8 +433,8 @@ void Renderer::TriggerSelection()
             sr = Viewport::FromInclusive(rc).ToExclusive();
         }
 
-        std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
-            LOG_IF_FAILED(pEngine->InvalidateSelection(_previousSelection));
+        _InvalidateEngines([previousSelection = _previousSelection, rects](IRenderEngine* const pEngine) {
+            LOG_IF_FAILED(pEngine->InvalidateSelection(previousSelection));
             LOG_IF_FAILED(pEngine->InvalidateSelection(rects));
         });
 
@@ -365,25 +460,17 @@ bool Renderer::_CheckViewportAndScroll()
     coordDelta.X = srOldViewport.Left - srNewViewport.Left;
     coordDelta.Y = srOldViewport.Top - srNewViewport.Top;
 
-    for (auto engine : _rgpEngines)
-    {
-        LOG_IF_FAILED(engine->UpdateViewport(srNewViewport));
-    }
+    _InvalidateEngines([srNewViewport](IRenderEngine* const pEngine) {
+        LOG_IF_FAILED(pEngine->UpdateViewport(srNewViewport));
+    });
 
     _viewport = Viewport::FromInclusive(srNewViewport);
 
-    // If we're keeping some buffers between calls, let them know about the viewport size
-    // so they can prepare the buffers for changes to either preallocate memory at once
-    // (instead of growing naturally) or shrink down to reduce usage as appropriate.
-    const size_t lineLength = gsl::narrow_cast<size_t>(til::rectangle{ srNewViewport }.width());
-    til::manage_vector(_clusterBuffer, lineLength, _shrinkThreshold);
-
     if (coordDelta.X != 0 || coordDelta.Y != 0)
     {
-        for (auto engine : _rgpEngines)
-        {
-            LOG_IF_FAILED(engine->InvalidateScroll(&coordDelta));
-        }
+        _InvalidateEngines([coordDelta](IRenderEngine* const pEngine) {
+            LOG_IF_FAILED(pEngine->InvalidateScroll(&coordDelta));
+        });
 
         _ScrollPreviousSelection(coordDelta);
 
@@ -419,8 +506,8 @@ void Renderer::TriggerScroll()
 // - <none>
 void Renderer::TriggerScroll(const COORD* const pcoordDelta)
 {
-    std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
-        LOG_IF_FAILED(pEngine->InvalidateScroll(pcoordDelta));
+    _InvalidateEngines([coordDelta = *pcoordDelta](IRenderEngine* const pEngine) {
+        LOG_IF_FAILED(pEngine->InvalidateScroll(&coordDelta));
     });
 
     _ScrollPreviousSelection(*pcoordDelta);
@@ -437,6 +524,18 @@ void Renderer::TriggerScroll(const COORD* const pcoordDelta)
 // - <none>
 void Renderer::TriggerCircling()
 {
+    // While a frame is painted from the snapshot, it can't be interrupted by
+    // another one. It doesn't need the buffer to hold still though, so the
+    // engines are only told once it's done, and repaint with the next frame.
+    const auto deferred = _DeferInvalidation([](IRenderEngine* const pEngine) {
+        bool fEngineRequestsRepaint = false;
+        LOG_IF_FAILED(pEngine->InvalidateCircling(&fEngineRequestsRepaint));
+    });
+    if (deferred)
+    {
+        return;
+    }
+
     for (IRenderEngine* const pEngine : _rgpEngines)
     {
         bool fEngineRequestsRepaint = false;
@@ -459,11 +558,9 @@ void Renderer::TriggerCircling()
 // - <none>
 void Renderer::TriggerTitleChange()
 {
-    const std::wstring newTitle = _pData->GetConsoleTitle();
-    for (IRenderEngine* const pEngine : _rgpEngines)
-    {
+    _InvalidateEngines([newTitle = _pData->GetConsoleTitle()](IRenderEngine* const pEngine) {
         LOG_IF_FAILED(pEngine->InvalidateTitle(newTitle));
-    }
+    });
     _NotifyPaintFrame();
 }
 
@@ -475,7 +572,7 @@ void Renderer::TriggerTitleChange()
 // - the HRESULT of the underlying engine's UpdateTitle call.
 HRESULT Renderer::_PaintTitle(IRenderEngine* const pEngine)
 {
-    const std::wstring newTitle = _pData->GetConsoleTitle();
+    const std::wstring newTitle = _pPaintData->GetConsoleTitle();
     return pEngine->UpdateTitle(newTitle);
 }
 
@@ -489,6 +586,7 @@ HRESULT Renderer::_PaintTitle(IRenderEngine* const pEngine)
 // - <none>
 void Renderer::TriggerFontChange(const int iDpi, const FontInfoDesired& FontInfoDesired, _Out_ FontInfo& FontInfo)
 {
+    const auto engineLock = LockEngines();
     std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
         LOG_IF_FAILED(pEngine->UpdateDpi(iDpi));
         LOG_IF_FAILED(pEngine->UpdateFont(FontInfoDesired, FontInfo));
@@ -522,6 +620,7 @@ void Renderer::TriggerFontChange(const int iDpi, const FontInfoDesired& FontInfo
     //      Only return the result of the successful one if it's not S_FALSE (which is the VT renderer)
     // TODO: 14560740 - The Window might be able to get at this info in a more sane manner
     FAIL_FAST_IF(!(_rgpEngines.size() <= 2));
+    const auto engineLock = LockEngines();
     for (IRenderEngine* const pEngine : _rgpEngines)
     {
         const HRESULT hr = LOG_IF_FAILED(pEngine->GetProposedFont(FontInfoDesired, FontInfo, iDpi));
@@ -554,6 +653,7 @@ bool Renderer::IsGlyphWideByFont(const std::wstring_view glyph)
     //      Only return the result of the successful one if it's not S_FALSE (which is the VT renderer)
     // TODO: 14560740 - The Window might be able to get at this info in a more sane manner
     FAIL_FAST_IF(!(_rgpEngines.size() <= 2));
+    const auto engineLock = LockEngines();
     for (IRenderEngine* const pEngine : _rgpEngines)
     {
         const HRESULT hr = LOG_IF_FAILED(pEngine->IsGlyphWideByFont(glyph, &fIsFullWidth));
@@ -615,7 +715,7 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
     // This is the subsection of the entire screen buffer that is currently being presented.
     // It can move left/right or top/bottom depending on how the viewport is scrolled
     // relative to the entire buffer.
-    const auto view = _pData->GetViewport();
+    const auto view = _pPaintData->GetViewport();
 
     // This is effectively the number of cells on the visible screen that need to be redrawn.
     // The origin is always 0, 0 because it represents the screen itself, not the underlying buffer.
@@ -638,7 +738,7 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
         if (redraw.Width() > 0)
         {
             // Retrieve the text buffer so we can read information out of it.
-            const auto& buffer = _pData->GetTextBuffer();
+            const auto& buffer = _pPaintData->GetTextBuffer();
 
             // Now walk through each row of text that we need to redraw.
             for (auto row = redraw.Top(); row < redraw.BottomExclusive(); row++)
@@ -682,7 +782,7 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
                                         const COORD target,
                                         const bool lineWrapped)
 {
-    auto globalInvert{ _pData->IsScreenReversed() };
+    auto globalInvert{ _pPaintData->IsScreenReversed() };
 
     // If we have valid data, let's figure out how to draw it.
     if (it)
@@ -693,10 +793,12 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
         // Retrieve the iterator for one line of information.
         size_t cols = 0;
 
-        // Retrieve the first color.
+        // Retrieve the first color. Its interned ID is what we compare against
+        // while walking the run, as that's much cheaper than comparing attributes.
         auto color = it->TextAttr();
+        auto colorId = it.GetAttributeId();
         // Retrieve the first pattern id
-        auto patternIds = _pData->GetPatternId(target);
+        auto patternIds = _pPaintData->GetPatternId(target);
 
         // And hold the point where we should start drawing.
         auto screenPoint = target;
@@ -742,8 +844,8 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
             do
             {
                 COORD thisPoint{ screenPoint.X + gsl::narrow<SHORT>(cols), screenPoint.Y };
-                const auto thisPointPatterns = _pData->GetPatternId(thisPoint);
-                if (color != it->TextAttr() || patternIds != thisPointPatterns)
+                const auto thisPointPatterns = _pPaintData->GetPatternId(thisPoint);
+                if (colorId != it.GetAttributeId() || patternIds != thisPointPatterns)
                 {
                     auto newAttr{ it->TextAttr() };
                     // foreground doesn't matter for runs of spaces (!)
@@ -751,6 +853,7 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
                     if (!_IsAllSpaces(it->Chars()) || !newAttr.HasIdenticalVisualRepresentationForBlankSpace(color, globalInvert) || patternIds != thisPointPatterns)
                     {
                         color = newAttr;
+                        colorId = it.GetAttributeId();
                         patternIds = thisPointPatterns;
                         break; // vend this run
                     }
@@ -805,7 +908,7 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
 
             // If we're allowed to do grid drawing, draw that now too (since it will be coupled with the color data)
             // We're only allowed to draw the grid lines under certain circumstances.
-            if (_pData->IsGridLineDrawingAllowed())
+            if (_pPaintData->IsGridLineDrawingAllowed())
             {
                 // See GH: 803
                 // If we found a wide character while we looped above, it's possible we skipped over the right half
@@ -921,7 +1024,7 @@ void Renderer::_PaintBufferOutputGridLineHelper(_In_ IRenderEngine* const pEngin
         if (_hoveredInterval->start <= coordTargetTil &&
             coordTargetTil <= _hoveredInterval->stop)
         {
-            if (_pData->GetPatternId(coordTarget).size() > 0)
+            if (_pPaintData->GetPatternId(coordTarget).size() > 0)
             {
                 lines |= IRenderEngine::GridLines::Underline;
             }
@@ -932,7 +1035,7 @@ void Renderer::_PaintBufferOutputGridLineHelper(_In_ IRenderEngine* const pEngin
     if (lines != IRenderEngine::GridLines::None)
     {
         // Get the current foreground color to render the lines.
-        const COLORREF rgb = _pData->GetAttributeColors(textAttribute).first;
+        const COLORREF rgb = _pPaintData->GetAttributeColors(textAttribute).first;
         // Draw the lines
         LOG_IF_FAILED(pEngine->PaintBufferGridLines(lines, rgb, cchLine, coordTarget));
     }
@@ -950,35 +1053,35 @@ void Renderer::_PaintBufferOutputGridLineHelper(_In_ IRenderEngine* const pEngin
 // - nullopt if the cursor is off or out-of-frame, otherwise a CursorOptions
 [[nodiscard]] std::optional<CursorOptions> Renderer::_GetCursorInfo()
 {
-    if (_pData->IsCursorVisible())
+    if (_pPaintData->IsCursorVisible())
     {
         // Get cursor position in buffer
-        COORD coordCursor = _pData->GetCursorPosition();
+        COORD coordCursor = _pPaintData->GetCursorPosition();
 
         // GH#3166: Only draw the cursor if it's actually in the viewport. It
         // might be on the line that's in that partially visible row at the
         // bottom of the viewport, the space that's not quite a full line in
         // height. Since we don't draw that text, we shouldn't draw the cursor
         // there either.
-        Viewport view = _pData->GetViewport();
+        Viewport view = _pPaintData->GetViewport();
         if (view.IsInBounds(coordCursor))
         {
             // Adjust cursor to viewport
             view.ConvertToOrigin(&coordCursor);
 
-            COLORREF cursorColor = _pData->GetCursorColor();
+            COLORREF cursorColor = _pPaintData->GetCursorColor();
             bool useColor = cursorColor != INVALID_COLOR;
 
             // Build up the cursor parameters including position, color, and drawing options
             CursorOptions options;
             options.coordCursor = coordCursor;
-            options.ulCursorHeightPercent = _pData->GetCursorHeight();
-            options.cursorPixelWidth = _pData->GetCursorPixelWidth();
-            options.fIsDoubleWidth = _pData->IsCursorDoubleWidth();
-            options.cursorType = _pData->GetCursorStyle();
+            options.ulCursorHeightPercent = _pPaintData->GetCursorHeight();
+            options.cursorPixelWidth = _pPaintData->GetCursorPixelWidth();
+            options.fIsDoubleWidth = _pPaintData->IsCursorDoubleWidth();
+            options.cursorType = _pPaintData->GetCursorStyle();
             options.fUseColor = useColor;
             options.cursorColor = cursorColor;
-            options.isOn = _pData->IsCursorOn();
+            options.isOn = _pPaintData->IsCursorOn();
 
             return { options };
         }
@@ -1033,7 +1136,7 @@ void Renderer::_PaintOverlay(IRenderEngine& engine,
     try
     {
         // First get the screen buffer's viewport.
-        Viewport view = _pData->GetViewport();
+        Viewport view = _pPaintData->GetViewport();
 
         // Now get the overlay's viewport and adjust it to where it is supposed to be relative to the window.
 
@@ -1083,7 +1186,7 @@ void Renderer::_PaintOverlays(_In_ IRenderEngine* const pEngine)
 {
     try
     {
-        const auto overlays = _pData->GetOverlays();
+        const auto overlays = _pPaintData->GetOverlays();
 
         for (const auto& overlay : overlays)
         {
@@ -1105,19 +1208,26 @@ void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
     {
         auto dirtyAreas = pEngine->GetDirtyArea();
 
+        // The search matches are painted like the selection, and under it,
+        // so that the selected match stands out from the others.
+        const auto highlights = _ToViewportRects(_pPaintData, _pPaintData->GetSearchHighlightRects());
+
         // Get selection rectangles
-        const auto rectangles = _GetSelectionRects();
-        for (auto rect : rectangles)
+        const auto rectangles = _GetSelectionRects(_pPaintData);
+        for (const auto rects : { &highlights, &rectangles })
         {
-            for (auto dirtyRect : dirtyAreas)
+            for (auto rect : *rects)
             {
-                // Make a copy as `TrimToViewport` will manipulate it and
-                // can destroy it for the next dirtyRect to test against.
-                auto rectCopy = rect;
-                Viewport dirtyView = Viewport::FromInclusive(dirtyRect);
-                if (dirtyView.TrimToViewport(&rectCopy))
+                for (auto dirtyRect : dirtyAreas)
                 {
-                    LOG_IF_FAILED(pEngine->PaintSelection(rectCopy));
+                    // Make a copy as `TrimToViewport` will manipulate it and
+                    // can destroy it for the next dirtyRect to test against.
+                    auto rectCopy = rect;
+                    Viewport dirtyView = Viewport::FromInclusive(dirtyRect);
+                    if (dirtyView.TrimToViewport(&rectCopy))
+                    {
+                        LOG_IF_FAILED(pEngine->PaintSelection(rectCopy));
+                    }
                 }
             }
         }
@@ -1140,7 +1250,7 @@ void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
 {
     // The last color needs to be each engine's responsibility. If it's local to this function,
     //      then on the next engine we might not update the color.
-    return pEngine->UpdateDrawingBrushes(textAttributes, _pData, isSettingDefaultBrushes);
+    return pEngine->UpdateDrawingBrushes(textAttributes, _pPaintData, isSettingDefaultBrushes);
 }
 
 // Routine Description:
@@ -1158,13 +1268,27 @@ void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
 
 // Routine Description:
 // - Helper to determine the selected region of the buffer.
+// Arguments:
+// - pData - The data to read the selection from: the console, or the snapshot being painted.
 // Return Value:
 // - A vector of rectangles representing the regions to select, line by line.
-std::vector<SMALL_RECT> Renderer::_GetSelectionRects() const
+std::vector<SMALL_RECT> Renderer::_GetSelectionRects(IRenderData* const pData) const
+{
+    return _ToViewportRects(pData, pData->GetSelectionRects());
+}
+
+// Routine Description:
+// - Helper to move rectangles of the buffer into the viewport, the way the
+//   selection is painted.
+// Arguments:
+// - pData - The data whose viewport the rectangles are moved into.
+// - rects - The rectangles, one per line, in buffer coordinates.
+// Return Value:
+// - The rectangles, relative to the viewport, with an exclusive bottom right.
+std::vector<SMALL_RECT> Renderer::_ToViewportRects(IRenderData* const pData, const std::vector<Viewport>& rects)
 {
-    auto rects = _pData->GetSelectionRects();
     // Adjust rectangles to viewport
-    Viewport view = _pData->GetViewport();
+    Viewport view = pData->GetViewport();
 
     std::vector<SMALL_RECT> result;
 
@@ -1236,6 +1360,36 @@ void Renderer::SetRendererEnteredErrorStateCallback(std::function<void()> pfn)
     _pfnRendererEnteredErrorState = std::move(pfn);
 }
 
+// Method Description:
+// - Sets whether frames are painted from a snapshot of the rows they repaint.
+//   The console is only locked while the snapshot is taken, so that writing
+//   to it isn't held up for the whole frame. Engines that have to paint
+//   before the buffer circles (like the VT engine) can't be used this way.
+// - Set this before painting is enabled.
+// Arguments:
+// - enabled: whether to paint from the snapshot.
+// Return Value:
+// - <none>
+void Renderer::SetSnapshotRendering(const bool enabled) noexcept
+{
+    _snapshotRendering = enabled;
+}
+
+// Method Description:
+// - Waits for the engines to finish painting, and keeps them from painting
+//   again until the returned lock is released. When frames are painted from
+//   the snapshot, the console lock doesn't keep the render thread out of the
+//   engines, so it has to be held while calling into an engine directly.
+// - Don't call back into the renderer while holding it, other than to invalidate.
+// Arguments:
+// - <none>
+// Return Value:
+// - The lock on the engines.
+[[nodiscard]] std::unique_lock<std::mutex> Renderer::LockEngines()
+{
+    return std::unique_lock<std::mutex>{ _engineLock };
+}
+
 // Method Description:
 // - Attempts to restart the renderer.
 void Renderer::ResetErrorStateAndResume()
@@ -21,6 +21,7 @@ Author(s):
 #include "../inc/IRenderData.hpp"
 
 #include "thread.hpp"
+#include "RenderSnapshot.hpp"
 
 #include "../../buffer/out/textBuffer.hpp"
 #include "../../buffer/out/CharRow.hpp"
@@ -78,6 +79,8 @@ namespace Microsoft::Console::Render
         void AddRenderEngine(_In_ IRenderEngine* const pEngine) override;
 
         void SetRendererEnteredErrorStateCallback(std::function<void()> pfn);
+        void SetSnapshotRendering(const bool enabled) noexcept;
+        [[nodiscard]] std::unique_lock<std::mutex> LockEngines();
         void ResetErrorStateAndResume();
 
         void UpdateLastHoveredInterval(const std::optional<interval_tree::IntervalTree<til::point, size_t>::interval>& newInterval);
@@ -87,6 +90,22 @@ namespace Microsoft::Console::Render
 
         IRenderData* _pData; // Non-ownership pointer
 
+        // The data that the frame being painted reads: _pData, or _snapshot
+        // if the frame is painted from it.
+        IRenderData* _pPaintData;
+        RenderSnapshot _snapshot;
+        bool _snapshotRendering = false;
+
+        // Held while an engine paints, so that the engines are only used by
+        // one thread at a time even once the console is unlocked.
+        std::mutex _engineLock;
+
+        // While a frame is painted from the snapshot, the invalidations that
+        // come in are queued, and passed on to the engines once it's done.
+        std::mutex _deferLock;
+        bool _paintingSnapshot = false;
+        std::vector<std::function<void(IRenderEngine* const)>> _deferredInvalidations;
+
         std::unique_ptr<IRenderThread> _pThread;
         bool _destructing = false;
 
@@ -94,6 +113,11 @@ namespace Microsoft::Console::Render
 
         void _NotifyPaintFrame();
 
+        void _InvalidateEngines(const std::function<void(IRenderEngine* const)>& invalidate);
+        bool _DeferInvalidation(const std::function<void(IRenderEngine* const)>& invalidate);
+        void _BeginSnapshotFrame();
+        void _EndSnapshotFrame() noexcept;
+
         [[nodiscard]] HRESULT _PaintFrameForEngine(_In_ IRenderEngine* const pEngine) noexcept;
 
         bool _CheckViewportAndScroll();
@@ -129,7 +153,8 @@ namespace Microsoft::Console::Render
         static constexpr float _shrinkThreshold = 0.8f;
         std::vector<Cluster> _clusterBuffer;
 
-        std::vector<SMALL_RECT> _GetSelectionRects() const;
+        std::vector<SMALL_RECT> _GetSelectionRects(IRenderData* const pData) const;
+        static std::vector<SMALL_RECT> _ToViewportRects(IRenderData* const pData, const std::vector<Microsoft::Console::Types::Viewport>& rects);
         void _ScrollPreviousSelection(const til::point delta);
         std::vector<SMALL_RECT> _previousSelection;
 
@@ -71,6 +71,9 @@ namespace Microsoft::Console::Render
 
         virtual const std::vector<size_t> GetPatternId(const COORD location) const noexcept = 0;
 
+        // One rectangle per row for the parts of the viewport that search matches cover, in buffer coordinates.
+        virtual std::vector<Microsoft::Console::Types::Viewport> GetSearchHighlightRects() noexcept = 0;
+
     protected:
         IRenderData() = default;
     };
@@ -47,6 +47,18 @@ namespace Microsoft::Console::VirtualTerminal
 
         virtual bool ActionSs3Dispatch(const wchar_t wch, const VTParameters parameters) = 0;
 
+        // DCS sequences are delivered in three steps, so that long data strings
+        // (like sixel images or soft fonts) never have to be buffered by the parser:
+        // - ActionDcsDispatch is called once the final character is seen.
+        // - ActionDcsPassThrough is then called with each span of the data string,
+        //   as much of it as is available in the string being processed.
+        // - ActionDcsEnd is called when the string terminator is seen, or with
+        //   cancelled set when the data string is aborted by CAN, SUB, or an escape
+        //   sequence other than ST.
+        virtual bool ActionDcsDispatch(const VTID id, const VTParameters parameters) = 0;
+        virtual bool ActionDcsPassThrough(const std::wstring_view string) = 0;
+        virtual bool ActionDcsEnd(const bool cancelled) = 0;
+
         virtual bool ParseControlSequenceAfterSs3() const = 0;
         virtual bool FlushAtEndOfString() const = 0;
         virtual bool DispatchControlCharsFromEscape() const = 0;
@@ -517,6 +517,43 @@ bool InputStateMachineEngine::ActionOscDispatch(const wchar_t /*wch*/,
     return false;
 }
 
+// Method Description:
+// - Triggers the DcsDispatch action to indicate that the listener should handle
+//      a device control string. No input sequences are DCS sequences.
+// Arguments:
+// - id - Identifier of the control string: its intermediates and final character.
+// - parameters - set of numeric parameters collected while parsing the sequence.
+// Return Value:
+// - true if we handled the dispatch.
+bool InputStateMachineEngine::ActionDcsDispatch(const VTID /*id*/, const VTParameters /*parameters*/) noexcept
+{
+    return false;
+}
+
+// Method Description:
+// - Triggers the DcsPassThrough action to hand the listener a span of the data
+//      string of the control string that was last dispatched.
+// Arguments:
+// - string - The next part of the data string. NOT null terminated.
+// Return Value:
+// - true if we handled the data.
+bool InputStateMachineEngine::ActionDcsPassThrough(const std::wstring_view /*string*/) noexcept
+{
+    return true;
+}
+
+// Method Description:
+// - Triggers the DcsEnd action to indicate that the data string of the
+//      control string that was last dispatched is complete.
+// Arguments:
+// - cancelled - True if the data string was aborted instead of terminated with ST.
+// Return Value:
+// - true if we handled the end of the string.
+bool InputStateMachineEngine::ActionDcsEnd(const bool /*cancelled*/) noexcept
+{
+    return true;
+}
+
 // Method Description:
 // - Writes a sequence of keypresses to the buffer based on the wch,
 //      vkey and modifiers passed in. Will create both the appropriate key downs
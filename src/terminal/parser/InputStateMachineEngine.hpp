@@ -156,6 +156,10 @@ namespace Microsoft::Console::VirtualTerminal
 
         bool ActionSs3Dispatch(const wchar_t wch, const VTParameters parameters) override;
 
+        bool ActionDcsDispatch(const VTID id, const VTParameters parameters) noexcept override;
+        bool ActionDcsPassThrough(const std::wstring_view string) noexcept override;
+        bool ActionDcsEnd(const bool cancelled) noexcept override;
+
         bool ParseControlSequenceAfterSs3() const noexcept override;
         bool FlushAtEndOfString() const noexcept override;
         bool DispatchControlCharsFromEscape() const noexcept override;
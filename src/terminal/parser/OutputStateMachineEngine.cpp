@@ -772,6 +772,47 @@ bool OutputStateMachineEngine::ActionSs3Dispatch(const wchar_t /*wch*/, const VT
     return false;
 }
 
+// Routine Description:
+// - Triggers the DcsDispatch action to indicate that the listener should handle
+//      a device control string. This is called when the final character is seen,
+//      and is followed by the data string through ActionDcsPassThrough.
+// Arguments:
+// - id - Identifier of the control string: its intermediates and final character.
+// - parameters - set of numeric parameters collected while parsing the sequence.
+// Return Value:
+// - true iff we successfully dispatched the sequence.
+bool OutputStateMachineEngine::ActionDcsDispatch(const VTID /*id*/, const VTParameters /*parameters*/) noexcept
+{
+    // TODO:GH#7316: The output engine doesn't handle any DCS sequences yet.
+    _ClearLastChar();
+    return false;
+}
+
+// Routine Description:
+// - Triggers the DcsPassThrough action to hand the listener a span of the data
+//      string of the control string that was last dispatched.
+// Arguments:
+// - string - The next part of the data string. NOT null terminated.
+// Return Value:
+// - true iff we successfully handled the data.
+bool OutputStateMachineEngine::ActionDcsPassThrough(const std::wstring_view /*string*/) noexcept
+{
+    // Nothing was dispatched, so there's nothing to pass the data to.
+    return true;
+}
+
+// Routine Description:
+// - Triggers the DcsEnd action to indicate that the data string of the
+//      control string that was last dispatched is complete.
+// Arguments:
+// - cancelled - True if the data string was aborted instead of terminated with ST.
+// Return Value:
+// - true iff we successfully handled the end of the string.
+bool OutputStateMachineEngine::ActionDcsEnd(const bool /*cancelled*/) noexcept
+{
+    return true;
+}
+
 // Routine Description:
 // - Null terminates, then returns, the string that we've collected as part of the OSC string.
 // Arguments:
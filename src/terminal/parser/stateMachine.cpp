@@ -7,8 +7,36 @@
 
 #include "ascii.hpp"
 
+#if defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#endif
+
 using namespace Microsoft::Console::VirtualTerminal;
 
+const std::array<std::wstring_view, StateMachine::StateCount> StateMachine::_stateNames{
+    L"Ground",
+    L"Escape",
+    L"EscapeIntermediate",
+    L"CsiEntry",
+    L"CsiIntermediate",
+    L"CsiIgnore",
+    L"CsiParam",
+    L"OscParam",
+    L"OscString",
+    L"OscTermination",
+    L"Ss3Entry",
+    L"Ss3Param",
+    L"Vt52Param",
+    L"DcsEntry",
+    L"DcsIgnore",
+    L"DcsIntermediate",
+    L"DcsParam",
+    L"DcsPassThrough",
+    L"DcsTermination",
+    L"SosPmApcString",
+    L"SosPmApcTermination",
+};
+
 //Takes ownership of the pEngine.
 StateMachine::StateMachine(std::unique_ptr<IStateMachineEngine> engine) :
     _engine(std::move(engine)),
@@ -18,9 +46,11 @@ StateMachine::StateMachine(std::unique_ptr<IStateMachineEngine> engine) :
     _parameters{},
     _parameterLimitReached(false),
     _oscString{},
+    _oscStringOverflowed(false),
     _cachedSequence{ std::nullopt },
     _processingIndividually(false)
 {
+    _oscString.reserve(OSC_STRING_RESERVED_LENGTH);
     _ActionClear();
 }
 
@@ -39,6 +69,30 @@ IStateMachineEngine& StateMachine::Engine() noexcept
     return *_engine;
 }
 
+// Routine Description:
+// - Gets the counters of the sequences dispatched and the characters processed
+//   so far. They're only collected when the parser is built with
+//   VT_PARSER_STATISTICS, otherwise the snapshot is empty.
+// Arguments:
+// - <none>
+// Return Value:
+// - A copy of the counters, which can be compared with a later snapshot.
+ParserStatistics::Snapshot StateMachine::GetStatistics() const
+{
+    return _stats.TakeSnapshot(_stateNames);
+}
+
+// Routine Description:
+// - Sets the counters returned by GetStatistics back to zero.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void StateMachine::ResetStatistics() noexcept
+{
+    _stats.Reset();
+}
+
 // Routine Description:
 // - Determines if a character is a valid number character, 0-9.
 // Arguments:
@@ -372,6 +426,235 @@ static constexpr bool _isActionableFromGround(const wchar_t wch) noexcept
     return (wch <= AsciiChars::US) || _isC1ControlCharacter(wch) || _isDelete(wch);
 }
 
+// Routine Description:
+// - Finds the next character in the string that is _isActionableFromGround.
+//   Almost all of the output we receive is plain printable text, so on x86/x64
+//   we test 8 characters at a time with SSE2 and only test characters one by
+//   one for the tail of the string (or on other architectures).
+// Arguments:
+// - string - Characters to scan.
+// - offset - Index of the first character to test.
+// Return Value:
+// - The index of the first actionable character at or after offset,
+//   or string.size() if the rest of the string is printable.
+static size_t _findActionableFromGround(const std::wstring_view string, size_t offset) noexcept
+{
+    const auto size = string.size();
+
+    // wchar_t is only 16 bits wide on Windows. The portable VtBench build
+    // runs this on Linux too, where it takes the scalar loop.
+#if (defined(_M_X64) || defined(_M_IX86)) && WCHAR_MAX == 0xFFFF
+    static_assert(sizeof(wchar_t) == sizeof(uint16_t));
+    const auto data = string.data();
+
+    // Everything up to and including US (0x1F) is actionable, as is the
+    // contiguous range from DEL (0x7F) to the end of the C1 controls (0x9F).
+    // SSE2 has no unsigned 16-bit compares, so "x <= n" is tested as
+    // "saturating(x - n) == 0". The DEL/C1 test first subtracts DEL with
+    // wraparound, which pushes everything below DEL out of range.
+    const auto c0Max = _mm_set1_epi16(AsciiChars::US);
+    const auto delBase = _mm_set1_epi16(AsciiChars::DEL);
+    const auto delC1Span = _mm_set1_epi16(L'\x9F' - AsciiChars::DEL);
+    const auto zero = _mm_setzero_si128();
+
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+    for (; offset + 8 <= size; offset += 8)
+    {
+        const auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+        const auto isC0 = _mm_cmpeq_epi16(_mm_subs_epu16(chars, c0Max), zero);
+        const auto isDelOrC1 = _mm_cmpeq_epi16(_mm_subs_epu16(_mm_sub_epi16(chars, delBase), delC1Span), zero);
+        const auto mask = _mm_movemask_epi8(_mm_or_si128(isC0, isDelOrC1));
+        if (mask != 0)
+        {
+            unsigned long index;
+            _BitScanForward(&index, gsl::narrow_cast<unsigned long>(mask));
+            // Each 16-bit lane contributes two bits to the byte mask.
+            return offset + index / 2;
+        }
+    }
+#pragma warning(pop)
+#endif
+
+    for (; offset < size; ++offset)
+    {
+        if (_isActionableFromGround(til::at(string, offset)))
+        {
+            break;
+        }
+    }
+    return offset;
+}
+
+// Routine Description:
+// - Determines the number of code units in a UTF-8 sequence from its lead byte.
+//   Continuation bytes and invalid lead bytes count as a sequence of their own,
+//   which will be converted to U+FFFD.
+// Arguments:
+// - ch - The lead byte of the sequence.
+// Return Value:
+// - The length of the sequence, from 1 to 4.
+static constexpr size_t _utf8SequenceLength(const char ch) noexcept
+{
+    const auto byte = static_cast<uint8_t>(ch);
+    if (byte >= 0xF0 && byte <= 0xF7)
+    {
+        return 4;
+    }
+    else if (byte >= 0xE0 && byte <= 0xEF)
+    {
+        return 3;
+    }
+    else if (byte >= 0xC0 && byte <= 0xDF)
+    {
+        return 2;
+    }
+    return 1;
+}
+
+// Routine Description:
+// - Determines whether a byte is a UTF-8 continuation byte, 0x80 to 0xBF.
+// Arguments:
+// - ch - The byte to test.
+// Return Value:
+// - True if it continues a code point.
+static constexpr bool _isUtf8Continuation(const char ch) noexcept
+{
+    return (static_cast<uint8_t>(ch) & 0xC0) == 0x80;
+}
+
+// Routine Description:
+// - Determines the length of the code point that starts at the given offset.
+//   It ends early at the first byte that isn't a continuation byte, so that
+//   an incomplete code point can't swallow the start of an escape sequence.
+// Arguments:
+// - string - UTF-8 encoded characters.
+// - offset - Index of the lead byte of the code point.
+// Return Value:
+// - The number of bytes that belong to the code point, at least 1.
+static size_t _utf8CodePointLength(const std::string_view string, const size_t offset) noexcept
+{
+    const auto end = std::min(offset + _utf8SequenceLength(til::at(string, offset)), string.size());
+    auto length = offset + 1;
+    while (length < end && _isUtf8Continuation(til::at(string, length)))
+    {
+        ++length;
+    }
+    return length - offset;
+}
+
+// Routine Description:
+// - Determines how many bytes at the end of the string belong to a code point
+//   that was cut off and will be completed by the next string.
+// Arguments:
+// - string - UTF-8 encoded characters.
+// Return Value:
+// - The number of bytes of the incomplete code point, or 0 if there is none.
+static size_t _utf8PartialLength(const std::string_view string) noexcept
+{
+    // A code point is at most 4 bytes long, so the lead byte of an incomplete
+    // one has to be within the last 3.
+    for (size_t length = 1; length <= std::min<size_t>(3, string.size()); length++)
+    {
+        const auto ch = til::at(string, string.size() - length);
+        if (!_isUtf8Continuation(ch))
+        {
+            return _utf8SequenceLength(ch) > length ? length : 0;
+        }
+    }
+    return 0;
+}
+
+// Routine Description:
+// - Finds the next character in the UTF-8 string that is _isActionableFromGround.
+//   That's any byte below SPC, DEL, and the C1 controls, which are encoded as
+//   0xC2 followed by 0x80 to 0x9F. Like _findActionableFromGround, this tests
+//   16 bytes at a time with SSE2 on x86/x64.
+// Arguments:
+// - string - UTF-8 encoded characters to scan.
+// - offset - Index of the first byte to test.
+// Return Value:
+// - The index of the first byte of the first actionable character at or
+//   after offset, or string.size() if the rest of the string is printable.
+static size_t _findActionableFromGroundUtf8(const std::string_view string, size_t offset) noexcept
+{
+    const auto size = string.size();
+    const auto isC1At = [&](const size_t i) noexcept {
+        const auto next = i + 1 < size ? static_cast<uint8_t>(til::at(string, i + 1)) : 0;
+        return next >= 0x80 && next <= 0x9F;
+    };
+
+#if defined(_M_X64) || defined(_M_IX86)
+    const auto data = string.data();
+    const auto c0Max = _mm_set1_epi8(static_cast<char>(AsciiChars::US));
+    const auto del = _mm_set1_epi8(static_cast<char>(AsciiChars::DEL));
+    const auto c1Lead = _mm_set1_epi8(static_cast<char>(0xC2));
+    const auto zero = _mm_setzero_si128();
+
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+    while (offset + 16 <= size)
+    {
+        const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+        const auto isC0 = _mm_cmpeq_epi8(_mm_subs_epu8(bytes, c0Max), zero);
+        const auto isDel = _mm_cmpeq_epi8(bytes, del);
+        const auto isC1Lead = _mm_cmpeq_epi8(bytes, c1Lead);
+        auto mask = gsl::narrow_cast<unsigned long>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(isC0, isDel), isC1Lead)));
+        while (mask != 0)
+        {
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            // 0xC2 is also the lead byte of printable characters like U+00A0.
+            if (til::at(string, offset + index) != static_cast<char>(0xC2) || isC1At(offset + index))
+            {
+                return offset + index;
+            }
+            mask &= mask - 1;
+        }
+        offset += 16;
+    }
+#pragma warning(pop)
+#endif
+
+    for (; offset < size; ++offset)
+    {
+        const auto byte = static_cast<uint8_t>(til::at(string, offset));
+        if (byte <= AsciiChars::US || byte == AsciiChars::DEL || (byte == 0xC2 && isC1At(offset)))
+        {
+            break;
+        }
+    }
+    return offset;
+}
+
+// Routine Description:
+// - Finds the end of the run of characters that the DcsPassThrough state
+//   passes through to the engine unchanged: C0 controls other than CAN, SUB and
+//   ESC, and 0x20 - 0x7E. Everything else ends or aborts the data string, or is
+//   ignored, and is left for ProcessCharacter. Since all of these are ASCII,
+//   this works the same for UTF-16 and UTF-8 text.
+// Arguments:
+// - string - Characters to scan.
+// - offset - Index of the first character to test.
+// Return Value:
+// - The index of the first character at or after offset that isn't passed
+//   through, or string.size() if the rest of the string is.
+template<typename T>
+static size_t _findDcsPassThroughEnd(const std::basic_string_view<T> string, size_t offset) noexcept
+{
+    for (; offset < string.size(); ++offset)
+    {
+        const auto ch = static_cast<std::make_unsigned_t<T>>(til::at(string, offset));
+        if (ch >= AsciiChars::DEL || ch == AsciiChars::ESC || ch == AsciiChars::CAN || ch == AsciiChars::SUB)
+        {
+            break;
+        }
+    }
+    return offset;
+}
+
 #pragma warning(pop)
 
 // Routine Description:
@@ -383,7 +666,10 @@ static constexpr bool _isActionableFromGround(const wchar_t wch) noexcept
 void StateMachine::_ActionExecute(const wchar_t wch)
 {
     _trace.TraceOnExecute(wch);
-    _engine->ActionExecute(wch);
+
+    const auto start = _stats.StartDispatch();
+    const bool success = _engine->ActionExecute(wch);
+    _stats.EndDispatch(ParserStatistics::SequenceKind::Execute, wch, success, start);
 }
 
 // Routine Description:
@@ -397,7 +683,10 @@ void StateMachine::_ActionExecute(const wchar_t wch)
 void StateMachine::_ActionExecuteFromEscape(const wchar_t wch)
 {
     _trace.TraceOnExecuteFromEscape(wch);
-    _engine->ActionExecuteFromEscape(wch);
+
+    const auto start = _stats.StartDispatch();
+    const bool success = _engine->ActionExecuteFromEscape(wch);
+    _stats.EndDispatch(ParserStatistics::SequenceKind::Execute, wch, success, start);
 }
 
 // Routine Description:
@@ -409,7 +698,27 @@ void StateMachine::_ActionExecuteFromEscape(const wchar_t wch)
 void StateMachine::_ActionPrint(const wchar_t wch)
 {
     _trace.TraceOnAction(L"Print");
-    _engine->ActionPrint(wch);
+
+    const auto start = _stats.StartDispatch();
+    const bool success = _engine->ActionPrint(wch);
+    _stats.EndDispatch(ParserStatistics::SequenceKind::Print, 0, success, start);
+    _stats.CountPrinted(1);
+}
+
+// Routine Description:
+// - Triggers the PrintString action to indicate that the listener should render a run of printable characters.
+// Arguments:
+// - string - Characters to dispatch.
+// Return Value:
+// - <none>
+void StateMachine::_ActionPrintString(const std::wstring_view string)
+{
+    const auto start = _stats.StartDispatch();
+    const bool success = _engine->ActionPrintString(string);
+    _stats.EndDispatch(ParserStatistics::SequenceKind::Print, 0, success, start);
+    _stats.CountPrinted(string.size());
+
+    _trace.DispatchPrintRunTrace(string);
 }
 
 // Routine Description:
@@ -423,7 +732,10 @@ void StateMachine::_ActionEscDispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"EscDispatch");
 
-    const bool success = _engine->ActionEscDispatch(_identifier.Finalize(wch));
+    const auto id = _identifier.Finalize(wch);
+    const auto start = _stats.StartDispatch();
+    const bool success = _engine->ActionEscDispatch(id);
+    _stats.EndDispatch(ParserStatistics::SequenceKind::Esc, id, success, start);
 
     // Trace the result.
     _trace.DispatchSequenceTrace(success);
@@ -446,8 +758,10 @@ void StateMachine::_ActionVt52EscDispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"Vt52EscDispatch");
 
-    const bool success = _engine->ActionVt52EscDispatch(_identifier.Finalize(wch),
-                                                        { _parameters.data(), _parameters.size() });
+    const auto id = _identifier.Finalize(wch);
+    const auto start = _stats.StartDispatch();
+    const bool success = _engine->ActionVt52EscDispatch(id, { _parameters.data(), _parameters.size() });
+    _stats.EndDispatch(ParserStatistics::SequenceKind::Vt52, id, success, start);
 
     // Trace the result.
     _trace.DispatchSequenceTrace(success);
@@ -470,8 +784,10 @@ void StateMachine::_ActionCsiDispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"CsiDispatch");
 
-    const bool success = _engine->ActionCsiDispatch(_identifier.Finalize(wch),
-                                                    { _parameters.data(), _parameters.size() });
+    const auto id = _identifier.Finalize(wch);
+    const auto start = _stats.StartDispatch();
+    const bool success = _engine->ActionCsiDispatch(id, { _parameters.data(), _parameters.size() });
+    _stats.EndDispatch(ParserStatistics::SequenceKind::Csi, id, success, start);
 
     // Trace the result.
     _trace.DispatchSequenceTrace(success);
@@ -563,6 +879,7 @@ void StateMachine::_ActionClear()
     _parameterLimitReached = false;
 
     _oscString.clear();
+    _oscStringOverflowed = false;
     _oscParameter = 0;
 
     _engine->ActionClear();
@@ -594,16 +911,24 @@ void StateMachine::_ActionOscParam(const wchar_t wch) noexcept
 }
 
 // Routine Description:
-// - Stores this character as part of the OSC string
+// - Stores these characters as part of the OSC string. ProcessString hands over
+//   runs of characters at once, ProcessCharacter a single character at a time.
+// - Once the string has reached MAX_OSC_STRING_LENGTH, the rest of it is
+//   dropped and the sequence will be ignored instead of dispatched.
 // Arguments:
-// - wch - Character to dispatch.
+// - string - Characters to store.
 // Return Value:
 // - <none>
-void StateMachine::_ActionOscPut(const wchar_t wch)
+void StateMachine::_ActionOscPut(const std::wstring_view string)
 {
     _trace.TraceOnAction(L"OscPut");
 
-    _oscString.push_back(wch);
+    const auto available = MAX_OSC_STRING_LENGTH - _oscString.size();
+    if (string.size() > available)
+    {
+        _oscStringOverflowed = true;
+    }
+    _oscString.append(string.substr(0, available));
 }
 
 // Routine Description:
@@ -617,7 +942,11 @@ void StateMachine::_ActionOscDispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"OscDispatch");
 
-    const bool success = _engine->ActionOscDispatch(wch, _oscParameter, _oscString);
+    // A string that was truncated is ignored, since acting on part of it
+    // (like setting the clipboard to part of a file) would be worse.
+    const auto start = _stats.StartDispatch();
+    const bool success = !_oscStringOverflowed && _engine->ActionOscDispatch(wch, _oscParameter, _oscString);
+    _stats.EndDispatch(ParserStatistics::SequenceKind::Osc, _oscParameter, success, start);
 
     // Trace the result.
     _trace.DispatchSequenceTrace(success);
@@ -640,7 +969,9 @@ void StateMachine::_ActionSs3Dispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"Ss3Dispatch");
 
+    const auto start = _stats.StartDispatch();
     const bool success = _engine->ActionSs3Dispatch(wch, { _parameters.data(), _parameters.size() });
+    _stats.EndDispatch(ParserStatistics::SequenceKind::Ss3, wch, success, start);
 
     // Trace the result.
     _trace.DispatchSequenceTrace(success);
@@ -653,16 +984,55 @@ void StateMachine::_ActionSs3Dispatch(const wchar_t wch)
 }
 
 // Routine Description:
-// - Triggers the DcsPassThrough action to indicate that the listener should handle a DCS data string character.
+// - Triggers the DcsDispatch action to indicate that the listener should handle a device control string.
+//   The data string that follows is handed to the listener with _ActionDcsPassThrough.
 // Arguments:
 // - wch - Character to dispatch.
 // Return Value:
 // - <none>
-void StateMachine::_ActionDcsPassThrough(const wchar_t wch)
+void StateMachine::_ActionDcsDispatch(const wchar_t wch)
+{
+    _trace.TraceOnAction(L"DcsDispatch");
+
+    const auto id = _identifier.Finalize(wch);
+    const auto start = _stats.StartDispatch();
+    const bool success = _engine->ActionDcsDispatch(id, { _parameters.data(), _parameters.size() });
+    _stats.EndDispatch(ParserStatistics::SequenceKind::Dcs, id, success, start);
+
+    // Trace the result.
+    _trace.DispatchSequenceTrace(success);
+
+    if (!success)
+    {
+        // Suppress it and log telemetry on failed cases
+        TermTelemetry::Instance().LogFailed(wch);
+    }
+}
+
+// Routine Description:
+// - Triggers the DcsPassThrough action to indicate that the listener should handle part of a DCS data string.
+//   ProcessString hands over as much of the data string as it can at once,
+//   ProcessCharacter a single character at a time.
+// Arguments:
+// - string - Characters to dispatch.
+// Return Value:
+// - <none>
+void StateMachine::_ActionDcsPassThrough(const std::wstring_view string)
 {
     _trace.TraceOnAction(L"DcsPassThrough");
-    _trace.TraceOnExecute(wch);
-    // TODO:GH#7316: Send the DCS passthrough sequence to the engine
+    _engine->ActionDcsPassThrough(string);
+}
+
+// Routine Description:
+// - Triggers the DcsEnd action to indicate that the DCS data string is complete.
+// Arguments:
+// - cancelled - True if the data string was aborted, rather than terminated with ST.
+// Return Value:
+// - <none>
+void StateMachine::_ActionDcsEnd(const bool cancelled)
+{
+    _trace.TraceOnAction(L"DcsEnd");
+    _engine->ActionDcsEnd(cancelled);
 }
 
 // Routine Description:
@@ -685,12 +1055,18 @@ void StateMachine::_EnterGround() noexcept
 // - Moves the state machine into the Escape state.
 //   This state is entered:
 //   1. When the Escape character is seen at any time.
+//   An escape sequence other than ST aborts a DCS data string that's in progress.
 // Arguments:
 // - <none>
 // Return Value:
 // - <none>
 void StateMachine::_EnterEscape()
 {
+    if (_state == VTStates::DcsPassThrough || _state == VTStates::DcsTermination)
+    {
+        _ActionDcsEnd(true);
+    }
+
     _state = VTStates::Escape;
     _trace.TraceStateChange(L"Escape");
     _ActionClear();
@@ -978,739 +1354,771 @@ void StateMachine::_EnterSosPmApcTermination() noexcept
 }
 
 // Routine Description:
-// - Processes a character event into an Action that occurs while in the Ground state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Print all other characters
+// - Determines the class of a character for the purposes of the transition table.
+//   Every character in a class is treated identically by _TransitionFor in every
+//   state, which is verified at compile time below.
 // Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventGround(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"Ground");
-    if (_isC0Code(wch) || _isDelete(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else
-    {
-        _ActionPrint(wch);
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the Escape state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Enter Control Sequence state
-//   5. Dispatch an Escape action.
-// Arguments:
-// - wch - Character that triggered the event
+// - wch - Character to classify.
 // Return Value:
-// - <none>
-void StateMachine::_EventEscape(const wchar_t wch)
+// - The character's class.
+constexpr StateMachine::CharClasses StateMachine::_ClassifyCharacter(const wchar_t wch) noexcept
 {
-    _trace.TraceOnEvent(L"Escape");
-    if (_isC0Code(wch))
+    if (wch >= 0x80)
     {
-        if (_engine->DispatchControlCharsFromEscape())
-        {
-            _ActionExecuteFromEscape(wch);
-            _EnterGround();
-        }
-        else
-        {
-            _ActionExecute(wch);
-        }
+        // C1 controls are converted to their 7-bit equivalents before we get
+        // here, so everything else above ASCII is a graphic character.
+        return CharClasses::NonAscii;
     }
-    else if (_isDelete(wch))
+    else if (_isOscTerminator(wch))
     {
-        _ActionIgnore();
+        return CharClasses::Bel;
     }
-    else if (_isIntermediate(wch))
+    else if (_isC0Code(wch))
     {
-        if (_engine->DispatchIntermediatesFromEscape())
-        {
-            _ActionEscDispatch(wch);
-            _EnterGround();
-        }
-        else
-        {
-            _ActionCollect(wch);
-            _EnterEscapeIntermediate();
-        }
+        return CharClasses::C0;
     }
-    else if (_isInAnsiMode)
+    else if (_isEscape(wch))
     {
-        if (_isCsiIndicator(wch))
-        {
-            _EnterCsiEntry();
-        }
-        else if (_isOscIndicator(wch))
-        {
-            _EnterOscParam();
-        }
-        else if (_isSs3Indicator(wch) && _engine->ParseControlSequenceAfterSs3())
-        {
-            _EnterSs3Entry();
-        }
-        else if (_isDcsIndicator(wch))
-        {
-            _EnterDcsEntry();
-        }
-        else if (_isSosIndicator(wch) || _isPmIndicator(wch) || _isApcIndicator(wch))
-        {
-            _EnterSosPmApcString();
-        }
-        else
-        {
-            _ActionEscDispatch(wch);
-            _EnterGround();
-        }
+        return CharClasses::Escape;
     }
-    else if (_isVt52CursorAddress(wch))
+    else if (wch < AsciiChars::SPC)
     {
-        _EnterVt52Param();
+        // CAN and SUB are executed from any state before we get here, except
+        // when the engine wants control characters dispatched from Escape.
+        return CharClasses::CanSub;
     }
-    else
+    else if (_isIntermediate(wch))
     {
-        _ActionVt52EscDispatch(wch);
-        _EnterGround();
+        return CharClasses::Intermediate;
     }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the EscapeIntermediate state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Dispatch an Escape action.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventEscapeIntermediate(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"EscapeIntermediate");
-    if (_isC0Code(wch))
+    else if (_isNumericParamValue(wch))
     {
-        _ActionExecute(wch);
+        return CharClasses::Digit;
     }
-    else if (_isIntermediate(wch))
+    else if (_isCsiInvalid(wch))
     {
-        _ActionCollect(wch);
+        return CharClasses::Colon;
     }
-    else if (_isDelete(wch))
+    else if (_isParameterDelimiter(wch))
     {
-        _ActionIgnore();
+        return CharClasses::Semicolon;
     }
-    else if (_isInAnsiMode)
+    else if (_isCsiPrivateMarker(wch))
     {
-        _ActionEscDispatch(wch);
-        _EnterGround();
+        return CharClasses::PrivateMarker;
     }
-    else if (_isVt52CursorAddress(wch))
+    else if (_isCsiIndicator(wch))
     {
-        _EnterVt52Param();
+        return CharClasses::CsiIndicator;
     }
-    else
+    else if (_isOscIndicator(wch))
     {
-        _ActionVt52EscDispatch(wch);
-        _EnterGround();
+        return CharClasses::OscIndicator;
     }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiEntry state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Store parameter data
-//   6. Collect Control Sequence Private markers
-//   7. Dispatch a control sequence with parameters for action
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventCsiEntry(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"CsiEntry");
-    if (_isC0Code(wch))
+    else if (_isSs3Indicator(wch))
     {
-        _ActionExecute(wch);
+        return CharClasses::Ss3Indicator;
     }
-    else if (_isDelete(wch))
+    else if (_isDcsIndicator(wch))
     {
-        _ActionIgnore();
+        return CharClasses::DcsIndicator;
     }
-    else if (_isIntermediate(wch))
+    else if (_isSosIndicator(wch) || _isPmIndicator(wch) || _isApcIndicator(wch))
     {
-        _ActionCollect(wch);
-        _EnterCsiIntermediate();
+        return CharClasses::SosPmApcIndicator;
     }
-    else if (_isCsiInvalid(wch))
+    else if (_isVt52CursorAddress(wch))
     {
-        _EnterCsiIgnore();
+        return CharClasses::Vt52CursorAddress;
     }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
+    else if (_isStringTerminatorIndicator(wch))
     {
-        _ActionParam(wch);
-        _EnterCsiParam();
+        return CharClasses::StringTerminator;
     }
-    else if (_isCsiPrivateMarker(wch))
+    else if (_isDelete(wch))
     {
-        _ActionCollect(wch);
-        _EnterCsiParam();
+        return CharClasses::Delete;
     }
     else
     {
-        _ActionCsiDispatch(wch);
-        _EnterGround();
+        return CharClasses::Final;
     }
 }
 
 // Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiIntermediate state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Dispatch a control sequence with parameters for action
+// - Determines the action to take and the state to move to when the given
+//   character is seen in the given state. This is the state diagram from
+//   http://vt100.net/emu/dec_ansi_parser, with our own extensions for VT52,
+//   SS3 and the input engine. It's only ever evaluated at compile time, to
+//   build the transition tables used by _ProcessEvent.
+//   Actions that depend on the engine's configuration leave nextState as the
+//   current state and perform their own transition when they're executed.
 // Arguments:
-// - wch - Character that triggered the event
+// - state - The state the character is seen in.
+// - wch - A character representative of its class.
+// - ansiMode - Whether we're in ANSI mode (as opposed to VT52 mode).
 // Return Value:
-// - <none>
-void StateMachine::_EventCsiIntermediate(const wchar_t wch)
+// - The transition for the character.
+constexpr StateMachine::Transition StateMachine::_TransitionFor(const VTStates state, const wchar_t wch, const bool ansiMode) noexcept
 {
-    _trace.TraceOnEvent(L"CsiIntermediate");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isIntermediate(wch))
+    switch (state)
     {
-        _ActionCollect(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediateInvalid(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else
-    {
-        _ActionCsiDispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiIgnore state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Return to Ground
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventCsiIgnore(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"CsiIgnore");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediateInvalid(wch))
-    {
-        _ActionIgnore();
-    }
-    else
-    {
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiParam state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Store parameter data
-//   6. Dispatch a control sequence with parameters for action
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventCsiParam(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"CsiParam");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-        _EnterCsiIntermediate();
-    }
-    else if (_isParameterInvalid(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else
-    {
-        _ActionCsiDispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the OscParam state.
-//   Events in this state will:
-//   1. Collect numeric values into an Osc Param
-//   2. Move to the OscString state on a delimiter
-//   3. Ignore everything else.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventOscParam(const wchar_t wch) noexcept
-{
-    _trace.TraceOnEvent(L"OscParam");
-    if (_isOscTerminator(wch))
-    {
-        _EnterGround();
-    }
-    else if (_isNumericParamValue(wch))
-    {
-        _ActionOscParam(wch);
-    }
-    else if (_isOscDelimiter(wch))
-    {
-        _EnterOscString();
-    }
-    else
-    {
-        _ActionIgnore();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into a Action that occurs while in the OscParam state.
-//   Events in this state will:
-//   1. Trigger the OSC action associated with the param on an OscTerminator
-//   2. If we see a ESC, enter the OscTermination state. We'll wait for one
-//      more character before we dispatch the string.
-//   3. Ignore OscInvalid characters.
-//   4. Collect everything else into the OscString
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventOscString(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"OscString");
-    if (_isOscTerminator(wch))
-    {
-        _ActionOscDispatch(wch);
-        _EnterGround();
-    }
-    else if (_isEscape(wch))
-    {
-        _EnterOscTermination();
-    }
-    else if (_isOscInvalid(wch))
-    {
-        _ActionIgnore();
-    }
-    else
-    {
-        // add this character to our OSC string
-        _ActionOscPut(wch);
-    }
-}
-
-// Routine Description:
-// - Handle the two-character termination of a OSC sequence.
-//   Events in this state will:
-//   1. Trigger the OSC action associated with the param on an OscTerminator
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the Ss3Entry state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   4. Store parameter data
-//   5. Dispatch a control sequence with parameters for action
-//  SS3 sequences are structurally the same as CSI sequences, just with a
-//      different initiation. It's safe to reuse CSI's functions for
-//      determining if a character is a parameter, delimiter, or invalid.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventSs3Entry(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"Ss3Entry");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isCsiInvalid(wch))
-    {
-        // It's safe for us to go into the CSI ignore here, because both SS3 and
-        //      CSI sequences ignore characters the same way.
-        _EnterCsiIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-        _EnterSs3Param();
-    }
-    else
-    {
-        _ActionSs3Dispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiParam state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   4. Store parameter data
-//   5. Dispatch a control sequence with parameters for action
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventSs3Param(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"Ss3Param");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-    }
-    else if (_isParameterInvalid(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else
-    {
-        _ActionSs3Dispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the Vt52Param state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Store exactly two parameter characters
-//   4. Dispatch a control sequence with parameters for action (always Direct Cursor Address)
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventVt52Param(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"Vt52Param");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else
-    {
-        _parameters.push_back(wch);
-        if (_parameters.size() == 2)
+    case VTStates::Ground:
+        // 1. Execute C0 control characters
+        // 2. Print all other characters
+        if (_isC0Code(wch) || _isDelete(wch))
         {
-            // The command character is processed before the parameter values,
-            // but it will always be 'Y', the Direct Cursor Address command.
-            _ActionVt52EscDispatch(L'Y');
-            _EnterGround();
+            return { Actions::Execute, state };
+        }
+        return { Actions::Print, state };
+    case VTStates::Escape:
+        // 1. Execute C0 control characters
+        // 2. Ignore Delete characters
+        // 3. Collect Intermediate characters
+        // 4. Enter Control Sequence state
+        // 5. Dispatch an Escape action.
+        if (_isC0Code(wch))
+        {
+            return { Actions::ExecuteFromEscape, state };
+        }
+        else if (_isDelete(wch))
+        {
+            return { Actions::Ignore, state };
+        }
+        else if (_isIntermediate(wch))
+        {
+            return { Actions::CollectFromEscape, state };
+        }
+        else if (ansiMode)
+        {
+            if (_isCsiIndicator(wch))
+            {
+                return { Actions::None, VTStates::CsiEntry };
+            }
+            else if (_isOscIndicator(wch))
+            {
+                return { Actions::None, VTStates::OscParam };
+            }
+            else if (_isSs3Indicator(wch))
+            {
+                return { Actions::Ss3FromEscape, state };
+            }
+            else if (_isDcsIndicator(wch))
+            {
+                return { Actions::None, VTStates::DcsEntry };
+            }
+            else if (_isSosIndicator(wch) || _isPmIndicator(wch) || _isApcIndicator(wch))
+            {
+                return { Actions::None, VTStates::SosPmApcString };
+            }
+            return { Actions::EscDispatch, VTStates::Ground };
+        }
+        else if (_isVt52CursorAddress(wch))
+        {
+            return { Actions::None, VTStates::Vt52Param };
+        }
+        return { Actions::Vt52EscDispatch, VTStates::Ground };
+    case VTStates::EscapeIntermediate:
+        // 1. Execute C0 control characters
+        // 2. Ignore Delete characters
+        // 3. Collect Intermediate characters
+        // 4. Dispatch an Escape action.
+        if (_isC0Code(wch))
+        {
+            return { Actions::Execute, state };
+        }
+        else if (_isIntermediate(wch))
+        {
+            return { Actions::Collect, state };
+        }
+        else if (_isDelete(wch))
+        {
+            return { Actions::Ignore, state };
+        }
+        else if (ansiMode)
+        {
+            return { Actions::EscDispatch, VTStates::Ground };
+        }
+        else if (_isVt52CursorAddress(wch))
+        {
+            return { Actions::None, VTStates::Vt52Param };
+        }
+        return { Actions::Vt52EscDispatch, VTStates::Ground };
+    case VTStates::CsiEntry:
+        // 1. Execute C0 control characters
+        // 2. Ignore Delete characters
+        // 3. Collect Intermediate characters
+        // 4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
+        // 5. Store parameter data
+        // 6. Collect Control Sequence Private markers
+        // 7. Dispatch a control sequence with parameters for action
+        if (_isC0Code(wch))
+        {
+            return { Actions::Execute, state };
+        }
+        else if (_isDelete(wch))
+        {
+            return { Actions::Ignore, state };
+        }
+        else if (_isIntermediate(wch))
+        {
+            return { Actions::Collect, VTStates::CsiIntermediate };
+        }
+        else if (_isCsiInvalid(wch))
+        {
+            return { Actions::None, VTStates::CsiIgnore };
+        }
+        else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
+        {
+            return { Actions::Param, VTStates::CsiParam };
+        }
+        else if (_isCsiPrivateMarker(wch))
+        {
+            return { Actions::Collect, VTStates::CsiParam };
+        }
+        return { Actions::CsiDispatch, VTStates::Ground };
+    case VTStates::CsiIntermediate:
+        // 1. Execute C0 control characters
+        // 2. Ignore Delete characters
+        // 3. Collect Intermediate characters
+        // 4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
+        // 5. Dispatch a control sequence with parameters for action
+        if (_isC0Code(wch))
+        {
+            return { Actions::Execute, state };
+        }
+        else if (_isIntermediate(wch))
+        {
+            return { Actions::Collect, state };
+        }
+        else if (_isDelete(wch))
+        {
+            return { Actions::Ignore, state };
+        }
+        else if (_isIntermediateInvalid(wch))
+        {
+            return { Actions::None, VTStates::CsiIgnore };
+        }
+        return { Actions::CsiDispatch, VTStates::Ground };
+    case VTStates::CsiIgnore:
+        // 1. Execute C0 control characters
+        // 2. Ignore Delete, Intermediate, and parameter characters
+        // 3. Return to Ground on anything else
+        if (_isC0Code(wch))
+        {
+            return { Actions::Execute, state };
+        }
+        else if (_isDelete(wch) || _isIntermediate(wch) || _isIntermediateInvalid(wch))
+        {
+            return { Actions::Ignore, state };
+        }
+        return { Actions::None, VTStates::Ground };
+    case VTStates::CsiParam:
+        // 1. Execute C0 control characters
+        // 2. Ignore Delete characters
+        // 3. Collect Intermediate characters
+        // 4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
+        // 5. Store parameter data
+        // 6. Dispatch a control sequence with parameters for action
+        if (_isC0Code(wch))
+        {
+            return { Actions::Execute, state };
+        }
+        else if (_isDelete(wch))
+        {
+            return { Actions::Ignore, state };
+        }
+        else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
+        {
+            return { Actions::Param, state };
+        }
+        else if (_isIntermediate(wch))
+        {
+            return { Actions::Collect, VTStates::CsiIntermediate };
+        }
+        else if (_isParameterInvalid(wch))
+        {
+            return { Actions::None, VTStates::CsiIgnore };
+        }
+        return { Actions::CsiDispatch, VTStates::Ground };
+    case VTStates::OscParam:
+        // 1. Collect numeric values into an Osc Param
+        // 2. Move to the OscString state on a delimiter
+        // 3. Ignore everything else.
+        if (_isOscTerminator(wch))
+        {
+            return { Actions::None, VTStates::Ground };
+        }
+        else if (_isNumericParamValue(wch))
+        {
+            return { Actions::OscParam, state };
+        }
+        else if (_isOscDelimiter(wch))
+        {
+            return { Actions::None, VTStates::OscString };
+        }
+        return { Actions::Ignore, state };
+    case VTStates::OscString:
+        // 1. Trigger the OSC action associated with the param on an OscTerminator
+        // 2. If we see a ESC, enter the OscTermination state. We'll wait for one
+        //    more character before we dispatch the string.
+        // 3. Ignore OscInvalid characters.
+        // 4. Collect everything else into the OscString
+        if (_isOscTerminator(wch))
+        {
+            return { Actions::OscDispatch, VTStates::Ground };
+        }
+        else if (_isEscape(wch))
+        {
+            return { Actions::None, VTStates::OscTermination };
+        }
+        else if (_isOscInvalid(wch))
+        {
+            return { Actions::Ignore, state };
+        }
+        return { Actions::OscPut, state };
+    case VTStates::Ss3Entry:
+        // 1. Execute C0 control characters
+        // 2. Ignore Delete characters
+        // 3. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
+        // 4. Store parameter data
+        // 5. Dispatch a control sequence with parameters for action
+        // SS3 sequences are structurally the same as CSI sequences, just with a
+        // different initiation. It's safe to reuse CSI's functions for
+        // determining if a character is a parameter, delimiter, or invalid,
+        // and to go into CsiIgnore, since both ignore characters the same way.
+        if (_isC0Code(wch))
+        {
+            return { Actions::Execute, state };
+        }
+        else if (_isDelete(wch))
+        {
+            return { Actions::Ignore, state };
+        }
+        else if (_isCsiInvalid(wch))
+        {
+            return { Actions::None, VTStates::CsiIgnore };
+        }
+        else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
+        {
+            return { Actions::Param, VTStates::Ss3Param };
+        }
+        return { Actions::Ss3Dispatch, VTStates::Ground };
+    case VTStates::Ss3Param:
+        // 1. Execute C0 control characters
+        // 2. Ignore Delete characters
+        // 3. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
+        // 4. Store parameter data
+        // 5. Dispatch a control sequence with parameters for action
+        if (_isC0Code(wch))
+        {
+            return { Actions::Execute, state };
+        }
+        else if (_isDelete(wch))
+        {
+            return { Actions::Ignore, state };
+        }
+        else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
+        {
+            return { Actions::Param, state };
+        }
+        else if (_isParameterInvalid(wch))
+        {
+            return { Actions::None, VTStates::CsiIgnore };
+        }
+        return { Actions::Ss3Dispatch, VTStates::Ground };
+    case VTStates::Vt52Param:
+        // 1. Execute C0 control characters
+        // 2. Ignore Delete characters
+        // 3. Store exactly two parameter characters
+        // 4. Dispatch a control sequence with parameters for action (always Direct Cursor Address)
+        if (_isC0Code(wch))
+        {
+            return { Actions::Execute, state };
+        }
+        else if (_isDelete(wch))
+        {
+            return { Actions::Ignore, state };
+        }
+        return { Actions::Vt52Param, state };
+    case VTStates::DcsEntry:
+        // 1. Ignore C0 control characters
+        // 2. Ignore Delete characters
+        // 3. Begin to ignore all remaining characters when an invalid character is detected (DcsIgnore)
+        // 4. Store parameter data
+        // 5. Collect Intermediate characters
+        // 6. Dispatch the control string on anything else, and pass through its data string
+        // DCS sequences are structurally almost the same as CSI sequences, just with an
+        // extra data string. It's safe to reuse CSI functions for
+        // determining if a character is a parameter, delimiter, or invalid.
+        if (_isC0Code(wch) || _isDelete(wch))
+        {
+            return { Actions::Ignore, state };
+        }
+        else if (_isCsiInvalid(wch))
+        {
+            return { Actions::None, VTStates::DcsIgnore };
+        }
+        else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
+        {
+            return { Actions::Param, VTStates::DcsParam };
+        }
+        else if (_isIntermediate(wch))
+        {
+            return { Actions::Collect, VTStates::DcsIntermediate };
+        }
+        return { Actions::DcsDispatch, VTStates::DcsPassThrough };
+    case VTStates::DcsIgnore:
+        // The entire DCS string is considered invalid and we will ignore everything.
+        // The termination state is handled outside when an ESC is seen.
+        return { Actions::Ignore, state };
+    case VTStates::DcsIntermediate:
+        // 1. Ignore C0 control characters
+        // 2. Ignore Delete characters
+        // 3. Collect intermediate data.
+        // 4. Begin to ignore all remaining intermediates when an invalid character is detected (DcsIgnore)
+        // 5. Dispatch the control string on anything else, and pass through its data string
+        if (_isC0Code(wch) || _isDelete(wch))
+        {
+            return { Actions::Ignore, state };
+        }
+        else if (_isIntermediate(wch))
+        {
+            return { Actions::Collect, state };
+        }
+        else if (_isIntermediateInvalid(wch))
+        {
+            return { Actions::None, VTStates::DcsIgnore };
+        }
+        return { Actions::DcsDispatch, VTStates::DcsPassThrough };
+    case VTStates::DcsParam:
+        // 1. Ignore C0 control characters
+        // 2. Ignore Delete characters
+        // 3. Collect DCS parameter data
+        // 4. Enter DcsIntermediate if we see an intermediate
+        // 5. Begin to ignore all remaining parameters when an invalid character is detected (DcsIgnore)
+        // 6. Dispatch the control string on anything else, and pass through its data string
+        if (_isC0Code(wch) || _isDelete(wch))
+        {
+            return { Actions::Ignore, state };
+        }
+        else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
+        {
+            return { Actions::Param, state };
+        }
+        else if (_isIntermediate(wch))
+        {
+            return { Actions::Collect, VTStates::DcsIntermediate };
+        }
+        else if (_isParameterInvalid(wch))
+        {
+            return { Actions::None, VTStates::DcsIgnore };
+        }
+        return { Actions::DcsDispatch, VTStates::DcsPassThrough };
+    case VTStates::DcsPassThrough:
+        // 1. Pass through if character is valid.
+        // 2. If we see a ESC, enter the DcsTermination state.
+        // 3. Ignore everything else.
+        // ProcessString passes through runs of valid characters in bulk, see _findDcsPassThroughEnd.
+        if (_isC0Code(wch) || _isDcsPassThroughValid(wch))
+        {
+            return { Actions::DcsPassThrough, state };
+        }
+        else if (_isEscape(wch))
+        {
+            return { Actions::None, VTStates::DcsTermination };
+        }
+        return { Actions::Ignore, state };
+    case VTStates::SosPmApcString:
+        // 1. If we see a ESC, enter the SosPmApcTermination state.
+        // 2. Ignore everything else.
+        if (_isEscape(wch))
+        {
+            return { Actions::None, VTStates::SosPmApcTermination };
+        }
+        return { Actions::Ignore, state };
+    case VTStates::OscTermination:
+    case VTStates::DcsTermination:
+    case VTStates::SosPmApcTermination:
+        // "Variable Length String" termination:
+        // 1. Trigger the corresponding action and enter ground if we see a string terminator,
+        // 2. Otherwise treat this as a normal escape character event.
+        if (_isStringTerminatorIndicator(wch))
+        {
+            // We don't support any SOS/PM/APC control string yet.
+            if (state == VTStates::OscTermination)
+            {
+                return { Actions::OscDispatch, VTStates::Ground };
+            }
+            else if (state == VTStates::DcsTermination)
+            {
+                return { Actions::DcsEnd, VTStates::Ground };
+            }
+            return { Actions::None, VTStates::Ground };
+        }
+        return { Actions::ReprocessAsEscape, state };
+    default:
+        return { Actions::None, state };
+    }
+}
+
+// Routine Description:
+// - Builds the transition table for every state and character class. The
+//   table is generated at compile time from _TransitionFor, so that processing
+//   a character at runtime is a single lookup instead of a chain of range checks.
+// Arguments:
+// - ansiMode - Whether to build the table for ANSI mode or VT52 mode.
+// Return Value:
+// - The transition table.
+constexpr StateMachine::TransitionTable StateMachine::_BuildTransitionTable(const bool ansiMode) noexcept
+{
+    // A representative character for each class, in the order of CharClasses.
+    constexpr std::array<wchar_t, CharClassCount> representatives{
+        AsciiChars::NUL, // C0
+        AsciiChars::BEL, // Bel
+        AsciiChars::CAN, // CanSub
+        AsciiChars::ESC, // Escape
+        L' ', // Intermediate
+        L'0', // Digit
+        L':', // Colon
+        L';', // Semicolon
+        L'?', // PrivateMarker
+        L'[', // CsiIndicator
+        L']', // OscIndicator
+        L'O', // Ss3Indicator
+        L'P', // DcsIndicator
+        L'X', // SosPmApcIndicator
+        L'Y', // Vt52CursorAddress
+        L'\\', // StringTerminator
+        L'm', // Final
+        AsciiChars::DEL, // Delete
+        L'\xA0', // NonAscii
+    };
+
+    TransitionTable table{};
+    for (size_t state = 0; state < StateCount; state++)
+    {
+        for (size_t charClass = 0; charClass < CharClassCount; charClass++)
+        {
+            const auto wch = til::at(representatives, charClass);
+            til::at(til::at(table, state), charClass) = _TransitionFor(static_cast<VTStates>(state), wch, ansiMode);
         }
     }
+    return table;
 }
 
 // Routine Description:
-// - Processes a character event into an Action that occurs while in the DcsEntry state.
-//   Events in this state will:
-//   1. Ignore C0 control characters
-//   2. Ignore Delete characters
-//   3. Begin to ignore all remaining characters when an invalid character is detected (DcsIgnore)
-//   4. Store parameter data
-//   5. Collect Intermediate characters
-//   6. Pass through everything else
-//  DCS sequences are structurally almost the same as CSI sequences, just with an
-//      extra data string. It's safe to reuse CSI functions for
-//      determining if a character is a parameter, delimiter, or invalid.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventDcsEntry(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"DcsEntry");
-    if (_isC0Code(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isCsiInvalid(wch))
-    {
-        _EnterDcsIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-        _EnterDcsParam();
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-        _EnterDcsIntermediate();
-    }
-    else
-    {
-        _ActionDcsPassThrough(wch);
-        _EnterDcsPassThrough();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the DcsIgnore state.
-//   In this state the entire DCS string is considered invalid and we will ignore everything.
-//   The termination state is handled outside when an ESC is seen.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventDcsIgnore() noexcept
-{
-    _trace.TraceOnEvent(L"DcsIgnore");
-    _ActionIgnore();
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the DcsIntermediate state.
-//   Events in this state will:
-//   1. Ignore C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect intermediate data.
-//   4. Begin to ignore all remaining intermediates when an invalid character is detected (DcsIgnore)
-//   5. Enter DcsPassThrough if we see DCS pass through indicator
-//   6. Pass through everything else.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventDcsIntermediate(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"DcsIntermediate");
-    if (_isC0Code(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-    }
-    else if (_isIntermediateInvalid(wch))
-    {
-        _EnterDcsIgnore();
-    }
-    else
-    {
-        _ActionDcsPassThrough(wch);
-        _EnterDcsPassThrough();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the DcsParam state.
-//   Events in this state will:
-//   1. Ignore C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect DCS parameter data
-//   4. Enter DcsIntermediate if we see an intermediate
-//   5. Begin to ignore all remaining parameters when an invalid character is detected (DcsIgnore)
-//   6. Pass through everything else.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventDcsParam(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"DcsParam");
-    if (_isC0Code(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-        _EnterDcsIntermediate();
-    }
-    else if (_isParameterInvalid(wch))
-    {
-        _EnterDcsIgnore();
-    }
-    else
-    {
-        _ActionDcsPassThrough(wch);
-        _EnterDcsPassThrough();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the DcsPassThrough state.
-//   Events in this state will:
-//   1. Pass through if character is valid.
-//   2. If we see a ESC, enter the DcsTermination state.
-//   3. Ignore everything else.
+// - Verifies that every character is treated the same as the representative
+//   of its class in every state, i.e. that the classes are fine enough for the
+//   table to be equivalent to evaluating _TransitionFor on each character.
 // Arguments:
-// - wch - Character that triggered the event
+// - ansiMode - Whether to verify the ANSI mode or VT52 mode table.
 // Return Value:
-// - <none>
-void StateMachine::_EventDcsPassThrough(const wchar_t wch)
+// - True if the table is equivalent. False if it isn't.
+constexpr bool StateMachine::_VerifyTransitionTable(const bool ansiMode) noexcept
 {
-    _trace.TraceOnEvent(L"DcsPassThrough");
-    if (_isC0Code(wch) || _isDcsPassThroughValid(wch))
-    {
-        _ActionDcsPassThrough(wch);
-    }
-    else if (_isEscape(wch))
+    const auto table = _BuildTransitionTable(ansiMode);
+    for (size_t state = 0; state < StateCount; state++)
     {
-        _EnterDcsTermination();
-    }
-    else
-    {
-        _ActionIgnore();
+        // Characters >= 0xA0 are all NonAscii, so testing one more past ASCII is enough.
+        for (wchar_t wch = 0; wch <= 0xA0; wch++)
+        {
+            // C1 controls are never classified, see _ClassifyCharacter.
+            if (wch >= 0x80 && wch < 0xA0)
+            {
+                continue;
+            }
+            const auto expected = _TransitionFor(static_cast<VTStates>(state), wch, ansiMode);
+            const auto actual = til::at(til::at(table, state), static_cast<size_t>(_ClassifyCharacter(wch)));
+            if (expected.action != actual.action || expected.nextState != actual.nextState)
+            {
+                return false;
+            }
+        }
     }
-}
-
-// Routine Description:
-// - Handle SOS/PM/APC string.
-//   Events in this state will:
-//   1. If we see a ESC, enter the SosPmApcTermination state.
-//   2. Ignore everything else.
+    return true;
+}
+
+// Routine Description:
+// - Moves the state machine into the given state by calling its _EnterXxx function.
+// Arguments:
+// - state - The state to enter.
+// Return Value:
+// - <none>
+void StateMachine::_EnterState(const VTStates state)
+{
+    switch (state)
+    {
+    case VTStates::Ground:
+        return _EnterGround();
+    case VTStates::Escape:
+        return _EnterEscape();
+    case VTStates::EscapeIntermediate:
+        return _EnterEscapeIntermediate();
+    case VTStates::CsiEntry:
+        return _EnterCsiEntry();
+    case VTStates::CsiIntermediate:
+        return _EnterCsiIntermediate();
+    case VTStates::CsiIgnore:
+        return _EnterCsiIgnore();
+    case VTStates::CsiParam:
+        return _EnterCsiParam();
+    case VTStates::OscParam:
+        return _EnterOscParam();
+    case VTStates::OscString:
+        return _EnterOscString();
+    case VTStates::OscTermination:
+        return _EnterOscTermination();
+    case VTStates::Ss3Entry:
+        return _EnterSs3Entry();
+    case VTStates::Ss3Param:
+        return _EnterSs3Param();
+    case VTStates::Vt52Param:
+        return _EnterVt52Param();
+    case VTStates::DcsEntry:
+        return _EnterDcsEntry();
+    case VTStates::DcsIgnore:
+        return _EnterDcsIgnore();
+    case VTStates::DcsIntermediate:
+        return _EnterDcsIntermediate();
+    case VTStates::DcsParam:
+        return _EnterDcsParam();
+    case VTStates::DcsPassThrough:
+        return _EnterDcsPassThrough();
+    case VTStates::DcsTermination:
+        return _EnterDcsTermination();
+    case VTStates::SosPmApcString:
+        return _EnterSosPmApcString();
+    case VTStates::SosPmApcTermination:
+        return _EnterSosPmApcTermination();
+    default:
+        return;
+    }
+}
+
+// Routine Description:
+// - Processes a character event in the current state: looks up the transition
+//   for the character's class, performs its action, and enters the next state.
 // Arguments:
 // - wch - Character that triggered the event
 // Return Value:
 // - <none>
-void StateMachine::_EventSosPmApcString(const wchar_t wch) noexcept
+void StateMachine::_ProcessEvent(const wchar_t wch)
 {
-    _trace.TraceOnEvent(L"SosPmApcString");
-    if (_isEscape(wch))
-    {
-        _EnterSosPmApcTermination();
-    }
-    else
-    {
-        _ActionIgnore();
-    }
-}
+    static_assert(_VerifyTransitionTable(true), "ANSI transition table doesn't match _TransitionFor");
+    static_assert(_VerifyTransitionTable(false), "VT52 transition table doesn't match _TransitionFor");
 
-// Routine Description:
-// - Handle "Variable Length String" termination.
-//   Events in this state will:
-//   1. Trigger the corresponding action and enter ground if we see a string terminator,
-//   2. Otherwise treat this as a normal escape character event.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventVariableLengthStringTermination(const wchar_t wch)
-{
-    if (_isStringTerminatorIndicator(wch))
+    static constexpr auto ansiTransitions = _BuildTransitionTable(true);
+    static constexpr auto vt52Transitions = _BuildTransitionTable(false);
+
+    const auto state = _state;
+    _trace.TraceOnEvent(til::at(_stateNames, static_cast<size_t>(state)));
+
+    const auto& transitions = _isInAnsiMode ? ansiTransitions : vt52Transitions;
+    const auto& transition = til::at(til::at(transitions, static_cast<size_t>(state)), static_cast<size_t>(_ClassifyCharacter(wch)));
+
+    switch (transition.action)
     {
-        if (_state == VTStates::OscTermination)
+    case Actions::None:
+        break;
+    case Actions::Ignore:
+        _ActionIgnore();
+        break;
+    case Actions::Execute:
+        _ActionExecute(wch);
+        break;
+    case Actions::Print:
+        _ActionPrint(wch);
+        break;
+    case Actions::Collect:
+        _ActionCollect(wch);
+        break;
+    case Actions::Param:
+        _ActionParam(wch);
+        break;
+    case Actions::EscDispatch:
+        _ActionEscDispatch(wch);
+        break;
+    case Actions::Vt52EscDispatch:
+        _ActionVt52EscDispatch(wch);
+        break;
+    case Actions::CsiDispatch:
+        _ActionCsiDispatch(wch);
+        break;
+    case Actions::OscParam:
+        _ActionOscParam(wch);
+        break;
+    case Actions::OscPut:
+        _ActionOscPut({ &wch, 1 });
+        break;
+    case Actions::OscDispatch:
+        _ActionOscDispatch(wch);
+        break;
+    case Actions::Ss3Dispatch:
+        _ActionSs3Dispatch(wch);
+        break;
+    case Actions::DcsDispatch:
+        _ActionDcsDispatch(wch);
+        break;
+    case Actions::DcsPassThrough:
+        _ActionDcsPassThrough({ &wch, 1 });
+        break;
+    case Actions::DcsEnd:
+        _ActionDcsEnd(false);
+        break;
+    case Actions::ExecuteFromEscape:
+        if (_engine->DispatchControlCharsFromEscape())
         {
-            _ActionOscDispatch(wch);
+            _ActionExecuteFromEscape(wch);
+            _EnterGround();
         }
-        else if (_state == VTStates::DcsTermination)
+        else
         {
-            // TODO:GH#7316: The Dcs sequence has successfully terminated. This is where we'd be dispatching the DCS command.
+            _ActionExecute(wch);
         }
-        else if (_state == VTStates::SosPmApcTermination)
+        break;
+    case Actions::CollectFromEscape:
+        if (_engine->DispatchIntermediatesFromEscape())
         {
-            // We don't support any SOS/PM/APC control string yet.
+            _ActionEscDispatch(wch);
+            _EnterGround();
         }
-        _EnterGround();
+        else
+        {
+            _ActionCollect(wch);
+            _EnterEscapeIntermediate();
+        }
+        break;
+    case Actions::Ss3FromEscape:
+        if (_engine->ParseControlSequenceAfterSs3())
+        {
+            _EnterSs3Entry();
+        }
+        else
+        {
+            _ActionEscDispatch(wch);
+            _EnterGround();
+        }
+        break;
+    case Actions::Vt52Param:
+        _parameters.push_back(wch);
+        if (_parameters.size() == 2)
+        {
+            // The command character is processed before the parameter values,
+            // but it will always be 'Y', the Direct Cursor Address command.
+            _ActionVt52EscDispatch(L'Y');
+            _EnterGround();
+        }
+        break;
+    case Actions::ReprocessAsEscape:
+        _EnterEscape();
+        _ProcessEvent(wch);
+        break;
     }
-    else
+
+    if (transition.nextState != state)
     {
-        _EnterEscape();
-        _EventEscape(wch);
+        _EnterState(transition.nextState);
     }
 }
 
@@ -1723,6 +2131,7 @@ void StateMachine::_EventVariableLengthStringTermination(const wchar_t wch)
 void StateMachine::ProcessCharacter(const wchar_t wch)
 {
     _trace.TraceCharInput(wch);
+    _stats.CountInput(static_cast<size_t>(_state), 1, 0);
 
     // Process "from anywhere" events first.
     const bool isFromAnywhereChar = (wch == AsciiChars::CAN || wch == AsciiChars::SUB);
@@ -1733,6 +2142,11 @@ void StateMachine::ProcessCharacter(const wchar_t wch)
     // these from any state.
     if (isFromAnywhereChar && !(_state == VTStates::Escape && _engine->DispatchControlCharsFromEscape()))
     {
+        // CAN and SUB abort a DCS data string that's in progress.
+        if (_state == VTStates::DcsPassThrough || _state == VTStates::DcsTermination)
+        {
+            _ActionDcsEnd(true);
+        }
         _ActionExecute(wch);
         _EnterGround();
     }
@@ -1757,13 +2171,13 @@ void StateMachine::ProcessCharacter(const wchar_t wch)
                 _EnterSosPmApcTermination();
             }
 
-            _EventVariableLengthStringTermination(_c1To7Bit(wch));
+            _ProcessEvent(_c1To7Bit(wch));
         }
         // Enter Escape state and pass the converted 7-bit character.
         else
         {
             _EnterEscape();
-            _EventEscape(_c1To7Bit(wch));
+            _ProcessEvent(_c1To7Bit(wch));
         }
     }
     // Don't go to escape from the "Variable Length String" state - ESC (and C1 String Terminator)
@@ -1775,55 +2189,10 @@ void StateMachine::ProcessCharacter(const wchar_t wch)
     else
     {
         // Then pass to the current state as an event
-        switch (_state)
-        {
-        case VTStates::Ground:
-            return _EventGround(wch);
-        case VTStates::Escape:
-            return _EventEscape(wch);
-        case VTStates::EscapeIntermediate:
-            return _EventEscapeIntermediate(wch);
-        case VTStates::CsiEntry:
-            return _EventCsiEntry(wch);
-        case VTStates::CsiIntermediate:
-            return _EventCsiIntermediate(wch);
-        case VTStates::CsiIgnore:
-            return _EventCsiIgnore(wch);
-        case VTStates::CsiParam:
-            return _EventCsiParam(wch);
-        case VTStates::OscParam:
-            return _EventOscParam(wch);
-        case VTStates::OscString:
-            return _EventOscString(wch);
-        case VTStates::OscTermination:
-            return _EventVariableLengthStringTermination(wch);
-        case VTStates::Ss3Entry:
-            return _EventSs3Entry(wch);
-        case VTStates::Ss3Param:
-            return _EventSs3Param(wch);
-        case VTStates::Vt52Param:
-            return _EventVt52Param(wch);
-        case VTStates::DcsEntry:
-            return _EventDcsEntry(wch);
-        case VTStates::DcsIgnore:
-            return _EventDcsIgnore();
-        case VTStates::DcsIntermediate:
-            return _EventDcsIntermediate(wch);
-        case VTStates::DcsParam:
-            return _EventDcsParam(wch);
-        case VTStates::DcsPassThrough:
-            return _EventDcsPassThrough(wch);
-        case VTStates::DcsTermination:
-            return _EventVariableLengthStringTermination(wch);
-        case VTStates::SosPmApcString:
-            return _EventSosPmApcString(wch);
-        case VTStates::SosPmApcTermination:
-            return _EventVariableLengthStringTermination(wch);
-        default:
-            return;
-        }
+        _ProcessEvent(wch);
     }
 }
+
 // Method Description:
 // - Pass the current string we're processing through to the engine. It may eat
 //      the string, it may write it straight to the input unmodified, it might
@@ -1878,6 +2247,48 @@ void StateMachine::ProcessString(const std::wstring_view string)
 
     while (current < string.size())
     {
+        // Hand the data string of a DCS sequence to the engine in bulk,
+        // up to the next character that might end it.
+        if (_processingIndividually && _state == VTStates::DcsPassThrough)
+        {
+            // The engine consumes the data string as it arrives, so neither
+            // it nor the sequence that introduced it can ever be flushed
+            // to the terminal.
+            _cachedSequence.reset();
+            start = current;
+
+            const auto end = _findDcsPassThroughEnd(string, current);
+            if (end > current)
+            {
+                _stats.CountInput(static_cast<size_t>(_state), end - current, 0);
+                _ActionDcsPassThrough(string.substr(current, end - current));
+                current = end;
+                start = current;
+                continue;
+            }
+        }
+
+        // Likewise, collect OSC strings in bulk, up to the next character that
+        // isn't simply stored. Unlike DCS data, they remain part of the run,
+        // unless they got too long and will be ignored.
+        if (_processingIndividually && _state == VTStates::OscString)
+        {
+            if (_oscStringOverflowed)
+            {
+                _cachedSequence.reset();
+                start = current;
+            }
+
+            const auto end = _findActionableFromGround(string, current);
+            if (end > current)
+            {
+                _stats.CountInput(static_cast<size_t>(_state), end - current, 0);
+                _ActionOscPut(string.substr(current, end - current));
+                current = end;
+                continue;
+            }
+        }
+
         // The run will be everything from the start INCLUDING the current one
         // in case we process the current character and it turns into a passthrough
         // fallback that picks up this _run inside `FlushToTerminal` above.
@@ -1896,26 +2307,25 @@ void StateMachine::ProcessString(const std::wstring_view string)
         }
         else
         {
-            if (_isActionableFromGround(string.at(current))) // If the current char is the start of an escape sequence, or should be executed in ground state...
+            // Skip over the printable run in bulk, adding every char to the current run to be printed.
+            current = _findActionableFromGround(string, current);
+            if (current < string.size()) // If the current char is the start of an escape sequence, or should be executed in ground state...
             {
-                if (!_run.empty())
+                // The run is composed INCLUDING current, as above, so that
+                // it's what `FlushToTerminal` picks up if printing triggers it.
+                _run = string.substr(start, current - start + 1);
+
+                // We must trim current off here since we just determined it's
+                // actionable and only pass through everything before it.
+                const auto allLeadingUpTo = _run.substr(0, _run.size() - 1);
+                if (!allLeadingUpTo.empty())
                 {
-                    // Because the _run above is composed INCLUDING current, we must
-                    // trim it off here since we just determined it's actionable
-                    // and only pass through everything before it.
-                    const auto allLeadingUpTo = _run.substr(0, _run.size() - 1);
-
-                    _engine->ActionPrintString(allLeadingUpTo); // ... print all the chars leading up to it as part of the run...
-                    _trace.DispatchPrintRunTrace(allLeadingUpTo);
+                    _stats.CountInput(static_cast<size_t>(_state), allLeadingUpTo.size(), 0);
+                    _ActionPrintString(allLeadingUpTo); // ... print all the chars leading up to it as part of the run...
                 }
 
                 _processingIndividually = true; // begin processing future characters individually...
                 start = current;
-                continue;
-            }
-            else
-            {
-                ++current; // Otherwise, add this char to the current run to be printed.
             }
         }
     }
@@ -1929,78 +2339,297 @@ void StateMachine::ProcessString(const std::wstring_view string)
     if (!_processingIndividually && !_run.empty())
     {
         // print the rest of the characters in the string
-        _engine->ActionPrintString(_run);
-        _trace.DispatchPrintRunTrace(_run);
+        _stats.CountInput(static_cast<size_t>(_state), _run.size(), 0);
+        _ActionPrintString(_run);
     }
     else if (_processingIndividually)
     {
-        // One of the "weird things" in VT input is the case of something like
-        // <kbd>alt+[</kbd>. In VT, that's encoded as `\x1b[`. However, that's
-        // also the start of a CSI, and could be the start of a longer sequence,
-        // there's no way to know for sure. For an <kbd>alt+[</kbd> keypress,
-        // the parser originally would just sit in the `CsiEntry` state after
-        // processing it, which would pollute the following keypress (e.g.
-        // <kbd>alt+[</kbd>, <kbd>A</kbd> would be processed like `\x1b[A`,
-        // which is _wrong_).
-        //
-        // Fortunately, for VT input, each keystroke comes in as an individual
-        // write operation. So, if at the end of processing a string for the
-        // InputEngine, we find that we're not in the Ground state, that implies
-        // that we've processed some input, but not dispatched it yet. This
-        // block at the end of `ProcessString` will then re-process the
-        // undispatched string, but it will ensure that it dispatches on the
-        // last character of the string. For our previous `\x1b[` scenario, that
-        // means we'll make sure to call `_ActionEscDispatch('[')`., which will
-        // properly decode the string as <kbd>alt+[</kbd>.
-
-        if (_engine->FlushAtEndOfString())
-        {
-            // Reset our state, and put all but the last char in again.
-            ResetState();
-            // Chars to flush are [pwchSequenceStart, pwchCurr)
-            auto wchIter = _run.cbegin();
-            while (wchIter < _run.cend() - 1)
+        _ProcessIncompleteSequence();
+    }
+}
+
+// Routine Description:
+// - Helper for entry to the state machine with UTF-8 text, which is what we
+//     read from a pty. Works like the UTF-16 overload above, but escape
+//     sequences are parsed byte by byte, and only the printable runs between
+//     them are converted to UTF-16, right as they're handed to the engine.
+//     Code points that are split across calls are completed on the next call.
+// Arguments:
+// - string - UTF-8 encoded characters to operate upon
+// Return Value:
+// - <none>
+void StateMachine::ProcessString(const std::string_view string)
+{
+    _utf8Sequence.clear();
+
+    auto remaining = string;
+
+    // Complete the code point that the last call ended in the middle of. If
+    // the string doesn't continue it, the incomplete code point turns into
+    // U+FFFD, and the byte that interrupted it is parsed as usual.
+    if (!_utf8Partials.empty())
+    {
+        const auto sequenceLength = _utf8SequenceLength(_utf8Partials.front());
+        size_t taken = 0;
+        while (_utf8Partials.size() < sequenceLength && taken < remaining.size() && _isUtf8Continuation(til::at(remaining, taken)))
+        {
+            _utf8Partials.push_back(til::at(remaining, taken));
+            ++taken;
+        }
+        remaining = remaining.substr(taken);
+        if (_utf8Partials.size() < sequenceLength && remaining.empty())
+        {
+            return;
+        }
+
+        // It might be a C1 control character, which starts a sequence.
+        if (!_processingIndividually && _findActionableFromGroundUtf8(_utf8Partials, 0) == 0)
+        {
+            _processingIndividually = true;
+        }
+        _ProcessUtf8CodePoint(_utf8Partials);
+        _utf8Partials.clear();
+    }
+
+    // Hold back a code point that's cut off at the end of the string.
+    const auto partialLength = _utf8PartialLength(remaining);
+    _utf8Partials.assign(remaining.substr(remaining.size() - partialLength));
+    remaining = remaining.substr(0, remaining.size() - partialLength);
+
+    size_t current = 0;
+    while (current < remaining.size())
+    {
+        if (_processingIndividually)
+        {
+            // Like above, DCS data strings are handed to the engine in bulk.
+            // The characters that are passed through are all ASCII.
+            if (_state == VTStates::DcsPassThrough)
             {
-                ProcessCharacter(*wchIter);
-                wchIter++;
+                _cachedSequence.reset();
+                _utf8Sequence.clear();
+
+                const auto end = _findDcsPassThroughEnd(remaining, current);
+                if (end > current)
+                {
+                    _stats.CountInput(static_cast<size_t>(_state), end - current, end - current);
+                    _utf8Print.assign(remaining.begin() + current, remaining.begin() + end);
+                    _ActionDcsPassThrough(_utf8Print);
+                    current = end;
+                    continue;
+                }
             }
-            // Manually execute the last char [pwchCurr]
-            switch (_state)
+            else if (_state == VTStates::OscString)
             {
-            case VTStates::Ground:
-                _ActionExecute(*wchIter);
-                break;
-            case VTStates::Escape:
-            case VTStates::EscapeIntermediate:
-                _ActionEscDispatch(*wchIter);
-                break;
-            case VTStates::CsiEntry:
-            case VTStates::CsiIntermediate:
-            case VTStates::CsiIgnore:
-            case VTStates::CsiParam:
-                _ActionCsiDispatch(*wchIter);
-                break;
-            case VTStates::OscParam:
-            case VTStates::OscString:
-            case VTStates::OscTermination:
-                _ActionOscDispatch(*wchIter);
-                break;
-            case VTStates::Ss3Entry:
-            case VTStates::Ss3Param:
-                _ActionSs3Dispatch(*wchIter);
-                break;
+                if (_oscStringOverflowed)
+                {
+                    _cachedSequence.reset();
+                    _utf8Sequence.clear();
+                }
+
+                const auto end = _findActionableFromGroundUtf8(remaining, current);
+                if (end > current)
+                {
+                    THROW_IF_FAILED(til::u8u16(remaining.substr(current, end - current), _utf8Print));
+                    _stats.CountInput(static_cast<size_t>(_state), _utf8Print.size(), end - current);
+                    _utf8Sequence.append(_utf8Print);
+                    _ActionOscPut(_utf8Print);
+                    current = end;
+                    continue;
+                }
             }
-            // microsoft/terminal#2746: Make sure to return to the ground state
-            // after dispatching the characters
-            _EnterGround();
+
+            // Escape sequences are all ASCII, so only code points inside of
+            // strings like OSC titles take more than one byte here.
+            const auto length = _utf8CodePointLength(remaining, current);
+            _ProcessUtf8CodePoint(remaining.substr(current, length));
+            current += length;
         }
         else
         {
-            // If the engine doesn't require flushing at the end of the string, we
-            // want to cache the partial sequence in case we have to flush the whole
-            // thing to the terminal later.
-            _cachedSequence = _cachedSequence.value_or(std::wstring{}) + std::wstring{ _run };
+            const auto start = current;
+            current = _findActionableFromGroundUtf8(remaining, current);
+            if (current > start)
+            {
+                THROW_IF_FAILED(til::u8u16(remaining.substr(start, current - start), _utf8Print));
+                _stats.CountInput(static_cast<size_t>(_state), _utf8Print.size(), current - start);
+                _run = _utf8Print;
+                _ActionPrintString(_run);
+            }
+
+            if (current < remaining.size())
+            {
+                _processingIndividually = true;
+                _utf8Sequence.clear();
+            }
+        }
+    }
+
+    // Like above, this has to happen even if the sequence was handed to the
+    // engine in bulk and there's nothing left to replay, so that engines
+    // that flush at the end of every string are back in the ground state.
+    if (_processingIndividually)
+    {
+        _run = _utf8Sequence;
+        _ProcessIncompleteSequence();
+    }
+}
+
+// Routine Description:
+// - Feeds a single UTF-8 code point into the state machine while we're
+//     processing characters individually, and keeps track of the sequence
+//     it's a part of, in case the engine asks us to pass it through.
+// Arguments:
+// - codePoint - The UTF-8 code units of one code point.
+// Return Value:
+// - <none>
+void StateMachine::_ProcessUtf8CodePoint(const std::string_view codePoint)
+{
+    // The characters are counted as they're processed, below.
+    _stats.CountInput(static_cast<size_t>(_state), 0, codePoint.size());
+
+    std::wstring_view units;
+    wchar_t ascii{};
+    if (codePoint.size() == 1 && static_cast<unsigned char>(codePoint.front()) < 0x80)
+    {
+        ascii = static_cast<wchar_t>(codePoint.front());
+        units = { &ascii, 1 };
+    }
+    else
+    {
+        // Invalid code units are converted to U+FFFD, just like MultiByteToWideChar does for the UTF-16 path.
+        THROW_IF_FAILED(til::u8u16(codePoint, _utf8CodePoint));
+        units = _utf8CodePoint;
+    }
+
+    for (size_t i = 0; i < units.size(); i++)
+    {
+        const auto wch = til::at(units, i);
+        if (!_processingIndividually)
+        {
+            // The sequence ended in the middle of a surrogate pair, so the
+            // rest of it is printable.
+            const auto rest = units.substr(i);
+            _run = rest;
+            _stats.CountInput(static_cast<size_t>(_state), rest.size(), 0);
+            _ActionPrintString(rest);
+            break;
+        }
+
+        _utf8Sequence.push_back(wch);
+        _run = _utf8Sequence;
+        ProcessCharacter(wch);
+        if (_state == VTStates::Ground)
+        {
+            _processingIndividually = false;
+            _utf8Sequence.clear();
+        }
+    }
+}
+
+// Routine Description:
+// - Handles a sequence that's still incomplete at the end of the string given
+//   to ProcessString. _run holds the sequence's characters from this string.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void StateMachine::_ProcessIncompleteSequence()
+{
+    // One of the "weird things" in VT input is the case of something like
+    // <kbd>alt+[</kbd>. In VT, that's encoded as `\x1b[`. However, that's
+    // also the start of a CSI, and could be the start of a longer sequence,
+    // there's no way to know for sure. For an <kbd>alt+[</kbd> keypress,
+    // the parser originally would just sit in the `CsiEntry` state after
+    // processing it, which would pollute the following keypress (e.g.
+    // <kbd>alt+[</kbd>, <kbd>A</kbd> would be processed like `\x1b[A`,
+    // which is _wrong_).
+    //
+    // Fortunately, for VT input, each keystroke comes in as an individual
+    // write operation. So, if at the end of processing a string for the
+    // InputEngine, we find that we're not in the Ground state, that implies
+    // that we've processed some input, but not dispatched it yet. This
+    // block at the end of `ProcessString` will then re-process the
+    // undispatched string, but it will ensure that it dispatches on the
+    // last character of the string. For our previous `\x1b[` scenario, that
+    // means we'll make sure to call `_ActionEscDispatch('[')`., which will
+    // properly decode the string as <kbd>alt+[</kbd>.
+
+    if (_engine->FlushAtEndOfString())
+    {
+        // A DCS data string has already been handed to the engine, so there's
+        // nothing to replay, but it mustn't swallow the next string either.
+        if (_state == VTStates::DcsPassThrough || _state == VTStates::DcsTermination)
+        {
+            _ActionDcsEnd(true);
+            _EnterGround();
+            return;
+        }
+
+        // Likewise, an OSC string that got too long is ignored rather than
+        // replayed, and a sequence whose characters were all consumed in bulk
+        // has nothing left to replay.
+        if ((_state == VTStates::OscString && _oscStringOverflowed) || _run.empty())
+        {
+            _EnterGround();
+            return;
+        }
+
+        // Reset our state, and put all but the last char in again.
+        ResetState();
+        // Chars to flush are [pwchSequenceStart, pwchCurr)
+        auto wchIter = _run.cbegin();
+        while (wchIter < _run.cend() - 1)
+        {
+            ProcessCharacter(*wchIter);
+            wchIter++;
+        }
+        // Manually execute the last char [pwchCurr]
+        switch (_state)
+        {
+        case VTStates::Ground:
+            _ActionExecute(*wchIter);
+            break;
+        case VTStates::Escape:
+        case VTStates::EscapeIntermediate:
+            _ActionEscDispatch(*wchIter);
+            break;
+        case VTStates::CsiEntry:
+        case VTStates::CsiIntermediate:
+        case VTStates::CsiIgnore:
+        case VTStates::CsiParam:
+            _ActionCsiDispatch(*wchIter);
+            break;
+        case VTStates::OscParam:
+        case VTStates::OscString:
+        case VTStates::OscTermination:
+            _ActionOscDispatch(*wchIter);
+            break;
+        case VTStates::Ss3Entry:
+        case VTStates::Ss3Param:
+            _ActionSs3Dispatch(*wchIter);
+            break;
+        }
+        // microsoft/terminal#2746: Make sure to return to the ground state
+        // after dispatching the characters
+        _EnterGround();
+    }
+    else if (_state == VTStates::DcsPassThrough || (_state == VTStates::OscString && _oscStringOverflowed))
+    {
+        // A DCS data string is handed to the engine as it arrives, and an OSC
+        // string that's too long will be ignored. Neither can be flushed to the
+        // terminal, so don't let them pile up in the cache.
+        _cachedSequence.reset();
+    }
+    else
+    {
+        // If the engine doesn't require flushing at the end of the string, we
+        // want to cache the partial sequence in case we have to flush the whole
+        // thing to the terminal later.
+        if (!_cachedSequence.has_value())
+        {
+            _cachedSequence.emplace();
         }
+        _cachedSequence->append(_run);
     }
 }
 
@@ -15,8 +15,10 @@ Abstract:
 #pragma once
 
 #include "IStateMachineEngine.hpp"
+#include "statistics.hpp"
 #include "telemetry.hpp"
 #include "tracing.hpp"
+#include <array>
 #include <memory>
 
 namespace Microsoft::Console::VirtualTerminal
@@ -32,6 +34,14 @@ namespace Microsoft::Console::VirtualTerminal
     // that number.
     constexpr size_t MAX_PARAMETER_COUNT = 32;
 
+    // OSC strings are collected into a buffer that's allocated up front, large
+    // enough for titles, hyperlinks and colors. Longer strings grow it up to
+    // the maximum length, beyond which the string is truncated and the whole
+    // sequence is ignored. In practice only OSC 52 clipboard data gets that
+    // long, and the maximum allows for about 768KB of base64 encoded text.
+    constexpr size_t OSC_STRING_RESERVED_LENGTH = 1024;
+    constexpr size_t MAX_OSC_STRING_LENGTH = 1024 * 1024;
+
     class StateMachine final
     {
 #ifdef UNIT_TESTING
@@ -46,6 +56,7 @@ namespace Microsoft::Console::VirtualTerminal
 
         void ProcessCharacter(const wchar_t wch);
         void ProcessString(const std::wstring_view string);
+        void ProcessString(const std::string_view string);
 
         void ResetState() noexcept;
 
@@ -54,20 +65,26 @@ namespace Microsoft::Console::VirtualTerminal
         const IStateMachineEngine& Engine() const noexcept;
         IStateMachineEngine& Engine() noexcept;
 
+        ParserStatistics::Snapshot GetStatistics() const;
+        void ResetStatistics() noexcept;
+
     private:
         void _ActionExecute(const wchar_t wch);
         void _ActionExecuteFromEscape(const wchar_t wch);
         void _ActionPrint(const wchar_t wch);
+        void _ActionPrintString(const std::wstring_view string);
         void _ActionEscDispatch(const wchar_t wch);
         void _ActionVt52EscDispatch(const wchar_t wch);
         void _ActionCollect(const wchar_t wch) noexcept;
         void _ActionParam(const wchar_t wch);
         void _ActionCsiDispatch(const wchar_t wch);
         void _ActionOscParam(const wchar_t wch) noexcept;
-        void _ActionOscPut(const wchar_t wch);
+        void _ActionOscPut(const std::wstring_view string);
         void _ActionOscDispatch(const wchar_t wch);
         void _ActionSs3Dispatch(const wchar_t wch);
-        void _ActionDcsPassThrough(const wchar_t wch);
+        void _ActionDcsDispatch(const wchar_t wch);
+        void _ActionDcsPassThrough(const std::wstring_view string);
+        void _ActionDcsEnd(const bool cancelled);
 
         void _ActionClear();
         void _ActionIgnore() noexcept;
@@ -94,25 +111,8 @@ namespace Microsoft::Console::VirtualTerminal
         void _EnterSosPmApcString() noexcept;
         void _EnterSosPmApcTermination() noexcept;
 
-        void _EventGround(const wchar_t wch);
-        void _EventEscape(const wchar_t wch);
-        void _EventEscapeIntermediate(const wchar_t wch);
-        void _EventCsiEntry(const wchar_t wch);
-        void _EventCsiIntermediate(const wchar_t wch);
-        void _EventCsiIgnore(const wchar_t wch);
-        void _EventCsiParam(const wchar_t wch);
-        void _EventOscParam(const wchar_t wch) noexcept;
-        void _EventOscString(const wchar_t wch);
-        void _EventSs3Entry(const wchar_t wch);
-        void _EventSs3Param(const wchar_t wch);
-        void _EventVt52Param(const wchar_t wch);
-        void _EventDcsEntry(const wchar_t wch);
-        void _EventDcsIgnore() noexcept;
-        void _EventDcsIntermediate(const wchar_t wch);
-        void _EventDcsParam(const wchar_t wch);
-        void _EventDcsPassThrough(const wchar_t wch);
-        void _EventSosPmApcString(const wchar_t wch) noexcept;
-        void _EventVariableLengthStringTermination(const wchar_t wch);
+        void _ProcessIncompleteSequence();
+        void _ProcessUtf8CodePoint(const std::string_view codePoint);
 
         void _AccumulateTo(const wchar_t wch, size_t& value) noexcept;
         const bool _IsVariableLengthStringState() const noexcept;
@@ -142,7 +142,83 @@ namespace Microsoft::Console::VirtualTerminal
             SosPmApcTermination
         };
 
+        static constexpr size_t StateCount = static_cast<size_t>(VTStates::SosPmApcTermination) + 1;
+        static_assert(StateCount <= ParserStatistics::MaxStateCount);
+
+        // The names of the states, in the order of VTStates, for tracing and statistics.
+        static const std::array<std::wstring_view, StateCount> _stateNames;
+
+        // The classes of characters that the transition table distinguishes between.
+        enum class CharClasses : uint8_t
+        {
+            C0,
+            Bel,
+            CanSub,
+            Escape,
+            Intermediate,
+            Digit,
+            Colon,
+            Semicolon,
+            PrivateMarker,
+            CsiIndicator,
+            OscIndicator,
+            Ss3Indicator,
+            DcsIndicator,
+            SosPmApcIndicator,
+            Vt52CursorAddress,
+            StringTerminator,
+            Final,
+            Delete,
+            NonAscii
+        };
+
+        static constexpr size_t CharClassCount = static_cast<size_t>(CharClasses::NonAscii) + 1;
+
+        enum class Actions : uint8_t
+        {
+            None,
+            Ignore,
+            Execute,
+            Print,
+            Collect,
+            Param,
+            EscDispatch,
+            Vt52EscDispatch,
+            CsiDispatch,
+            OscParam,
+            OscPut,
+            OscDispatch,
+            Ss3Dispatch,
+            DcsDispatch,
+            DcsPassThrough,
+            DcsEnd,
+            // These depend on the engine or on the parameters collected so far,
+            // and perform their own state transitions.
+            ExecuteFromEscape,
+            CollectFromEscape,
+            Ss3FromEscape,
+            Vt52Param,
+            ReprocessAsEscape
+        };
+
+        struct Transition
+        {
+            Actions action;
+            VTStates nextState;
+        };
+
+        using TransitionTable = std::array<std::array<Transition, CharClassCount>, StateCount>;
+
+        static constexpr CharClasses _ClassifyCharacter(const wchar_t wch) noexcept;
+        static constexpr Transition _TransitionFor(const VTStates state, const wchar_t wch, const bool ansiMode) noexcept;
+        static constexpr TransitionTable _BuildTransitionTable(const bool ansiMode) noexcept;
+        static constexpr bool _VerifyTransitionTable(const bool ansiMode) noexcept;
+
+        void _EnterState(const VTStates state);
+        void _ProcessEvent(const wchar_t wch);
+
         Microsoft::Console::VirtualTerminal::ParserTracing _trace;
+        VT_PARSER_STATISTICS_NO_UNIQUE_ADDRESS ParserStatistics _stats;
 
         std::unique_ptr<IStateMachineEngine> _engine;
 
@@ -157,10 +233,19 @@ namespace Microsoft::Console::VirtualTerminal
         bool _parameterLimitReached;
 
         std::wstring _oscString;
+        bool _oscStringOverflowed;
         size_t _oscParameter;
 
         std::optional<std::wstring> _cachedSequence;
 
+        // State for ProcessString with UTF-8 text: the bytes of a code point
+        // that was cut off at the end of the last call, the current sequence
+        // converted to UTF-16, and reusable conversion buffers.
+        std::string _utf8Partials;
+        std::wstring _utf8Sequence;
+        std::wstring _utf8Print;
+        std::wstring _utf8CodePoint;
+
         // This is tracked per state machine instance so that separate calls to Process*
         //   can start and finish a sequence.
         bool _processingIndividually;
@@ -0,0 +1,120 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "statistics.hpp"
+
+using namespace Microsoft::Console::VirtualTerminal;
+
+bool ParserStatistics::SequenceKey::operator<(const SequenceKey& other) const noexcept
+{
+    return kind < other.kind || (kind == other.kind && id < other.id);
+}
+
+bool ParserStatistics::SequenceKey::operator==(const SequenceKey& other) const noexcept
+{
+    return kind == other.kind && id == other.id;
+}
+
+// Routine Description:
+// - Subtracts an earlier snapshot of the same state machine from this one, so
+//   that only what was processed in between remains. Sequences that weren't
+//   dispatched in between are left out.
+// Arguments:
+// - earlier - A snapshot taken before this one.
+// Return Value:
+// - The difference between the snapshots.
+ParserStatistics::Snapshot ParserStatistics::Snapshot::operator-(const Snapshot& earlier) const
+{
+    Snapshot difference;
+
+    for (const auto& [key, counters] : sequences)
+    {
+        auto result = counters;
+        if (const auto it = earlier.sequences.find(key); it != earlier.sequences.end())
+        {
+            const auto& before = it->second;
+            result.count -= before.count;
+            result.failed -= before.failed;
+            result.totalTime -= before.totalTime;
+            for (size_t i = 0; i < HistogramBucketCount; i++)
+            {
+                til::at(result.histogram, i) -= til::at(before.histogram, i);
+            }
+        }
+        if (result.count != 0)
+        {
+            difference.sequences.emplace(key, result);
+        }
+    }
+
+    difference.states = states;
+    for (size_t i = 0; i < difference.states.size() && i < earlier.states.size(); i++)
+    {
+        auto& result = til::at(difference.states, i);
+        const auto& before = til::at(earlier.states, i);
+        result.characters -= before.characters;
+        result.bytes -= before.bytes;
+    }
+
+    difference.printedCharacters = printedCharacters - earlier.printedCharacters;
+    return difference;
+}
+
+#if VT_PARSER_STATISTICS
+// Routine Description:
+// - Copies the current counters.
+// Arguments:
+// - stateNames - The names of the state machine's states, in order.
+// Return Value:
+// - The counters.
+ParserStatistics::Snapshot ParserStatistics::TakeSnapshot(const gsl::span<const std::wstring_view> stateNames) const
+{
+    Snapshot snapshot;
+    snapshot.sequences = _sequences;
+    for (size_t i = 0; i < gsl::narrow_cast<size_t>(stateNames.size()) && i < MaxStateCount; i++)
+    {
+        auto counters = til::at(_states, i);
+        counters.state = til::at(stateNames, i);
+        snapshot.states.emplace_back(counters);
+    }
+    snapshot.printedCharacters = _printedCharacters;
+    return snapshot;
+}
+
+// Routine Description:
+// - Sets all counters back to zero.
+void ParserStatistics::Reset() noexcept
+{
+    _sequences.clear();
+    _states = {};
+    _printedCharacters = 0;
+}
+
+// Routine Description:
+// - Counts a dispatched sequence and adds the time it took to its histogram.
+// Arguments:
+// - key - The sequence that was dispatched.
+// - success - Whether the engine handled it.
+// - time - The time spent in the engine.
+void ParserStatistics::_RecordDispatch(const SequenceKey key, const bool success, const std::chrono::nanoseconds time)
+{
+    auto& counters = _sequences[key];
+    counters.count++;
+    if (!success)
+    {
+        counters.failed++;
+    }
+    counters.totalTime += time;
+
+    auto nanoseconds = gsl::narrow_cast<uint64_t>(std::max<int64_t>(time.count(), 0));
+    size_t bucket = 0;
+    while (nanoseconds != 0 && bucket < HistogramBucketCount - 1)
+    {
+        nanoseconds >>= 1;
+        bucket++;
+    }
+    til::at(counters.histogram, bucket)++;
+}
+#endif
@@ -0,0 +1,184 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- statistics.hpp
+
+Abstract:
+- This module counts what the state machine processes: the sequences that it
+  dispatches, keyed by their VTID, with a histogram of the time spent handling
+  each of them, and the characters and bytes that it consumes in each state.
+- Unlike ParserTracing, it doesn't depend on TraceLogging, and the counters can
+  be read back and compared, to find the sequences that dominate a workload.
+- It's only compiled in when VT_PARSER_STATISTICS is defined to 1, for instance
+  with `set CL=/DVT_PARSER_STATISTICS=1` before building. Otherwise the class
+  has no counters, every method is an empty inline one, and the state machine
+  holds it with VT_PARSER_STATISTICS_NO_UNIQUE_ADDRESS so it takes up no room.
+*/
+#pragma once
+
+#ifndef VT_PARSER_STATISTICS
+#define VT_PARSER_STATISTICS 0
+#endif
+
+// MSVC accepts [[no_unique_address]] but doesn't act on it, only on its own spelling.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define VT_PARSER_STATISTICS_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#else
+#define VT_PARSER_STATISTICS_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+
+#include <array>
+#include <chrono>
+#include <map>
+
+namespace Microsoft::Console::VirtualTerminal
+{
+    class ParserStatistics final
+    {
+    public:
+        static constexpr bool IsEnabled = VT_PARSER_STATISTICS != 0;
+
+        // Dispatch times are counted in buckets of powers of two nanoseconds.
+        // Bucket 0 holds times under 1ns, bucket n times in [2^(n-1), 2^n)ns,
+        // and the last bucket everything that took longer than that.
+        static constexpr size_t HistogramBucketCount = 32;
+
+        // The most states that can be counted. The state machine has fewer.
+        static constexpr size_t MaxStateCount = 32;
+
+        using Clock = std::chrono::steady_clock;
+
+        enum class SequenceKind : uint8_t
+        {
+            Print,
+            Execute,
+            Esc,
+            Vt52,
+            Csi,
+            Osc,
+            Ss3,
+            Dcs
+        };
+
+        struct SequenceKey
+        {
+            SequenceKind kind;
+            // The VTID of ESC, VT52, CSI and DCS sequences, the parameter of
+            // OSC sequences, the character of SS3 sequences and C0 controls,
+            // and 0 for printed text.
+            uint64_t id;
+
+            bool operator<(const SequenceKey& other) const noexcept;
+            bool operator==(const SequenceKey& other) const noexcept;
+        };
+
+        struct SequenceCounters
+        {
+            uint64_t count = 0;
+            uint64_t failed = 0;
+            std::chrono::nanoseconds totalTime{};
+            std::array<uint64_t, HistogramBucketCount> histogram{};
+        };
+
+        struct StateCounters
+        {
+            std::wstring_view state;
+            // The UTF-16 code units consumed in the state.
+            uint64_t characters = 0;
+            // The bytes consumed in the state. These are only counted for
+            // text that's given to StateMachine::ProcessString as UTF-8.
+            uint64_t bytes = 0;
+        };
+
+        struct Snapshot
+        {
+            std::map<SequenceKey, SequenceCounters> sequences;
+            std::vector<StateCounters> states;
+            uint64_t printedCharacters = 0;
+
+            Snapshot operator-(const Snapshot& earlier) const;
+        };
+
+#if VT_PARSER_STATISTICS
+        // Routine Description:
+        // - Marks the start of a call into the engine. Pass the result to EndDispatch.
+        Clock::time_point StartDispatch() const noexcept
+        {
+            return Clock::now();
+        }
+
+        // Routine Description:
+        // - Counts a call into the engine that was started with StartDispatch.
+        // Arguments:
+        // - kind, id - The sequence that was dispatched.
+        // - success - Whether the engine handled it.
+        // - start - The result of StartDispatch.
+        void EndDispatch(const SequenceKind kind, const uint64_t id, const bool success, const Clock::time_point start)
+        {
+            _RecordDispatch({ kind, id }, success, Clock::now() - start);
+        }
+
+        // Routine Description:
+        // - Counts input that was consumed in the given state.
+        // Arguments:
+        // - state - The index of the state.
+        // - characters - The number of UTF-16 code units consumed.
+        // - bytes - The number of UTF-8 bytes consumed.
+        void CountInput(const size_t state, const size_t characters, const size_t bytes) noexcept
+        {
+            auto& counters = til::at(_states, state);
+            counters.characters += characters;
+            counters.bytes += bytes;
+        }
+
+        // Routine Description:
+        // - Counts characters that were handed to the engine to be printed.
+        void CountPrinted(const size_t characters) noexcept
+        {
+            _printedCharacters += characters;
+        }
+
+        Snapshot TakeSnapshot(const gsl::span<const std::wstring_view> stateNames) const;
+        void Reset() noexcept;
+
+    private:
+        void _RecordDispatch(const SequenceKey key, const bool success, const std::chrono::nanoseconds time);
+
+        std::map<SequenceKey, SequenceCounters> _sequences;
+        std::array<StateCounters, MaxStateCount> _states{};
+        uint64_t _printedCharacters = 0;
+#else
+        // Without the statistics there's nothing to count into, and the calls
+        // the state machine makes compile to nothing. Snapshots are empty.
+        constexpr Clock::time_point StartDispatch() const noexcept
+        {
+            return {};
+        }
+
+        constexpr void EndDispatch(const SequenceKind /*kind*/, const uint64_t /*id*/, const bool /*success*/, const Clock::time_point /*start*/) const noexcept
+        {
+        }
+
+        constexpr void CountInput(const size_t /*state*/, const size_t /*characters*/, const size_t /*bytes*/) const noexcept
+        {
+        }
+
+        constexpr void CountPrinted(const size_t /*characters*/) const noexcept
+        {
+        }
+
+        Snapshot TakeSnapshot(const gsl::span<const std::wstring_view> /*stateNames*/) const
+        {
+            return {};
+        }
+
+        constexpr void Reset() const noexcept
+        {
+        }
+#endif
+    };
+
+    static_assert(ParserStatistics::IsEnabled || std::is_empty_v<ParserStatistics>);
+}
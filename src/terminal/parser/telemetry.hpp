@@ -20,7 +20,7 @@ TRACELOGGING_DECLARE_PROVIDER(g_hConsoleVirtTermParserEventTraceProvider);
 
 namespace Microsoft::Console::VirtualTerminal
 {
-    class TermTelemetry sealed
+    class TermTelemetry final
     {
     public:
         // Implement this as a singleton class.
@@ -18,7 +18,7 @@ Abstract:
 
 namespace Microsoft::Console::VirtualTerminal
 {
-    class ParserTracing sealed
+    class ParserTracing final
     {
     public:
         ParserTracing() noexcept;
@@ -557,6 +557,33 @@ class Microsoft::Console::VirtualTerminal::OutputEngineTest final
         VERIFY_ARE_EQUAL(mach._state, StateMachine::VTStates::Ground);
     }
 
+    TEST_METHOD(TestOscStringTruncated)
+    {
+        auto dispatch = std::make_unique<DummyDispatch>();
+        auto engine = std::make_unique<OutputStateMachineEngine>(std::move(dispatch));
+        StateMachine mach(std::move(engine));
+
+        const std::wstring chunk(MAX_OSC_STRING_LENGTH / 4, L's');
+
+        mach.ProcessString(L"\x1b]52;");
+        for (size_t i = 0; i < 10; i++)
+        {
+            mach.ProcessString(chunk);
+            VERIFY_ARE_EQUAL(mach._state, StateMachine::VTStates::OscString);
+        }
+        // The string stops growing at the limit, and isn't cached for a passthrough either.
+        VERIFY_ARE_EQUAL(mach._oscString.size(), MAX_OSC_STRING_LENGTH);
+        VERIFY_IS_TRUE(mach._oscStringOverflowed);
+        VERIFY_IS_FALSE(mach._cachedSequence.has_value());
+
+        mach.ProcessCharacter(AsciiChars::BEL);
+        VERIFY_ARE_EQUAL(mach._state, StateMachine::VTStates::Ground);
+
+        mach.ProcessString(L"\x1b]2;title");
+        VERIFY_ARE_EQUAL(mach._oscString, L"title");
+        VERIFY_IS_FALSE(mach._oscStringOverflowed);
+    }
+
     TEST_METHOD(NormalTestOscParam)
     {
         auto dispatch = std::make_unique<DummyDispatch>();
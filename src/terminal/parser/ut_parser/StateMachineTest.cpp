@@ -6,6 +6,7 @@
 #include "../../inc/consoletaeftemplates.hpp"
 
 #include "stateMachine.hpp"
+#include "InputStateMachineEngine.hpp"
 
 using namespace WEX::Common;
 using namespace WEX::Logging;
@@ -19,6 +20,7 @@ namespace Microsoft
         {
             class StateMachineTest;
             class TestStateMachineEngine;
+            class TestKeystrokeDispatch;
         };
     };
 };
@@ -33,6 +35,15 @@ public:
         printed.clear();
         passedThrough.clear();
         csiParams.clear();
+        oscParameter = 0;
+        oscString.clear();
+        oscDispatches = 0;
+        dcsId = 0;
+        dcsParams.clear();
+        dcsData.clear();
+        dcsDataCalls = 0;
+        dcsTerminated = 0;
+        dcsCancelled = 0;
     }
 
     bool ActionExecute(const wchar_t /* wch */) override { return true; };
@@ -59,9 +70,12 @@ public:
     bool ActionIgnore() override { return true; };
 
     bool ActionOscDispatch(const wchar_t /* wch */,
-                           const size_t /* parameter */,
-                           const std::wstring_view /* string */) override
+                           const size_t parameter,
+                           const std::wstring_view string) override
     {
+        oscParameter = parameter;
+        oscString = string;
+        oscDispatches++;
         if (pfnFlushToTerminal)
         {
             pfnFlushToTerminal();
@@ -72,6 +86,36 @@ public:
 
     bool ActionSs3Dispatch(const wchar_t /* wch */, const VTParameters /* parameters */) override { return true; };
 
+    bool ActionDcsDispatch(const VTID id, const VTParameters parameters) override
+    {
+        dcsId = id;
+        for (size_t i = 0; i < parameters.size(); i++)
+        {
+            dcsParams.push_back(parameters.at(i).value_or(0));
+        }
+        return true;
+    };
+
+    bool ActionDcsPassThrough(const std::wstring_view string) override
+    {
+        dcsData += string;
+        dcsDataCalls++;
+        return true;
+    };
+
+    bool ActionDcsEnd(const bool cancelled) override
+    {
+        if (cancelled)
+        {
+            dcsCancelled++;
+        }
+        else
+        {
+            dcsTerminated++;
+        }
+        return true;
+    };
+
     bool ParseControlSequenceAfterSs3() const override { return false; }
     bool FlushAtEndOfString() const override { return false; };
     bool DispatchControlCharsFromEscape() const override { return false; };
@@ -99,6 +143,20 @@ public:
     // This will only be populated if ActionCsiDispatch is called.
     std::vector<size_t> csiParams;
 
+    // The last OSC sequence, and how many were dispatched.
+    size_t oscParameter = 0;
+    std::wstring oscString;
+    size_t oscDispatches = 0;
+
+    // The last DCS sequence (or 0), its data string, how many calls it was
+    // delivered in, and how many sequences were terminated or cancelled.
+    uint64_t dcsId = 0;
+    std::vector<size_t> dcsParams;
+    std::wstring dcsData;
+    size_t dcsDataCalls = 0;
+    size_t dcsTerminated = 0;
+    size_t dcsCancelled = 0;
+
     // Flush function for pass-through test.
     std::function<bool()> pfnFlushToTerminal;
 
@@ -109,6 +167,52 @@ public:
     std::wstring printed;
 };
 
+// Collects the text that the input engine types, for tests that need an
+// engine which flushes at the end of every string.
+class Microsoft::Console::VirtualTerminal::TestKeystrokeDispatch final : public IInteractDispatch
+{
+public:
+    bool WriteInput(std::deque<std::unique_ptr<IInputEvent>>& inputEvents) override
+    {
+        for (const auto& event : inputEvents)
+        {
+            if (event->EventType() == InputEventType::KeyEvent)
+            {
+                const auto& key = static_cast<const KeyEvent&>(*event);
+                if (key.IsKeyDown())
+                {
+                    typed.push_back(key.GetCharData());
+                }
+            }
+        }
+        return true;
+    }
+
+    bool WriteCtrlKey(const KeyEvent& event) override
+    {
+        typed.push_back(event.GetCharData());
+        return true;
+    }
+
+    bool WriteString(const std::wstring_view string) override
+    {
+        typed += string;
+        return true;
+    }
+
+    bool WindowManipulation(const DispatchTypes::WindowManipulationType /*function*/,
+                            const VTParameter /*parameter1*/,
+                            const VTParameter /*parameter2*/) override
+    {
+        return true;
+    }
+
+    bool MoveCursor(const size_t /*row*/, const size_t /*col*/) override { return true; }
+    bool IsVtInputEnabled() const override { return false; }
+
+    std::wstring typed;
+};
+
 class Microsoft::Console::VirtualTerminal::StateMachineTest
 {
     TEST_CLASS(StateMachineTest);
@@ -128,7 +232,18 @@ class Microsoft::Console::VirtualTerminal::StateMachineTest
     TEST_METHOD(PassThroughUnhandled);
     TEST_METHOD(RunStorageBeforeEscape);
     TEST_METHOD(BulkTextPrint);
+    TEST_METHOD(BulkTextPrintStopsAtEveryOffset);
     TEST_METHOD(PassThroughUnhandledSplitAcrossWrites);
+    TEST_METHOD(Utf8TextPrint);
+    TEST_METHOD(Utf8SplitAcrossWrites);
+    TEST_METHOD(Utf8SplitInterruptedByEscape);
+    TEST_METHOD(OscStringInBulk);
+    TEST_METHOD(OscStringTooLong);
+    TEST_METHOD(DcsDataStringInBulk);
+    TEST_METHOD(DcsDataStringSplitAcrossWrites);
+    TEST_METHOD(DcsDataStringCancelled);
+    TEST_METHOD(Utf8InputFlushesIncompleteStrings);
+    TEST_METHOD(StatisticsCountSequencesAndStates);
 };
 
 void StateMachineTest::TwoStateMachinesDoNotInterfereWithEachother()
@@ -201,6 +316,42 @@ void StateMachineTest::BulkTextPrint()
     VERIFY_ARE_EQUAL(String(L"12345 Hello World"), String(engine.printed.c_str()));
 }
 
+void StateMachineTest::BulkTextPrintStopsAtEveryOffset()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // The printable characters on either side of the actionable ranges, plus a
+    // few whose high or low byte alone would look like a control character.
+    const std::wstring_view printable{ L" ~\xA0\x7F7F\x1F00\x9F41\x0100\xFFFF" };
+    const std::wstring_view actionable{ L"\x00\x0D\x1F\x7F", 4 };
+
+    for (const auto control : actionable)
+    {
+        // Cover every position in and around a couple of vectorized blocks.
+        for (size_t offset = 0; offset < 40; offset++)
+        {
+            std::wstring leading, trailing;
+            for (size_t i = 0; i < offset; i++)
+            {
+                leading += til::at(printable, i % printable.size());
+            }
+            for (size_t i = 0; i < 40 - offset; i++)
+            {
+                trailing += til::at(printable, i % printable.size());
+            }
+
+            engine.ResetTestState();
+            machine.ProcessString(leading + control + trailing);
+
+            Log::Comment(NoThrowString().Format(L"Control 0x%02x at offset %zu", control, offset));
+            VERIFY_ARE_EQUAL(leading + trailing, engine.printed);
+        }
+    }
+}
+
 void StateMachineTest::PassThroughUnhandledSplitAcrossWrites()
 {
     auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
@@ -246,3 +397,351 @@ void StateMachineTest::PassThroughUnhandledSplitAcrossWrites()
     VERIFY_ARE_EQUAL(L"\x1b]99;foo\x1b\\", engine.passedThrough);
     VERIFY_ARE_EQUAL(L"", engine.printed);
 }
+
+void StateMachineTest::Utf8TextPrint()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // Hook up the passthrough function.
+    engine.pfnFlushToTerminal = std::bind(&StateMachine::FlushToTerminal, &machine);
+
+    // "Grüße ", a C1 CSI sequence, U+00A0 (which shares its lead byte with the C1 controls) and U+4E2D.
+    machine.ProcessString("Gr\xC3\xBC\xC3\x9F" "e \xC2\x9B?999h\xC2\xA0\xE4\xB8\xAD");
+
+    VERIFY_ARE_EQUAL(L"Gr\x00FC\x00DF" L"e \x00A0\x4E2D", engine.printed);
+    VERIFY_ARE_EQUAL(L"\x9B?999h", engine.passedThrough);
+}
+
+void StateMachineTest::Utf8SplitAcrossWrites()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // Hook up the passthrough function.
+    engine.pfnFlushToTerminal = std::bind(&StateMachine::FlushToTerminal, &machine);
+
+    // A code point split in printable text.
+    machine.ProcessString("a\xE4");
+    machine.ProcessString("\xB8");
+    machine.ProcessString("\xAD" "b");
+    VERIFY_ARE_EQUAL(L"a\x4E2D" L"b", engine.printed);
+
+    engine.ResetTestState();
+
+    // A C1 control split from its sequence, and a code point split inside of it.
+    machine.ProcessString("\xC2");
+    machine.ProcessString("\x9D" "0;\xC3");
+    machine.ProcessString("\xBC\x07");
+    VERIFY_ARE_EQUAL(L"", engine.printed);
+    VERIFY_ARE_EQUAL(L"\x9D" L"0;\x00FC\x07", engine.passedThrough);
+}
+
+void StateMachineTest::Utf8SplitInterruptedByEscape()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // A write that ends in the lead byte of a code point, followed by one that starts with an escape sequence.
+    machine.ProcessString("a\xE2");
+    machine.ProcessString("\x1b[31mb");
+    VERIFY_ARE_EQUAL(L"a\xFFFD" L"b", engine.printed);
+    VERIFY_ARE_EQUAL(1u, engine.csiParams.size());
+    VERIFY_ARE_EQUAL(31u, engine.csiParams.at(0));
+
+    engine.ResetTestState();
+
+    // The same, after a continuation byte that did arrive. Whether the two
+    // bytes become one U+FFFD or two is up to the conversion.
+    machine.ProcessString("\xE4");
+    machine.ProcessString("\xB8");
+    machine.ProcessString("\x1b[4m");
+    VERIFY_IS_FALSE(engine.printed.empty());
+    VERIFY_ARE_EQUAL(std::wstring::npos, engine.printed.find_first_not_of(L'\xFFFD'));
+    VERIFY_ARE_EQUAL(1u, engine.csiParams.size());
+    VERIFY_ARE_EQUAL(4u, engine.csiParams.at(0));
+
+    engine.ResetTestState();
+
+    // An incomplete code point in the middle of a single write.
+    machine.ProcessString("c\xE2\x1b[7md");
+    VERIFY_ARE_EQUAL(L"c\xFFFD" L"d", engine.printed);
+    VERIFY_ARE_EQUAL(1u, engine.csiParams.size());
+    VERIFY_ARE_EQUAL(7u, engine.csiParams.at(0));
+}
+
+void StateMachineTest::OscStringInBulk()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // DEL and non-ASCII characters are stored along with the rest, C0 controls are ignored.
+    machine.ProcessString(L"\x1b]2;T\x00EBst\x7f\r title\x07");
+    VERIFY_ARE_EQUAL(2u, engine.oscParameter);
+    VERIFY_ARE_EQUAL(L"T\x00EBst\x7f title", engine.oscString);
+    VERIFY_ARE_EQUAL(1u, engine.oscDispatches);
+
+    engine.ResetTestState();
+
+    // Split across writes, and during the terminator.
+    machine.ProcessString(L"\x1b]0;ab");
+    machine.ProcessString(L"cd\x1b");
+    VERIFY_ARE_EQUAL(0u, engine.oscDispatches);
+    machine.ProcessString(L"\\");
+    VERIFY_ARE_EQUAL(L"abcd", engine.oscString);
+    VERIFY_ARE_EQUAL(1u, engine.oscDispatches);
+
+    engine.ResetTestState();
+
+    // The same for UTF-8 text, with a code point split across writes.
+    machine.ProcessString("\x1b]2;T\xC3");
+    machine.ProcessString("\xABst\x07");
+    VERIFY_ARE_EQUAL(L"T\x00EBst", engine.oscString);
+    VERIFY_ARE_EQUAL(1u, engine.oscDispatches);
+}
+
+void StateMachineTest::OscStringTooLong()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // Hook up the passthrough function.
+    engine.pfnFlushToTerminal = std::bind(&StateMachine::FlushToTerminal, &machine);
+
+    const std::wstring longest(MAX_OSC_STRING_LENGTH, L'A');
+
+    Log::Comment(L"A string of the maximum length is dispatched.");
+    machine.ProcessString(L"\x1b]52;" + longest + L"\x07");
+    VERIFY_ARE_EQUAL(1u, engine.oscDispatches);
+    VERIFY_ARE_EQUAL(longest, engine.oscString);
+
+    engine.ResetTestState();
+
+    Log::Comment(L"A longer string is ignored, even when it's written in pieces.");
+    machine.ProcessString(L"\x1b]52;" + longest);
+    machine.ProcessString(L"AAAA");
+    machine.ProcessString(longest + L"\x1b\\");
+    VERIFY_ARE_EQUAL(0u, engine.oscDispatches);
+    VERIFY_ARE_EQUAL(L"", engine.passedThrough);
+    VERIFY_ARE_EQUAL(L"", engine.printed);
+
+    Log::Comment(L"The next sequence is dispatched as usual.");
+    machine.ProcessString(L"\x1b]2;title\x07");
+    VERIFY_ARE_EQUAL(1u, engine.oscDispatches);
+    VERIFY_ARE_EQUAL(L"title", engine.oscString);
+}
+
+void StateMachineTest::DcsDataStringInBulk()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // A sixel image, which is passed through along with its C0 controls.
+    machine.ProcessString(L"\x1bP0;1q#0;2;0;0;0#1!80~\r-\x1b\\after");
+
+    VERIFY_ARE_EQUAL(static_cast<uint64_t>(VTID("q")), engine.dcsId);
+    std::vector<size_t> expectedParams{ 0u, 1u };
+    VERIFY_ARE_EQUAL(expectedParams, engine.dcsParams);
+    VERIFY_ARE_EQUAL(L"#0;2;0;0;0#1!80~\r-", engine.dcsData);
+    VERIFY_ARE_EQUAL(1u, engine.dcsDataCalls); // the whole data string in one call
+    VERIFY_ARE_EQUAL(1u, engine.dcsTerminated);
+    VERIFY_ARE_EQUAL(0u, engine.dcsCancelled);
+    VERIFY_ARE_EQUAL(L"after", engine.printed);
+
+    engine.ResetTestState();
+
+    // Characters that are ignored in the data string split it, but don't end it.
+    machine.ProcessString(L"\x1bP$qab\x7f" L"cd\x00E9" L"ef\x9C");
+
+    VERIFY_ARE_EQUAL(static_cast<uint64_t>(VTID("$q")), engine.dcsId);
+    VERIFY_ARE_EQUAL(L"abcdef", engine.dcsData);
+    VERIFY_ARE_EQUAL(3u, engine.dcsDataCalls);
+    VERIFY_ARE_EQUAL(1u, engine.dcsTerminated);
+    VERIFY_ARE_EQUAL(0u, engine.dcsCancelled);
+}
+
+void StateMachineTest::DcsDataStringSplitAcrossWrites()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // Hook up the passthrough function.
+    engine.pfnFlushToTerminal = std::bind(&StateMachine::FlushToTerminal, &machine);
+
+    // The data string is handed over as it arrives, and split during the terminator.
+    machine.ProcessString(L"\x1bPq");
+    VERIFY_ARE_EQUAL(static_cast<uint64_t>(VTID("q")), engine.dcsId);
+    VERIFY_ARE_EQUAL(L"", engine.dcsData);
+
+    machine.ProcessString(L"abc");
+    VERIFY_ARE_EQUAL(L"abc", engine.dcsData);
+
+    machine.ProcessString(L"def\x1b");
+    VERIFY_ARE_EQUAL(L"abcdef", engine.dcsData);
+    VERIFY_ARE_EQUAL(0u, engine.dcsTerminated);
+
+    machine.ProcessString(L"\\");
+    VERIFY_ARE_EQUAL(2u, engine.dcsDataCalls);
+    VERIFY_ARE_EQUAL(1u, engine.dcsTerminated);
+
+    // None of it is flushed to the terminal or printed.
+    VERIFY_ARE_EQUAL(L"", engine.passedThrough);
+    VERIFY_ARE_EQUAL(L"", engine.printed);
+
+    engine.ResetTestState();
+
+    // The same for UTF-8 text, ending with a split C1 ST.
+    machine.ProcessString("\x1bPqab");
+    machine.ProcessString("cd\xC2");
+    machine.ProcessString("\x9C" "after");
+    VERIFY_ARE_EQUAL(L"abcd", engine.dcsData);
+    VERIFY_ARE_EQUAL(2u, engine.dcsDataCalls);
+    VERIFY_ARE_EQUAL(1u, engine.dcsTerminated);
+    VERIFY_ARE_EQUAL(L"", engine.passedThrough);
+    VERIFY_ARE_EQUAL(L"after", engine.printed);
+}
+
+void StateMachineTest::DcsDataStringCancelled()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // Cancelled by CAN.
+    machine.ProcessString(L"\x1bPqab\x18" L"after");
+    VERIFY_ARE_EQUAL(L"ab", engine.dcsData);
+    VERIFY_ARE_EQUAL(0u, engine.dcsTerminated);
+    VERIFY_ARE_EQUAL(1u, engine.dcsCancelled);
+    VERIFY_ARE_EQUAL(L"after", engine.printed);
+
+    engine.ResetTestState();
+
+    // Cancelled by an escape sequence other than ST, which is still dispatched.
+    machine.ProcessString(L"\x1bPqab\x1b[3m");
+    VERIFY_ARE_EQUAL(L"ab", engine.dcsData);
+    VERIFY_ARE_EQUAL(1u, engine.dcsCancelled);
+    std::vector<size_t> expectedCsi{ 3u };
+    VERIFY_ARE_EQUAL(expectedCsi, engine.csiParams);
+
+    engine.ResetTestState();
+
+    // Cancelled by a C1 control, and by an ESC right after the ESC of the terminator.
+    machine.ProcessString(L"\x1bPqab\x9B" L"4m\x1bPqcd\x1b\x1b[5m");
+    VERIFY_ARE_EQUAL(L"abcd", engine.dcsData);
+    VERIFY_ARE_EQUAL(0u, engine.dcsTerminated);
+    VERIFY_ARE_EQUAL(2u, engine.dcsCancelled);
+    expectedCsi = { 4u, 5u };
+    VERIFY_ARE_EQUAL(expectedCsi, engine.csiParams);
+
+    engine.ResetTestState();
+
+    // A sequence that's ignored because of an invalid character is never dispatched.
+    machine.ProcessString(L"\x1bP1:2qab\x1b\\");
+    VERIFY_ARE_EQUAL(0u, engine.dcsId);
+    VERIFY_ARE_EQUAL(L"", engine.dcsData);
+    VERIFY_ARE_EQUAL(0u, engine.dcsTerminated);
+    VERIFY_ARE_EQUAL(0u, engine.dcsCancelled);
+}
+
+void StateMachineTest::Utf8InputFlushesIncompleteStrings()
+{
+    auto dispatchPtr{ std::make_unique<TestKeystrokeDispatch>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& dispatch{ *dispatchPtr.get() };
+    StateMachine machine{ std::make_unique<InputStateMachineEngine>(std::move(dispatchPtr)) };
+
+    Log::Comment(L"A DCS data string that isn't terminated by the end of the string is cancelled.");
+    machine.ProcessString(std::string_view{ "\x1bPqabc" });
+    machine.ProcessString(std::string_view{ "x" });
+    VERIFY_ARE_EQUAL(L"x", dispatch.typed);
+
+    dispatch.typed.clear();
+
+    Log::Comment(L"So is one that only got as far as the terminator.");
+    machine.ProcessString(std::string_view{ "\x1bPqabc\x1b" });
+    machine.ProcessString(std::string_view{ "y" });
+    VERIFY_ARE_EQUAL(L"y", dispatch.typed);
+
+    dispatch.typed.clear();
+
+    Log::Comment(L"An OSC string that got too long is dropped, rather than typed.");
+    const std::string longest(MAX_OSC_STRING_LENGTH + 1, 'A');
+    machine.ProcessString(std::string_view{ "\x1b]52;" + longest });
+    machine.ProcessString(std::string_view{ "z" });
+    VERIFY_ARE_EQUAL(L"z", dispatch.typed);
+}
+
+void StateMachineTest::StatisticsCountSequencesAndStates()
+{
+    StateMachine machine{ std::make_unique<TestStateMachineEngine>() };
+
+    machine.ProcessString(L"ab\x1b[1;2mcd\x1b]2;title\x07\r\n");
+    const auto before = machine.GetStatistics();
+
+    if constexpr (!ParserStatistics::IsEnabled)
+    {
+        Log::Comment(L"The parser was built without VT_PARSER_STATISTICS, so nothing is counted.");
+        VERIFY_IS_TRUE(before.sequences.empty());
+        VERIFY_IS_TRUE(before.states.empty());
+        VERIFY_ARE_EQUAL(0u, before.printedCharacters);
+    }
+    else
+    {
+        const auto countOf = [](const ParserStatistics::Snapshot& snapshot, const ParserStatistics::SequenceKind kind, const uint64_t id) {
+            const auto it = snapshot.sequences.find({ kind, id });
+            return it == snapshot.sequences.end() ? uint64_t{ 0 } : it->second.count;
+        };
+        const auto charactersIn = [](const ParserStatistics::Snapshot& snapshot, const std::wstring_view state) {
+            for (const auto& counters : snapshot.states)
+            {
+                if (counters.state == state)
+                {
+                    return counters.characters;
+                }
+            }
+            return uint64_t{ 0 };
+        };
+
+        Log::Comment(L"Sequences are counted by their identifier.");
+        VERIFY_ARE_EQUAL(1u, countOf(before, ParserStatistics::SequenceKind::Csi, VTID("m")));
+        VERIFY_ARE_EQUAL(1u, countOf(before, ParserStatistics::SequenceKind::Osc, 2));
+        VERIFY_ARE_EQUAL(1u, countOf(before, ParserStatistics::SequenceKind::Execute, L'\r'));
+        VERIFY_ARE_EQUAL(1u, countOf(before, ParserStatistics::SequenceKind::Execute, L'\n'));
+        VERIFY_ARE_EQUAL(4u, before.printedCharacters);
+
+        Log::Comment(L"Every character is counted in the state it was consumed in.");
+        VERIFY_ARE_EQUAL(8u, charactersIn(before, L"Ground"));
+        VERIFY_ARE_EQUAL(3u, charactersIn(before, L"CsiParam"));
+        VERIFY_ARE_EQUAL(6u, charactersIn(before, L"OscString"));
+
+        Log::Comment(L"The difference between snapshots only holds what was processed in between.");
+        machine.ProcessString("\x1b[mxyz");
+        const auto difference = machine.GetStatistics() - before;
+        VERIFY_ARE_EQUAL(1u, countOf(difference, ParserStatistics::SequenceKind::Csi, VTID("m")));
+        VERIFY_ARE_EQUAL(0u, countOf(difference, ParserStatistics::SequenceKind::Osc, 2));
+        VERIFY_ARE_EQUAL(3u, difference.printedCharacters);
+        VERIFY_ARE_EQUAL(4u, charactersIn(difference, L"Ground"));
+
+        Log::Comment(L"Resetting the statistics sets every counter back to zero.");
+        machine.ResetStatistics();
+        const auto after = machine.GetStatistics();
+        VERIFY_IS_TRUE(after.sequences.empty());
+        VERIFY_ARE_EQUAL(0u, after.printedCharacters);
+        VERIFY_ARE_EQUAL(0u, charactersIn(after, L"Ground"));
+    }
+}
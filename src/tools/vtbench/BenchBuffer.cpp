@@ -0,0 +1,684 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "BenchBuffer.hpp"
+
+#include "..\..\inc\unicode.hpp"
+
+using namespace Microsoft::Console::Types;
+using namespace Microsoft::Console::VirtualTerminal;
+
+static constexpr UINT s_cursorSize = 25;
+
+BenchBuffer::BenchBuffer(const COORD viewportSize, const SHORT totalRows) :
+    _viewport{ Viewport::FromDimensions({ 0, 0 }, viewportSize) },
+    _scrollMargins{ 0 },
+    _autoWrap{ true },
+    _invalidated{ false }
+{
+    const COORD bufferSize{ viewportSize.X, std::max(viewportSize.Y, totalRows) };
+    _buffer = std::make_unique<TextBuffer>(bufferSize, TextAttribute{}, s_cursorSize, *this);
+}
+
+TextBuffer& BenchBuffer::GetTextBuffer() noexcept
+{
+    return *_buffer;
+}
+
+const TextBuffer& BenchBuffer::GetTextBuffer() const noexcept
+{
+    return *_buffer;
+}
+
+Viewport BenchBuffer::GetViewport() const noexcept
+{
+    return _viewport;
+}
+
+void BenchBuffer::SetViewport(const Viewport viewport) noexcept
+{
+    _viewport = viewport;
+}
+
+// Routine Description:
+// - Sets the DECSTBM margins, relative to the top of the viewport.
+//   A top margin that isn't above the bottom margin clears them.
+// Arguments:
+// - scrollMargins - The inclusive top and bottom rows of the scrolling region.
+// Return Value:
+// - <none>
+void BenchBuffer::SetScrollMargins(const SMALL_RECT& scrollMargins) noexcept
+{
+    _scrollMargins = scrollMargins;
+}
+
+void BenchBuffer::SetAutoWrap(const bool wrapAtEOL) noexcept
+{
+    _autoWrap = wrapAtEOL;
+}
+
+// Routine Description:
+// - Changes the size of the viewport and reflows the buffer into it with
+//   TextBuffer::Reflow. The total number of rows is kept. The viewport keeps
+//   the cursor at the same height in it, where possible, and the scrolling
+//   margins are cleared.
+// Arguments:
+// - viewportSize - The new size of the viewport.
+// Return Value:
+// - <none>
+void BenchBuffer::Resize(const COORD viewportSize)
+{
+    const COORD bufferSize{ viewportSize.X, std::max(viewportSize.Y, _buffer->GetSize().Height()) };
+    auto newBuffer = std::make_unique<TextBuffer>(bufferSize, _buffer->GetCurrentAttributes(), s_cursorSize, *this);
+
+    const auto cursorHeightBefore = _buffer->GetCursor().GetPosition().Y - _viewport.Top();
+    THROW_IF_FAILED(TextBuffer::Reflow(*_buffer, *newBuffer, std::nullopt, std::nullopt));
+    _buffer.swap(newBuffer);
+    _buffer->AdoptReflowSource(std::move(newBuffer));
+
+    const auto cursorY = _buffer->GetCursor().GetPosition().Y;
+    const auto maxTop = bufferSize.Y - viewportSize.Y;
+    const auto top = std::clamp(cursorY - std::clamp(cursorHeightBefore, 0, viewportSize.Y - 1), 0, maxTop);
+    _viewport = Viewport::FromDimensions({ 0, gsl::narrow_cast<SHORT>(top) }, viewportSize);
+    _scrollMargins = { 0 };
+
+    TriggerRedrawAll();
+}
+
+// Routine Description:
+// - Writes printable text at the cursor, a row at a time, wrapping onto the
+//   next row and scrolling as needed. Printable ASCII goes through
+//   TextBuffer::WriteAscii and everything else through WriteLine.
+// Arguments:
+// - string - The text to write.
+// Return Value:
+// - <none>
+void BenchBuffer::WriteText(const std::wstring_view string)
+{
+    auto& cursor = _buffer->GetCursor();
+    cursor.StartDeferDrawing();
+
+    const auto attributes = _buffer->GetCurrentAttributes();
+    auto remaining = string;
+    while (!remaining.empty())
+    {
+        auto position = cursor.GetPosition();
+        size_t consumed = 0;
+        if (const auto ascii = TextBuffer::MeasurePrintableAscii(remaining); ascii != 0)
+        {
+            consumed = _buffer->WriteAscii(remaining.substr(0, ascii), position, attributes, _autoWrap);
+            position.X += gsl::narrow<SHORT>(consumed);
+        }
+        else
+        {
+            const auto end = std::find_if(remaining.begin() + 1, remaining.end(), [](const wchar_t wch) noexcept {
+                return wch >= L' ' && wch <= L'~';
+            });
+            const OutputCellIterator it{ remaining.substr(0, gsl::narrow_cast<size_t>(end - remaining.begin())), attributes };
+            const auto itEnd = _buffer->WriteLine(it, position, _autoWrap);
+            consumed = gsl::narrow_cast<size_t>(itEnd.GetInputDistance(it));
+            position.X += gsl::narrow<SHORT>(itEnd.GetCellDistance(it));
+        }
+        remaining = remaining.substr(consumed);
+
+        if (consumed == 0)
+        {
+            // Nothing more fits on this row. Without DECAWM, the rest is
+            // discarded. Otherwise it goes on the next row, unless it
+            // didn't even fit on an empty one.
+            if (!_autoWrap || position.X == 0)
+            {
+                break;
+            }
+            position.X = 0;
+            position.Y++;
+        }
+        _AdjustCursorPosition(position);
+    }
+
+    cursor.EndDeferDrawing();
+}
+
+void BenchBuffer::SetCursorPosition(const COORD position)
+{
+    auto clamped = position;
+    _buffer->GetSize().Clamp(clamped);
+    _buffer->GetCursor().SetPosition(clamped);
+}
+
+// Routine Description:
+// - Moves the cursor down one line, and possibly also to the leftmost column.
+//   At the bottom of the scrolling region the region content moves up instead.
+// Arguments:
+// - withReturn - Set to true if a carriage return should be performed as well.
+// Return Value:
+// - <none>
+void BenchBuffer::LineFeed(const bool withReturn)
+{
+    auto& cursor = _buffer->GetCursor();
+    auto position = cursor.GetPosition();
+    _buffer->GetRowByOffset(position.Y).GetCharRow().SetWrapForced(false);
+
+    if (withReturn)
+    {
+        position.X = 0;
+    }
+
+    if (_AreMarginsSet() && position.Y == _BottomMargin())
+    {
+        const SMALL_RECT margins{ 0, _TopMargin(), SHORT_MAX, _BottomMargin() };
+        ScrollRegion(margins, margins, { 0, gsl::narrow_cast<SHORT>(_TopMargin() - 1) }, GetEraseAttributes(true));
+        cursor.SetPosition(position);
+    }
+    else
+    {
+        position.Y++;
+        _AdjustCursorPosition(position);
+    }
+}
+
+// Routine Description:
+// - Moves the cursor up one line. At the top of the viewport (or margins), the
+//   content is shifted down instead.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void BenchBuffer::ReverseLineFeed()
+{
+    auto& cursor = _buffer->GetCursor();
+    const auto position = cursor.GetPosition();
+    const auto top = _AreMarginsSet() ? _TopMargin() : _viewport.Top();
+
+    if (position.Y > top)
+    {
+        cursor.SetPosition({ position.X, gsl::narrow_cast<SHORT>(position.Y - 1) });
+    }
+    else if (_IsCursorInMargins(position))
+    {
+        const auto bottom = _AreMarginsSet() ? _BottomMargin() : _viewport.BottomInclusive();
+        const SMALL_RECT scrollRect{ 0, top, SHORT_MAX, bottom };
+        ScrollRegion(scrollRect, scrollRect, { 0, gsl::narrow_cast<SHORT>(top + 1) }, GetEraseAttributes(true));
+    }
+}
+
+// Routine Description:
+// - IL/DL - Inserts or deletes lines at the cursor by scrolling the rest of
+//   the scrolling region down or up.
+// Arguments:
+// - count - The number of lines to insert or delete.
+// - insert - true to insert lines, false to delete them.
+// Return Value:
+// - <none>
+void BenchBuffer::ModifyLines(const size_t count, const bool insert)
+{
+    auto& cursor = _buffer->GetCursor();
+    const auto position = cursor.GetPosition();
+    if (_IsCursorInMargins(position))
+    {
+        const auto bottom = _AreMarginsSet() ? _BottomMargin() : _viewport.BottomInclusive();
+        const SMALL_RECT scrollRect{ 0, position.Y, SHORT_MAX, bottom };
+        const auto distance = gsl::narrow_cast<SHORT>(std::min<size_t>(count, SHORT_MAX));
+        const COORD destination{ 0, gsl::narrow_cast<SHORT>(insert ? position.Y + distance : position.Y - distance) };
+        ScrollRegion(scrollRect, scrollRect, destination, GetEraseAttributes(true));
+        cursor.SetPosition({ 0, position.Y });
+    }
+}
+
+// Routine Description:
+// - ED2 in a VT session - Moves the viewport below the last written line,
+//   so the old content is kept in the scrollback, and clears the new viewport.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void BenchBuffer::EraseAll()
+{
+    auto& cursor = _buffer->GetCursor();
+    auto relativeCursor = cursor.GetPosition();
+    _viewport.ConvertToOrigin(&relativeCursor);
+
+    auto newTop = gsl::narrow_cast<SHORT>(_buffer->GetLastNonSpaceCharacter().Y + 1);
+    for (auto i = newTop + _viewport.Height() - _buffer->GetSize().Height(); i > 0; i--)
+    {
+        _buffer->IncrementCircularBuffer(true);
+        newTop--;
+    }
+
+    _viewport = Viewport::FromDimensions({ 0, newTop }, _viewport.Dimensions());
+    _viewport.ConvertFromOrigin(&relativeCursor);
+    cursor.SetPosition(relativeCursor);
+    _buffer->FillRect(UNICODE_SPACE, GetEraseAttributes(true), _viewport);
+}
+
+void BenchBuffer::FillRegion(const COORD startPosition,
+                             const size_t fillLength,
+                             const wchar_t fillChar,
+                             const TextAttribute& fillAttrs)
+{
+    _buffer->FillCells(fillChar, fillAttrs, startPosition, fillLength, false);
+}
+
+// Routine Description:
+// - Moves a block of cells to a new origin within the clip, and blanks the
+//   part of the block that was uncovered. Blocks of whole rows are rotated
+//   with TextBuffer::ScrollRows, anything else is copied a row at a time.
+// Arguments:
+// - scrollRect - Inclusive region to copy/move (source and size).
+// - clipRect - Optional inclusive clip region to contain buffer change effects.
+// - destinationOrigin - Upper left corner of target region.
+// - fillAttrs - Attributes to fill the uncovered region with.
+// Return Value:
+// - <none>
+void BenchBuffer::ScrollRegion(const SMALL_RECT scrollRect,
+                               const std::optional<SMALL_RECT> clipRect,
+                               const COORD destinationOrigin,
+                               const TextAttribute& fillAttrs)
+{
+    const auto bufferSize = _buffer->GetSize();
+    const auto clip = Viewport::Intersect(bufferSize, Viewport::FromInclusive(clipRect.value_or(bufferSize.ToInclusive())));
+    const auto source = Viewport::Intersect(clip, Viewport::FromInclusive(scrollRect));
+    if (!source.IsValid())
+    {
+        return;
+    }
+
+    const COORD delta{ gsl::narrow_cast<SHORT>(destinationOrigin.X - scrollRect.Left), gsl::narrow_cast<SHORT>(destinationOrigin.Y - scrollRect.Top) };
+    const auto target = Viewport::Intersect(clip, Viewport::Offset(source, delta));
+    if (target.IsValid())
+    {
+        // The part of the source that has somewhere to go.
+        const auto from = Viewport::Offset(target, { gsl::narrow_cast<SHORT>(-delta.X), gsl::narrow_cast<SHORT>(-delta.Y) });
+        if (delta.X == 0 && from.Width() == bufferSize.Width())
+        {
+            _buffer->ScrollRows(from.Top(), from.Height(), delta.Y);
+        }
+        else
+        {
+            // Going down, the bottom row is copied first so that no row is
+            // overwritten before it's read.
+            std::vector<OutputCell> cells;
+            for (SHORT i = 0; i < target.Height(); ++i)
+            {
+                const auto row = gsl::narrow_cast<SHORT>(delta.Y > 0 ? target.Height() - 1 - i : i);
+                const auto sourceRow = Viewport::FromDimensions({ from.Left(), gsl::narrow_cast<SHORT>(from.Top() + row) }, { from.Width(), 1 });
+                cells.clear();
+                for (auto it = _buffer->GetCellDataAt(sourceRow.Origin(), sourceRow); it; ++it)
+                {
+                    cells.emplace_back(*it);
+                }
+                const COORD rowTarget{ target.Left(), gsl::narrow_cast<SHORT>(target.Top() + row) };
+                _buffer->WriteLine(OutputCellIterator{ gsl::span<const OutputCell>{ cells } }, rowTarget, false, target.RightInclusive());
+            }
+        }
+    }
+
+    for (const auto& view : Viewport::Subtract(source, target))
+    {
+        _buffer->FillRect(UNICODE_SPACE, fillAttrs, view);
+    }
+}
+
+// Routine Description:
+// - Most VT erase operations fill with the current background color but no
+//   other meta attributes. Everything else fills with the default attributes.
+// Arguments:
+// - standardFillAttrs - If true, use the standard erase attributes.
+// Return Value:
+// - The attributes to fill with.
+TextAttribute BenchBuffer::GetEraseAttributes(const bool standardFillAttrs) const noexcept
+{
+    auto fillAttrs = TextAttribute{};
+    if (standardFillAttrs)
+    {
+        fillAttrs = _buffer->GetCurrentAttributes();
+        fillAttrs.SetStandardErase();
+    }
+    return fillAttrs;
+}
+
+// Routine Description:
+// - Returns whether anything was invalidated since the last call, which is
+//   when a renderer would have painted a frame.
+bool BenchBuffer::ConsumeInvalidation() noexcept
+{
+    return std::exchange(_invalidated, false);
+}
+
+void BenchBuffer::TriggerRedraw(const Viewport& /*region*/)
+{
+    _invalidated = true;
+}
+
+void BenchBuffer::TriggerRedraw(const COORD* const /*pcoord*/)
+{
+    _invalidated = true;
+}
+
+void BenchBuffer::TriggerRedrawCursor(const COORD* const /*pcoord*/)
+{
+    _invalidated = true;
+}
+
+void BenchBuffer::TriggerRedrawAll()
+{
+    _invalidated = true;
+}
+
+void BenchBuffer::TriggerTeardown()
+{
+}
+
+void BenchBuffer::TriggerSelection()
+{
+    _invalidated = true;
+}
+
+void BenchBuffer::TriggerScroll()
+{
+    _invalidated = true;
+}
+
+void BenchBuffer::TriggerScroll(const COORD* const /*pcoordDelta*/)
+{
+    _invalidated = true;
+}
+
+void BenchBuffer::TriggerCircling()
+{
+    _invalidated = true;
+}
+
+void BenchBuffer::TriggerTitleChange()
+{
+    _invalidated = true;
+}
+
+bool BenchBuffer::_AreMarginsSet() const noexcept
+{
+    return _scrollMargins.Bottom > _scrollMargins.Top;
+}
+
+bool BenchBuffer::_IsCursorInMargins(const COORD position) const noexcept
+{
+    if (!_AreMarginsSet())
+    {
+        return true;
+    }
+    return position.Y >= _TopMargin() && position.Y <= _BottomMargin();
+}
+
+SHORT BenchBuffer::_TopMargin() const noexcept
+{
+    return _viewport.Top() + _scrollMargins.Top;
+}
+
+SHORT BenchBuffer::_BottomMargin() const noexcept
+{
+    return _viewport.Top() + _scrollMargins.Bottom;
+}
+
+// Routine Description:
+// - Moves the cursor, cycling the circular buffer if it would move past the
+//   last row and pulling the viewport down if it would move below it.
+// Arguments:
+// - proposedPosition - The new cursor position.
+// Return Value:
+// - <none>
+void BenchBuffer::_AdjustCursorPosition(const COORD proposedPosition)
+{
+    auto position = proposedPosition;
+    const auto bufferHeight = _buffer->GetSize().Height();
+    while (position.Y >= bufferHeight)
+    {
+        _buffer->IncrementCircularBuffer(true);
+        position.Y--;
+    }
+
+    _buffer->GetCursor().SetPosition(position);
+
+    if (position.Y > _viewport.BottomInclusive())
+    {
+        const COORD newOrigin{ 0, gsl::narrow_cast<SHORT>(position.Y - _viewport.Height() + 1) };
+        _viewport = Viewport::FromDimensions(newOrigin, _viewport.Dimensions());
+    }
+}
+
+BenchGetSet::BenchGetSet(BenchBuffer& buffer) noexcept :
+    _buffer{ buffer },
+    _outputCodepage{ CP_UTF8 },
+    _lineFeedMode{ false }
+{
+}
+
+bool BenchGetSet::GetConsoleCursorInfo(CONSOLE_CURSOR_INFO& cursorInfo) const
+{
+    const auto& cursor = _buffer.GetTextBuffer().GetCursor();
+    cursorInfo.dwSize = cursor.GetSize();
+    cursorInfo.bVisible = cursor.IsVisible();
+    return true;
+}
+
+bool BenchGetSet::GetConsoleScreenBufferInfoEx(CONSOLE_SCREEN_BUFFER_INFOEX& screenBufferInfo) const
+{
+    const auto& textBuffer = _buffer.GetTextBuffer();
+    screenBufferInfo.dwSize = textBuffer.GetSize().Dimensions();
+    screenBufferInfo.dwCursorPosition = textBuffer.GetCursor().GetPosition();
+    screenBufferInfo.wAttributes = textBuffer.GetCurrentAttributes().GetLegacyAttributes();
+    // Like the console API, the window rectangle is handed out exclusive.
+    screenBufferInfo.srWindow = _buffer.GetViewport().ToExclusive();
+    screenBufferInfo.dwMaximumWindowSize = screenBufferInfo.dwSize;
+    return true;
+}
+
+bool BenchGetSet::SetConsoleCursorInfo(const CONSOLE_CURSOR_INFO& cursorInfo)
+{
+    auto& cursor = _buffer.GetTextBuffer().GetCursor();
+    cursor.SetSize(cursorInfo.dwSize);
+    cursor.SetIsVisible(cursorInfo.bVisible);
+    return true;
+}
+
+bool BenchGetSet::SetConsoleCursorPosition(const COORD position)
+{
+    _buffer.SetCursorPosition(position);
+    return true;
+}
+
+bool BenchGetSet::PrivateGetTextAttributes(TextAttribute& attrs) const
+{
+    attrs = _buffer.GetTextBuffer().GetCurrentAttributes();
+    return true;
+}
+
+bool BenchGetSet::PrivateSetTextAttributes(const TextAttribute& attrs)
+{
+    _buffer.GetTextBuffer().SetCurrentAttributes(attrs);
+    return true;
+}
+
+bool BenchGetSet::PrivateWriteConsoleInputW(std::deque<std::unique_ptr<IInputEvent>>& events,
+                                            size_t& eventsWritten)
+{
+    // There is nobody to read responses to queries, so they are dropped.
+    eventsWritten = events.size();
+    events.clear();
+    return true;
+}
+
+bool BenchGetSet::SetConsoleWindowInfo(const bool /*absolute*/,
+                                       const SMALL_RECT& window)
+{
+    _buffer.SetViewport(Viewport::FromInclusive(window));
+    return true;
+}
+
+bool BenchGetSet::PrivateSetAutoWrapMode(const bool wrapAtEOL)
+{
+    _buffer.SetAutoWrap(wrapAtEOL);
+    return true;
+}
+
+bool BenchGetSet::PrivateShowCursor(const bool show)
+{
+    _buffer.GetTextBuffer().GetCursor().SetIsVisible(show);
+    return true;
+}
+
+bool BenchGetSet::PrivateAllowCursorBlinking(const bool enable)
+{
+    _buffer.GetTextBuffer().GetCursor().SetBlinkingAllowed(enable);
+    return true;
+}
+
+bool BenchGetSet::PrivateSetScrollingRegion(const SMALL_RECT& scrollMargins)
+{
+    if (scrollMargins.Top > scrollMargins.Bottom)
+    {
+        return false;
+    }
+    _buffer.SetScrollMargins(scrollMargins);
+    return true;
+}
+
+bool BenchGetSet::PrivateGetLineFeedMode() const
+{
+    return _lineFeedMode;
+}
+
+bool BenchGetSet::PrivateLineFeed(const bool withReturn)
+{
+    _buffer.LineFeed(withReturn);
+    return true;
+}
+
+bool BenchGetSet::PrivateReverseLineFeed()
+{
+    _buffer.ReverseLineFeed();
+    return true;
+}
+
+bool BenchGetSet::PrivateEraseAll()
+{
+    _buffer.EraseAll();
+    return true;
+}
+
+bool BenchGetSet::GetUserDefaultCursorStyle(CursorType& style)
+{
+    style = CursorType::Legacy;
+    return true;
+}
+
+bool BenchGetSet::SetCursorStyle(const CursorType style)
+{
+    _buffer.GetTextBuffer().GetCursor().SetType(style);
+    return true;
+}
+
+bool BenchGetSet::SetCursorColor(const COLORREF color)
+{
+    _buffer.GetTextBuffer().GetCursor().SetColor(color);
+    return true;
+}
+
+bool BenchGetSet::SetConsoleOutputCP(const unsigned int codepage)
+{
+    _outputCodepage = codepage;
+    return true;
+}
+
+bool BenchGetSet::GetConsoleOutputCP(unsigned int& codepage)
+{
+    codepage = _outputCodepage;
+    return true;
+}
+
+bool BenchGetSet::DeleteLines(const size_t count)
+{
+    _buffer.ModifyLines(count, false);
+    return true;
+}
+
+bool BenchGetSet::InsertLines(const size_t count)
+{
+    _buffer.ModifyLines(count, true);
+    return true;
+}
+
+bool BenchGetSet::PrivateGetColorTableEntry(const size_t index, COLORREF& value) const
+{
+    if (index >= 256)
+    {
+        return false;
+    }
+    value = 0;
+    return true;
+}
+
+bool BenchGetSet::PrivateSetColorTableEntry(const size_t index, const COLORREF /*value*/) const
+{
+    return index < 256;
+}
+
+bool BenchGetSet::PrivateFillRegion(const COORD startPosition,
+                                    const size_t fillLength,
+                                    const wchar_t fillChar,
+                                    const bool standardFillAttrs)
+{
+    _buffer.FillRegion(startPosition, fillLength, fillChar, _buffer.GetEraseAttributes(standardFillAttrs));
+    return true;
+}
+
+bool BenchGetSet::PrivateScrollRegion(const SMALL_RECT scrollRect,
+                                      const std::optional<SMALL_RECT> clipRect,
+                                      const COORD destinationOrigin,
+                                      const bool standardFillAttrs)
+{
+    _buffer.ScrollRegion(scrollRect, clipRect, destinationOrigin, _buffer.GetEraseAttributes(standardFillAttrs));
+    return true;
+}
+
+bool BenchGetSet::PrivateAddHyperlink(const std::wstring_view uri, const std::wstring_view params) const
+{
+    auto& textBuffer = _buffer.GetTextBuffer();
+    auto attr = textBuffer.GetCurrentAttributes();
+    const auto id = textBuffer.GetHyperlinkId(uri, params);
+    attr.SetHyperlinkId(id);
+    textBuffer.SetCurrentAttributes(attr);
+    textBuffer.AddHyperlinkToMap(uri, id);
+    return true;
+}
+
+bool BenchGetSet::PrivateEndHyperlink() const
+{
+    auto& textBuffer = _buffer.GetTextBuffer();
+    auto attr = textBuffer.GetCurrentAttributes();
+    attr.SetHyperlinkId(0);
+    textBuffer.SetCurrentAttributes(attr);
+    return true;
+}
+
+BenchWriter::BenchWriter(BenchBuffer& buffer) noexcept :
+    _buffer{ buffer }
+{
+}
+
+void BenchWriter::Print(const wchar_t wch)
+{
+    _buffer.WriteText({ &wch, 1 });
+}
+
+void BenchWriter::PrintString(const std::wstring_view string)
+{
+    _buffer.WriteText(string);
+}
+
+// C0 controls the dispatcher doesn't handle itself end up here. The
+// benchmark renders them like any other glyph.
+void BenchWriter::Execute(const wchar_t wch)
+{
+    _buffer.WriteText({ &wch, 1 });
+}
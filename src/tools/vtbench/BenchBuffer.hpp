@@ -0,0 +1,190 @@
+/*++
+Copyright (c) Microsoft Corporation.
+Licensed under the MIT license.
+
+Module Name:
+- BenchBuffer.hpp
+
+Abstract:
+- A thin adapter that lets the benchmark drive AdaptDispatch into a bare
+  TextBuffer. It is NOT the conhost screen buffer: SCREEN_INFORMATION and the
+  stream writer in _stream.cpp (WriteCharsLegacy) aren't involved, so the
+  "textbuffer" stage approximates conhost's output path and doesn't measure
+  it. Changes to the host side of that path need a conhost run to measure.
+- BenchBuffer keeps the viewport, the margins and the wrap mode, and turns
+  every operation into one or two TextBuffer calls (WriteAscii, WriteLine,
+  FillCells, FillRect, ScrollRows, IncrementCircularBuffer, Reflow).
+- BenchGetSet and BenchWriter are the ConGetSet and AdaptDefaults adapters
+  that AdaptDispatch takes ownership of. Anything that would need a window,
+  an input buffer or a renderer is accepted and ignored.
+--*/
+
+#pragma once
+
+#include "..\..\buffer\out\textBuffer.hpp"
+#include "..\..\renderer\inc\IRenderTarget.hpp"
+#include "..\..\terminal\adapter\adaptDefaults.hpp"
+#include "..\..\terminal\adapter\conGetSet.hpp"
+
+class BenchBuffer final : public Microsoft::Console::Render::IRenderTarget
+{
+public:
+    BenchBuffer(const COORD viewportSize, const SHORT totalRows);
+
+    TextBuffer& GetTextBuffer() noexcept;
+    const TextBuffer& GetTextBuffer() const noexcept;
+
+    Microsoft::Console::Types::Viewport GetViewport() const noexcept;
+    void SetViewport(const Microsoft::Console::Types::Viewport viewport) noexcept;
+
+    void SetScrollMargins(const SMALL_RECT& scrollMargins) noexcept;
+    void SetAutoWrap(const bool wrapAtEOL) noexcept;
+    void Resize(const COORD viewportSize);
+
+    void WriteText(const std::wstring_view string);
+    void SetCursorPosition(const COORD position);
+    void LineFeed(const bool withReturn);
+    void ReverseLineFeed();
+    void ModifyLines(const size_t count, const bool insert);
+    void EraseAll();
+
+    void FillRegion(const COORD startPosition,
+                    const size_t fillLength,
+                    const wchar_t fillChar,
+                    const TextAttribute& fillAttrs);
+    void ScrollRegion(const SMALL_RECT scrollRect,
+                      const std::optional<SMALL_RECT> clipRect,
+                      const COORD destinationOrigin,
+                      const TextAttribute& fillAttrs);
+
+    TextAttribute GetEraseAttributes(const bool standardFillAttrs) const noexcept;
+
+    bool ConsumeInvalidation() noexcept;
+
+    // IRenderTarget. Nothing is rendered, these only note that a frame would be.
+    void TriggerRedraw(const Microsoft::Console::Types::Viewport& region) override;
+    void TriggerRedraw(const COORD* const pcoord) override;
+    void TriggerRedrawCursor(const COORD* const pcoord) override;
+    void TriggerRedrawAll() override;
+    void TriggerTeardown() override;
+    void TriggerSelection() override;
+    void TriggerScroll() override;
+    void TriggerScroll(const COORD* const pcoordDelta) override;
+    void TriggerCircling() override;
+    void TriggerTitleChange() override;
+
+private:
+    bool _AreMarginsSet() const noexcept;
+    bool _IsCursorInMargins(const COORD position) const noexcept;
+    SHORT _TopMargin() const noexcept;
+    SHORT _BottomMargin() const noexcept;
+    void _AdjustCursorPosition(const COORD proposedPosition);
+
+    std::unique_ptr<TextBuffer> _buffer;
+    Microsoft::Console::Types::Viewport _viewport;
+    SMALL_RECT _scrollMargins;
+    bool _autoWrap;
+    bool _invalidated;
+};
+
+class BenchGetSet final : public Microsoft::Console::VirtualTerminal::ConGetSet
+{
+public:
+    BenchGetSet(BenchBuffer& buffer) noexcept;
+
+    bool GetConsoleCursorInfo(CONSOLE_CURSOR_INFO& cursorInfo) const override;
+    bool GetConsoleScreenBufferInfoEx(CONSOLE_SCREEN_BUFFER_INFOEX& screenBufferInfo) const override;
+    bool SetConsoleCursorInfo(const CONSOLE_CURSOR_INFO& cursorInfo) override;
+    bool SetConsoleCursorPosition(const COORD position) override;
+
+    bool PrivateGetTextAttributes(TextAttribute& attrs) const override;
+    bool PrivateSetTextAttributes(const TextAttribute& attrs) override;
+
+    bool PrivateWriteConsoleInputW(std::deque<std::unique_ptr<IInputEvent>>& events,
+                                   size_t& eventsWritten) override;
+    bool SetConsoleWindowInfo(const bool absolute,
+                              const SMALL_RECT& window) override;
+
+    bool PrivateSetAutoWrapMode(const bool wrapAtEOL) override;
+
+    bool PrivateShowCursor(const bool show) override;
+    bool PrivateAllowCursorBlinking(const bool enable) override;
+
+    bool PrivateSetScrollingRegion(const SMALL_RECT& scrollMargins) override;
+    bool PrivateGetLineFeedMode() const override;
+    bool PrivateLineFeed(const bool withReturn) override;
+    bool PrivateReverseLineFeed() override;
+
+    bool PrivateEraseAll() override;
+    bool GetUserDefaultCursorStyle(CursorType& style) override;
+    bool SetCursorStyle(const CursorType style) override;
+    bool SetCursorColor(const COLORREF color) override;
+
+    bool SetConsoleOutputCP(const unsigned int codepage) override;
+    bool GetConsoleOutputCP(unsigned int& codepage) override;
+
+    bool DeleteLines(const size_t count) override;
+    bool InsertLines(const size_t count) override;
+
+    bool PrivateGetColorTableEntry(const size_t index, COLORREF& value) const override;
+    bool PrivateSetColorTableEntry(const size_t index, const COLORREF value) const override;
+
+    bool PrivateFillRegion(const COORD startPosition,
+                           const size_t fillLength,
+                           const wchar_t fillChar,
+                           const bool standardFillAttrs) override;
+
+    bool PrivateScrollRegion(const SMALL_RECT scrollRect,
+                             const std::optional<SMALL_RECT> clipRect,
+                             const COORD destinationOrigin,
+                             const bool standardFillAttrs) override;
+
+    bool PrivateAddHyperlink(const std::wstring_view uri, const std::wstring_view params) const override;
+    bool PrivateEndHyperlink() const override;
+
+    // Nothing the benchmark measures depends on these, so they are accepted and ignored.
+    // There is only one buffer: the alternate screen writes into the main one, which
+    // costs the same. And the viewport always follows the cursor, so it is at the bottom.
+    bool SetConsoleScreenBufferInfoEx(const CONSOLE_SCREEN_BUFFER_INFOEX& /*screenBufferInfo*/) override { return true; }
+    bool PrivateIsVtInputEnabled() const override { return false; }
+    bool PrivateSetCursorKeysMode(const bool /*applicationMode*/) override { return true; }
+    bool PrivateSetKeypadMode(const bool /*applicationMode*/) override { return true; }
+    bool PrivateEnableWin32InputMode(const bool /*win32InputMode*/) override { return true; }
+    bool PrivateSetAnsiMode(const bool /*ansiMode*/) override { return true; }
+    bool PrivateSetScreenMode(const bool /*reverseMode*/) override { return true; }
+    bool PrivateWarningBell() override { return true; }
+    bool SetConsoleTitleW(const std::wstring_view /*title*/) override { return true; }
+    bool PrivateUseAlternateScreenBuffer() override { return true; }
+    bool PrivateUseMainScreenBuffer() override { return true; }
+    bool PrivateEnableVT200MouseMode(const bool /*enabled*/) override { return true; }
+    bool PrivateEnableUTF8ExtendedMouseMode(const bool /*enabled*/) override { return true; }
+    bool PrivateEnableSGRExtendedMouseMode(const bool /*enabled*/) override { return true; }
+    bool PrivateEnableButtonEventMouseMode(const bool /*enabled*/) override { return true; }
+    bool PrivateEnableAnyEventMouseMode(const bool /*enabled*/) override { return true; }
+    bool PrivateEnableAlternateScroll(const bool /*enabled*/) override { return true; }
+    bool PrivateWriteConsoleControlInput(const KeyEvent /*key*/) override { return true; }
+    bool PrivateRefreshWindow() override { return true; }
+    bool PrivateSuppressResizeRepaint() override { return true; }
+    bool IsConsolePty() const override { return false; }
+    bool MoveToBottom() const override { return true; }
+    bool PrivateSetDefaultForeground(const COLORREF /*value*/) const override { return true; }
+    bool PrivateSetDefaultBackground(const COLORREF /*value*/) const override { return true; }
+
+private:
+    BenchBuffer& _buffer;
+    unsigned int _outputCodepage;
+    bool _lineFeedMode;
+};
+
+class BenchWriter final : public Microsoft::Console::VirtualTerminal::AdaptDefaults
+{
+public:
+    BenchWriter(BenchBuffer& buffer) noexcept;
+
+    void Print(const wchar_t wch) override;
+    void PrintString(const std::wstring_view string) override;
+    void Execute(const wchar_t wch) override;
+
+private:
+    BenchBuffer& _buffer;
+};
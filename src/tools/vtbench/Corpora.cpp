@@ -0,0 +1,235 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "Corpora.hpp"
+
+// The viewport size the TUI corpus draws for. Matches the benchmark buffer.
+static constexpr int s_screenWidth = 120;
+static constexpr int s_screenHeight = 30;
+
+static int _RandomInt(std::mt19937& rng, const int min, const int max)
+{
+    return std::uniform_int_distribution<int>{ min, max }(rng);
+}
+
+template<typename T, size_t N>
+static const T& _RandomElement(std::mt19937& rng, const std::array<T, N>& elements)
+{
+    return til::at(elements, _RandomInt(rng, 0, gsl::narrow_cast<int>(N - 1)));
+}
+
+static void _AppendCodepoint(std::wstring& text, const uint32_t codepoint)
+{
+    if (codepoint < 0x10000)
+    {
+        text.push_back(gsl::narrow_cast<wchar_t>(codepoint));
+    }
+    else
+    {
+        const auto offset = codepoint - 0x10000;
+        text.push_back(gsl::narrow_cast<wchar_t>(0xD800 + (offset >> 10)));
+        text.push_back(gsl::narrow_cast<wchar_t>(0xDC00 + (offset & 0x3FF)));
+    }
+}
+
+// Routine Description:
+// - A line of a typical service log. Plain printable ASCII ending in CRLF,
+//   which is the case the parser's bulk print path is meant for.
+static void _AppendAsciiLogLine(std::wstring& text, std::mt19937& rng)
+{
+    static constexpr std::array<std::wstring_view, 4> levels{ L"INFO ", L"DEBUG", L"WARN ", L"ERROR" };
+    static constexpr std::array<std::wstring_view, 5> routes{ L"/api/v1/items", L"/api/v1/users", L"/healthz", L"/api/v2/search", L"/static/app.js" };
+
+    fmt::format_to(std::back_inserter(text),
+                   L"2020-07-{:02}T{:02}:{:02}:{:02}.{:03}Z {} [worker-{:02}] request {} completed in {}ms status={} path={}/{}\r\n",
+                   _RandomInt(rng, 1, 28),
+                   _RandomInt(rng, 0, 23),
+                   _RandomInt(rng, 0, 59),
+                   _RandomInt(rng, 0, 59),
+                   _RandomInt(rng, 0, 999),
+                   _RandomElement(rng, levels),
+                   _RandomInt(rng, 0, 31),
+                   _RandomInt(rng, 1000, 999999),
+                   _RandomInt(rng, 0, 2500),
+                   _RandomInt(rng, 0, 9) == 0 ? 500 : 200,
+                   _RandomElement(rng, routes),
+                   _RandomInt(rng, 0, 99999));
+}
+
+// Routine Description:
+// - A line of colored output in the style of compilers, test runners and
+//   ls --color, with short runs of text between SGR sequences in the 16
+//   color, 256 color and RGB forms.
+static void _AppendSgrLine(std::wstring& text, std::mt19937& rng)
+{
+    static constexpr std::array<std::wstring_view, 8> words{ L"src/", L"main.cpp", L"warning:", L"error:", L"PASSED", L"FAILED", L"note:", L"include" };
+
+    const auto segments = _RandomInt(rng, 4, 12);
+    for (auto i = 0; i < segments; i++)
+    {
+        switch (_RandomInt(rng, 0, 3))
+        {
+        case 0:
+            fmt::format_to(std::back_inserter(text), L"\x1b[{};{}m", _RandomInt(rng, 0, 1), _RandomInt(rng, 30, 37));
+            break;
+        case 1:
+            fmt::format_to(std::back_inserter(text), L"\x1b[38;5;{}m", _RandomInt(rng, 0, 255));
+            break;
+        case 2:
+            fmt::format_to(std::back_inserter(text), L"\x1b[38;2;{};{};{}m", _RandomInt(rng, 0, 255), _RandomInt(rng, 0, 255), _RandomInt(rng, 0, 255));
+            break;
+        default:
+            fmt::format_to(std::back_inserter(text), L"\x1b[1;4;{}m", _RandomInt(rng, 90, 97));
+            break;
+        }
+        text.append(_RandomElement(rng, words));
+        text.append(L"\x1b[0m ");
+    }
+    text.append(L"\r\n");
+}
+
+// Routine Description:
+// - One full screen redraw in the style of top or a text editor: hide the
+//   cursor, address every row, paint colored fields, clear to end of line,
+//   and occasionally scroll part of the screen with DECSTBM.
+static void _AppendTuiFrame(std::wstring& text, std::mt19937& rng)
+{
+    text.append(L"\x1b[?25l\x1b[H\x1b[7m");
+    fmt::format_to(std::back_inserter(text), L" tasks: {} total, {} running   load average: {}.{:02}", _RandomInt(rng, 100, 400), _RandomInt(rng, 1, 8), _RandomInt(rng, 0, 9), _RandomInt(rng, 0, 99));
+    text.append(L"\x1b[K\x1b[m");
+
+    for (auto row = 2; row <= s_screenHeight; row++)
+    {
+        fmt::format_to(std::back_inserter(text), L"\x1b[{};1H", row);
+        auto column = 0;
+        while (column < s_screenWidth - 16)
+        {
+            const auto width = _RandomInt(rng, 4, 15);
+            fmt::format_to(std::back_inserter(text), L"\x1b[{};{}m{:>{}}", _RandomInt(rng, 30, 37), _RandomInt(rng, 40, 47), _RandomInt(rng, 0, 99999), width);
+            column += width;
+        }
+        text.append(L"\x1b[m\x1b[K");
+    }
+
+    if (_RandomInt(rng, 0, 3) == 0)
+    {
+        // Scroll the middle of the screen up by a few lines.
+        fmt::format_to(std::back_inserter(text), L"\x1b[5;{}r\x1b[{};1H", s_screenHeight - 5, s_screenHeight - 5);
+        for (auto i = _RandomInt(rng, 1, 4); i > 0; i--)
+        {
+            text.append(L"\n");
+        }
+        text.append(L"\x1b[r");
+    }
+
+    fmt::format_to(std::back_inserter(text), L"\x1b[{};{}H\x1b[?25h", _RandomInt(rng, 1, s_screenHeight), _RandomInt(rng, 1, s_screenWidth));
+}
+
+// Routine Description:
+// - A line of mostly non-ASCII text: CJK ideographs, kana and hangul (all
+//   double width), emoji outside the BMP, and Latin with combining accents.
+static void _AppendCjkEmojiLine(std::wstring& text, std::mt19937& rng)
+{
+    const auto glyphs = _RandomInt(rng, 20, 50);
+    for (auto i = 0; i < glyphs; i++)
+    {
+        switch (_RandomInt(rng, 0, 5))
+        {
+        case 0:
+        case 1:
+            _AppendCodepoint(text, _RandomInt(rng, 0x4E00, 0x9FFF));
+            break;
+        case 2:
+            _AppendCodepoint(text, _RandomInt(rng, 0x3041, 0x3096));
+            break;
+        case 3:
+            _AppendCodepoint(text, _RandomInt(rng, 0xAC00, 0xD7A3));
+            break;
+        case 4:
+            _AppendCodepoint(text, _RandomInt(rng, 0x1F600, 0x1F64F));
+            break;
+        default:
+            text.push_back(gsl::narrow_cast<wchar_t>(_RandomInt(rng, L'a', L'z')));
+            text.push_back(L'\x0301');
+            text.push_back(L' ');
+            break;
+        }
+    }
+    text.append(L"\r\n");
+}
+
+// Routine Description:
+// - A line of OSC 8 hyperlinks with long URIs, as printed by ls --hyperlink
+//   or a compiler linking diagnostics to source. Terminated with both ST and BEL.
+static void _AppendHyperlinkLine(std::wstring& text, std::mt19937& rng)
+{
+    const auto links = _RandomInt(rng, 1, 3);
+    for (auto i = 0; i < links; i++)
+    {
+        fmt::format_to(std::back_inserter(text), L"\x1b]8;id={};https://example.com/repository/tree/{:08x}", _RandomInt(rng, 0, 65535), _RandomInt(rng, 0, INT_MAX));
+        for (auto depth = _RandomInt(rng, 6, 16); depth > 0; depth--)
+        {
+            fmt::format_to(std::back_inserter(text), L"/directory{}", _RandomInt(rng, 0, 999));
+        }
+        fmt::format_to(std::back_inserter(text), L"/file{}.cpp?plain=1&line={}#L{}", _RandomInt(rng, 0, 999), _RandomInt(rng, 1, 5000), _RandomInt(rng, 1, 5000));
+
+        const auto terminator = _RandomInt(rng, 0, 1) ? std::wstring_view{ L"\x1b\\" } : std::wstring_view{ L"\x07" };
+        text.append(terminator);
+        fmt::format_to(std::back_inserter(text), L"file{}.cpp", _RandomInt(rng, 0, 999));
+        text.append(L"\x1b]8;;");
+        text.append(terminator);
+        text.append(L"  ");
+    }
+    text.append(L"\r\n");
+}
+
+template<typename T>
+static Corpus _Generate(const std::wstring_view name, const size_t targetLength, const T& appendOne)
+{
+    // A fixed seed, so every run measures identical input.
+    std::mt19937 rng{ 0x5EED };
+
+    Corpus corpus{ std::wstring{ name }, {} };
+    corpus.text.reserve(targetLength + 4096);
+    while (corpus.text.size() < targetLength)
+    {
+        appendOne(corpus.text, rng);
+    }
+    return corpus;
+}
+
+// Routine Description:
+// - Generates each of the canned corpora.
+// Arguments:
+// - targetLength - Approximate length of each corpus in UTF-16 code units.
+//   Generation stops at the first complete line or frame past this length.
+// Return Value:
+// - The corpora, in a fixed order.
+std::vector<Corpus> GenerateCorpora(const size_t targetLength)
+{
+    std::vector<Corpus> corpora;
+    corpora.emplace_back(_Generate(L"ascii-log", targetLength, _AppendAsciiLogLine));
+    corpora.emplace_back(_Generate(L"sgr-color", targetLength, _AppendSgrLine));
+    corpora.emplace_back(_Generate(L"tui-redraw", targetLength, _AppendTuiFrame));
+    corpora.emplace_back(_Generate(L"cjk-emoji", targetLength, _AppendCjkEmojiLine));
+    corpora.emplace_back(_Generate(L"osc8-links", targetLength, _AppendHyperlinkLine));
+    return corpora;
+}
+
+// Routine Description:
+// - Loads a UTF-8 file as a corpus, for measuring real captured output.
+// Arguments:
+// - path - The file to read.
+// Return Value:
+// - The corpus, named after the file.
+Corpus LoadCorpus(const std::filesystem::path& path)
+{
+    std::ifstream file{ path, std::ios::binary };
+    THROW_HR_IF(E_FAIL, !file.is_open());
+
+    const std::string bytes{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+
+    return Corpus{ path.filename().wstring(), til::u8u16(bytes) };
+}
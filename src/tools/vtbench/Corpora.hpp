@@ -0,0 +1,26 @@
+/*++
+Copyright (c) Microsoft Corporation.
+Licensed under the MIT license.
+
+Module Name:
+- Corpora.hpp
+
+Abstract:
+- Canned input for the VT pipeline benchmark. Each corpus is generated from a
+  fixed seed, so the same build always measures the same bytes.
+
+--*/
+
+#pragma once
+
+struct Corpus
+{
+    std::wstring name;
+    std::wstring text;
+};
+
+// Generates every canned corpus, each roughly targetLength UTF-16 code units long.
+std::vector<Corpus> GenerateCorpora(const size_t targetLength);
+
+// Reads a UTF-8 file (like a captured VT session) to be used as a corpus.
+Corpus LoadCorpus(const std::filesystem::path& path);
@@ -0,0 +1,148 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// TOOL GroundScan
+// Microbenchmark for the printable-run scan in StateMachine::ProcessString
+// (_findActionableFromGround in stateMachine.cpp). It measures the scan alone,
+// the scalar loop against the SSE2 one, on 8M characters of build-log style
+// text: printable ASCII with a CRLF every 20 to 120 characters.
+// NOTE Both scans are copies of the parser's, so that they can be compared in
+// one binary and on any compiler. Keep them in sync when the parser changes;
+// every one of the 65536 code units is checked against the scalar test first.
+//
+//   cl /O2 /EHsc GroundScan.cpp           (or: g++ -O2 GroundScan.cpp)
+//   GroundScan
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include <emmintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define NOINLINE __declspec(noinline)
+#else
+#define NOINLINE __attribute__((noinline))
+#endif
+
+static constexpr char16_t US = 0x1F;
+static constexpr char16_t DEL = 0x7F;
+
+static constexpr bool _isActionableFromGround(const char16_t ch) noexcept
+{
+    return ch <= US || (ch >= 0x80 && ch <= 0x9F) || ch == DEL;
+}
+
+static unsigned _firstSetBit(const int mask) noexcept
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, static_cast<unsigned long>(mask));
+    return index;
+#else
+    return static_cast<unsigned>(__builtin_ctz(static_cast<unsigned>(mask)));
+#endif
+}
+
+NOINLINE static size_t _scanScalar(const std::u16string_view string, size_t offset) noexcept
+{
+    for (; offset < string.size(); ++offset)
+    {
+        if (_isActionableFromGround(string[offset]))
+        {
+            break;
+        }
+    }
+    return offset;
+}
+
+NOINLINE static size_t _scanSse2(const std::u16string_view string, size_t offset) noexcept
+{
+    const auto size = string.size();
+    const auto data = string.data();
+    const auto c0Max = _mm_set1_epi16(US);
+    const auto delBase = _mm_set1_epi16(DEL);
+    const auto delC1Span = _mm_set1_epi16(0x9F - DEL);
+    const auto zero = _mm_setzero_si128();
+
+    for (; offset + 8 <= size; offset += 8)
+    {
+        const auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+        const auto isC0 = _mm_cmpeq_epi16(_mm_subs_epu16(chars, c0Max), zero);
+        const auto isDelOrC1 = _mm_cmpeq_epi16(_mm_subs_epu16(_mm_sub_epi16(chars, delBase), delC1Span), zero);
+        const auto mask = _mm_movemask_epi8(_mm_or_si128(isC0, isDelOrC1));
+        if (mask != 0)
+        {
+            return offset + _firstSetBit(mask) / 2;
+        }
+    }
+    return _scanScalar(string, offset);
+}
+
+static std::u16string _GenerateBuildLog(const size_t length)
+{
+    std::mt19937 rng{ 1 };
+    std::u16string text;
+    text.reserve(length + 128);
+    while (text.size() < length)
+    {
+        const auto lineLength = 20 + rng() % 100;
+        for (size_t i = 0; i < lineLength; i++)
+        {
+            text += static_cast<char16_t>(0x20 + rng() % 95);
+        }
+        text += u"\r\n";
+    }
+    return text;
+}
+
+// Routine Description:
+// - Checks that both scans agree on every code unit, at every position in a block of 8.
+static bool _Verify()
+{
+    for (unsigned ch = 0; ch <= 0xFFFF; ch++)
+    {
+        for (size_t position = 0; position < 16; position++)
+        {
+            std::u16string text(16, u'a');
+            text[position] = static_cast<char16_t>(ch);
+            if (_scanScalar(text, 0) != _scanSse2(text, 0))
+            {
+                printf("mismatch for U+%04X at %zu\n", ch, position);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template<typename T>
+static void _Measure(const char* name, const std::u16string_view text, const T& scan)
+{
+    static constexpr int iterations = 20;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        for (size_t offset = 0; offset < text.size(); offset = scan(text, offset) + 1)
+        {
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const auto chars = static_cast<double>(text.size()) * iterations;
+    printf("%-8s %8.0f MB/s %6.2f ns/char\n", name, chars * sizeof(char16_t) / elapsed.count() / 1e6, elapsed.count() * 1e9 / chars);
+}
+
+int main()
+{
+    if (!_Verify())
+    {
+        return 1;
+    }
+
+    const auto text = _GenerateBuildLog(8 * 1024 * 1024);
+    _Measure("scalar", text, _scanScalar);
+    _Measure("sse2", text, _scanSse2);
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "Replay.hpp"
+#include "BenchBuffer.hpp"
+
+#include "..\..\terminal\adapter\adaptDispatch.hpp"
+#include "..\..\terminal\parser\OutputStateMachineEngine.hpp"
+#include "..\..\terminal\parser\stateMachine.hpp"
+
+using namespace Microsoft::Console::Utils;
+using namespace Microsoft::Console::VirtualTerminal;
+
+static constexpr std::chrono::microseconds s_frameInterval{ 1000000 / 60 };
+
+static COORD _ToViewportSize(const uint32_t columns, const uint32_t rows)
+{
+    return { gsl::narrow<SHORT>(columns), gsl::narrow<SHORT>(rows) };
+}
+
+// Routine Description:
+// - FNV-1a over the text of every row of the viewport.
+static uint64_t _HashViewport(const BenchBuffer& buffer)
+{
+    const auto viewport = buffer.GetViewport();
+    uint64_t hash = 0xcbf29ce484222325;
+    for (auto y = viewport.Top(); y < viewport.BottomExclusive(); y++)
+    {
+        for (const auto wch : buffer.GetTextBuffer().GetRowByOffset(y).GetText())
+        {
+            hash = (hash ^ wch) * 0x100000001b3;
+        }
+        hash = (hash ^ L'\n') * 0x100000001b3;
+    }
+    return hash;
+}
+
+// Routine Description:
+// - Feeds every record of a capture to a new buffer of the capture's size.
+// Arguments:
+// - capture - The capture to replay.
+// - totalRows - The number of rows in the buffer, including the scrollback.
+// - realTime - If true, each record is fed when it's due according to its
+//   timestamp, rather than as soon as the previous one is done.
+// Return Value:
+// - The counts and timing of the replay.
+ReplayResult Replay(const VtCapture& capture, const SHORT totalRows, const bool realTime)
+{
+    BenchBuffer buffer{ _ToViewportSize(capture.columns, capture.rows), totalRows };
+    auto dispatch = std::make_unique<AdaptDispatch>(std::make_unique<BenchGetSet>(buffer), std::make_unique<BenchWriter>(buffer));
+    auto engine = std::make_unique<OutputStateMachineEngine>(std::move(dispatch));
+    StateMachine machine{ std::move(engine) };
+
+    ReplayResult result;
+    auto lastFrame = 0ll;
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& record : capture.records)
+    {
+        // A renderer would have painted at every tick between the previous
+        // record and this one, but only the first paint has anything to do.
+        const auto frame = record.time / s_frameInterval;
+        if (frame != lastFrame)
+        {
+            lastFrame = frame;
+            result.frames += buffer.ConsumeInvalidation() ? 1 : 0;
+        }
+
+        if (realTime)
+        {
+            std::this_thread::sleep_until(start + record.time);
+        }
+
+        if (record.type == VtCaptureRecordType::Output)
+        {
+            machine.ProcessString(std::string_view{ record.output });
+            result.bytes += record.output.size();
+        }
+        else if (record.columns != 0 && record.rows != 0)
+        {
+            buffer.Resize(_ToViewportSize(record.columns, record.rows));
+            result.resizes++;
+        }
+
+        result.records++;
+        result.captureDuration = record.time;
+    }
+    result.elapsed = std::chrono::steady_clock::now() - start;
+
+    // And the final frame, for whatever was left.
+    result.frames += buffer.ConsumeInvalidation() ? 1 : 0;
+    result.screenHash = _HashViewport(buffer);
+    return result;
+}
@@ -0,0 +1,36 @@
+/*++
+Copyright (c) Microsoft Corporation.
+Licensed under the MIT license.
+
+Module Name:
+- Replay.hpp
+
+Abstract:
+- Replays a VT session capture (see VtCapture.hpp) through the textbuffer
+  stage, StateMachine + OutputStateMachineEngine + AdaptDispatch into a bare
+  TextBuffer (see BenchBuffer.hpp), without a window or a renderer.
+- Replays are deterministic. Frames are counted on the capture's own timeline,
+  as the number of 60 Hz ticks at which something had been invalidated since
+  the previous frame, so they don't depend on how fast the replay runs.
+
+--*/
+
+#pragma once
+
+#include "..\..\types\inc\VtCapture.hpp"
+
+struct ReplayResult
+{
+    size_t records = 0;
+    size_t bytes = 0;
+    size_t resizes = 0;
+    size_t frames = 0;
+    // The time the capture covers, and the time the replay took.
+    std::chrono::microseconds captureDuration{};
+    std::chrono::nanoseconds elapsed{};
+    // A hash of the text in the final viewport, to compare replays by.
+    uint64_t screenHash = 0;
+};
+
+// Replays a capture as fast as possible, or with the timing it was recorded with.
+ReplayResult Replay(const Microsoft::Console::Utils::VtCapture& capture, const SHORT totalRows, const bool realTime);
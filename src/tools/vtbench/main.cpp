@@ -0,0 +1,465 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// TOOL VtBench
+// Throughput benchmark for the VT output pipeline. Each corpus is run through
+// three stages:
+//  - parse-utf16: StateMachine + OutputStateMachineEngine into a dispatch that does nothing.
+//  - parse-utf8:  the same, but fed UTF-8 through StateMachine::ProcessString(std::string_view).
+//  - textbuffer:  StateMachine + OutputStateMachineEngine + AdaptDispatch into a bare TextBuffer,
+//                 through the thin adapter in BenchBuffer.hpp. This approximates conhost's
+//                 output path without SCREEN_INFORMATION or WriteCharsLegacy, so it doesn't
+//                 measure them.
+// The difference between the parse and textbuffer stages is the cost of dispatch and TextBuffer writes.
+// With --stats, and a parser built with VT_PARSER_STATISTICS=1, it also shows
+// which sequences the textbuffer stage spends its time dispatching.
+// With --replay, it replays a session captured by the Terminal's
+// "experimental.recordingDirectory" setting through the textbuffer stage instead.
+// The CMake build (CMakeLists.txt) defines VTBENCH_PARSER_ONLY and has only the
+// parse stages, so that the parser can be measured on any platform.
+
+#include "precomp.h"
+
+#include "Corpora.hpp"
+
+#include "../../terminal/parser/OutputStateMachineEngine.hpp"
+#include "../../terminal/parser/stateMachine.hpp"
+
+#ifndef VTBENCH_PARSER_ONLY
+#include "BenchBuffer.hpp"
+#include "Replay.hpp"
+
+#include "../../terminal/adapter/adaptDispatch.hpp"
+#endif
+
+using namespace Microsoft::Console::VirtualTerminal;
+
+// Same as the default conhost window, with the default scrollback.
+static constexpr COORD s_viewportSize{ 120, 30 };
+static constexpr SHORT s_totalRows = 9001;
+
+// The dispatch for the parse-only stages. Every sequence is accepted by the
+// engine and then ignored, so only the parser is measured.
+class NullDispatch final : public TermDispatch
+{
+public:
+    void Execute(const wchar_t /*wchControl*/) override
+    {
+    }
+    void Print(const wchar_t /*wchPrintable*/) override
+    {
+    }
+    void PrintString(const std::wstring_view /*string*/) override
+    {
+    }
+};
+
+struct BenchOptions
+{
+    size_t iterations = 5;
+    size_t corpusLength = 4 * 1024 * 1024;
+    size_t chunkLength = 4096;
+    bool csv = false;
+    bool stats = false;
+    bool realTime = false;
+    std::optional<std::filesystem::path> replay;
+    std::vector<std::filesystem::path> files;
+};
+
+struct StageResult
+{
+    std::wstring_view stage;
+    std::chrono::nanoseconds best;
+};
+
+using Clock = std::chrono::steady_clock;
+
+// Routine Description:
+// - Feeds text to the state machine in chunks, the way it arrives from a pipe.
+//   The UTF-8 overload deliberately splits code points at chunk boundaries.
+template<typename T>
+static void _Feed(StateMachine& machine, const std::basic_string_view<T> text, const size_t chunkLength)
+{
+    for (size_t offset = 0; offset < text.size(); offset += chunkLength)
+    {
+        machine.ProcessString(text.substr(offset, chunkLength));
+    }
+}
+
+template<typename T>
+static std::chrono::nanoseconds _TimeParse(const std::basic_string_view<T> text, const size_t chunkLength)
+{
+    auto engine = std::make_unique<OutputStateMachineEngine>(std::make_unique<NullDispatch>());
+    StateMachine machine{ std::move(engine) };
+
+    const auto start = Clock::now();
+    _Feed(machine, text, chunkLength);
+    return Clock::now() - start;
+}
+
+#ifndef VTBENCH_PARSER_ONLY
+static std::chrono::nanoseconds _TimeTextBuffer(const std::wstring_view text, const size_t chunkLength)
+{
+    BenchBuffer buffer{ s_viewportSize, s_totalRows };
+    auto dispatch = std::make_unique<AdaptDispatch>(std::make_unique<BenchGetSet>(buffer), std::make_unique<BenchWriter>(buffer));
+    auto engine = std::make_unique<OutputStateMachineEngine>(std::move(dispatch));
+    StateMachine machine{ std::move(engine) };
+
+    const auto start = Clock::now();
+    _Feed(machine, text, chunkLength);
+    return Clock::now() - start;
+}
+#endif
+
+// Routine Description:
+// - Runs one stage once to warm up caches and allocators, then the requested
+//   number of times, and keeps the fastest run. The minimum is the most stable
+//   statistic on a shared machine, which is what regression checks need.
+template<typename T>
+static std::chrono::nanoseconds _BestOf(const size_t iterations, const T& runOnce)
+{
+    auto best = runOnce();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        best = std::min(best, runOnce());
+    }
+    return best;
+}
+
+// Printed at the top of every report, so that the textbuffer numbers aren't read as conhost's.
+static constexpr std::wstring_view s_textBufferNote{ L"textbuffer is a TextBuffer-only approximation of conhost's output path, it doesn't run SCREEN_INFORMATION or WriteCharsLegacy" };
+
+static void _PrintHeader(const BenchOptions& options)
+{
+    if (options.csv)
+    {
+        wprintf(L"corpus,stage,bytes,chars,best_ns,mb_per_s,ns_per_char\n");
+    }
+    else
+    {
+#ifndef VTBENCH_PARSER_ONLY
+        wprintf(L"note: %ls\n", s_textBufferNote.data());
+#endif
+        wprintf(L"%-16ls %-12ls %12ls %12ls %12ls %10ls %10ls\n", L"corpus", L"stage", L"bytes", L"chars", L"best ms", L"MB/s", L"ns/char");
+    }
+}
+
+// Routine Description:
+// - Prints one result row. MB/s is measured against the UTF-8 size of the
+//   corpus for every stage, so stages are directly comparable. ns/char is
+//   per UTF-16 code unit, which is what the parser consumes.
+static void _PrintResult(const BenchOptions& options, const Corpus& corpus, const size_t bytes, const StageResult& result)
+{
+    const auto ns = gsl::narrow_cast<double>(std::max<long long>(result.best.count(), 1));
+    const auto mbPerSecond = gsl::narrow_cast<double>(bytes) * 1e3 / ns;
+    const auto nsPerChar = ns / gsl::narrow_cast<double>(std::max<size_t>(corpus.text.size(), 1));
+
+    if (options.csv)
+    {
+        wprintf(L"%ls,%ls,%zu,%zu,%lld,%.2f,%.3f\n", corpus.name.c_str(), result.stage.data(), bytes, corpus.text.size(), result.best.count(), mbPerSecond, nsPerChar);
+    }
+    else
+    {
+        wprintf(L"%-16ls %-12ls %12zu %12zu %12.3f %10.2f %10.3f\n", corpus.name.c_str(), result.stage.data(), bytes, corpus.text.size(), ns / 1e6, mbPerSecond, nsPerChar);
+    }
+}
+
+// Routine Description:
+// - Describes a counted sequence the way it's written, like "CSI ?h" or "OSC 52".
+static std::wstring _SequenceName(const ParserStatistics::SequenceKey& key)
+{
+    static constexpr std::array<std::wstring_view, 8> prefixes{ L"print", L"C0 ", L"ESC ", L"VT52 ", L"CSI ", L"OSC ", L"SS3 ", L"DCS " };
+
+    std::wstring name{ til::at(prefixes, static_cast<size_t>(key.kind)) };
+    switch (key.kind)
+    {
+    case ParserStatistics::SequenceKind::Print:
+        break;
+    case ParserStatistics::SequenceKind::Execute:
+        fmt::format_to(std::back_inserter(name), L"0x{:02X}", key.id);
+        break;
+    case ParserStatistics::SequenceKind::Osc:
+        name += std::to_wstring(key.id);
+        break;
+    default:
+        // A VTID holds the intermediates in its low bytes, followed by the final.
+        for (auto id = key.id; id != 0; id >>= CHAR_BIT)
+        {
+            name += gsl::narrow_cast<wchar_t>(id & 0xFF);
+        }
+        break;
+    }
+    return name;
+}
+
+// Routine Description:
+// - Returns the upper bound of the histogram bucket that the given fraction of
+//   the dispatches fell in, in nanoseconds.
+static uint64_t _Percentile(const ParserStatistics::SequenceCounters& counters, const double fraction)
+{
+    const auto target = gsl::narrow_cast<uint64_t>(gsl::narrow_cast<double>(counters.count) * fraction);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counters.histogram.size(); i++)
+    {
+        seen += til::at(counters.histogram, i);
+        if (seen > target || seen == counters.count)
+        {
+            return uint64_t{ 1 } << i;
+        }
+    }
+    return 0;
+}
+
+// Routine Description:
+// - Runs the textbuffer stage once more and prints the parser statistics for it:
+//   the sequences that took the most time to dispatch, and how much of the
+//   corpus was consumed in each parser state. Without the textbuffer stage,
+//   it runs parse-utf16 instead, which shows the parser's own share.
+static void _PrintStatistics(const Corpus& corpus, const size_t chunkLength)
+{
+#ifdef VTBENCH_PARSER_ONLY
+    auto engine = std::make_unique<OutputStateMachineEngine>(std::make_unique<NullDispatch>());
+#else
+    BenchBuffer buffer{ s_viewportSize, s_totalRows };
+    auto dispatch = std::make_unique<AdaptDispatch>(std::make_unique<BenchGetSet>(buffer), std::make_unique<BenchWriter>(buffer));
+    auto engine = std::make_unique<OutputStateMachineEngine>(std::move(dispatch));
+#endif
+    StateMachine machine{ std::move(engine) };
+
+    const auto before = machine.GetStatistics();
+    _Feed(machine, std::wstring_view{ corpus.text }, chunkLength);
+    const auto statistics = machine.GetStatistics() - before;
+
+    std::vector<std::pair<ParserStatistics::SequenceKey, ParserStatistics::SequenceCounters>> sequences{ statistics.sequences.begin(), statistics.sequences.end() };
+    std::sort(sequences.begin(), sequences.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.second.totalTime > rhs.second.totalTime;
+    });
+
+    static constexpr size_t maxSequences = 20;
+    wprintf(L"\n%ls: %llu characters printed\n", corpus.name.c_str(), statistics.printedCharacters);
+    wprintf(L"  %-16ls %10ls %8ls %12ls %10ls %10ls %10ls\n", L"sequence", L"count", L"failed", L"total ms", L"mean ns", L"p50 ns<", L"p99 ns<");
+    for (size_t i = 0; i < sequences.size() && i < maxSequences; i++)
+    {
+        const auto& [key, counters] = til::at(sequences, i);
+        const auto totalNs = gsl::narrow_cast<double>(counters.totalTime.count());
+        wprintf(L"  %-16ls %10llu %8llu %12.3f %10.1f %10llu %10llu\n",
+                _SequenceName(key).c_str(),
+                counters.count,
+                counters.failed,
+                totalNs / 1e6,
+                totalNs / gsl::narrow_cast<double>(counters.count),
+                _Percentile(counters, 0.5),
+                _Percentile(counters, 0.99));
+    }
+
+    wprintf(L"  %-20ls %12ls %12ls\n", L"state", L"chars", L"bytes");
+    for (const auto& state : statistics.states)
+    {
+        if (state.characters != 0 || state.bytes != 0)
+        {
+            wprintf(L"  %-20ls %12llu %12llu\n", state.state.data(), state.characters, state.bytes);
+        }
+    }
+}
+
+static void _RunCorpus(const BenchOptions& options, const Corpus& corpus)
+{
+    const auto utf16 = std::wstring_view{ corpus.text };
+    const auto utf8String = til::u16u8(utf16);
+    const auto utf8 = std::string_view{ utf8String };
+
+    std::vector<StageResult> results{
+        StageResult{ L"parse-utf16", _BestOf(options.iterations, [&]() { return _TimeParse(utf16, options.chunkLength); }) },
+        StageResult{ L"parse-utf8", _BestOf(options.iterations, [&]() { return _TimeParse(utf8, options.chunkLength); }) },
+    };
+#ifndef VTBENCH_PARSER_ONLY
+    results.emplace_back(StageResult{ L"textbuffer", _BestOf(options.iterations, [&]() { return _TimeTextBuffer(utf16, options.chunkLength); }) });
+#endif
+
+    for (const auto& result : results)
+    {
+        _PrintResult(options, corpus, utf8.size(), result);
+    }
+
+    if (options.stats)
+    {
+        if constexpr (ParserStatistics::IsEnabled)
+        {
+            _PrintStatistics(corpus, options.chunkLength);
+        }
+        else
+        {
+            wprintf(L"%ls: no statistics, the parser was built without VT_PARSER_STATISTICS=1\n", corpus.name.c_str());
+        }
+    }
+}
+
+#ifndef VTBENCH_PARSER_ONLY
+// Routine Description:
+// - Replays a capture, as fast as possible the requested number of times and
+//   keeping the fastest, or once in real time. The counts are the same for
+//   every run, only the time differs.
+static void _RunReplay(const BenchOptions& options, const std::filesystem::path& path)
+{
+    const auto capture = Microsoft::Console::Utils::VtCapture::Load(path);
+
+    auto result = Replay(capture, s_totalRows, options.realTime);
+    for (size_t i = 0; !options.realTime && i < options.iterations; i++)
+    {
+        const auto run = Replay(capture, s_totalRows, false);
+        result.elapsed = std::min(result.elapsed, run.elapsed);
+    }
+
+    const auto ns = gsl::narrow_cast<double>(std::max<long long>(result.elapsed.count(), 1));
+    const auto mbPerSecond = gsl::narrow_cast<double>(result.bytes) * 1e3 / ns;
+    const auto captureMs = gsl::narrow_cast<double>(result.captureDuration.count()) / 1e3;
+
+    if (options.csv)
+    {
+        wprintf(L"capture,records,bytes,resizes,frames,capture_ms,best_ns,mb_per_s,screen_hash\n");
+        wprintf(L"%ls,%zu,%zu,%zu,%zu,%.3f,%lld,%.2f,%016llx\n", path.filename().c_str(), result.records, result.bytes, result.resizes, result.frames, captureMs, result.elapsed.count(), mbPerSecond, result.screenHash);
+    }
+    else
+    {
+        wprintf(L"note:        %ls\n", s_textBufferNote.data());
+        wprintf(L"capture:     %ls (%ux%u)\n", path.filename().c_str(), capture.columns, capture.rows);
+        wprintf(L"records:     %zu (%zu bytes, %zu resizes)\n", result.records, result.bytes, result.resizes);
+        wprintf(L"duration:    %.3f ms captured, %.3f ms %ls\n", captureMs, ns / 1e6, options.realTime ? L"replayed" : L"best");
+        wprintf(L"throughput:  %.2f MB/s\n", mbPerSecond);
+        wprintf(L"frames:      %zu at 60 Hz\n", result.frames);
+        wprintf(L"screen hash: %016llx\n", result.screenHash);
+    }
+}
+#endif
+
+static void _PrintUsage()
+{
+    wprintf(L"usage: VtBench [-i iterations] [-s corpus length] [-c chunk length] [--csv] [--stats] [file ...]\n");
+    wprintf(L"       VtBench [-i iterations] [--csv] [--realtime] --replay capture\n");
+    wprintf(L"  Files are read as UTF-8 and benchmarked instead of the built-in corpora.\n");
+    wprintf(L"  --stats prints the parser statistics of each corpus, if they were compiled in.\n");
+    wprintf(L"  --replay feeds a .vtcap session capture through the textbuffer stage and counts\n");
+    wprintf(L"  the frames it would have rendered. --realtime keeps the captured timing.\n");
+}
+
+static bool _ParseSize(const wchar_t* const arg, size_t& value)
+{
+    wchar_t* end = nullptr;
+    const auto parsed = wcstoull(arg, &end, 10);
+    if (end == arg || *end != L'\0' || parsed == 0)
+    {
+        return false;
+    }
+    value = gsl::narrow_cast<size_t>(parsed);
+    return true;
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+{
+    BenchOptions options;
+    const auto args = gsl::make_span(argv, argc);
+    for (size_t i = 1; i < args.size(); i++)
+    {
+        const std::wstring_view arg{ til::at(args, i) };
+        const auto hasValue = i + 1 < args.size();
+        if (arg == L"-i" && hasValue && _ParseSize(til::at(args, ++i), options.iterations))
+        {
+            continue;
+        }
+        if (arg == L"-s" && hasValue && _ParseSize(til::at(args, ++i), options.corpusLength))
+        {
+            continue;
+        }
+        if (arg == L"-c" && hasValue && _ParseSize(til::at(args, ++i), options.chunkLength))
+        {
+            continue;
+        }
+        if (arg == L"--csv")
+        {
+            options.csv = true;
+            continue;
+        }
+        if (arg == L"--stats")
+        {
+            options.stats = true;
+            continue;
+        }
+        if (arg == L"--realtime")
+        {
+            options.realTime = true;
+            continue;
+        }
+        if (arg == L"--replay" && hasValue)
+        {
+            options.replay.emplace(til::at(args, ++i));
+            continue;
+        }
+        if (!arg.empty() && arg.front() != L'-')
+        {
+            options.files.emplace_back(arg);
+            continue;
+        }
+
+        _PrintUsage();
+        return 1;
+    }
+
+    try
+    {
+        if (options.replay)
+        {
+#ifdef VTBENCH_PARSER_ONLY
+            wprintf(L"--replay needs the textbuffer stage, which this build doesn't have\n");
+            return 1;
+#else
+            _RunReplay(options, options.replay.value());
+            return 0;
+#endif
+        }
+
+        std::vector<Corpus> corpora;
+        if (options.files.empty())
+        {
+            corpora = GenerateCorpora(options.corpusLength);
+        }
+        else
+        {
+            for (const auto& file : options.files)
+            {
+                corpora.emplace_back(LoadCorpus(file));
+            }
+        }
+
+        _PrintHeader(options);
+        for (const auto& corpus : corpora)
+        {
+            _RunCorpus(options, corpus);
+        }
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        wprintf(L"benchmark failed: 0x%08x\n", static_cast<unsigned int>(wil::ResultFromCaughtException()));
+        return 1;
+    }
+
+    return 0;
+}
+
+#ifndef _WIN32
+// Everywhere else the arguments are UTF-8 and there's no wmain.
+int main(int argc, char* argv[])
+{
+    std::vector<std::wstring> arguments;
+    std::vector<wchar_t*> wideArgv;
+    for (const auto arg : gsl::make_span(argv, argc))
+    {
+        arguments.emplace_back(til::u8u16(std::string_view{ arg }));
+    }
+    for (auto& arg : arguments)
+    {
+        wideArgv.emplace_back(arg.data());
+    }
+    return wmain(argc, wideArgv.data());
+}
+#endif
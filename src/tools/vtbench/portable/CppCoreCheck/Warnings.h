@@ -0,0 +1,8 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// The C++ Core Check warning sets only mean something to MSVC's code analysis.
+
+#pragma once
+
+#define ALL_CPPCORECHECK_WARNINGS
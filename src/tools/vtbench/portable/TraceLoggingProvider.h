@@ -0,0 +1,24 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// ETW isn't available outside Windows, so the providers are never registered
+// and every event is dropped without evaluating its fields.
+
+#pragma once
+
+#include "windows.h"
+
+typedef const struct _TlgProvider_t* TraceLoggingHProvider;
+
+#define TRACELOGGING_DECLARE_PROVIDER(handle) extern const TraceLoggingHProvider handle
+#define TRACELOGGING_DEFINE_PROVIDER(handle, ...) extern const TraceLoggingHProvider handle = nullptr
+
+#define TraceLoggingRegister(handle) ((void)(handle))
+#define TraceLoggingUnregister(handle) ((void)(handle))
+#define TraceLoggingProviderEnabled(handle, level, keyword) false
+#define TraceLoggingWrite(handle, ...) ((void)(handle))
+#define TraceLoggingWriteActivity(handle, ...) ((void)(handle))
+
+// From evntprov.h. Activity IDs are only created for ETW, so this fails.
+#define EVENT_ACTIVITY_CTRL_CREATE_ID 3
+ULONG EventActivityIdControl(ULONG controlCode, GUID* activityId) noexcept;
@@ -0,0 +1,20 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// CNG is only used to create v5 UUIDs, which the benchmark never does.
+// Every function fails with STATUS_NOT_SUPPORTED (see sdk.cpp).
+
+#pragma once
+
+#include "windows.h"
+
+typedef PVOID BCRYPT_HANDLE;
+typedef PVOID BCRYPT_ALG_HANDLE;
+typedef PVOID BCRYPT_HASH_HANDLE;
+
+#define BCRYPT_SHA1_ALG_HANDLE (reinterpret_cast<BCRYPT_ALG_HANDLE>(static_cast<ULONG_PTR>(0x00000031)))
+
+NTSTATUS BCryptCreateHash(BCRYPT_ALG_HANDLE algorithm, BCRYPT_HASH_HANDLE* hash, PUCHAR hashObject, ULONG hashObjectLength, PUCHAR secret, ULONG secretLength, ULONG flags) noexcept;
+NTSTATUS BCryptHashData(BCRYPT_HASH_HANDLE hash, PUCHAR input, ULONG inputLength, ULONG flags) noexcept;
+NTSTATUS BCryptFinishHash(BCRYPT_HASH_HANDLE hash, PUCHAR output, ULONG outputLength, ULONG flags) noexcept;
+NTSTATUS BCryptDestroyHash(BCRYPT_HASH_HANDLE hash) noexcept;
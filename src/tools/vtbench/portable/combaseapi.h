@@ -0,0 +1,12 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// COM isn't available outside Windows. The GUID helpers in types fail with
+// E_NOTIMPL (see sdk.cpp); the benchmark never calls them.
+
+#pragma once
+
+#include "windows.h"
+
+HRESULT IIDFromString(PCWSTR string, GUID* iid) noexcept;
+HRESULT CoCreateGuid(GUID* guid) noexcept;
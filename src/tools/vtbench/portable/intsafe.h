@@ -0,0 +1,8 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// Nothing the parser-only stages compile uses intsafe; see windows.h.
+
+#pragma once
+
+#include "windows.h"
@@ -0,0 +1,8 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// Included by types/precomp.h. Nothing the parser-only stages compile uses it.
+
+#pragma once
+
+#include "windows.h"
@@ -0,0 +1,8 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// See combaseapi.h.
+
+#pragma once
+
+#include "combaseapi.h"
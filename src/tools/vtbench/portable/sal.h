@@ -0,0 +1,19 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// SAL annotations only inform MSVC's code analysis; everywhere else they're empty.
+
+#pragma once
+
+#define _In_
+#define _In_opt_
+#define _Out_
+#define _Out_opt_
+#define _Inout_
+#define _In_reads_(x)
+#define _Out_writes_(x)
+#define _Out_writes_bytes_(x)
+#define _Field_size_bytes_part_(size, count)
+#define _Must_inspect_result_
+#define _Check_return_
+#define _Success_(x)
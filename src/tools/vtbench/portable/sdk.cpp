@@ -0,0 +1,231 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// The functions declared by the portable Windows SDK headers.
+
+#include <cwchar>
+
+#include "windows.h"
+#include "TraceLoggingProvider.h"
+#include "bcrypt.h"
+#include "combaseapi.h"
+
+namespace
+{
+    thread_local DWORD s_lastError = 0;
+
+    // Returns the length of the well-formed UTF-8 sequence at the start of
+    // input and its code point, or 0 if it's ill-formed or cut off.
+    int _DecodeUtf8(const unsigned char* input, const int length, char32_t& codePoint) noexcept
+    {
+        const auto lead = input[0];
+        int sequenceLength = 0;
+        char32_t minimum = 0;
+        if (lead < 0x80)
+        {
+            codePoint = lead;
+            return 1;
+        }
+        if (lead >= 0xC2 && lead <= 0xDF)
+        {
+            sequenceLength = 2;
+            minimum = 0x80;
+            codePoint = lead & 0x1F;
+        }
+        else if (lead >= 0xE0 && lead <= 0xEF)
+        {
+            sequenceLength = 3;
+            minimum = 0x800;
+            codePoint = lead & 0x0F;
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4)
+        {
+            sequenceLength = 4;
+            minimum = 0x10000;
+            codePoint = lead & 0x07;
+        }
+        if (sequenceLength == 0 || sequenceLength > length)
+        {
+            return 0;
+        }
+        for (auto i = 1; i < sequenceLength; i++)
+        {
+            if ((input[i] & 0xC0) != 0x80)
+            {
+                return 0;
+            }
+            codePoint = (codePoint << 6) | (input[i] & 0x3F);
+        }
+        if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+        {
+            return 0;
+        }
+        return sequenceLength;
+    }
+}
+
+DWORD GetLastError() noexcept
+{
+    return s_lastError;
+}
+
+void SetLastError(const DWORD error) noexcept
+{
+    s_lastError = error;
+}
+
+// Routine Description:
+// - Converts UTF-8 to UTF-16. Unlike Windows, every byte of an ill-formed
+//   sequence becomes its own U+FFFD. The VT corpora are well-formed, and
+//   StateMachine handles partial sequences itself, so the difference doesn't
+//   show in the benchmark.
+// Return Value:
+// - The number of UTF-16 code units written, or needed if outputLength is 0.
+int MultiByteToWideChar(const UINT codePage, const DWORD /*flags*/, const char* input, const int inputLength, wchar_t* output, const int outputLength) noexcept
+{
+    if (codePage != CP_UTF8 || inputLength < 0)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return 0;
+    }
+
+    const auto bytes = reinterpret_cast<const unsigned char*>(input);
+    int written = 0;
+    const auto put = [&](const char32_t unit) noexcept {
+        if (outputLength != 0 && written < outputLength)
+        {
+            output[written] = static_cast<wchar_t>(unit);
+        }
+        written++;
+    };
+
+    for (int offset = 0; offset < inputLength;)
+    {
+        char32_t codePoint = 0;
+        const auto length = _DecodeUtf8(bytes + offset, inputLength - offset, codePoint);
+        if (length == 0)
+        {
+            put(0xFFFD);
+            offset++;
+            continue;
+        }
+        if (codePoint >= 0x10000)
+        {
+            put(0xD800 + ((codePoint - 0x10000) >> 10));
+            put(0xDC00 + ((codePoint - 0x10000) & 0x3FF));
+        }
+        else
+        {
+            put(codePoint);
+        }
+        offset += length;
+    }
+
+    if (outputLength != 0 && written > outputLength)
+    {
+        SetLastError(ERROR_INSUFFICIENT_BUFFER);
+        return 0;
+    }
+    return written;
+}
+
+// Routine Description:
+// - Converts UTF-16 to UTF-8. Unpaired surrogates become U+FFFD.
+// Return Value:
+// - The number of bytes written, or needed if outputLength is 0.
+int WideCharToMultiByte(const UINT codePage, const DWORD /*flags*/, const wchar_t* input, const int inputLength, char* output, const int outputLength, const char* /*defaultChar*/, BOOL* /*usedDefaultChar*/) noexcept
+{
+    if (codePage != CP_UTF8 || inputLength < 0)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return 0;
+    }
+
+    int written = 0;
+    const auto put = [&](const char32_t byte) noexcept {
+        if (outputLength != 0 && written < outputLength)
+        {
+            output[written] = static_cast<char>(byte);
+        }
+        written++;
+    };
+
+    for (int offset = 0; offset < inputLength; offset++)
+    {
+        char32_t codePoint = static_cast<char16_t>(input[offset]);
+        if (codePoint >= 0xD800 && codePoint <= 0xDBFF && offset + 1 < inputLength && (static_cast<char16_t>(input[offset + 1]) & 0xFC00) == 0xDC00)
+        {
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (static_cast<char16_t>(input[offset + 1]) - 0xDC00);
+            offset++;
+        }
+        else if (codePoint >= 0xD800 && codePoint <= 0xDFFF)
+        {
+            codePoint = 0xFFFD;
+        }
+
+        if (codePoint < 0x80)
+        {
+            put(codePoint);
+        }
+        else if (codePoint < 0x800)
+        {
+            put(0xC0 | (codePoint >> 6));
+            put(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000)
+        {
+            put(0xE0 | (codePoint >> 12));
+            put(0x80 | ((codePoint >> 6) & 0x3F));
+            put(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            put(0xF0 | (codePoint >> 18));
+            put(0x80 | ((codePoint >> 12) & 0x3F));
+            put(0x80 | ((codePoint >> 6) & 0x3F));
+            put(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    if (outputLength != 0 && written > outputLength)
+    {
+        SetLastError(ERROR_INSUFFICIENT_BUFFER);
+        return 0;
+    }
+    return written;
+}
+
+ULONG EventActivityIdControl(const ULONG /*controlCode*/, GUID* /*activityId*/) noexcept
+{
+    return ERROR_NOT_SUPPORTED;
+}
+
+HRESULT IIDFromString(PCWSTR /*string*/, GUID* /*iid*/) noexcept
+{
+    return E_NOTIMPL;
+}
+
+HRESULT CoCreateGuid(GUID* /*guid*/) noexcept
+{
+    return E_NOTIMPL;
+}
+
+NTSTATUS BCryptCreateHash(BCRYPT_ALG_HANDLE /*algorithm*/, BCRYPT_HASH_HANDLE* /*hash*/, PUCHAR /*hashObject*/, ULONG /*hashObjectLength*/, PUCHAR /*secret*/, ULONG /*secretLength*/, ULONG /*flags*/) noexcept
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS BCryptHashData(BCRYPT_HASH_HANDLE /*hash*/, PUCHAR /*input*/, ULONG /*inputLength*/, ULONG /*flags*/) noexcept
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS BCryptFinishHash(BCRYPT_HASH_HANDLE /*hash*/, PUCHAR /*output*/, ULONG /*outputLength*/, ULONG /*flags*/) noexcept
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS BCryptDestroyHash(BCRYPT_HASH_HANDLE /*hash*/) noexcept
+{
+    return STATUS_NOT_SUPPORTED;
+}
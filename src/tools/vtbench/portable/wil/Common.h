@@ -0,0 +1,16 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// The flag helpers from WIL's common.h that the parser-only stages use.
+
+#pragma once
+
+#include <type_traits>
+
+#include "../windows.h"
+
+#define WI_UpdateFlagsInMask(var, flagsMask, newFlags) \
+    ((var) = static_cast<std::remove_reference_t<decltype(var)>>(((var) & ~(flagsMask)) | ((newFlags) & (flagsMask))))
+#define WI_IsFlagSet(val, flag) (((val) & (flag)) == (flag))
+#define WI_SetFlag(var, flag) ((var) |= (flag))
+#define WI_ClearFlag(var, flag) ((var) &= ~(flag))
@@ -0,0 +1,144 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- Result.h
+
+Abstract:
+- The subset of WIL's error handling that the parser-only stages of VtBench
+  use, for the portable (CMake) build. WIL itself only builds against the
+  Windows SDK.
+- Failures are thrown as wil::ResultException carrying the HRESULT, like WIL.
+  Logging macros don't log: there's no telemetry or debugger to log to.
+--*/
+
+#pragma once
+
+#include <exception>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "Common.h"
+
+namespace wil
+{
+    class ResultException : public std::exception
+    {
+    public:
+        explicit ResultException(const HRESULT hr) noexcept :
+            _hr{ hr }
+        {
+        }
+
+        HRESULT GetErrorCode() const noexcept
+        {
+            return _hr;
+        }
+
+        const char* what() const noexcept override
+        {
+            return "wil::ResultException";
+        }
+
+    private:
+        HRESULT _hr;
+    };
+
+    [[noreturn]] inline void ThrowResult(const HRESULT hr)
+    {
+        throw ResultException{ hr };
+    }
+
+    inline HRESULT ResultFromCaughtException() noexcept
+    {
+        try
+        {
+            throw;
+        }
+        catch (const ResultException& e)
+        {
+            return e.GetErrorCode();
+        }
+        catch (const std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+        catch (...)
+        {
+            return E_FAIL;
+        }
+    }
+
+    template<typename T>
+    constexpr bool verify_bool(const T& value) noexcept
+    {
+        return static_cast<bool>(value);
+    }
+
+    // Like WIL's, except that it never fails: the formatted text is truncated
+    // to 256 characters instead, which is plenty for the GUIDs it's used for.
+    template<typename T, typename... Args>
+    T str_printf(const wchar_t* format, Args&&... args)
+    {
+        wchar_t buffer[256]{};
+        swprintf(buffer, std::extent_v<decltype(buffer)>, format, std::forward<Args>(args)...);
+        return T{ buffer };
+    }
+}
+
+#define THROW_HR(hr) ::wil::ThrowResult(hr)
+#define THROW_HR_IF(hr, condition) \
+    do                             \
+    {                              \
+        if (condition)             \
+        {                          \
+            THROW_HR(hr);          \
+        }                          \
+    } while (0)
+#define THROW_HR_IF_NULL(hr, ptr) THROW_HR_IF(hr, (ptr) == nullptr)
+#define THROW_IF_FAILED(hrResult)         \
+    do                                    \
+    {                                     \
+        const HRESULT __hrRet = (hrResult); \
+        if (FAILED(__hrRet))              \
+        {                                 \
+            THROW_HR(__hrRet);            \
+        }                                 \
+    } while (0)
+#define THROW_IF_NTSTATUS_FAILED(status) THROW_HR_IF(E_FAIL, !NT_SUCCESS(status))
+#define THROW_LAST_ERROR_IF(condition) THROW_HR_IF(E_FAIL, condition)
+
+#define RETURN_HR_IF(hr, condition) \
+    do                              \
+    {                               \
+        if (condition)              \
+        {                           \
+            return (hr);            \
+        }                           \
+    } while (0)
+#define RETURN_IF_FAILED(hrResult)        \
+    do                                    \
+    {                                     \
+        const HRESULT __hrRet = (hrResult); \
+        if (FAILED(__hrRet))              \
+        {                                 \
+            return __hrRet;               \
+        }                                 \
+    } while (0)
+
+#define LOG_HR(hr) ((void)(hr))
+#define LOG_IF_FAILED(hrResult) ((void)(hrResult))
+#define LOG_CAUGHT_EXCEPTION() ((void)0)
+
+#define CATCH_LOG() \
+    catch (...)     \
+    {               \
+    }
+#define CATCH_RETURN()                                \
+    catch (...)                                       \
+    {                                                 \
+        return ::wil::ResultFromCaughtException();    \
+    }
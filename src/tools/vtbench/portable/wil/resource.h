@@ -0,0 +1,41 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// The resource wrappers from WIL's resource.h that the parser-only stages use.
+
+#pragma once
+
+#include "Result.h"
+#include "../bcrypt.h"
+
+namespace wil
+{
+    class unique_bcrypt_hash
+    {
+    public:
+        unique_bcrypt_hash() = default;
+        unique_bcrypt_hash(const unique_bcrypt_hash&) = delete;
+        unique_bcrypt_hash& operator=(const unique_bcrypt_hash&) = delete;
+
+        ~unique_bcrypt_hash()
+        {
+            if (_handle)
+            {
+                BCryptDestroyHash(_handle);
+            }
+        }
+
+        BCRYPT_HASH_HANDLE get() const noexcept
+        {
+            return _handle;
+        }
+
+        BCRYPT_HASH_HANDLE* operator&() noexcept
+        {
+            return &_handle;
+        }
+
+    private:
+        BCRYPT_HASH_HANDLE _handle = nullptr;
+    };
+}
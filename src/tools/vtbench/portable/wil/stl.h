@@ -0,0 +1,8 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// Everything the portable build needs from WIL is in Result.h.
+
+#pragma once
+
+#include "Result.h"
@@ -0,0 +1,230 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- windows.h
+
+Abstract:
+- The part of the Windows SDK that the parser, the color helpers in types and
+  til need, for the portable (CMake) build of VtBench's parser-only stages.
+- Only types, constants and the handful of functions those sources call are
+  declared here. Anything that needs the OS, like GUID creation, fails with
+  E_NOTIMPL (see sdk.cpp). Don't grow this into an emulation of Windows:
+  code that needs more belongs in the MSBuild-only stages.
+--*/
+
+#pragma once
+
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// til picks its 64-bit overloads, and the parser its SSE2 paths, with the MSVC
+// architecture macros.
+#if defined(__x86_64__) && !defined(_M_AMD64)
+#define _M_AMD64 1
+#define _M_X64 1
+#elif defined(__i386__) && !defined(_M_IX86)
+#define _M_IX86 1
+#elif defined(__aarch64__) && !defined(_M_ARM64)
+#define _M_ARM64 1
+#endif
+
+// windef.h's include guard, which til checks for before offering COLORREF conversions.
+#define _WINDEF_
+
+#define WINAPI
+#define __cdecl
+#define __declspec(x)
+#define __pragma(x)
+#define CONST const
+#define NTAPI
+#define NTSYSCALLAPI
+#define __kernel_entry
+#define UNREFERENCED_PARAMETER(x) (void)(x)
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+#define FALSE 0
+#define TRUE 1
+
+typedef char CHAR, *PCHAR;
+typedef unsigned char UCHAR, BYTE, *PUCHAR;
+typedef short SHORT;
+typedef unsigned short USHORT, WORD;
+typedef int INT, BOOL;
+typedef unsigned int UINT;
+typedef int16_t INT16;
+typedef uint16_t UINT16;
+typedef int32_t INT32, LONG, HRESULT, NTSTATUS;
+typedef uint32_t UINT32;
+typedef uint32_t ULONG, DWORD;
+typedef int64_t LONGLONG;
+typedef uint64_t ULONGLONG;
+typedef intptr_t LONG_PTR;
+typedef uintptr_t ULONG_PTR;
+typedef size_t SIZE_T;
+typedef wchar_t WCHAR, *PWCH, *PWSTR;
+typedef const wchar_t* PCWSTR;
+typedef void* PVOID;
+typedef void* HANDLE;
+typedef DWORD COLORREF;
+
+#define INVALID_HANDLE_VALUE (reinterpret_cast<HANDLE>(static_cast<LONG_PTR>(-1)))
+
+typedef struct _COORD
+{
+    SHORT X;
+    SHORT Y;
+} COORD, *PCOORD;
+
+typedef struct _SMALL_RECT
+{
+    SHORT Left;
+    SHORT Top;
+    SHORT Right;
+    SHORT Bottom;
+} SMALL_RECT, *PSMALL_RECT;
+
+typedef struct tagRECT
+{
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+} RECT;
+
+typedef struct tagPOINT
+{
+    LONG x;
+    LONG y;
+} POINT;
+
+typedef struct tagSIZE
+{
+    LONG cx;
+    LONG cy;
+} SIZE;
+
+typedef struct _GUID
+{
+    uint32_t Data1;
+    uint16_t Data2;
+    uint16_t Data3;
+    uint8_t Data4[8];
+} GUID;
+
+inline bool operator==(const GUID& lhs, const GUID& rhs) noexcept
+{
+    return memcmp(&lhs, &rhs, sizeof(GUID)) == 0;
+}
+
+inline bool operator!=(const GUID& lhs, const GUID& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+#define S_OK ((HRESULT)0L)
+#define S_FALSE ((HRESULT)1L)
+#define E_NOTIMPL ((HRESULT)0x80004001L)
+#define E_POINTER ((HRESULT)0x80004003L)
+#define E_ABORT ((HRESULT)0x80004004L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_UNEXPECTED ((HRESULT)0x8000FFFFL)
+#define E_BOUNDS ((HRESULT)0x8000000BL)
+#define E_ACCESSDENIED ((HRESULT)0x80070005L)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define E_NOT_VALID_STATE ((HRESULT)0x8007139FL)
+
+#define ERROR_NOT_ENOUGH_MEMORY 8L
+#define ERROR_INVALID_DATA 13L
+#define ERROR_NOT_SUPPORTED 50L
+#define ERROR_INVALID_PARAMETER 87L
+#define ERROR_INSUFFICIENT_BUFFER 122L
+
+#define STATUS_NOT_SUPPORTED ((NTSTATUS)0xC00000BBL)
+
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define NT_SUCCESS(status) (((NTSTATUS)(status)) >= 0)
+#define HRESULT_FROM_WIN32(x) ((HRESULT)(x) <= 0 ? ((HRESULT)(x)) : ((HRESULT)(((x)&0x0000FFFF) | (7 << 16) | 0x80000000)))
+
+#define RGB(r, g, b) ((COLORREF)(((BYTE)(r) | ((WORD)((BYTE)(g)) << 8)) | (((DWORD)(BYTE)(b)) << 16)))
+#define GetRValue(rgb) ((BYTE)(rgb))
+#define GetGValue(rgb) ((BYTE)(((WORD)(rgb)) >> 8))
+#define GetBValue(rgb) ((BYTE)((rgb) >> 16))
+#define LOBYTE(w) ((BYTE)(((ULONG_PTR)(w)) & 0xff))
+#define HIBYTE(w) ((BYTE)((((ULONG_PTR)(w)) >> 8) & 0xff))
+#define LOWORD(l) ((WORD)(((ULONG_PTR)(l)) & 0xffff))
+#define HIWORD(l) ((WORD)((((ULONG_PTR)(l)) >> 16) & 0xffff))
+
+#define FOREGROUND_BLUE 0x0001
+#define FOREGROUND_GREEN 0x0002
+#define FOREGROUND_RED 0x0004
+#define FOREGROUND_INTENSITY 0x0008
+#define BACKGROUND_BLUE 0x0010
+#define BACKGROUND_GREEN 0x0020
+#define BACKGROUND_RED 0x0040
+#define BACKGROUND_INTENSITY 0x0080
+#define COMMON_LVB_LEADING_BYTE 0x0100
+#define COMMON_LVB_TRAILING_BYTE 0x0200
+#define COMMON_LVB_GRID_HORIZONTAL 0x0400
+#define COMMON_LVB_GRID_LVERTICAL 0x0800
+#define COMMON_LVB_GRID_RVERTICAL 0x1000
+#define COMMON_LVB_REVERSE_VIDEO 0x4000
+#define COMMON_LVB_UNDERSCORE 0x8000
+
+// From winnt.h.
+#define DEFINE_ENUM_FLAG_OPERATORS(ENUMTYPE)                                                                                                         \
+    inline constexpr ENUMTYPE operator|(ENUMTYPE a, ENUMTYPE b) noexcept { return ENUMTYPE(((std::underlying_type_t<ENUMTYPE>)a) | ((std::underlying_type_t<ENUMTYPE>)b)); } \
+    inline ENUMTYPE& operator|=(ENUMTYPE& a, ENUMTYPE b) noexcept { return a = a | b; }                                                                \
+    inline constexpr ENUMTYPE operator&(ENUMTYPE a, ENUMTYPE b) noexcept { return ENUMTYPE(((std::underlying_type_t<ENUMTYPE>)a) & ((std::underlying_type_t<ENUMTYPE>)b)); } \
+    inline ENUMTYPE& operator&=(ENUMTYPE& a, ENUMTYPE b) noexcept { return a = a & b; }                                                                \
+    inline constexpr ENUMTYPE operator~(ENUMTYPE a) noexcept { return ENUMTYPE(~((std::underlying_type_t<ENUMTYPE>)a)); }                              \
+    inline constexpr ENUMTYPE operator^(ENUMTYPE a, ENUMTYPE b) noexcept { return ENUMTYPE(((std::underlying_type_t<ENUMTYPE>)a) ^ ((std::underlying_type_t<ENUMTYPE>)b)); } \
+    inline ENUMTYPE& operator^=(ENUMTYPE& a, ENUMTYPE b) noexcept { return a = a ^ b; }
+
+// From the MSVC CRT.
+inline int memcpy_s(void* destination, const size_t destinationSize, const void* source, const size_t count) noexcept
+{
+    if (count > destinationSize)
+    {
+        return ERANGE;
+    }
+    memcpy(destination, source, count);
+    return 0;
+}
+
+DWORD GetLastError() noexcept;
+void SetLastError(DWORD error) noexcept;
+
+// til's UTF-8 conversions are written against these two. The portable versions
+// handle CP_UTF8 only, which is the only code page til passes.
+#define CP_UTF8 65001
+int MultiByteToWideChar(UINT codePage, DWORD flags, const char* input, int inputLength, wchar_t* output, int outputLength) noexcept;
+int WideCharToMultiByte(UINT codePage, DWORD flags, const wchar_t* input, int inputLength, char* output, int outputLength, const char* defaultChar, BOOL* usedDefaultChar) noexcept;
+
+// Defined by the compiler as an intrinsic on Windows.
+inline unsigned char _BitScanForward(unsigned long* index, unsigned long mask) noexcept
+{
+    if (mask == 0)
+    {
+        return 0;
+    }
+    *index = static_cast<unsigned long>(__builtin_ctzl(mask));
+    return 1;
+}
+
+inline unsigned char _BitScanReverse(unsigned long* index, unsigned long mask) noexcept
+{
+    if (mask == 0)
+    {
+        return 0;
+    }
+    *index = static_cast<unsigned long>(sizeof(unsigned long) * CHAR_BIT - 1 - __builtin_clzl(mask));
+    return 1;
+}
@@ -0,0 +1,7 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// ETW isn't available outside Windows. TraceLoggingProvider.h drops every event,
+// so the levels and keywords are never evaluated.
+
+#pragma once
@@ -0,0 +1,7 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// WRL is only used by the COM parts of the console, none of which the
+// parser-only stages compile.
+
+#pragma once
@@ -0,0 +1,28 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- precomp.h
+
+Abstract:
+- Contains external headers to include in the precompile phase of console build process.
+- Avoid including internal project headers. Instead include them only in the classes that need them.
+--*/
+
+#pragma once
+
+// This includes support libraries from the CRT, STL, WIL, and GSL
+#include "LibraryIncludes.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+// {fmt} 8 moved the wchar_t overloads out of format.h.
+#if FMT_VERSION >= 80000
+#include <fmt/xchar.h>
+#endif
+
+#include "../../inc/conattrs.hpp"
@@ -0,0 +1,193 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "inc/VtCapture.hpp"
+
+using namespace Microsoft::Console::Utils;
+
+static constexpr auto s_invalidData = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+// Routine Description:
+// - Reads a LEB128 varint.
+// Arguments:
+// - bytes - The capture.
+// - offset - The offset of the varint. Moved past it on success.
+// Return Value:
+// - The value, or nullopt if the capture ends before the varint does.
+static std::optional<uint64_t> _ReadVarint(const std::string_view bytes, size_t& offset)
+{
+    uint64_t value = 0;
+    for (auto position = offset, shift = size_t{ 0 }; position < bytes.size(); position++, shift += 7)
+    {
+        THROW_HR_IF(s_invalidData, shift >= 64);
+
+        const auto byte = static_cast<uint8_t>(til::at(bytes, position));
+        value |= uint64_t{ byte & 0x7fu } << shift;
+        if ((byte & 0x80) == 0)
+        {
+            offset = position + 1;
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+static uint32_t _ReadSize(const std::string_view bytes, size_t& offset)
+{
+    const auto value = _ReadVarint(bytes, offset);
+    THROW_HR_IF(s_invalidData, !value.has_value() || value.value() > UINT32_MAX);
+    return gsl::narrow_cast<uint32_t>(value.value());
+}
+
+// Routine Description:
+// - Decodes a capture. A record that's cut off at the end, like the last one
+//   of a session that was terminated while recording, is left out.
+// Arguments:
+// - bytes - The contents of a capture file.
+// Return Value:
+// - The capture. Throws if it isn't one, or it uses a newer format version.
+VtCapture VtCapture::Parse(const std::string_view bytes)
+{
+    THROW_HR_IF(s_invalidData, bytes.substr(0, VtCaptureEncoder::Magic.size()) != VtCaptureEncoder::Magic);
+
+    size_t offset = VtCaptureEncoder::Magic.size();
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED), _ReadSize(bytes, offset) != VtCaptureEncoder::Version);
+
+    VtCapture capture;
+    capture.columns = _ReadSize(bytes, offset);
+    capture.rows = _ReadSize(bytes, offset);
+
+    std::chrono::microseconds time{};
+    while (offset < bytes.size())
+    {
+        const auto type = static_cast<VtCaptureRecordType>(til::at(bytes, offset++));
+        THROW_HR_IF(s_invalidData, type != VtCaptureRecordType::Output && type != VtCaptureRecordType::Resize);
+
+        const auto delta = _ReadVarint(bytes, offset);
+        if (!delta)
+        {
+            break;
+        }
+        time += std::chrono::microseconds{ delta.value() };
+
+        VtCaptureRecord record;
+        record.type = type;
+        record.time = time;
+
+        if (type == VtCaptureRecordType::Output)
+        {
+            const auto length = _ReadVarint(bytes, offset);
+            if (!length || length.value() > bytes.size() - offset)
+            {
+                break;
+            }
+            record.output = bytes.substr(offset, gsl::narrow_cast<size_t>(length.value()));
+            offset += record.output.size();
+        }
+        else
+        {
+            const auto columns = _ReadVarint(bytes, offset);
+            const auto rows = columns ? _ReadVarint(bytes, offset) : std::nullopt;
+            if (!rows)
+            {
+                break;
+            }
+            THROW_HR_IF(s_invalidData, columns.value() > UINT32_MAX || rows.value() > UINT32_MAX);
+            record.columns = gsl::narrow_cast<uint32_t>(columns.value());
+            record.rows = gsl::narrow_cast<uint32_t>(rows.value());
+        }
+
+        capture.records.emplace_back(std::move(record));
+    }
+
+    return capture;
+}
+
+// Routine Description:
+// - Reads and decodes a capture file.
+// Arguments:
+// - path - The capture file.
+// Return Value:
+// - The capture.
+VtCapture VtCapture::Load(const std::filesystem::path& path)
+{
+    std::ifstream file{ path, std::ios::binary };
+    THROW_HR_IF(E_FAIL, !file.is_open());
+
+    const std::string bytes{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+    return Parse(bytes);
+}
+
+// Routine Description:
+// - Starts a capture of a terminal of the given size.
+//   The header is the first thing returned by Pending().
+VtCaptureEncoder::VtCaptureEncoder(const uint32_t columns, const uint32_t rows)
+{
+    _pending.append(Magic);
+    _AppendVarint(Version);
+    _AppendVarint(columns);
+    _AppendVarint(rows);
+}
+
+// Routine Description:
+// - Records a chunk of output. A surrogate pair that's split across chunks is
+//   completed with the next one.
+// Arguments:
+// - time - The time since the start of the capture.
+// - text - The output.
+void VtCaptureEncoder::Output(const std::chrono::microseconds time, const std::wstring_view text)
+{
+    THROW_IF_FAILED(til::u16u8(text, _utf8, _partials));
+    if (_utf8.empty())
+    {
+        return;
+    }
+
+    _AppendRecord(VtCaptureRecordType::Output, time);
+    _AppendVarint(_utf8.size());
+    _pending.append(_utf8);
+}
+
+// Routine Description:
+// - Records a change of the terminal's size.
+// Arguments:
+// - time - The time since the start of the capture.
+// - columns, rows - The new size.
+void VtCaptureEncoder::Resize(const std::chrono::microseconds time, const uint32_t columns, const uint32_t rows)
+{
+    _AppendRecord(VtCaptureRecordType::Resize, time);
+    _AppendVarint(columns);
+    _AppendVarint(rows);
+}
+
+// Routine Description:
+// - Returns the encoded bytes that haven't been cleared yet, to be written out.
+std::string_view VtCaptureEncoder::Pending() const noexcept
+{
+    return _pending;
+}
+
+void VtCaptureEncoder::ClearPending() noexcept
+{
+    _pending.clear();
+}
+
+void VtCaptureEncoder::_AppendRecord(const VtCaptureRecordType type, const std::chrono::microseconds time)
+{
+    // Times are stored as deltas, which can't be negative.
+    const auto clamped = std::max(time, _lastTime);
+    _pending.push_back(static_cast<char>(type));
+    _AppendVarint(gsl::narrow_cast<uint64_t>((clamped - _lastTime).count()));
+    _lastTime = clamped;
+}
+
+void VtCaptureEncoder::_AppendVarint(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        _pending.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    _pending.push_back(static_cast<char>(value));
+}
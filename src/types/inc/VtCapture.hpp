@@ -0,0 +1,76 @@
+/*++
+Copyright (c) Microsoft Corporation.
+Licensed under the MIT license.
+
+Module Name:
+- VtCapture.hpp
+
+Abstract:
+- Writes and reads VT session captures: the output that a client wrote to a
+  terminal, with the time at which it arrived, and the resizes in between.
+  A capture can be replayed without the application that produced it.
+- A capture starts with a header of the magic "VTCP", the format version,
+  and the initial size in columns and rows. It's followed by one record per
+  output chunk or resize: the record type, the microseconds since the
+  previous record, and the payload. All numbers after the magic are LEB128
+  varints, and output is stored as UTF-8.
+--*/
+
+#pragma once
+
+#include <chrono>
+
+namespace Microsoft::Console::Utils
+{
+    enum class VtCaptureRecordType : uint8_t
+    {
+        Output = 0,
+        Resize = 1
+    };
+
+    struct VtCaptureRecord
+    {
+        VtCaptureRecordType type = VtCaptureRecordType::Output;
+        // The time since the start of the capture.
+        std::chrono::microseconds time{};
+        // The UTF-8 text of an Output record.
+        std::string output;
+        // The new size of a Resize record.
+        uint32_t columns = 0;
+        uint32_t rows = 0;
+    };
+
+    struct VtCapture
+    {
+        uint32_t columns = 0;
+        uint32_t rows = 0;
+        std::vector<VtCaptureRecord> records;
+
+        static VtCapture Parse(const std::string_view bytes);
+        static VtCapture Load(const std::filesystem::path& path);
+    };
+
+    class VtCaptureEncoder final
+    {
+    public:
+        static constexpr std::string_view Magic{ "VTCP" };
+        static constexpr uint32_t Version = 1;
+
+        VtCaptureEncoder(const uint32_t columns, const uint32_t rows);
+
+        void Output(const std::chrono::microseconds time, const std::wstring_view text);
+        void Resize(const std::chrono::microseconds time, const uint32_t columns, const uint32_t rows);
+
+        std::string_view Pending() const noexcept;
+        void ClearPending() noexcept;
+
+    private:
+        void _AppendRecord(const VtCaptureRecordType type, const std::chrono::microseconds time);
+        void _AppendVarint(uint64_t value);
+
+        std::string _pending;
+        std::string _utf8;
+        til::u16state _partials;
+        std::chrono::microseconds _lastTime{};
+    };
+}
@@ -0,0 +1,105 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "..\..\inc\consoletaeftemplates.hpp"
+
+#include "..\inc\VtCapture.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+using namespace Microsoft::Console::Utils;
+using namespace std::chrono_literals;
+
+class VtCaptureTests
+{
+    TEST_CLASS(VtCaptureTests);
+
+    TEST_METHOD(TestRoundTrip);
+    TEST_METHOD(TestSurrogatePairSplitAcrossChunks);
+    TEST_METHOD(TestTruncatedCapture);
+    TEST_METHOD(TestInvalidCapture);
+};
+
+void VtCaptureTests::TestRoundTrip()
+{
+    VtCaptureEncoder encoder{ 120, 30 };
+    encoder.Output(5us, L"hello\x1b[m");
+    encoder.Resize(200us, 80, 25);
+    encoder.Output(3s, L"w\x00f6rld");
+
+    const auto capture = VtCapture::Parse(encoder.Pending());
+    VERIFY_ARE_EQUAL(120u, capture.columns);
+    VERIFY_ARE_EQUAL(30u, capture.rows);
+    VERIFY_ARE_EQUAL(3u, capture.records.size());
+
+    const auto& first = til::at(capture.records, 0);
+    VERIFY_IS_TRUE(first.type == VtCaptureRecordType::Output);
+    VERIFY_ARE_EQUAL(5, first.time.count());
+    VERIFY_IS_TRUE(first.output == "hello\x1b[m");
+
+    const auto& second = til::at(capture.records, 1);
+    VERIFY_IS_TRUE(second.type == VtCaptureRecordType::Resize);
+    VERIFY_ARE_EQUAL(200, second.time.count());
+    VERIFY_ARE_EQUAL(80u, second.columns);
+    VERIFY_ARE_EQUAL(25u, second.rows);
+
+    const auto& third = til::at(capture.records, 2);
+    VERIFY_ARE_EQUAL(3000000, third.time.count());
+    VERIFY_IS_TRUE(third.output == "w\xc3\xb6rld");
+
+    Log::Comment(L"Pending bytes that were cleared aren't returned again.");
+    encoder.ClearPending();
+    VERIFY_IS_TRUE(encoder.Pending().empty());
+}
+
+void VtCaptureTests::TestSurrogatePairSplitAcrossChunks()
+{
+    VtCaptureEncoder encoder{ 80, 25 };
+    encoder.Output(1us, L"a\xd83d");
+    encoder.Output(2us, L"\xde00");
+
+    const auto capture = VtCapture::Parse(encoder.Pending());
+    VERIFY_ARE_EQUAL(2u, capture.records.size());
+    VERIFY_IS_TRUE(til::at(capture.records, 0).output == "a");
+    VERIFY_IS_TRUE(til::at(capture.records, 1).output == "\xf0\x9f\x98\x80");
+}
+
+void VtCaptureTests::TestTruncatedCapture()
+{
+    VtCaptureEncoder encoder{ 80, 25 };
+    encoder.Output(1us, L"first");
+    encoder.Output(2us, L"second");
+    const std::string bytes{ encoder.Pending() };
+
+    Log::Comment(L"A record that was cut off is left out.");
+    const auto capture = VtCapture::Parse(std::string_view{ bytes }.substr(0, bytes.size() - 1));
+    VERIFY_ARE_EQUAL(1u, capture.records.size());
+    VERIFY_IS_TRUE(til::at(capture.records, 0).output == "first");
+}
+
+void VtCaptureTests::TestInvalidCapture()
+{
+    const auto parseError = [](const std::string_view bytes) {
+        try
+        {
+            VtCapture::Parse(bytes);
+        }
+        catch (...)
+        {
+            return wil::ResultFromCaughtException();
+        }
+        return S_OK;
+    };
+
+    VERIFY_ARE_EQUAL(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), parseError("not a capture"));
+
+    Log::Comment(L"Captures of a later version can't be read.");
+    VERIFY_ARE_EQUAL(HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED), parseError("VTCP\x02\x50\x19"));
+
+    Log::Comment(L"Unknown record types are rejected.");
+    VERIFY_ARE_EQUAL(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), parseError("VTCP\x01\x50\x19\x07"));
+}